@@ -542,6 +542,9 @@ my_bool	net_write_command(NET *net,unsigned char command,
 			  const unsigned char *packet, size_t len);
 int	net_real_write(NET *net,const unsigned char *packet, size_t len);
 unsigned long my_net_read(NET *net);
+#ifdef MYSQL_SERVER
+my_bool	my_net_reinit(NET *net, Vio* vio, unsigned int my_flags);
+#endif
 
 #ifdef MY_GLOBAL_INCLUDED
 void my_net_set_write_timeout(NET *net, uint timeout);
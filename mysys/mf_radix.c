@@ -58,3 +58,89 @@ void radixsort_for_str_ptr(uchar **base, uint number_of_elements, size_t size_of
   next:;
   }
 }
+
+
+/*
+  Most significant byte first radix sort for pointers to fixed length
+  strings (American flag sort).
+
+  The pointers are distributed into 256 buckets by the byte at 'offset'
+  and every bucket is then sorted by the following bytes. The pointers
+  are permuted in place, so no extra buffer is needed. Bytes that are
+  the same in all strings of a partition are skipped without splitting
+  it. Partitions with less than MSD_RADIX_MIN_ITEMS strings, and the
+  partitions left after MSD_RADIX_MAX_LEVEL splits (to bound the stack
+  used), are sorted with qsort.
+*/
+
+#define MSD_RADIX_MIN_ITEMS 64
+#define MSD_RADIX_MAX_LEVEL 8
+
+static void msd_radixsort(uchar **base, uint number_of_elements,
+                          size_t offset, size_t size_of_element, uint level)
+{
+  uchar **end= base + number_of_elements, **ptr;
+  uchar **next[256];
+  uint32 count[256];
+  uint i;
+
+  if (number_of_elements < MSD_RADIX_MIN_ITEMS || level >= MSD_RADIX_MAX_LEVEL)
+  {
+    my_qsort2(base, number_of_elements, sizeof(uchar*),
+              get_ptr_compare(size_of_element), (void*) &size_of_element);
+    return;
+  }
+
+  for (;; offset++)
+  {
+    if (offset == size_of_element)
+      return;                                   /* All strings are equal */
+    bzero((uchar*) count, sizeof(count));
+    for (ptr= base ; ptr < end ; ptr++)
+      count[ptr[0][offset]]++;
+    if (count[base[0][offset]] != number_of_elements)
+      break;
+  }
+
+  /* next[i] is where the next string with byte i is to be placed */
+  for (ptr= base, i= 0 ; i < 256 ; i++)
+  {
+    next[i]= ptr;
+    ptr+= count[i];
+  }
+  /* Move every string to its bucket, following the cycles of the permutation */
+  for (ptr= base, i= 0 ; i < 256 ; i++)
+  {
+    ptr+= count[i];                             /* End of bucket i */
+    while (next[i] < ptr)
+    {
+      uchar *str= *next[i];
+      uint digit= str[offset];
+      while (digit != i)
+      {
+        uchar *tmp= *next[digit];
+        *next[digit]++= str;
+        str= tmp;
+        digit= str[offset];
+      }
+      *next[i]++= str;
+    }
+  }
+
+  if (++offset == size_of_element)
+    return;
+  for (i= 0 ; i < 256 ; i++)
+  {
+    if (count[i] > 1)
+      msd_radixsort(next[i] - count[i], count[i], offset, size_of_element,
+                    level + 1);
+  }
+}
+
+
+void msd_radixsort_for_str_ptr(uchar **base, uint number_of_elements,
+                               size_t size_of_element)
+{
+  if (number_of_elements > 1 && size_of_element)
+    msd_radixsort(base, number_of_elements, 0, size_of_element, 0);
+}
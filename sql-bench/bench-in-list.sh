@@ -0,0 +1,157 @@
+#!@PERL@
+# Test of IN predicates with constant lists of different lengths.
+#
+# The lists are evaluated for every row of a table that is scanned, so
+# the times compare the lookup of a value in lists of integer, temporal
+# and binary string constants.
+
+use Cwd;
+use DBI;
+use Getopt::Long;
+use Benchmark;
+
+$opt_loop_count=100000;
+$opt_small_loop_count=10;
+
+$pwd = cwd(); $pwd = "." if ($pwd eq '');
+require "$pwd/bench-init.pl" || die "Can't read Configuration file: $!\n";
+
+if ($opt_small_test)
+{
+  $opt_loop_count/=10;
+  $opt_small_loop_count/=2;
+}
+
+@list_lengths=(4, 16, 64, 1000, 10000);
+
+print "Testing the speed of IN predicates with constant lists\n";
+print "The test table has $opt_loop_count rows.\n\n";
+
+####
+####  Connect and start timeing
+####
+
+$dbh = $server->connect();
+$start_time=new Benchmark;
+
+####
+#### Create needed tables
+####
+
+goto select_test if ($opt_skip_create);
+
+print "Creating table\n";
+$dbh->do("drop table bench1" . $server->{'drop_attr'});
+
+do_many($dbh,$server->create("bench1",
+			     ["id integer NOT NULL",
+			      "dt datetime NOT NULL",
+			      "str varbinary(20) NOT NULL"],
+			     []));
+
+if ($opt_lock_tables)
+{
+  do_query($dbh,"LOCK TABLES bench1 WRITE");
+}
+
+if ($opt_fast && $server->{transactions})
+{
+  $dbh->{AutoCommit} = 0;
+}
+
+print "Inserting $opt_loop_count rows\n";
+$loop_time=new Benchmark;
+
+for ($id=0 ; $id < $opt_loop_count ; $id++)
+{
+  do_query($dbh,"insert into bench1 values ($id," .
+	   "'2000-01-01 00:00:00' + interval $id second,'key$id')");
+}
+
+if ($opt_fast && $server->{transactions})
+{
+  $dbh->commit;
+  $dbh->{AutoCommit} = 1;
+}
+
+$end_time=new Benchmark;
+print "Time to insert ($opt_loop_count): " .
+    timestr(timediff($end_time, $loop_time),"all") . "\n\n";
+
+if ($opt_lock_tables)
+{
+  do_query($dbh,"UNLOCK TABLES");
+}
+
+if ($opt_fast && defined($server->{vacuum}))
+{
+  $server->vacuum(1,\$dbh,"bench1");
+}
+
+if ($opt_lock_tables)
+{
+  do_query($dbh,"LOCK TABLES bench1 READ");
+}
+
+####
+#### Scan the table with IN lists of different lengths
+####
+
+select_test:
+
+foreach $length (@list_lengths)
+{
+  # Every other constant of the list is found in the table
+  @ints=();
+  for ($i=0 ; $i < $length ; $i++)
+  {
+    push(@ints, int(rand($opt_loop_count)) * 2);
+  }
+  $int_list= join(",", @ints);
+  $dt_list= join(",", map { "'2000-01-01 00:00:00' + interval $_ second" }
+		 @ints);
+  $str_list= join(",", map { "'key$_'" } @ints);
+
+  test_in_list("int", $length, "select count(*) from bench1 where id in ($int_list)");
+  test_in_list("datetime", $length, "select count(*) from bench1 where dt in ($dt_list)");
+  test_in_list("varbinary", $length, "select count(*) from bench1 where str in ($str_list)");
+}
+
+####
+#### End of benchmark
+####
+
+if ($opt_lock_tables)
+{
+  do_query($dbh,"UNLOCK TABLES");
+}
+if (!$opt_skip_delete)
+{
+  do_query($dbh,"drop table bench1" . $server->{'drop_attr'});
+}
+
+if ($opt_fast && defined($server->{vacuum}))
+{
+  $server->vacuum(0,\$dbh);
+}
+
+$dbh->disconnect;				# close connection
+
+end_benchmark($start_time);
+
+
+sub test_in_list
+{
+  my ($type, $length, $query)= @_;
+  my ($loop_time, $end_time, $i, $rows);
+
+  $loop_time=new Benchmark;
+  $rows=0;
+  for ($i=0 ; $i < $opt_small_loop_count ; $i++)
+  {
+    $rows+=fetch_all_rows($dbh,$query);
+  }
+  $end_time=new Benchmark;
+  print "Time for in_list_${type}_$length ($i:$rows): " .
+    timestr(timediff($end_time, $loop_time),"all") . "\n";
+}
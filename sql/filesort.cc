@@ -40,6 +40,7 @@
 #include "log_slow.h"
 #include "debug_sync.h"
 #include "sql_base.h"
+#include "sql_task_pool.h"
 
 /// How to write record_ref.
 #define WRITE_REF(file,from) \
@@ -70,6 +71,12 @@ static SORT_ADDON_FIELD *get_addon_fields(ulong max_length_for_sort_data,
                                           uint sortlength, uint *plength);
 static void unpack_addon_fields(struct st_sort_addon_field *addon_field,
                                 uchar *buff, uchar *buff_end);
+static void unpack_packed_addon_fields(struct st_sort_addon_field *addon_field,
+                                       uchar *buff, uchar *buff_end);
+static int merge_runs(Sort_param *param, IO_CACHE *from_file,
+                      IO_CACHE *to_file, uchar *sort_buffer,
+                      BUFFPEK *lastbuff, BUFFPEK *Fb, BUFFPEK *Tb,
+                      int flag, THD *thd, bool in_task);
 static bool check_if_pq_applicable(Sort_param *param, Filesort_info *info,
                                    TABLE *table,
                                    ha_rows records, ulong memory_available);
@@ -107,6 +114,149 @@ void Sort_param::init_for_filesort(uint sortlen, TABLE *table,
 }
 
 
+/**
+  Check whether a part of the sort key can be packed.
+  Only strings whose keys can be padded are packed.
+*/
+
+static bool is_packable_sort_field(SORT_FIELD *sort_field)
+{
+  if (sort_field->length < MIN_PACKED_SORT_FIELD_LENGTH ||
+      sort_field->suffix_length)
+    return FALSE;
+  if (sort_field->field)
+    return (sort_field->field->cmp_type() == STRING_RESULT &&
+            sort_field->field->sort_charset() != &my_charset_bin);
+  return (sort_field->result_type == STRING_RESULT &&
+          sort_field->item->collation.collation != &my_charset_bin);
+}
+
+
+/**
+  Make the key of an empty string for a part of the sort key, the same
+  way make_sortkey() makes the keys of the values of the part.
+*/
+
+static void make_sort_field_pad(SORT_FIELD *sort_field, uchar *pad)
+{
+  uint length= sort_field->length;
+  if (sort_field->field)
+  {
+    Field *field= sort_field->field;
+    CHARSET_INFO *cs= field->sort_charset();
+    cs->coll->strnxfrm(cs, pad, length,
+                       field->char_length() * cs->strxfrm_multiply,
+                       (const uchar*) "", 0,
+                       MY_STRXFRM_PAD_WITH_SPACE | MY_STRXFRM_PAD_TO_MAXLEN);
+  }
+  else
+  {
+    Item *item= sort_field->item;
+    CHARSET_INFO *cs= item->collation.collation;
+    if (sort_field->need_strxnfrm)
+      cs->coll->strnxfrm(cs, pad, length,
+                         item->max_char_length() * cs->strxfrm_multiply,
+                         (const uchar*) "", 0,
+                         MY_STRXFRM_PAD_WITH_SPACE |
+                         MY_STRXFRM_PAD_TO_MAXLEN);
+    else
+      cs->cset->fill(cs, (char*) pad, length,
+                     (cs->state & MY_CS_BINSORT) ? (char) 0 : ' ');
+  }
+  if (sort_field->reverse)
+  {
+    for (uchar *end= pad + length; pad != end; pad++)
+      *pad= (uchar) ~*pad;
+  }
+}
+
+
+/**
+  Decide whether the records in the sort buffer are packed.
+
+  The string parts of the sort key that are at least
+  MIN_PACKED_SORT_FIELD_LENGTH bytes long are packed: the trailing bytes
+  of the key of a value that are the same as in the key of an empty
+  string (SORT_FIELD::pad) are not stored, and the rest is preceded by
+  its length. The key of a NULL value is not stored at all. As
+  cmp_packed_sort_keys() compares the missing bytes as if they were
+  taken from the key of the empty string, the keys sort the same way as
+  keys that are not packed.
+
+  The addon fields are packed if some of them are strings. They are then
+  stored one after another with Field::pack(), without padding.
+
+  Records of different lengths cannot be sorted with a priority queue,
+  so this is not called if one is used.
+
+  @retval TRUE  Out of memory
+*/
+
+bool Sort_param::init_packed_records()
+{
+  SORT_FIELD *sort_field;
+  uint pad_length= 0;
+
+  DBUG_EXECUTE_IF("filesort_no_packed_records", return FALSE;);
+
+  for (sort_field= local_sortorder; sort_field != end; sort_field++)
+  {
+    if (!is_packable_sort_field(sort_field))
+      continue;
+    sort_field->length_bytes= suffix_length(sort_field->length);
+    pad_length+= sort_field->length;
+    rec_length+= sort_field->length_bytes;
+  }
+  if (pad_length)
+  {
+    uchar *pad;
+    if (!(pad_buffer= (uchar*) my_malloc(pad_length,
+                                         MYF(MY_WME | MY_THREAD_SPECIFIC))))
+      return TRUE;
+    for (sort_field= local_sortorder, pad= pad_buffer;
+         sort_field != end;
+         sort_field++)
+    {
+      if (!sort_field->length_bytes)
+        continue;
+      sort_field->pad= pad;
+      make_sort_field_pad(sort_field, pad);
+      pad+= sort_field->length;
+    }
+    using_packed_keys= TRUE;
+    rec_length+= PACKED_SORT_KEY_LENGTH_BYTES;
+  }
+
+  if (addon_field &&
+      addon_length + PACKED_ADDON_LENGTH_BYTES <= UINT_MAX16)
+  {
+    for (SORT_ADDON_FIELD *addonf= addon_field; addonf->field; addonf++)
+    {
+      enum_field_types type= addonf->field->real_type();
+      if (type == MYSQL_TYPE_VARCHAR || type == MYSQL_TYPE_STRING ||
+          type == MYSQL_TYPE_VAR_STRING)
+      {
+        using_packed_addons= TRUE;
+        addon_length+= PACKED_ADDON_LENGTH_BYTES;
+        res_length= addon_length;
+        rec_length+= PACKED_ADDON_LENGTH_BYTES;
+        break;
+      }
+    }
+  }
+
+  /*
+    make_sortkey() may use sort_length bytes after the last key part as
+    a buffer for the value of the part.
+  */
+  if (using_packed_records() &&
+      !(tmp_record= (uchar*) my_malloc(rec_length + sort_length,
+                                       MYF(MY_WME | MY_THREAD_SPECIFIC))))
+    return TRUE;
+  return FALSE;
+}
+
+
 /**
   Sort a table.
   Creates a set of pointers that can be used to read the rows
@@ -194,15 +344,20 @@ ha_rows filesort(THD *thd, TABLE *table, SORT_FIELD *sortorder, uint s_length,
                           table,
                           thd->variables.max_length_for_sort_data,
                           max_rows, sort_positions);
+  param.sort_threads= (uint) thd->variables.max_sort_threads;
+  param.sort_form= table;
+  param.end=(param.local_sortorder=sortorder)+s_length;
 
   table_sort.addon_buf= 0;
   table_sort.addon_length= param.addon_length;
   table_sort.addon_field= param.addon_field;
   table_sort.unpack= unpack_addon_fields;
+  table_sort.using_packed_addons= FALSE;
+  /* Leave room for the length of the fields if they get packed */
   if (param.addon_field &&
       !(table_sort.addon_buf=
-        (uchar *) my_malloc(param.addon_length, MYF(MY_WME |
-                                                    MY_THREAD_SPECIFIC))))
+        (uchar *) my_malloc(param.addon_length + PACKED_ADDON_LENGTH_BYTES,
+                            MYF(MY_WME | MY_THREAD_SPECIFIC))))
     goto err;
 
   if (select && select->quick)
@@ -246,6 +401,15 @@ ha_rows filesort(THD *thd, TABLE *table, SORT_FIELD *sortorder, uint s_length,
   {
     DBUG_PRINT("info", ("filesort PQ is not applicable"));
 
+    if (param.init_packed_records())
+      goto err;
+    if (param.using_packed_addons)
+    {
+      table_sort.addon_length= param.addon_length;
+      table_sort.unpack= unpack_packed_addon_fields;
+      table_sort.using_packed_addons= TRUE;
+    }
+
     size_t min_sort_memory= MY_MAX(MIN_SORT_MEMORY, param.sort_length*MERGEBUFF2);
     set_if_bigger(min_sort_memory, sizeof(BUFFPEK*)*MERGEBUFF2);
     while (memory_available >= min_sort_memory)
@@ -285,8 +449,6 @@ ha_rows filesort(THD *thd, TABLE *table, SORT_FIELD *sortorder, uint s_length,
 		       DISK_BUFFER_SIZE, MYF(MY_WME)))
     goto err;
 
-  param.sort_form= table;
-  param.end=(param.local_sortorder=sortorder)+s_length;
   num_rows= find_all_keys(&param, select,
                           &table_sort,
                           &buffpek_pointers,
@@ -362,6 +524,8 @@ ha_rows filesort(THD *thd, TABLE *table, SORT_FIELD *sortorder, uint s_length,
 
   err:
   my_free(param.tmp_buffer);
+  my_free(param.tmp_record);
+  my_free(param.pad_buffer);
   if (!subselect || !subselect->is_uncacheable())
   {
     table_sort.free_sort_buffer();
@@ -452,6 +616,7 @@ void filesort_free_buffers(TABLE *table, bool full)
   my_free(table->sort.addon_field);
   table->sort.addon_buf= NULL;
   table->sort.addon_field= NULL;
+  table->sort.using_packed_addons= FALSE;
   DBUG_VOID_RETURN;
 }
 
@@ -666,6 +831,7 @@ static ha_rows find_all_keys(Sort_param *param, SQL_SELECT *select,
 {
   int error,flag,quick_select;
   uint idx,indexpos,ref_length;
+  ha_rows written_rows= 0;
   uchar *ref_pos,*next_pos,ref_buff[MAX_REFLENGTH];
   my_off_t record;
   TABLE *sort_form;
@@ -812,6 +978,24 @@ static ha_rows find_all_keys(Sort_param *param, SQL_SELECT *select,
         pq->push(ref_pos);
         idx= pq->num_elements();
       }
+      else if (param->using_packed_records())
+      {
+        uchar *to;
+        make_sortkey(param, param->tmp_record, ref_pos);
+        uint length= param->get_record_length(param->tmp_record);
+        if (!(to= fs_info->get_packed_record_buffer(idx, length)))
+        {
+          if (write_keys(param, fs_info, idx, buffpek_pointers, tempfile))
+             DBUG_RETURN(HA_POS_ERROR);
+          written_rows+= MY_MIN(idx, param->max_rows);
+	  idx= 0;
+	  indexpos++;
+          to= fs_info->get_packed_record_buffer(idx, length);
+          DBUG_ASSERT(to);
+        }
+        memcpy(to, param->tmp_record, length);
+        idx++;
+      }
       else
       {
         if (idx == param->max_keys_per_buffer)
@@ -855,12 +1039,16 @@ static ha_rows find_all_keys(Sort_param *param, SQL_SELECT *select,
     file->print_error(error,MYF(ME_ERROR | ME_WAITTANG)); // purecov: inspected
     DBUG_RETURN(HA_POS_ERROR);			/* purecov: inspected */
   }
-  if (indexpos && idx &&
-      write_keys(param, fs_info, idx, buffpek_pointers, tempfile))
-    DBUG_RETURN(HA_POS_ERROR);			/* purecov: inspected */
+  if (indexpos && idx)
+  {
+    if (write_keys(param, fs_info, idx, buffpek_pointers, tempfile))
+      DBUG_RETURN(HA_POS_ERROR);		/* purecov: inspected */
+    written_rows+= MY_MIN(idx, param->max_rows);
+  }
   const ha_rows retval=
-    my_b_inited(tempfile) ?
-    (ha_rows) (my_b_tell(tempfile)/param->rec_length) : idx;
+    !my_b_inited(tempfile) ? idx :
+    param->using_packed_records() ? written_rows :
+    (ha_rows) (my_b_tell(tempfile)/param->rec_length);
   DBUG_PRINT("info", ("find_all_keys return %u", (uint) retval));
   DBUG_RETURN(retval);
 } /* find_all_keys */
@@ -914,8 +1102,12 @@ write_keys(Sort_param *param,  Filesort_info *fs_info, uint count,
     count=(uint) param->max_rows;               /* purecov: inspected */
   buffpek.count=(ha_rows) count;
   for (end=sort_keys+count ; sort_keys != end ; sort_keys++)
+  {
+    if (param->using_packed_records())
+      rec_length= param->get_record_length(*sort_keys);
     if (my_b_write(tempfile, (uchar*) *sort_keys, (uint) rec_length))
       goto err;
+  }
   if (my_b_write(buffpek_pointers, (uchar*) &buffpek, sizeof(buffpek)))
     goto err;
   DBUG_RETURN(0);
@@ -948,6 +1140,50 @@ static inline void store_length(uchar *to, uint length, uint pack_length)
 }
 
 
+static inline uint read_length(const uchar *from, uint pack_length)
+{
+  switch (pack_length) {
+  case 1:
+    return *from;
+  case 2:
+    return mi_uint2korr(from);
+  case 3:
+    return mi_uint3korr(from);
+  default:
+    return mi_uint4korr(from);
+  }
+}
+
+
+/**
+  Pack a part of a packed sort key (see Sort_param::init_packed_records())
+
+  @param sort_field  The part of the key
+  @param to          Start of the part. The key made by make_sortkey()
+                     follows the space for the length and the NULL marker.
+  @param maybe_null  The part has a NULL marker
+
+  @return End of the packed part
+*/
+
+static uchar *pack_sort_field(SORT_FIELD *sort_field, uchar *to,
+                              bool maybe_null)
+{
+  uchar *key= to + sort_field->length_bytes + maybe_null;
+  uint length= sort_field->length;
+
+  if (maybe_null && key[-1] == (sort_field->reverse ? 1 : 0))
+    length= 0;                                  // NULL value
+  else
+  {
+    while (length && key[length - 1] == sort_field->pad[length - 1])
+      length--;
+  }
+  store_length(to, length, sort_field->length_bytes);
+  return key + length;
+}
+
+
 /** Make a sort-key from record. */
 
 static void make_sortkey(register Sort_param *param,
@@ -956,12 +1192,18 @@ static void make_sortkey(register Sort_param *param,
   reg3 Field *field;
   reg1 SORT_FIELD *sort_field;
   reg5 uint length;
+  uchar *key_start= to;
+
+  if (param->using_packed_keys)
+    to+= PACKED_SORT_KEY_LENGTH_BYTES;
 
   for (sort_field=param->local_sortorder ;
        sort_field != param->end ;
        sort_field++)
   {
     bool maybe_null=0;
+    uchar *part_start= to;
+    to+= sort_field->length_bytes;
     if ((field=sort_field->field))
     {						// Field
       field->make_sort_key(to, sort_field->length);
@@ -1129,22 +1371,53 @@ static void make_sortkey(register Sort_param *param,
     if (sort_field->reverse)
     {							/* Revers key */
       if (maybe_null && (to[-1]= !to[-1]))
-      {
         to+= sort_field->length; // don't waste the time reversing all 0's
-        continue;
-      }
-      length=sort_field->length;
-      while (length--)
+      else
       {
-	*to = (uchar) (~ *to);
-	to++;
+        length=sort_field->length;
+        while (length--)
+        {
+          *to = (uchar) (~ *to);
+          to++;
+        }
       }
     }
     else
       to+= sort_field->length;
+    if (sort_field->length_bytes)
+      to= pack_sort_field(sort_field, part_start, maybe_null);
   }
 
-  if (param->addon_field)
+  if (!param->addon_field)
+  {
+    /* Save filepos last */
+    memcpy((uchar*) to, ref_pos, (size_t) param->ref_length);
+    to+= param->ref_length;
+  }
+  if (param->using_packed_keys)
+    int4store(key_start, (uint32) (to - key_start));
+
+  if (param->addon_field && param->using_packed_addons)
+  {
+    /*
+      Save the length of the fields, then the null bit indicators and
+      the packed field values one after another.
+    */
+    SORT_ADDON_FIELD *addonf= param->addon_field;
+    uchar *start= to;
+    uchar *nulls= to + PACKED_ADDON_LENGTH_BYTES;
+    memset(nulls, 0, addonf->offset);
+    to= nulls + addonf->offset;
+    for ( ; (field= addonf->field) ; addonf++)
+    {
+      if (addonf->null_bit && field->is_null())
+        nulls[addonf->null_offset]|= addonf->null_bit;
+      else
+        to= field->pack(to, field->ptr);
+    }
+    int2store(start, (uint16) (to - start));
+  }
+  else if (param->addon_field)
   {
     /* 
       Save field values appended to sorted fields.
@@ -1181,12 +1454,68 @@ static void make_sortkey(register Sort_param *param,
       to+= addonf->length;
     }
   }
-  else
+  return;
+}
+
+
+/**
+  Compare two packed sort keys (see Sort_param::init_packed_records())
+
+  The bytes that are not stored in a packed part of a key are compared
+  as if they were taken from the key of an empty string, so the result
+  is the same as of memcmp() of the keys that are not packed.
+*/
+
+int cmp_packed_sort_keys(const Sort_param *param, uchar **a, uchar **b)
+{
+  uchar *pos_a= *a + PACKED_SORT_KEY_LENGTH_BYTES;
+  uchar *pos_b= *b + PACKED_SORT_KEY_LENGTH_BYTES;
+  int res;
+
+  for (const SORT_FIELD *sort_field= param->local_sortorder;
+       sort_field != param->end;
+       sort_field++)
   {
-    /* Save filepos last */
-    memcpy((uchar*) to, ref_pos, (size_t) param->ref_length);
+    bool maybe_null= (sort_field->field ? sort_field->field->maybe_null() :
+                      sort_field->item->maybe_null);
+    if (!sort_field->length_bytes)
+    {
+      uint length= sort_field->length + maybe_null;
+      if ((res= memcmp(pos_a, pos_b, length)))
+        return res;
+      pos_a+= length;
+      pos_b+= length;
+      continue;
+    }
+
+    uint length_a= read_length(pos_a, sort_field->length_bytes);
+    uint length_b= read_length(pos_b, sort_field->length_bytes);
+    pos_a+= sort_field->length_bytes;
+    pos_b+= sort_field->length_bytes;
+    if (maybe_null)
+    {
+      if (*pos_a != *pos_b)
+        return (int) *pos_a - (int) *pos_b;
+      pos_a++;
+      pos_b++;
+    }
+    uint common= MY_MIN(length_a, length_b);
+    if ((res= memcmp(pos_a, pos_b, common)))
+      return res;
+    if (length_a > length_b)
+      res= memcmp(pos_a + common, sort_field->pad + common,
+                  length_a - common);
+    else if (length_a < length_b)
+      res= memcmp(sort_field->pad + common, pos_b + common,
+                  length_b - common);
+    if (res)
+      return res;
+    pos_a+= length_a;
+    pos_b+= length_b;
   }
-  return;
+  if (!param->addon_field)
+    return memcmp(pos_a, pos_b, param->ref_length);
+  return 0;
 }
 
 
@@ -1255,7 +1584,13 @@ static bool save_index(Sort_param *param, uint count, Filesort_info *table_sort)
   uchar **sort_keys= table_sort->get_sort_keys();
   for (uchar **end= sort_keys+count ; sort_keys != end ; sort_keys++)
   {
-    memcpy(to, *sort_keys+offset, res_length);
+    if (param->using_packed_records())
+    {
+      uchar *res= param->get_result(*sort_keys);
+      memcpy(to, res, param->get_result_length(res));
+    }
+    else
+      memcpy(to, *sort_keys+offset, res_length);
     to+= res_length;
   }
   DBUG_RETURN(0);
@@ -1402,6 +1737,185 @@ bool check_if_pq_applicable(Sort_param *param,
 }
 
 
+/*
+  The write function of the IO_CACHEs of Merge_task: the data is written
+  with pwrite() so that several tasks can write to the same file at the
+  same time.
+*/
+
+static int flush_at_position(IO_CACHE *info)
+{
+  size_t length= (size_t) (info->write_pos - info->write_buffer);
+  if (length &&
+      mysql_file_pwrite(info->file, info->write_buffer, length,
+                        info->pos_in_file, info->myflags | MY_NABP))
+    return info->error= -1;
+  info->pos_in_file+= length;
+  info->write_pos= info->write_buffer;
+  info->write_end= info->write_buffer + info->buffer_length;
+  return 0;
+}
+
+
+static int write_at_position(IO_CACHE *info, const uchar *buffer,
+                             size_t count)
+{
+  if (flush_at_position(info))
+    return 1;
+  if (count >= info->buffer_length)
+  {
+    if (mysql_file_pwrite(info->file, buffer, count, info->pos_in_file,
+                          info->myflags | MY_NABP))
+      return info->error= -1;
+    info->pos_in_file+= count;
+    return 0;
+  }
+  memcpy(info->write_pos, buffer, count);
+  info->write_pos+= count;
+  return 0;
+}
+
+
+/**
+  Merges of one pass of merge_many_buff() done by one thread
+
+  The task merges every step'th group of MERGEBUFF runs, starting with the
+  group 'first', using its own part of the sort buffer. The output of a
+  group is written to to_file at the position of the group's input in
+  from_file: a merge never writes more than it reads, so the outputs of
+  the groups do not overlap and can be written in any order.
+*/
+
+class Merge_task :public Pool_task
+{
+public:
+  /* A copy of the sort parameters with the keys of this task's buffer */
+  Sort_param param;
+  /* The statement, checked for being killed */
+  THD *stmt_thd;
+  IO_CACHE *from_file, *to_file;
+  uchar *sort_buffer;
+  BUFFPEK *buffpek;
+  uint maxbuffer;
+  /* The BUFFPEKs of the outputs of the groups, and where the outputs end */
+  BUFFPEK *results;
+  my_off_t *result_ends;
+  uint groups, first, step;
+  int error;
+
+  void run(THD *thd);
+};
+
+
+void Merge_task::run(THD *thd)
+{
+  for (uint group= first; group < groups && !error; group+= step)
+  {
+    BUFFPEK *Fb= buffpek + group * MERGEBUFF;
+    BUFFPEK *Tb= group == groups - 1 ? buffpek + maxbuffer :
+                                       Fb + MERGEBUFF - 1;
+    IO_CACHE cache;
+
+    if (init_io_cache(&cache, to_file->file, DISK_BUFFER_SIZE, WRITE_CACHE,
+                      Fb->file_pos, 0, MYF(0)))
+    {
+      error= 1;
+      break;
+    }
+    cache.write_function= write_at_position;
+    if (merge_runs(&param, from_file, &cache, sort_buffer, results + group,
+                   Fb, Tb, 0, stmt_thd, TRUE) ||
+        flush_at_position(&cache))
+      error= 1;
+    result_ends[group]= my_b_tell(&cache);
+    end_io_cache(&cache);
+  }
+}
+
+
+/**
+  Do one pass of merge_many_buff() with several threads
+
+  @param[out] group_count  the number of merged groups of runs, whose
+                           BUFFPEKs are stored at the start of buffpek
+
+  @retval 0  the runs of the pass are merged
+  @retval 1  an error occurred
+  @retval -1 the pass is not worth doing in parallel
+*/
+
+static int merge_pass_in_parallel(Sort_param *param, uchar *sort_buffer,
+                                  BUFFPEK *buffpek, uint maxbuffer,
+                                  IO_CACHE *from_file, IO_CACHE *to_file,
+                                  uint *group_count)
+{
+  THD *thd= current_thd;
+  Merge_task tasks[MAX_SORT_THREADS];
+  Pool_task *task_list[MAX_SORT_THREADS];
+  BUFFPEK *results;
+  my_off_t *result_ends;
+  uint groups= 1, task_count, slice_keys;
+  int error= 0;
+
+  if (param->sort_threads < 2 || param->unique_buff)
+    return -1;
+  for (uint i= 0; i <= maxbuffer - MERGEBUFF*3/2; i+= MERGEBUFF)
+    groups++;
+  task_count= MY_MIN(MY_MIN(param->sort_threads, MAX_SORT_THREADS),
+                     MY_MIN(groups, param->max_keys_per_buffer /
+                                    MIN_KEYS_PER_SORT_THREAD));
+  if (task_count < 2)
+    return -1;
+  if ((to_file->file < 0 && real_open_cached_file(to_file)) ||
+      !(results= (BUFFPEK*) my_malloc(groups * (sizeof(BUFFPEK) +
+                                                sizeof(my_off_t)),
+                                      MYF(MY_WME | MY_THREAD_SPECIFIC))))
+    return 1;
+  result_ends= (my_off_t*) (results + groups);
+
+  slice_keys= param->max_keys_per_buffer / task_count;
+  for (uint i= 0; i < task_count; i++)
+  {
+    Merge_task *task= tasks + i;
+    task->param= *param;
+    task->param.max_keys_per_buffer= slice_keys;
+    task->stmt_thd= thd;
+    task->from_file= from_file;
+    task->to_file= to_file;
+    task->sort_buffer= sort_buffer + (size_t) i * slice_keys *
+                                     param->rec_length;
+    task->buffpek= buffpek;
+    task->maxbuffer= maxbuffer;
+    task->results= results;
+    task->result_ends= result_ends;
+    task->groups= groups;
+    task->first= i;
+    task->step= task_count;
+    task->error= 0;
+    task_list[i]= task;
+  }
+  run_pool_tasks(thd, task_list, task_count);
+
+  for (uint i= 0; i < task_count; i++)
+    error|= tasks[i].error;
+  if (!error)
+  {
+    for (uint group= 0; group < groups; group++)
+    {
+      thd->inc_status_sort_merge_passes();
+      thd->query_plan_fsort_passes++;
+    }
+    memcpy(buffpek, results, groups * sizeof(BUFFPEK));
+    *group_count= groups;
+    /* Continue writing, and reading, after the output of the last group */
+    if (reinit_io_cache(to_file, WRITE_CACHE, result_ends[groups - 1], 0, 0))
+      error= 1;
+  }
+  my_free(results);
+  return error;
+}
+
+
 /** Merge buffers to make < MERGEBUFF2 buffers. */
 
 int merge_many_buff(Sort_param *param, uchar *sort_buffer,
@@ -1410,6 +1924,8 @@ int merge_many_buff(Sort_param *param, uchar *sort_buffer,
   register uint i;
   IO_CACHE t_file2,*from_file,*to_file,*temp;
   BUFFPEK *lastbuff;
+  uint groups;
+  int res;
   DBUG_ENTER("merge_many_buff");
 
   if (*maxbuffer < MERGEBUFF2)
@@ -1427,15 +1943,23 @@ int merge_many_buff(Sort_param *param, uchar *sort_buffer,
     if (reinit_io_cache(to_file,WRITE_CACHE,0L,0,0))
       goto cleanup;
     lastbuff=buffpek;
-    for (i=0 ; i <= *maxbuffer-MERGEBUFF*3/2 ; i+=MERGEBUFF)
+    if ((res= merge_pass_in_parallel(param, sort_buffer, buffpek, *maxbuffer,
+                                     from_file, to_file, &groups)) > 0)
+      break;
+    if (res == 0)
+      lastbuff+= groups;
+    else
     {
+      for (i=0 ; i <= *maxbuffer-MERGEBUFF*3/2 ; i+=MERGEBUFF)
+      {
+        if (merge_buffers(param,from_file,to_file,sort_buffer,lastbuff++,
+                          buffpek+i,buffpek+i+MERGEBUFF-1,0))
+          goto cleanup;
+      }
       if (merge_buffers(param,from_file,to_file,sort_buffer,lastbuff++,
-			buffpek+i,buffpek+i+MERGEBUFF-1,0))
-      goto cleanup;
+                        buffpek+i,buffpek+ *maxbuffer,0))
+        break;                                  /* purecov: inspected */
     }
-    if (merge_buffers(param,from_file,to_file,sort_buffer,lastbuff++,
-		      buffpek+i,buffpek+ *maxbuffer,0))
-      break;					/* purecov: inspected */
     if (flush_io_cache(to_file))
       break;					/* purecov: inspected */
     temp=from_file; from_file=to_file; to_file=temp;
@@ -1483,6 +2007,78 @@ uint read_to_buffer(IO_CACHE *fromfile, BUFFPEK *buffpek,
 } /* read_to_buffer */
 
 
+/**
+  Read packed records (see Sort_param::using_packed_records()) to buffer.
+  Only whole records are read.
+
+  @retval
+    (uint)-1 if something goes wrong
+*/
+
+static uint read_packed_to_buffer(IO_CACHE *fromfile, BUFFPEK *buffpek,
+                                  Sort_param *param)
+{
+  uchar *pos, *end;
+  uint count;
+  size_t length;
+
+  if (!buffpek->count)
+    return 0;
+  length= (size_t) MY_MIN((my_off_t) buffpek->max_keys * param->rec_length,
+                          fromfile->end_of_file - buffpek->file_pos);
+  if (mysql_file_pread(fromfile->file, (uchar*) buffpek->base, length,
+                       buffpek->file_pos, MYF_RW))
+    return((uint) -1);                          /* purecov: inspected */
+
+  for (pos= buffpek->base, end= pos + length, count= 0;
+       count < buffpek->count;
+       count++)
+  {
+    size_t left= (size_t) (end - pos);
+    if (param->using_packed_keys && left < PACKED_SORT_KEY_LENGTH_BYTES)
+      break;
+    if (param->using_packed_addons &&
+        left < param->get_sort_key_length(pos) + PACKED_ADDON_LENGTH_BYTES)
+      break;
+    uint rec_length= param->get_record_length(pos);
+    if (left < rec_length)
+      break;
+    pos+= rec_length;
+  }
+  DBUG_ASSERT(count);
+  buffpek->key= buffpek->base;
+  buffpek->file_pos+= pos - buffpek->base;
+  buffpek->count-= count;
+  buffpek->mem_count= count;
+  return (uint) (pos - buffpek->base);
+}
+
+
+static inline uint read_to_buffer(IO_CACHE *fromfile, BUFFPEK *buffpek,
+                                  Sort_param *param)
+{
+  if (param->using_packed_records())
+    return read_packed_to_buffer(fromfile, buffpek, param);
+  return read_to_buffer(fromfile, buffpek, param->rec_length);
+}
+
+
+/**
+  Write a packed record or, if 'flag' is set, the result stored in it
+*/
+
+static bool write_packed_record(Sort_param *param, IO_CACHE *to_file,
+                                uchar *rec, int flag)
+{
+  if (flag)
+  {
+    uchar *res= param->get_result(rec);
+    return my_b_write(to_file, res, param->get_result_length(res));
+  }
+  return my_b_write(to_file, rec, param->get_record_length(rec));
+}
+
+
 /**
   Put all room used by freed buffer to use in adjacent buffer.
 
@@ -1540,6 +2136,28 @@ int merge_buffers(Sort_param *param, IO_CACHE *from_file,
                   IO_CACHE *to_file, uchar *sort_buffer,
                   BUFFPEK *lastbuff, BUFFPEK *Fb, BUFFPEK *Tb,
                   int flag)
+{
+  THD* const thd=current_thd;
+
+  thd->inc_status_sort_merge_passes();
+  thd->query_plan_fsort_passes++;
+  return merge_runs(param, from_file, to_file, sort_buffer, lastbuff, Fb, Tb,
+                    flag, thd, FALSE);
+} /* merge_buffers */
+
+
+/**
+  Merge buffers to one buffer, see merge_buffers()
+
+  @param thd      the statement, checked for being killed
+  @param in_task  TRUE <=> called by a thread other than the statement's,
+                  see Merge_task
+*/
+
+static int merge_runs(Sort_param *param, IO_CACHE *from_file,
+                      IO_CACHE *to_file, uchar *sort_buffer,
+                      BUFFPEK *lastbuff, BUFFPEK *Fb, BUFFPEK *Tb,
+                      int flag, THD *thd, bool in_task)
 {
   int error;
   uint rec_length,res_length,offset;
@@ -1556,11 +2174,7 @@ int merge_buffers(Sort_param *param, IO_CACHE *from_file,
   uchar *src;
   uchar *unique_buff= param->unique_buff;
   const bool killable= !param->not_killable;
-  THD* const thd=current_thd;
-  DBUG_ENTER("merge_buffers");
-
-  thd->inc_status_sort_merge_passes();
-  thd->query_plan_fsort_passes++;
+  DBUG_ENTER("merge_runs");
 
   error=0;
   rec_length= param->rec_length;
@@ -1585,6 +2199,11 @@ int merge_buffers(Sort_param *param, IO_CACHE *from_file,
     cmp= param->compare;
     first_cmp_arg= (void *) &param->cmp_context;
   }
+  else if (param->using_packed_keys)
+  {
+    cmp= (qsort2_cmp) cmp_packed_sort_keys;
+    first_cmp_arg= (void*) param;
+  }
   else
   {
     cmp= get_ptr_compare(sort_length);
@@ -1597,12 +2216,17 @@ int merge_buffers(Sort_param *param, IO_CACHE *from_file,
   {
     buffpek->base= strpos;
     buffpek->max_keys= maxcount;
-    strpos+=
-      (uint) (error= (int) read_to_buffer(from_file, buffpek, rec_length));
+    error= (int) read_to_buffer(from_file, buffpek, param);
 
     if (error == -1)
       goto err;					/* purecov: inspected */
-    buffpek->max_keys= buffpek->mem_count;	// If less data in buffers than expected
+    if (param->using_packed_records())
+      strpos+= maxcount * rec_length;           // The records may be longer
+    else
+    {
+      strpos+= (uint) error;
+      buffpek->max_keys= buffpek->mem_count;	// If less data in buffers than expected
+    }
     queue_insert(&queue, (uchar*) buffpek);
   }
 
@@ -1637,7 +2261,9 @@ int merge_buffers(Sort_param *param, IO_CACHE *from_file,
 
   while (queue.elements > 1)
   {
-    if (killable && thd->check_killed())
+    /* Only the statement's own thread may serve its APC requests */
+    if (killable && (in_task ? thd->killed != NOT_KILLED :
+                               thd->check_killed()))
     {
       error= 1; goto err;                        /* purecov: inspected */
     }
@@ -1676,7 +2302,9 @@ int merge_buffers(Sort_param *param, IO_CACHE *from_file,
       */          
       if (!check_dupl_count || dupl_count >= min_dupl_count)
       {
-        if (my_b_write(to_file, src+wr_offset, wr_len))
+        if (param->using_packed_records() ?
+            write_packed_record(param, to_file, src, flag) :
+            my_b_write(to_file, src+wr_offset, wr_len))
         {
           error=1; goto err;                        /* purecov: inspected */
         }
@@ -1695,11 +2323,11 @@ int merge_buffers(Sort_param *param, IO_CACHE *from_file,
       }
 
     skip_duplicate:
-      buffpek->key+= rec_length;
+      buffpek->key+= (param->using_packed_records() ?
+                      param->get_record_length(buffpek->key) : rec_length);
       if (! --buffpek->mem_count)
       {
-        if (!(error= (int) read_to_buffer(from_file, buffpek,
-                                          rec_length)))
+        if (!(error= (int) read_to_buffer(from_file, buffpek, param)))
         {
           (void) queue_remove_top(&queue);
           reuse_freed_buff(&queue, buffpek, rec_length);
@@ -1760,7 +2388,19 @@ int merge_buffers(Sort_param *param, IO_CACHE *from_file,
       buffpek->count= 0;                        /* Don't read more */
     }
     max_rows-= buffpek->mem_count;
-    if (flag == 0)
+    if (param->using_packed_records())
+    {
+      src= buffpek->key;
+      for (uint count= buffpek->mem_count; count; count--)
+      {
+        if (write_packed_record(param, to_file, src, flag))
+        {
+          error=1; goto err;                        /* purecov: inspected */
+        }
+        src+= param->get_record_length(src);
+      }
+    }
+    else if (flag == 0)
     {
       if (my_b_write(to_file, (uchar*) buffpek->key,
                      (rec_length*buffpek->mem_count)))
@@ -1789,7 +2429,7 @@ int merge_buffers(Sort_param *param, IO_CACHE *from_file,
       }
     }
   }
-  while ((error=(int) read_to_buffer(from_file, buffpek, rec_length))
+  while ((error=(int) read_to_buffer(from_file, buffpek, param))
          != -1 && error != 0);
 
 end:
@@ -1798,7 +2438,7 @@ end:
 err:
   delete_queue(&queue);
   DBUG_RETURN(error);
-} /* merge_buffers */
+} /* merge_runs */
 
 
 	/* Do a merge to output-file (save only positions) */
@@ -1859,6 +2499,8 @@ sortlength(THD *thd, SORT_FIELD *sortorder, uint s_length,
   {
     sortorder->need_strxnfrm= 0;
     sortorder->suffix_length= 0;
+    sortorder->length_bytes= 0;
+    sortorder->pad= 0;
     if (sortorder->field)
     {
       cs= sortorder->field->sort_charset();
@@ -2062,6 +2704,34 @@ unpack_addon_fields(struct st_sort_addon_field *addon_field, uchar *buff,
   }
 }
 
+
+/**
+  Copy packed values of fields from a buffer into the table records.
+  The buffer starts with its length, then the null bit indicators and
+  the packed values of the fields that are not NULL follow.
+*/
+
+static void
+unpack_packed_addon_fields(struct st_sort_addon_field *addon_field,
+                           uchar *buff, uchar *buff_end)
+{
+  Field *field;
+  SORT_ADDON_FIELD *addonf= addon_field;
+  uchar *nulls= buff + PACKED_ADDON_LENGTH_BYTES;
+  const uchar *from= nulls + addonf->offset;
+
+  for ( ; (field= addonf->field) ; addonf++)
+  {
+    if (addonf->null_bit && (addonf->null_bit & nulls[addonf->null_offset]))
+    {
+      field->set_null();
+      continue;
+    }
+    field->set_notnull();
+    from= field->unpack(field->ptr, from, buff_end, 0);
+  }
+}
+
 /*
 ** functions to change a double or float to a sortable string
 ** The following should work for IEEE
@@ -18,6 +18,8 @@
 #include "sql_sort.h"
 #include "table.h"
 #include "my_sys.h"
+#include "sql_class.h"                          // current_thd
+#include "sql_task_pool.h"
 
 
 namespace {
@@ -123,12 +125,180 @@ void Filesort_buffer::free_sort_buffer()
 }
 
 
+namespace {
+void sort_keys(uchar **keys, uint count, size_t sort_length, uchar **buffer,
+               const Sort_param *packed_param)
+{
+  if (packed_param)
+    my_qsort2(keys, count, sizeof(uchar*), (qsort2_cmp) cmp_packed_sort_keys,
+              (void*) packed_param);
+  else if (radixsort_is_appliccable(count, sort_length))
+    radixsort_for_str_ptr(keys, count, sort_length, buffer);
+  else
+    msd_radixsort_for_str_ptr(keys, count, sort_length);
+}
+
+
+/**
+  A part of the sort buffer that is sorted, or two sorted parts that are
+  merged, by one thread. See sort_keys_in_parallel().
+*/
+class Sort_task :public Pool_task
+{
+public:
+  uchar **keys;
+  uint count;
+  /* The second sorted part to merge, NULL if the keys are to be sorted */
+  uchar **keys2;
+  uint count2;
+  /*
+    count + count2 pointers: the result of the merge, or the scratch space
+    of the radix sort
+  */
+  uchar **to;
+  size_t sort_length;
+  /* The sort parameters if the keys are packed, otherwise NULL */
+  const Sort_param *packed_param;
+
+  void merge_keys();
+  void run(THD *thd)
+  {
+    if (keys2)
+      merge_keys();
+    else
+      sort_keys(keys, count, sort_length, to, packed_param);
+  }
+};
+
+
+void Sort_task::merge_keys()
+{
+  uchar **from1= keys, **end1= from1 + count;
+  uchar **from2= keys2, **end2= from2 + count2;
+  uchar **to_pos= to;
+
+  if (packed_param)
+  {
+    while (from1 != end1 && from2 != end2)
+      *to_pos++= cmp_packed_sort_keys(packed_param, from1, from2) <= 0 ?
+                 *from1++ : *from2++;
+  }
+  else
+  {
+    while (from1 != end1 && from2 != end2)
+      *to_pos++= memcmp(*from1, *from2, sort_length) <= 0 ? *from1++ :
+                                                           *from2++;
+  }
+  if (from1 != end1)
+    memcpy(to_pos, from1, (end1 - from1) * sizeof(uchar*));
+  else
+    memcpy(to_pos, from2, (end2 - from2) * sizeof(uchar*));
+}
+
+
+/**
+  Run the tasks: the first one in this thread, and the other ones in the
+  threads of the task pool.
+*/
+void run_sort_tasks(Sort_task *tasks, uint count)
+{
+  Pool_task *task_list[MAX_SORT_THREADS];
+  for (uint i= 0; i < count; i++)
+    task_list[i]= tasks + i;
+  run_pool_tasks(current_thd, task_list, count);
+}
+
+
+/**
+  Sort the keys with several threads
+
+  The keys are split into parts which are sorted by separate threads. The
+  sorted parts are then merged pairwise, all pairs at the same time, until
+  one part is left.
+
+  @retval TRUE   the keys are sorted
+  @retval FALSE  the keys could not be sorted in parallel
+*/
+bool sort_keys_in_parallel(uchar **keys, uint count, size_t sort_length,
+                           const Sort_param *packed_param, uint max_threads)
+{
+  Sort_task tasks[MAX_SORT_THREADS];
+  uint bounds[MAX_SORT_THREADS + 1];
+  uint parts= MY_MIN(MY_MIN(max_threads, MAX_SORT_THREADS),
+                     count / MIN_KEYS_PER_SORT_THREAD);
+  uchar **buffer, **from, **to;
+
+  if (parts < 2 ||
+      !(buffer= (uchar**) my_malloc(count * sizeof(uchar*),
+                                    MYF(MY_THREAD_SPECIFIC))))
+    return FALSE;
+
+  for (uint i= 0; i <= parts; i++)
+    bounds[i]= (uint) ((ulonglong) count * i / parts);
+  for (uint i= 0; i < parts; i++)
+  {
+    Sort_task *task= tasks + i;
+    task->keys= keys + bounds[i];
+    task->count= bounds[i + 1] - bounds[i];
+    task->keys2= NULL;
+    task->count2= 0;
+    task->to= buffer + bounds[i];
+    task->sort_length= sort_length;
+    task->packed_param= packed_param;
+  }
+  run_sort_tasks(tasks, parts);
+
+  from= keys;
+  to= buffer;
+  while (parts > 1)
+  {
+    uint pairs= parts / 2;
+    for (uint i= 0; i < pairs; i++)
+    {
+      Sort_task *task= tasks + i;
+      task->keys= from + bounds[2*i];
+      task->count= bounds[2*i + 1] - bounds[2*i];
+      task->keys2= from + bounds[2*i + 1];
+      task->count2= bounds[2*i + 2] - bounds[2*i + 1];
+      task->to= to + bounds[2*i];
+    }
+    if (parts % 2)
+      memcpy(to + bounds[parts - 1], from + bounds[parts - 1],
+             (count - bounds[parts - 1]) * sizeof(uchar*));
+    run_sort_tasks(tasks, pairs);
+
+    for (uint i= 0; i < parts; i+= 2)
+      bounds[i / 2]= bounds[i];
+    parts= (parts + 1) / 2;
+    bounds[parts]= count;
+    swap_variables(uchar**, from, to);
+  }
+  if (from != keys)
+    memcpy(keys, from, count * sizeof(uchar*));
+  my_free(buffer);
+  return TRUE;
+}
+}
+
+
 void Filesort_buffer::sort_buffer(const Sort_param *param, uint count)
 {
   if (count <= 1)
     return;
   uchar **keys= get_sort_keys();
   uchar **buffer= NULL;
+  const Sort_param *packed_param= param->using_packed_keys ? param : NULL;
+  if (param->sort_threads > 1 &&
+      sort_keys_in_parallel(keys, count, param->sort_length, packed_param,
+                            param->sort_threads))
+    return;
+  if (packed_param)
+  {
+    /* The parts of the packed keys are not at fixed offsets */
+    my_qsort2(keys, count, sizeof(uchar*), (qsort2_cmp) cmp_packed_sort_keys,
+              (void*) packed_param);
+    return;
+  }
   if (radixsort_is_appliccable(count, param->sort_length) &&
       (buffer= (uchar**) my_malloc(count*sizeof(char*),
                                    MYF(MY_THREAD_SPECIFIC))))
@@ -137,7 +307,10 @@ void Filesort_buffer::sort_buffer(const Sort_param *param, uint count)
     my_free(buffer);
     return;
   }
-  
-  size_t size= param->sort_length;
-  my_qsort2(keys, count, sizeof(uchar*), get_ptr_compare(size), &size);
+
+  /*
+    The keys are compared with memcmp(), so they can be sorted by their
+    bytes. The radix sort falls back to qsort for small partitions.
+  */
+  msd_radixsort_for_str_ptr(keys, count, param->sort_length);
 }
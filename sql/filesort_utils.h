@@ -74,6 +74,25 @@ public:
     return m_idx_array[idx];
   }
 
+  /**
+    Initializes a record pointer for a packed record of the given length.
+    As the lengths of packed records differ, their number is not known in
+    advance: the pointers are stored from the start of the buffer and the
+    records from its end backwards, until the two meet.
+
+    @return NULL if the record does not fit in the buffer
+  */
+  uchar *get_packed_record_buffer(uint idx, uint length)
+  {
+    uchar **keys= m_idx_array.array();
+    uchar *end= (idx ? keys[idx - 1] :
+                 m_start_of_data + m_idx_array.size() * m_record_length);
+    if (end - reinterpret_cast<uchar*>(keys + idx + 1) < (ptrdiff_t) length)
+      return NULL;
+    keys[idx]= end - length;
+    return keys[idx];
+  }
+
   /// Initializes all the record pointers.
   void init_record_pointers()
   {
@@ -256,6 +256,14 @@ enum enum_alter_inplace_result {
  */
 #define HA_CAN_EXPORT                 (1LL << 45)
 
+/*
+  Clones of the handler (see handler::clone()) can read the table
+  concurrently from different threads while the original handler holds
+  a read lock on it. This is what the parallel scan needs (see
+  sql_parallel_scan.cc).
+*/
+#define HA_CAN_PARALLEL_SCAN          (1LL << 46)
+
 
 /*
   Set of all binlog flags. Currently only contain the capabilities
@@ -1564,6 +1572,7 @@ typedef struct {
 
 #define UNDEF_NODEGROUP 65535
 class Item;
+class Exec_time_tracker;
 struct st_table_log_memory_entry;
 
 class partition_info;
@@ -2526,6 +2535,12 @@ public:
   */
   PSI_table *m_psi;
 
+  /*
+    Time spent in the calls that read rows of the table, collected by
+    ANALYZE statements. NULL when the statement is not analyzed.
+  */
+  Exec_time_tracker *tracker;
+
   virtual void unbind_psi();
   virtual void rebind_psi();
 
@@ -2556,7 +2571,7 @@ public:
     pushed_idx_cond(NULL),
     pushed_idx_cond_keyno(MAX_KEY),
     auto_inc_intervals_count(0),
-    m_psi(NULL), m_lock_type(F_UNLCK), ha_share(NULL)
+    m_psi(NULL), tracker(NULL), m_lock_type(F_UNLCK), ha_share(NULL)
   {
     DBUG_PRINT("info",
                ("handler created F_UNLCK %d F_RDLCK %d F_WRLCK %d",
@@ -602,7 +602,7 @@ public:
              PARAM_ITEM, TRIGGER_FIELD_ITEM, DECIMAL_ITEM,
              XPATH_NODESET, XPATH_NODESET_CMP,
              VIEW_FIXER_ITEM, EXPR_CACHE_ITEM,
-             DATE_ITEM};
+             DATE_ITEM, FIELD_APPROX_COUNT_DISTINCT_ITEM};
 
   enum cond_result { COND_UNDEF,COND_OK,COND_TRUE,COND_FALSE };
 
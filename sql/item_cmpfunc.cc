@@ -32,6 +32,7 @@
 #include "sql_parse.h"                          // check_stack_overrun
 #include "sql_time.h"                  // make_truncated_value_warning
 #include "sql_base.h"                  // dynamic_column_error_message
+#include <my_bit.h>                    // my_round_up_to_next_power
 
 static Item_result item_store_type(Item_result a, Item *item,
                                    my_bool unsigned_flag)
@@ -3488,12 +3489,60 @@ static int cmp_decimal(void *cmp_arg, my_decimal *a, my_decimal *b)
 }
 
 
+/*
+  Build the hash table of the values, if the vector has a hash function
+  and the list is long enough for the lookup to be cheaper than a binary
+  search. Must be called after sort(). If there is no memory for the
+  table, the values are searched for in the sorted vector.
+*/
+
+void in_vector::create_hash()
+{
+  if (!hash_func || used_count < IN_VECTOR_HASH_MIN_ELEMENTS)
+    return;
+
+  /* At most half of the slots are used */
+  uint hash_size= my_round_up_to_next_power(used_count * 2);
+  if (!(hash_table= (uint*) sql_calloc(hash_size * sizeof(uint))))
+    return;
+  hash_mask= hash_size - 1;
+
+  for (uint i= 0; i < used_count; i++)
+  {
+    /* Equal values are next to each other after sort() */
+    if (i && !compare_elems(i, i - 1))
+      continue;
+    uint idx= (uint) hash_func(collation, (uchar*) base + i * size) & hash_mask;
+    while (hash_table[idx])
+      idx= (idx + 1) & hash_mask;
+    hash_table[idx]= i + 1;
+  }
+}
+
+
+int in_vector::find_in_hash(const uchar *value)
+{
+  for (uint idx= (uint) hash_func(collation, value) & hash_mask;
+       hash_table[idx];
+       idx= (idx + 1) & hash_mask)
+  {
+    if (!(*compare)(collation, base + (hash_table[idx] - 1) * size,
+                    (void*) value))
+      return 1;
+  }
+  return 0;
+}
+
+
 int in_vector::find(Item *item)
 {
   uchar *result=get_value(item);
   if (!result || !used_count)
     return 0;				// Null value
 
+  if (hash_table)
+    return find_in_hash(result);
+
   uint start,end;
   start=0; end=used_count-1;
   while (start != end)
@@ -3510,10 +3559,32 @@ int in_vector::find(Item *item)
   return (int) ((*compare)(collation, base+start*size, result) == 0);
 }
 
+/*
+  Hash of a string in a binary collation. The collations that ignore
+  trailing spaces ignore them in the hash as well.
+*/
+
+static ulong hash_string_bin(CHARSET_INFO *cs, const uchar *value)
+{
+  const String *str= (const String*) value;
+  ulong nr1= 1, nr2= 4;
+  cs->coll->hash_sort(cs, (const uchar*) str->ptr(), str->length(),
+                      &nr1, &nr2);
+  return nr1;
+}
+
+
 in_string::in_string(uint elements,qsort2_cmp cmp_func, CHARSET_INFO *cs)
   :in_vector(elements, sizeof(String), cmp_func, cs),
    tmp(buff, sizeof(buff), &my_charset_bin)
-{}
+{
+  /*
+    In other collations the hash costs about as much as the comparisons
+    of a binary search
+  */
+  if (cs->state & MY_CS_BINSORT)
+    hash_func= hash_string_bin;
+}
 
 in_string::~in_string()
 {
@@ -3588,9 +3659,24 @@ void in_row::set(uint pos, Item *item)
   DBUG_VOID_RETURN;
 }
 
+/*
+  Hash of an integer or a packed temporal value. Values that cmp_longlong()
+  finds equal have the same val, the sign is not hashed.
+*/
+
+ulong hash_longlong(CHARSET_INFO *cs, const uchar *value)
+{
+  ulonglong val= (ulonglong) ((in_longlong::packed_longlong*) value)->val;
+  /* Fibonacci hashing, the high bits are mixed from all the bits of val */
+  return (ulong) ((val * 0x9E3779B97F4A7C15ULL) >> 32);
+}
+
+
 in_longlong::in_longlong(uint elements)
   :in_vector(elements,sizeof(packed_longlong),(qsort2_cmp) cmp_longlong, 0)
-{}
+{
+  hash_func= hash_longlong;
+}
 
 void in_longlong::set(uint pos,Item *item)
 {
@@ -4126,7 +4212,10 @@ void Item_func_in::fix_length_and_dec()
           have_null= 1;
       }
       if ((array->used_count= j))
-	array->sort();
+      {
+        array->sort();
+        array->create_hash();
+      }
     }
   }
   else
@@ -825,10 +825,19 @@ public:
 /* Functions to handle the optimized IN */
 
 
+/*
+  The smallest number of values of an IN list that are looked up in a hash
+  table rather than by a binary search in the sorted vector
+*/
+#define IN_VECTOR_HASH_MIN_ELEMENTS 16
+
+typedef ulong (*in_hash_func)(CHARSET_INFO *cs, const uchar *value);
+
 /* A vector of values of some type  */
 
 class in_vector :public Sql_alloc
 {
+  int find_in_hash(const uchar *value);
 public:
   char *base;
   uint size;
@@ -836,12 +845,20 @@ public:
   CHARSET_INFO *collation;
   uint count;
   uint used_count;
-  in_vector() {}
+  /*
+    Hash of the values, if the vector has one. Values that compare equal
+    must have the same hash, otherwise hash_func is NULL.
+  */
+  in_hash_func hash_func;
+  /* Positions of the values plus one, 0 is an empty slot */
+  uint *hash_table;
+  uint hash_mask;
+  in_vector() :hash_func(0), hash_table(0) {}
   in_vector(uint elements,uint element_length,qsort2_cmp cmp_func, 
   	    CHARSET_INFO *cmp_coll)
     :base((char*) sql_calloc(elements*element_length)),
      size(element_length), compare(cmp_func), collation(cmp_coll),
-     count(elements), used_count(elements) {}
+     count(elements), used_count(elements), hash_func(0), hash_table(0) {}
   virtual ~in_vector() {}
   virtual void set(uint pos,Item *item)=0;
   virtual uchar *get_value(Item *item)=0;
@@ -849,6 +866,7 @@ public:
   {
     my_qsort2(base,used_count,size,compare,(void*)collation);
   }
+  void create_hash();
   int find(Item *item);
   
   /* 
@@ -936,6 +954,7 @@ public:
   Item_result result_type() { return INT_RESULT; }
 
   friend int cmp_longlong(void *cmp_arg, packed_longlong *a,packed_longlong *b);
+  friend ulong hash_longlong(CHARSET_INFO *cs, const uchar *value);
 };
 
 
@@ -895,8 +895,12 @@ bool Aggregator_distinct::setup(THD *thd)
         }
       }
       DBUG_ASSERT(tree == 0);
+      /*
+        Keys that are compared as bytes can be deduplicated by hashing;
+        they are sorted only if they do not fit in memory.
+      */
       tree= new Unique(compare_key, cmp_arg, tree_key_length,
-                       item_sum->ram_limitation(thd));
+                       item_sum->ram_limitation(thd), 0, all_binary);
       /*
         The only time tree_key_length could be 0 is if someone does
         count(distinct) on a char(0) field - stupid thing to do,
@@ -963,9 +967,12 @@ bool Aggregator_distinct::setup(THD *thd)
       in.  Then the tree is dumped to the temporary file. We can use
       simple_raw_key_cmp because the table contains numbers only; decimals
       are converted to binary representation as well.
+      The values can be hashed as well, except doubles: their sum depends
+      on the order they are added in, which the hash table would change.
     */
     tree= new Unique(simple_raw_key_cmp, &tree_key_length, tree_key_length,
-                     item_sum->ram_limitation(thd));
+                     item_sum->ram_limitation(thd), 0,
+                     table->field[0]->result_type() != REAL_RESULT);
 
     DBUG_RETURN(tree == 0);
   }
@@ -1436,6 +1443,32 @@ bool Item_sum_sum::add()
 }
 
 
+/**
+  Add a sum of non-NULL values computed elsewhere
+
+  @param partial_dec   the sum, if the function accumulates decimals
+  @param partial_sum   the sum, if the function accumulates doubles
+
+  @details
+  The function is used to merge the partial sums computed by the workers
+  of a parallel scan (see Parallel_scan). It must be called only for
+  partial sums of at least one non-NULL value.
+*/
+
+void Item_sum_sum::add_partial_sum(my_decimal *partial_dec, double partial_sum)
+{
+  if (hybrid_type == DECIMAL_RESULT)
+  {
+    my_decimal_add(E_DEC_FATAL_ERROR, dec_buffs + (curr_dec_buff^1),
+                   partial_dec, dec_buffs + curr_dec_buff);
+    curr_dec_buff^= 1;
+  }
+  else
+    sum+= partial_sum;
+  null_value= 0;
+}
+
+
 longlong Item_sum_sum::val_int()
 {
   DBUG_ASSERT(fixed == 1);
@@ -2216,6 +2249,340 @@ bool Item_sum_and::add()
   return 0;
 }
 
+
+/* approx_count_distinct */
+
+/* The finalizer of MurmurHash3, spreads every bit of the key over the hash */
+
+static inline ulonglong hll_mix(ulonglong key)
+{
+  key^= key >> 33;
+  key*= 0xff51afd7ed558ccdULL;
+  key^= key >> 33;
+  key*= 0xc4ceb9fe1a85ec53ULL;
+  key^= key >> 33;
+  return key;
+}
+
+
+/*
+  Hash a string so that strings equal in its collation get the same hash.
+  hash_sort() mixes its state poorly, so the states from two different
+  initial values are combined to avoid collisions of long strings.
+*/
+
+static ulonglong hll_hash_string(CHARSET_INFO *cs, const uchar *str,
+                                 size_t length)
+{
+  ulong nr1= 1, nr2= 4, nr3= (ulong) 0x9E3779B97F4A7C15ULL, nr4= 1;
+  cs->coll->hash_sort(cs, str, length, &nr1, &nr2);
+  cs->coll->hash_sort(cs, str, length, &nr3, &nr4);
+  return hll_mix((ulonglong) nr1 ^ hll_mix((ulonglong) nr3));
+}
+
+
+static ulonglong hll_hash_real(double nr)
+{
+  ulonglong bits;
+  if (nr == 0.0)
+    nr= 0.0;                                    /* -0.0 is equal to 0.0 */
+  memcpy(&bits, &nr, sizeof(bits));
+  return hll_mix(bits);
+}
+
+
+/* Hash a decimal so that 1.0 and 1.00 get the same hash */
+
+static ulonglong hll_hash_decimal(my_decimal *dec)
+{
+  uchar buff[DECIMAL_MAX_FIELD_SIZE];
+  int frac= decimal_actual_fraction(dec);
+  int precision= MY_MAX(my_decimal_intg(dec) + frac, 1);
+  my_decimal2binary(E_DEC_FATAL_ERROR, dec, buff, precision, frac);
+  return hll_hash_string(&my_charset_bin, buff,
+                         my_decimal_get_binary_size(precision, frac));
+}
+
+
+/**
+  Hash the value of an expression
+
+  @param       item  the expression
+  @param[out]  hash  the hash of the value
+
+  @retval FALSE  the value is hashed
+  @retval TRUE   the value is NULL
+*/
+
+bool Item_sum_approx_count_distinct::hash_item(Item *item, ulonglong *hash)
+{
+  switch (item->cmp_type()) {
+  case INT_RESULT:
+  {
+    longlong nr= item->val_int();
+    *hash= hll_mix((ulonglong) nr);
+    break;
+  }
+  case REAL_RESULT:
+  {
+    double nr= item->val_real();
+    *hash= hll_hash_real(nr);
+    break;
+  }
+  case DECIMAL_RESULT:
+  {
+    my_decimal value, *dec= item->val_decimal(&value);
+    if (!dec)
+      return TRUE;
+    *hash= hll_hash_decimal(dec);
+    break;
+  }
+  case TIME_RESULT:
+  {
+    MYSQL_TIME ltime;
+    if (item->get_date(&ltime, TIME_INVALID_DATES))
+      return TRUE;
+    *hash= hll_mix((ulonglong) pack_time(&ltime));
+    break;
+  }
+  case STRING_RESULT:
+  {
+    StringBuffer<MAX_FIELD_WIDTH> buff;
+    String *res= item->val_str(&buff);
+    if (!res)
+      return TRUE;
+    *hash= hll_hash_string(res->charset(), (const uchar *) res->ptr(),
+                           res->length());
+    break;
+  }
+  case ROW_RESULT:
+  case IMPOSSIBLE_RESULT:
+    DBUG_ASSERT(0);
+    return TRUE;
+  }
+  return item->null_value;
+}
+
+
+/**
+  Hash the value of a field that is not NULL
+
+  The hash is the same as the one of an Item_field of the field.
+*/
+
+bool Item_sum_approx_count_distinct::hash_field(Field *field, ulonglong *hash)
+{
+  switch (field->cmp_type()) {
+  case INT_RESULT:
+    *hash= hll_mix((ulonglong) field->val_int());
+    break;
+  case REAL_RESULT:
+    *hash= hll_hash_real(field->val_real());
+    break;
+  case DECIMAL_RESULT:
+  {
+    my_decimal value;
+    *hash= hll_hash_decimal(field->val_decimal(&value));
+    break;
+  }
+  case TIME_RESULT:
+  {
+    MYSQL_TIME ltime;
+    if (field->get_date(&ltime, TIME_INVALID_DATES))
+      return TRUE;
+    *hash= hll_mix((ulonglong) pack_time(&ltime));
+    break;
+  }
+  case STRING_RESULT:
+  {
+    StringBuffer<MAX_FIELD_WIDTH> buff;
+    String *res= field->val_str(&buff);
+    *hash= hll_hash_string(res->charset(), (const uchar *) res->ptr(),
+                           res->length());
+    break;
+  }
+  case ROW_RESULT:
+  case IMPOSSIBLE_RESULT:
+    DBUG_ASSERT(0);
+    return TRUE;
+  }
+  return FALSE;
+}
+
+
+/* Add a hash to a sketch */
+
+void Item_sum_approx_count_distinct::add_hash(uchar *sketch, ulonglong hash)
+{
+  uint reg= (uint) (hash >> (64 - HLL_PRECISION));
+  /* The guard bit stops the loop after 64 - HLL_PRECISION zero bits */
+  ulonglong rest= (hash << HLL_PRECISION) | (1ULL << (HLL_PRECISION - 1));
+  uchar rank= 1;
+  for (; !(rest & (1ULL << 63)); rest<<= 1)
+    rank++;
+  if (rank > sketch[reg])
+    sketch[reg]= rank;
+}
+
+
+static double hll_sigma(double x)
+{
+  double y= 1.0, z= x, prev_z;
+  if (x == 1.0)
+    return HUGE_VAL;
+  do
+  {
+    x*= x;
+    prev_z= z;
+    z+= x * y;
+    y+= y;
+  } while (z != prev_z);
+  return z;
+}
+
+
+static double hll_tau(double x)
+{
+  double y= 1.0, z= 1.0 - x, prev_z;
+  if (x == 0.0 || x == 1.0)
+    return 0.0;
+  do
+  {
+    x= sqrt(x);
+    prev_z= z;
+    y*= 0.5;
+    z-= (1.0 - x) * (1.0 - x) * y;
+  } while (z != prev_z);
+  return z / 3;
+}
+
+
+/**
+  Estimate the number of distinct values added to a sketch
+
+  The estimator of O. Ertl, "New cardinality estimation algorithms for
+  HyperLogLog sketches" (2017) uses the histogram of the register values.
+  Unlike the original estimator it needs no corrections for small and
+  large cardinalities.
+*/
+
+longlong Item_sum_approx_count_distinct::estimate(const uchar *sketch)
+{
+  uint counts[HLL_MAX_RANK + 1];
+  double m= (double) HLL_REGISTERS, z;
+
+  bzero(counts, sizeof(counts));
+  for (uint i= 0; i < HLL_REGISTERS; i++)
+    counts[sketch[i]]++;
+
+  z= m * hll_tau(1.0 - counts[HLL_MAX_RANK] / m);
+  for (int k= HLL_MAX_RANK - 1; k >= 1; k--)
+    z= 0.5 * (z + counts[k]);
+  z+= m * hll_sigma(counts[0] / m);
+  /* An empty sketch gives an infinite z */
+  return (longlong) rint(m * m / (2 * M_LN2 * z));
+}
+
+
+Item *Item_sum_approx_count_distinct::copy_or_same(THD* thd)
+{
+  return new (thd->mem_root) Item_sum_approx_count_distinct(thd, this);
+}
+
+
+bool Item_sum_approx_count_distinct::setup(THD *thd)
+{
+  /* setup() can be called twice for ROLLUP items */
+  if (!registers && !(registers= (uchar *) thd->calloc(HLL_REGISTERS)))
+    return TRUE;
+  return FALSE;
+}
+
+
+void Item_sum_approx_count_distinct::clear()
+{
+  /* The function is not set up when the result has no rows */
+  if (registers)
+    bzero(registers, HLL_REGISTERS);
+}
+
+
+bool Item_sum_approx_count_distinct::add()
+{
+  ulonglong hash;
+  if (!hash_item(args[0], &hash))
+    add_hash(registers, hash);
+  return 0;
+}
+
+
+void Item_sum_approx_count_distinct::merge_sketch(const uchar *sketch)
+{
+  for (uint i= 0; i < HLL_REGISTERS; i++)
+    set_if_bigger(registers[i], sketch[i]);
+}
+
+
+longlong Item_sum_approx_count_distinct::val_int()
+{
+  DBUG_ASSERT(fixed == 1);
+  return registers ? estimate(registers) : 0;
+}
+
+
+/**
+  The temporary table of GROUP BY stores the sketch of the group, other
+  temporary tables store the estimate.
+*/
+
+Field *Item_sum_approx_count_distinct::create_tmp_field(bool group,
+                                                        TABLE *table,
+                                                        uint convert_blob_len)
+{
+  Field *field;
+  if (!group)
+    return Item_sum::create_tmp_field(group, table, convert_blob_len);
+
+  field= new Field_string(HLL_REGISTERS, 0, name, &my_charset_bin);
+  if (field != NULL)
+    field->init(table);
+  return field;
+}
+
+
+void Item_sum_approx_count_distinct::reset_field()
+{
+  bzero(result_field->ptr, HLL_REGISTERS);
+  update_field();
+}
+
+
+void Item_sum_approx_count_distinct::update_field()
+{
+  ulonglong hash;
+  if (!hash_item(args[0], &hash))
+    add_hash(result_field->ptr, hash);
+}
+
+
+Item_approx_count_distinct_field::Item_approx_count_distinct_field(
+  Item_sum_approx_count_distinct *item)
+{
+  name= item->name;
+  decimals= 0;
+  max_length= item->max_length;
+  unsigned_flag= item->unsigned_flag;
+  field= item->result_field;
+  maybe_null= 0;
+}
+
+
+longlong Item_approx_count_distinct_field::val_int()
+{
+  // fix_fields() never calls for this Item
+  return Item_sum_approx_count_distinct::estimate(field->ptr);
+}
+
 /************************************************************************
 ** reset result of a Item_sum with is saved in a tmp_table
 *************************************************************************/
@@ -341,7 +341,8 @@ public:
   enum Sumfunctype
   { COUNT_FUNC, COUNT_DISTINCT_FUNC, SUM_FUNC, SUM_DISTINCT_FUNC, AVG_FUNC,
     AVG_DISTINCT_FUNC, MIN_FUNC, MAX_FUNC, STD_FUNC,
-    VARIANCE_FUNC, SUM_BIT_FUNC, UDF_SUM_FUNC, GROUP_CONCAT_FUNC
+    VARIANCE_FUNC, SUM_BIT_FUNC, UDF_SUM_FUNC, GROUP_CONCAT_FUNC,
+    APPROX_COUNT_DISTINCT_FUNC
   };
 
   Item **ref_by; /* pointer to a ref to the object used to register it */
@@ -742,6 +743,7 @@ public:
   }
   void clear();
   bool add();
+  void add_partial_sum(my_decimal *partial_dec, double partial_sum);
   double val_real();
   longlong val_int();
   String *val_str(String*str);
@@ -799,6 +801,8 @@ class Item_sum_count :public Item_sum_int
     count=count_arg;
     Item_sum::make_const();
   }
+  /* Add rows counted elsewhere, e.g. by a worker of a parallel scan */
+  void add_count(longlong count_arg) { count+= count_arg; }
   longlong val_int();
   void reset_field();
   void update_field();
@@ -864,6 +868,12 @@ public:
   }
   void clear();
   bool add();
+  void add_partial_sum(my_decimal *partial_dec, double partial_sum,
+                       ulonglong partial_count)
+  {
+    Item_sum_sum::add_partial_sum(partial_dec, partial_sum);
+    count+= partial_count;
+  }
   double val_real();
   // In SPs we might force the "wrong" type with select into a declare variable
   longlong val_int() { return (longlong) rint(val_real()); }
@@ -1154,6 +1164,97 @@ class Item_sum_xor :public Item_sum_bit
 };
 
 
+/* Number of bits of a hash that select the register of a sketch */
+#define HLL_PRECISION 14
+#define HLL_REGISTERS (1U << HLL_PRECISION)
+/* Maximal value of a register: the rest of a 64 bit hash is zero */
+#define HLL_MAX_RANK (64 - HLL_PRECISION + 1)
+
+class Item_sum_approx_count_distinct;
+
+/* Item to get the estimate from a sketch stored in a temporary table */
+
+class Item_approx_count_distinct_field :public Item_result_field
+{
+public:
+  Field *field;
+  Item_approx_count_distinct_field(Item_sum_approx_count_distinct *item);
+  enum Type type() const { return FIELD_APPROX_COUNT_DISTINCT_ITEM; }
+  longlong val_int();
+  double val_real() { return (double) val_int(); }
+  String *val_str(String *str) { return val_string_from_int(str); }
+  my_decimal *val_decimal(my_decimal *dec_buf)
+  { return val_decimal_from_int(dec_buf); }
+  bool is_null() { return 0; }
+  enum_field_types field_type() const { return MYSQL_TYPE_LONGLONG; }
+  void fix_length_and_dec() {}
+  enum Item_result result_type () const { return INT_RESULT; }
+  bool check_vcol_func_processor(uchar *int_arg)
+  {
+    return trace_unsupported_by_check_vcol_func_processor(
+             "approx_count_distinct_field");
+  }
+  const char *func_name() const
+  { DBUG_ASSERT(0); return "approx_count_distinct_field"; }
+};
+
+
+/*
+  APPROX_COUNT_DISTINCT(expr) estimates COUNT(DISTINCT expr) with a
+  HyperLogLog sketch of HLL_REGISTERS one byte registers.
+
+  The first HLL_PRECISION bits of the 64 bit hash of a value select a
+  register, which keeps the maximal position of the first 1 bit in the
+  rest of the hashes mapped to it. The memory used does not depend on the
+  number of values, and the standard error of the estimate is
+  1.04/sqrt(HLL_REGISTERS), about 0.8%.
+
+  Two sketches are merged by taking the maximum of every register. The
+  sketch is thus the partial state of the function: it is stored in the
+  temporary table of GROUP BY and merged from the workers of a parallel
+  scan.
+*/
+
+class Item_sum_approx_count_distinct :public Item_sum_int
+{
+  /* The sketch, allocated by setup() */
+  uchar *registers;
+
+public:
+  Item_sum_approx_count_distinct(Item *item_par)
+    :Item_sum_int(item_par), registers(0)
+  {}
+  Item_sum_approx_count_distinct(THD *thd, Item_sum_approx_count_distinct *item)
+    :Item_sum_int(thd, item), registers(0)
+  {}
+  enum Sumfunctype sum_func () const { return APPROX_COUNT_DISTINCT_FUNC; }
+  bool setup(THD *thd);
+  void clear();
+  bool add();
+  longlong val_int();
+  void reset_field();
+  void update_field();
+  void no_rows_in_result() { clear(); }
+  /* Add a sketch built elsewhere, e.g. by a worker of a parallel scan */
+  void merge_sketch(const uchar *sketch);
+  Item *result_item(Field *field)
+  { return new Item_approx_count_distinct_field(this); }
+  Field *create_tmp_field(bool group, TABLE *table, uint convert_blob_length);
+  const char *func_name() const { return "approx_count_distinct("; }
+  Item *copy_or_same(THD* thd);
+  void cleanup()
+  {
+    registers= 0;
+    Item_sum_int::cleanup();
+  }
+
+  static bool hash_item(Item *item, ulonglong *hash);
+  static bool hash_field(Field *field, ulonglong *hash);
+  static void add_hash(uchar *sketch, ulonglong hash);
+  static longlong estimate(const uchar *sketch);
+};
+
+
 /*
   User defined aggregates
 */
@@ -63,6 +63,10 @@ handler::multi_range_read_info_const(uint keyno, RANGE_SEQ_IF *seq,
   ha_rows rows, total_rows= 0;
   uint n_ranges=0;
   THD *thd= current_thd;
+  ulong dive_limit= thd->variables.range_index_dive_limit;
+  /* Ranges that need records_in_range(), and those that were looked into */
+  uint n_dive_ranges= 0, n_dives= 0;
+  ha_rows dive_rows= 0;
   
   /* Default MRR implementation doesn't need buffer */
   *bufsz= 0;
@@ -91,6 +95,14 @@ handler::multi_range_read_info_const(uint keyno, RANGE_SEQ_IF *seq,
       rows= 1; /* there can be at most one row */
     else
     {
+      /*
+        Past the limit, look into every k-th range only, where k grows with
+        the number of ranges. The rows of the others are estimated below.
+      */
+      n_dive_ranges++;
+      if (dive_limit && n_dive_ranges > dive_limit &&
+          n_dive_ranges % (n_dive_ranges / dive_limit + 1))
+        continue;
       if (HA_POS_ERROR == (rows= this->records_in_range(keyno, min_endp, 
                                                         max_endp)))
       {
@@ -98,10 +110,19 @@ handler::multi_range_read_info_const(uint keyno, RANGE_SEQ_IF *seq,
         total_rows= HA_POS_ERROR;
         break;
       }
+      n_dives++;
+      dive_rows+= rows;
     }
     total_rows += rows;
   }
   
+  if (total_rows != HA_POS_ERROR && n_dive_ranges > n_dives)
+  {
+    /* The average of the ranges looked into for each one that was not */
+    total_rows+= (ha_rows) ((double) dive_rows / n_dives *
+                            (n_dive_ranges - n_dives) + 0.5);
+  }
+
   if (total_rows != HA_POS_ERROR)
   {
     /* The following calculation is the same as in multi_range_read_info(): */
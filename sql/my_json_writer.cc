@@ -0,0 +1,195 @@
+/*
+   Copyright (c) 2014, Monty Program Ab
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+#include "sql_priv.h"
+#include "sql_string.h"
+#include "my_json_writer.h"
+
+
+void Json_writer::append_indent()
+{
+  output.append('\n');
+  for (int i= 0; i < indent_level; i++)
+    output.append(STRING_WITH_LEN("  "));
+}
+
+
+/*
+  Write what precedes a value: the separator from the previous element of
+  the object or array and the indentation. Nothing is written for the
+  value of a member, it follows the name.
+*/
+
+void Json_writer::start_element()
+{
+  if (element_started)
+  {
+    element_started= false;
+    return;
+  }
+  if (!document_start)
+  {
+    if (!first_child)
+      output.append(',');
+    append_indent();
+  }
+  document_start= false;
+  first_child= false;
+}
+
+
+Json_writer& Json_writer::add_member(const char *name)
+{
+  DBUG_ASSERT(!element_started);
+  if (!first_child)
+    output.append(',');
+  append_indent();
+  first_child= false;
+
+  output.append('"');
+  append_escaped(name, strlen(name));
+  output.append(STRING_WITH_LEN("\": "));
+  element_started= true;
+  return *this;
+}
+
+
+void Json_writer::start_object()
+{
+  start_element();
+  output.append('{');
+  indent_level++;
+  first_child= true;
+}
+
+
+void Json_writer::start_array()
+{
+  start_element();
+  output.append('[');
+  indent_level++;
+  first_child= true;
+}
+
+
+void Json_writer::end_object()
+{
+  indent_level--;
+  if (!first_child)
+    append_indent();
+  first_child= false;
+  output.append('}');
+}
+
+
+void Json_writer::end_array()
+{
+  indent_level--;
+  if (!first_child)
+    append_indent();
+  first_child= false;
+  output.append(']');
+}
+
+
+void Json_writer::append_escaped(const char *str, size_t length)
+{
+  for (const char *end= str + length; str < end; str++)
+  {
+    switch (*str) {
+    case '"':
+      output.append(STRING_WITH_LEN("\\\""));
+      break;
+    case '\\':
+      output.append(STRING_WITH_LEN("\\\\"));
+      break;
+    case '\n':
+      output.append(STRING_WITH_LEN("\\n"));
+      break;
+    case '\r':
+      output.append(STRING_WITH_LEN("\\r"));
+      break;
+    case '\t':
+      output.append(STRING_WITH_LEN("\\t"));
+      break;
+    default:
+      if ((uchar) *str < 0x20)
+      {
+        char buf[8];
+        size_t len= my_snprintf(buf, sizeof(buf), "\\u%04x", (uint) (uchar) *str);
+        output.append(buf, len);
+      }
+      else
+        output.append(*str);
+    }
+  }
+}
+
+
+void Json_writer::add_str(const char *str, size_t length)
+{
+  start_element();
+  output.append('"');
+  append_escaped(str, length);
+  output.append('"');
+}
+
+
+void Json_writer::add_str(const char *str)
+{
+  add_str(str, strlen(str));
+}
+
+
+void Json_writer::add_str(const String &str)
+{
+  add_str(str.ptr(), str.length());
+}
+
+
+void Json_writer::add_ll(longlong val)
+{
+  char buf[64];
+  size_t length= longlong10_to_str(val, buf, -10) - buf;
+  start_element();
+  output.append(buf, length);
+}
+
+
+void Json_writer::add_double(double val)
+{
+  char buf[64];
+  size_t length= my_snprintf(buf, sizeof(buf), "%-.11g", val);
+  start_element();
+  output.append(buf, length);
+}
+
+
+void Json_writer::add_bool(bool val)
+{
+  start_element();
+  if (val)
+    output.append(STRING_WITH_LEN("true"));
+  else
+    output.append(STRING_WITH_LEN("false"));
+}
+
+
+void Json_writer::add_null()
+{
+  start_element();
+  output.append(STRING_WITH_LEN("null"));
+}
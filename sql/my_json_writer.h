@@ -0,0 +1,83 @@
+#ifndef MY_JSON_WRITER_INCLUDED
+#define MY_JSON_WRITER_INCLUDED
+
+/*
+   Copyright (c) 2014, Monty Program Ab
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/**
+  @file
+
+  @brief
+  A writer of JSON documents, used to print EXPLAIN FORMAT=JSON
+*/
+
+/*
+  Writes a JSON document into a String, indented by two spaces per level.
+
+  A member of an object is written with add_member() followed by a call
+  that writes its value, e.g.
+
+    writer.start_object();
+    writer.add_member("rows").add_ll(10);
+    writer.end_object();
+
+  The elements of an array are written with the value calls alone.
+*/
+
+class Json_writer
+{
+public:
+  Json_writer() :
+    indent_level(0), document_start(true), element_started(false),
+    first_child(true)
+  {}
+
+  Json_writer& add_member(const char *name);
+
+  /* Add atomic values */
+  void add_str(const char *str);
+  void add_str(const char *str, size_t length);
+  void add_str(const String &str);
+  void add_ll(longlong val);
+  void add_double(double val);
+  void add_bool(bool val);
+  void add_null();
+
+  /* Start a child object or array */
+  void start_object();
+  void start_array();
+
+  /* Finish the current object or array */
+  void end_object();
+  void end_array();
+
+  String output;
+
+private:
+  int indent_level;
+  /* TRUE <=> nothing has been written yet */
+  bool document_start;
+  /* TRUE <=> add_member() was called and the value is to be written */
+  bool element_started;
+  /* TRUE <=> the next element is the first one in its object or array */
+  bool first_child;
+
+  void start_element();
+  void append_indent();
+  void append_escaped(const char *str, size_t length);
+};
+
+#endif /* MY_JSON_WRITER_INCLUDED */
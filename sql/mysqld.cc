@@ -49,12 +49,14 @@
 #include "derror.h"       // init_errmessage
 #include "des_key_file.h" // load_des_key_file
 #include "sql_manager.h"  // stop_handle_manager, start_handle_manager
+#include "sql_task_pool.h" // task_pool_init, task_pool_end
 #include "sql_expression_cache.h" // subquery_cache_miss, subquery_cache_hit
 #include "sys_vars_shared.h"
 
 #include <m_ctype.h>
 #include <my_dir.h>
 #include <my_bit.h>
+#include <my_rdtsc.h>
 #include "slave.h"
 #include "rpl_mi.h"
 #include "sql_repl.h"
@@ -113,6 +115,15 @@
 #define HAVE_CLOSE_SERVER_SOCK 1
 #endif
 
+/*
+  Several threads can accept connections on the main port, each with its
+  own listening socket, if the kernel distributes the connections between
+  sockets bound to the same port (SO_REUSEPORT).
+*/
+#if defined(SO_REUSEPORT) && defined(HAVE_POLL) && !defined(EMBEDDED_LIBRARY)
+#define HAVE_ACCEPTOR_THREADS 1
+#endif
+
 extern "C" {					// Because of SCO 3.2V4.2
 #include <errno.h>
 #include <sys/stat.h>
@@ -325,6 +336,10 @@ static PSI_thread_key key_thread_handle_con_sharedmem;
 static PSI_thread_key key_thread_handle_con_sockets;
 #endif /* _WIN32 || HAVE_SMEM && !EMBEDDED_LIBRARY */
 
+#ifdef HAVE_ACCEPTOR_THREADS
+static PSI_thread_key key_thread_handle_con_acceptor;
+#endif /* HAVE_ACCEPTOR_THREADS */
+
 #ifdef __WIN__
 static PSI_thread_key key_thread_handle_shutdown;
 #endif /* __WIN__ */
@@ -355,6 +370,8 @@ static my_bool opt_short_log_format= 0;
 static uint kill_cached_threads, wake_thread;
 ulong max_used_connections;
 static volatile ulong cached_thread_count= 0;
+static volatile ulong cached_session_count= 0;
+static ulong sessions_reused= 0;
 static char *mysqld_user, *mysqld_chroot;
 static char *default_character_set_name;
 static char *character_set_filesystem_name;
@@ -365,6 +382,7 @@ static char *default_collation_name;
 char *default_storage_engine;
 static char compiled_default_collation_name[]= MYSQL_DEFAULT_COLLATION_NAME;
 static I_List<THD> thread_cache;
+static I_List<THD> session_cache;
 static bool binlog_format_used= false;
 LEX_STRING opt_init_connect, opt_init_slave;
 static mysql_cond_t COND_thread_cache, COND_flush_thread_cache;
@@ -480,6 +498,7 @@ int32 thread_running;
 int32 slave_open_temp_tables;
 ulong thread_created;
 ulong back_log, connect_timeout, concurrency, server_id;
+uint acceptor_threads;
 ulong what_to_log;
 ulong slow_launch_time;
 ulong open_files_limit, max_binlog_size;
@@ -492,6 +511,7 @@ ulong slave_run_triggers_for_rbr= 0;
 ulong slave_ddl_exec_mode_options= SLAVE_EXEC_MODE_IDEMPOTENT;
 ulonglong slave_type_conversions_options;
 ulong thread_cache_size=0;
+ulong session_cache_size=0;
 ulonglong binlog_cache_size=0;
 ulonglong max_binlog_cache_size=0;
 ulong slave_max_allowed_packet= 0;
@@ -518,6 +538,8 @@ ulong extra_max_connections;
 ulong slave_retried_transactions;
 ulonglong denied_connections;
 my_decimal decimal_zero;
+/* Timers used to measure the time of execution for ANALYZE statements */
+MY_TIMER_INFO sys_timer_info;
 
 /*
   Maximum length of parameter value which can be set through
@@ -873,6 +895,7 @@ PSI_mutex_key key_BINLOG_LOCK_index, key_BINLOG_LOCK_xid_list,
 PSI_mutex_key key_RELAYLOG_LOCK_index;
 PSI_mutex_key key_LOCK_slave_state, key_LOCK_binlog_state,
   key_LOCK_rpl_thread, key_LOCK_rpl_thread_pool, key_LOCK_parallel_entry;
+PSI_mutex_key key_LOCK_task_pool;
 
 PSI_mutex_key key_LOCK_stats,
   key_LOCK_global_user_client_stats, key_LOCK_global_table_stats,
@@ -951,7 +974,8 @@ static PSI_mutex_info all_server_mutexes[]=
   { &key_LOCK_binlog_state, "LOCK_binlog_state", 0},
   { &key_LOCK_rpl_thread, "LOCK_rpl_thread", 0},
   { &key_LOCK_rpl_thread_pool, "LOCK_rpl_thread_pool", 0},
-  { &key_LOCK_parallel_entry, "LOCK_parallel_entry", 0}
+  { &key_LOCK_parallel_entry, "LOCK_parallel_entry", 0},
+  { &key_LOCK_task_pool, "LOCK_task_pool", PSI_FLAG_GLOBAL}
 };
 
 PSI_rwlock_key key_rwlock_LOCK_grant, key_rwlock_LOCK_logger,
@@ -999,6 +1023,7 @@ PSI_cond_key key_COND_rpl_thread_queue, key_COND_rpl_thread,
   key_COND_parallel_entry, key_COND_group_commit_orderer,
   key_COND_prepare_ordered;
 PSI_cond_key key_COND_wait_gtid, key_COND_gtid_ignore_duplicates;
+PSI_cond_key key_COND_task_pool, key_COND_task_done;
 
 static PSI_cond_info all_server_conds[]=
 {
@@ -1047,13 +1072,15 @@ static PSI_cond_info all_server_conds[]=
   { &key_COND_group_commit_orderer, "COND_group_commit_orderer", 0},
   { &key_COND_prepare_ordered, "COND_prepare_ordered", 0},
   { &key_COND_wait_gtid, "COND_wait_gtid", 0},
-  { &key_COND_gtid_ignore_duplicates, "COND_gtid_ignore_duplicates", 0}
+  { &key_COND_gtid_ignore_duplicates, "COND_gtid_ignore_duplicates", 0},
+  { &key_COND_task_pool, "COND_task_pool", PSI_FLAG_GLOBAL},
+  { &key_COND_task_done, "COND_task_done", PSI_FLAG_GLOBAL}
 };
 
 PSI_thread_key key_thread_bootstrap, key_thread_delayed_insert,
   key_thread_handle_manager, key_thread_main,
   key_thread_one_connection, key_thread_signal_hand,
-  key_thread_slave_init, key_rpl_parallel_thread;
+  key_thread_slave_init, key_rpl_parallel_thread, key_thread_task_pool;
 
 static PSI_thread_info all_server_threads[]=
 {
@@ -1069,6 +1096,10 @@ static PSI_thread_info all_server_threads[]=
   { &key_thread_handle_con_sockets, "con_sockets", PSI_FLAG_GLOBAL},
 #endif /* _WIN32 || HAVE_SMEM && !EMBEDDED_LIBRARY */
 
+#ifdef HAVE_ACCEPTOR_THREADS
+  { &key_thread_handle_con_acceptor, "con_acceptor", 0},
+#endif /* HAVE_ACCEPTOR_THREADS */
+
 #ifdef __WIN__
   { &key_thread_handle_shutdown, "shutdown", PSI_FLAG_GLOBAL},
 #endif /* __WIN__ */
@@ -1080,7 +1111,8 @@ static PSI_thread_info all_server_threads[]=
   { &key_thread_one_connection, "one_connection", 0},
   { &key_thread_signal_hand, "signal_handler", PSI_FLAG_GLOBAL},
   { &key_thread_slave_init, "slave_init", PSI_FLAG_GLOBAL},
-  { &key_rpl_parallel_thread, "rpl_parallel_thread", 0}
+  { &key_rpl_parallel_thread, "rpl_parallel_thread", 0},
+  { &key_thread_task_pool, "task_pool", 0}
 };
 
 #ifdef HAVE_MMAP
@@ -1315,6 +1347,11 @@ void Buffered_logs::print()
 static Buffered_logs buffered_logs;
 
 static MYSQL_SOCKET unix_sock, base_ip_sock, extra_ip_sock;
+#ifdef HAVE_ACCEPTOR_THREADS
+/* Listening sockets and threads of the acceptors other than the main thread */
+static MYSQL_SOCKET *acceptor_socks;
+static uint volatile acceptor_threads_in_use;
+#endif
 struct my_rnd_struct sql_rand; ///< used by sql_class.cc:THD::THD()
 
 #ifndef EMBEDDED_LIBRARY
@@ -1494,6 +1531,11 @@ static bool pid_file_created= false;
 static void usage(void);
 static void start_signal_handler(void);
 static void close_server_sock();
+#ifdef HAVE_ACCEPTOR_THREADS
+static void start_acceptor_threads();
+static void stop_acceptor_threads();
+#endif
+static bool cache_session(THD *thd);
 static void clean_up_mutexes(void);
 static void wait_for_signal_thread_to_end(void);
 static void create_pid_file();
@@ -1553,6 +1595,10 @@ static void close_connections(void)
   mysql_mutex_unlock(&LOCK_thread_count);
 #endif /* __WIN__ */
 
+#ifdef HAVE_ACCEPTOR_THREADS
+  stop_acceptor_threads();
+#endif
+
 
   /* Abort listening to new connections */
   DBUG_PRINT("quit",("Closing sockets"));
@@ -1713,6 +1759,9 @@ static void close_connections(void)
   }
   mysql_mutex_unlock(&LOCK_thread_count);
 
+  /* No THD is added to the session cache after abort_loop is set */
+  flush_session_cache(0);
+
   DBUG_PRINT("quit",("close_connections thread"));
   DBUG_VOID_RETURN;
 }
@@ -1991,6 +2040,7 @@ void clean_up(bool print_message)
     my_bitmap_free(&slave_error_mask);
 #endif
   stop_handle_manager();
+  task_pool_end();
   release_ddl_log();
 
   /*
@@ -2349,7 +2399,22 @@ static void set_root(const char *path)
    Activate usage of a tcp port
 */
 
-static MYSQL_SOCKET activate_tcp_port(uint port)
+/**
+  Create a listening TCP/IP socket
+
+  @param port        the port
+  @param reuse_port  in: bind with SO_REUSEPORT, so that other sockets can
+                     be bound to the port; out: set to false if the
+                     option could not be set
+  @param optional    an additional socket of the acceptor threads: errors
+                     are reported as warnings and MYSQL_INVALID_SOCKET is
+                     returned instead of aborting the server
+
+  @return the socket
+*/
+
+static MYSQL_SOCKET activate_tcp_port(uint port, bool *reuse_port,
+                                      bool optional= false)
 {
   struct addrinfo *ai, *a;
   struct addrinfo hints;
@@ -2371,6 +2436,8 @@ static MYSQL_SOCKET activate_tcp_port(uint port)
   {
     DBUG_PRINT("error",("Got error: %d from getaddrinfo()", error));
     sql_perror(ER_DEFAULT(ER_IPSOCK_ERROR));  /* purecov: tested */
+    if (optional)
+      DBUG_RETURN(ip_sock);
     unireg_abort(1);				/* purecov: tested */
   }
 
@@ -2405,6 +2472,8 @@ static MYSQL_SOCKET activate_tcp_port(uint port)
   {
     DBUG_PRINT("error",("Got error: %d from socket()",socket_errno));
     sql_perror(ER_DEFAULT(ER_IPSOCK_ERROR));  /* purecov: tested */
+    if (optional)
+      goto err;
     unireg_abort(1);				/* purecov: tested */
   }
 
@@ -2420,6 +2489,26 @@ static MYSQL_SOCKET activate_tcp_port(uint port)
                                  sizeof(arg));
 #endif /* __WIN__ */
 
+#ifdef HAVE_ACCEPTOR_THREADS
+  if (*reuse_port)
+  {
+    arg= 1;
+    if (mysql_socket_setsockopt(ip_sock, SOL_SOCKET, SO_REUSEPORT,
+                                (char*)&arg, sizeof(arg)))
+    {
+      sql_print_warning("Failed to set SO_REUSEPORT on the TCP/IP socket, "
+                        "errno: %d. Connections are accepted by one thread.",
+                        (int) socket_errno);
+      *reuse_port= false;
+      /* Binding the socket would fail, the port is in use */
+      if (optional)
+        goto err;
+    }
+  }
+#else
+  *reuse_port= false;
+#endif
+
 #ifdef IPV6_V6ONLY
    /*
      For interoperability with older clients, IPv6 socket should
@@ -2451,13 +2540,20 @@ static MYSQL_SOCKET activate_tcp_port(uint port)
   {
     if (((ret= mysql_socket_bind(ip_sock, a->ai_addr, a->ai_addrlen)) >= 0 ) ||
         (socket_errno != SOCKET_EADDRINUSE) ||
-        (waited >= mysqld_port_timeout))
+        (waited >= mysqld_port_timeout) || optional)
       break;
     sql_print_information("Retrying bind on TCP/IP port %u", port);
     this_wait= retry * retry / 3 + 1;
     sleep(this_wait);
   }
   freeaddrinfo(ai);
+  ai= NULL;
+  if (ret < 0 && optional)
+  {
+    sql_print_warning("Failed to bind an additional socket to TCP/IP port "
+                      "%u, errno: %d", port, (int) socket_errno);
+    goto err;
+  }
   if (ret < 0)
   {
     char buff[100];
@@ -2473,9 +2569,18 @@ static MYSQL_SOCKET activate_tcp_port(uint port)
     sql_perror("Can't start server: listen() on TCP/IP port");
     sql_print_error("listen() on TCP/IP failed with error %d",
                     socket_errno);
+    if (optional)
+      goto err;
     unireg_abort(1);
   }
   DBUG_RETURN(ip_sock);
+
+err:
+  if (ai)
+    freeaddrinfo(ai);
+  if (mysql_socket_getfd(ip_sock) != INVALID_SOCKET)
+    (void) mysql_socket_close(ip_sock);
+  DBUG_RETURN(MYSQL_INVALID_SOCKET);
 }
 
 static void network_init(void)
@@ -2501,11 +2606,48 @@ static void network_init(void)
 #endif
   if (!opt_disable_networking && !opt_bootstrap)
   {
+    bool reuse_port= acceptor_threads > 1;
     if (mysqld_port)
-      base_ip_sock= activate_tcp_port(mysqld_port);
+      base_ip_sock= activate_tcp_port(mysqld_port, &reuse_port);
+    else
+      reuse_port= false;
+#ifdef HAVE_ACCEPTOR_THREADS
+    if (reuse_port)
+    {
+      uint i;
+      acceptor_socks= (MYSQL_SOCKET *)
+        my_malloc(sizeof(MYSQL_SOCKET) * (acceptor_threads - 1),
+                  MYF(MY_WME | MY_FAE));
+      for (i= 0; i < acceptor_threads - 1; i++)
+      {
+        acceptor_socks[i]= activate_tcp_port(mysqld_port, &reuse_port, true);
+        if (mysql_socket_getfd(acceptor_socks[i]) == INVALID_SOCKET)
+          break;
+      }
+      if (i < acceptor_threads - 1)
+      {
+        /* Fall back to the single listening socket */
+        sql_print_warning("Could not create a socket for each of the %u "
+                          "acceptor threads. Connections are accepted by "
+                          "one thread.", acceptor_threads);
+        while (i--)
+          (void) mysql_socket_close(acceptor_socks[i]);
+        my_free(acceptor_socks);
+        acceptor_socks= NULL;
+        reuse_port= false;
+      }
+    }
+#endif
+    if (!reuse_port)
+      acceptor_threads= 1;
     if (mysqld_extra_port)
-      extra_ip_sock= activate_tcp_port(mysqld_extra_port);
+    {
+      bool no_reuse_port= false;
+      extra_ip_sock= activate_tcp_port(mysqld_extra_port, &no_reuse_port);
+    }
   }
+  else
+    acceptor_threads= 1;
 
 #ifdef _WIN32
   /* create named pipe */
@@ -2734,7 +2876,10 @@ void unlink_thd(THD *thd)
   DBUG_EXECUTE_IF("sleep_after_lock_thread_count_before_delete_thd", sleep(5););
   mysql_mutex_unlock(&LOCK_thread_count);
 
-  delete thd;
+#ifndef EMBEDDED_LIBRARY
+  if (!cache_session(thd))
+#endif
+    delete thd;
   thread_safe_decrement32(&thread_count, &thread_count_lock);
 
   DBUG_VOID_RETURN;
@@ -2891,6 +3036,113 @@ void flush_thread_cache()
 }
 
 
+#ifndef EMBEDDED_LIBRARY
+/*
+  Store the THD of a closed connection in the session cache
+
+  SYNOPSIS
+    cache_session()
+    thd		 Thread handler, already unlinked and cleaned up
+
+  NOTES
+    The THD keeps its memory and is reset for the next connection by
+    get_cached_session(). LOCK_thread_cache protects the session cache.
+    A THD that is cached is no longer the current THD of the calling
+    thread when this function returns.
+
+  RETURN
+    0  THD was not cached and should be deleted
+    1  THD is in the cache
+*/
+
+static bool cache_session(THD *thd)
+{
+  DBUG_ENTER("cache_session");
+  if (cached_session_count >= session_cache_size || abort_loop ||
+      thd->system_thread != NON_SYSTEM_THREAD || thd->bootstrap ||
+      thd->rli_fake || thd->rgi_fake)      // Ran BINLOG statements
+    DBUG_RETURN(0);
+
+  thd->free_connection();
+  /*
+    Another thread can take the THD for a new connection as soon as it is
+    in the cache, so this thread must be done with it: detach it from
+    current_thd and from the mysys_var of this thread first
+  */
+  thd->reset_globals();
+  mysql_mutex_lock(&LOCK_thread_cache);
+  if (cached_session_count < session_cache_size && !abort_loop)
+  {
+    session_cache.push_back(thd);
+    cached_session_count++;
+    mysql_mutex_unlock(&LOCK_thread_cache);
+    DBUG_RETURN(1);
+  }
+  mysql_mutex_unlock(&LOCK_thread_cache);
+  DBUG_RETURN(0);
+}
+
+
+/*
+  Get a THD for a new connection from the session cache
+
+  NOTES
+    The THD is made the current THD and reset as if it was just created.
+
+  RETURN
+    0    The cache is empty
+    #    THD for the connection
+*/
+
+static THD *get_cached_session()
+{
+  THD *thd;
+  DBUG_ENTER("get_cached_session");
+  if (!cached_session_count)
+    DBUG_RETURN(0);
+
+  mysql_mutex_lock(&LOCK_thread_cache);
+  if ((thd= session_cache.get()))
+  {
+    cached_session_count--;
+    sessions_reused++;
+  }
+  mysql_mutex_unlock(&LOCK_thread_cache);
+  if (thd)
+  {
+    set_current_thd(thd);
+    thd->reset_for_reuse();
+  }
+  DBUG_RETURN(thd);
+}
+#endif /* EMBEDDED_LIBRARY */
+
+
+/*
+  Delete THDs from the session cache
+
+  SYNOPSIS
+    flush_session_cache()
+    keep	 Number of THDs that may stay in the cache
+*/
+
+void flush_session_cache(ulong keep)
+{
+  THD *thd;
+  DBUG_ENTER("flush_session_cache");
+  mysql_mutex_lock(&LOCK_thread_cache);
+  while (cached_session_count > keep && (thd= session_cache.get()))
+  {
+    cached_session_count--;
+    mysql_mutex_unlock(&LOCK_thread_cache);
+    delete thd;
+    mysql_mutex_lock(&LOCK_thread_cache);
+  }
+  mysql_mutex_unlock(&LOCK_thread_cache);
+  DBUG_VOID_RETURN;
+}
+
+
 /******************************************************************************
   Setup a signal thread with handles all signals.
   Because Linux doesn't support schemas use a mutex to check that
@@ -3864,6 +4116,7 @@ static int init_common_variables()
   connection_errors_max_connection= 0;
   connection_errors_peer_addr= 0;
   my_decimal_set_zero(&decimal_zero); // set decimal_zero constant;
+  my_timer_init(&sys_timer_info);
 
   if (pthread_key_create(&THR_THD,NULL) ||
       pthread_key_create(&THR_MALLOC,NULL))
@@ -4363,6 +4616,7 @@ static int init_thread_environment()
                    &LOCK_prepared_stmt_count, MY_MUTEX_INIT_FAST);
   mysql_mutex_init(key_LOCK_error_messages,
                    &LOCK_error_messages, MY_MUTEX_INIT_FAST);
+  task_pool_init();
   mysql_mutex_init(key_LOCK_uuid_short_generator,
                    &LOCK_short_uuid_generator, MY_MUTEX_INIT_FAST);
   mysql_mutex_init(key_LOCK_connection_count,
@@ -5494,6 +5748,9 @@ int mysqld_main(int argc, char **argv)
 #if defined(_WIN32) || defined(HAVE_SMEM)
   handle_connections_methods();
 #else
+#ifdef HAVE_ACCEPTOR_THREADS
+  start_acceptor_threads();
+#endif
   handle_connections_sockets();
 #endif /* _WIN32 || HAVE_SMEM */
 
@@ -6011,19 +6268,128 @@ inline void kill_broken_server()
 
 #ifndef EMBEDDED_LIBRARY
 
+/**
+  Create the THD of a new connection and hand it over to the scheduler
+
+  @param sock      the listening socket the connection was accepted on
+  @param new_sock  the socket of the connection
+*/
+
+static void handle_new_connection(MYSQL_SOCKET sock, MYSQL_SOCKET new_sock)
+{
+  THD *thd;
+  st_vio *vio_tmp;
+  bool is_unix_sock= (mysql_socket_getfd(sock) ==
+                      mysql_socket_getfd(unix_sock));
+
+#ifdef HAVE_LIBWRAP
+  {
+    if (!is_unix_sock)
+    {
+      struct request_info req;
+      signal(SIGCHLD, SIG_DFL);
+      request_init(&req, RQ_DAEMON, libwrapName, RQ_FILE,
+                   mysql_socket_getfd(new_sock), NULL);
+      my_fromhost(&req);
+      if (!my_hosts_access(&req))
+      {
+        /*
+          This may be stupid but refuse() includes an exit(0)
+          which we surely don't want...
+          clean_exit() - same stupid thing ...
+        */
+        syslog(deny_severity, "refused connect from %s",
+             my_eval_client(&req));
+
+        /*
+          C++ sucks (the gibberish in front just translates the supplied
+          sink function pointer in the req structure from a void (*sink)();
+          to a void(*sink)(int) if you omit the cast, the C++ compiler
+          will cry...
+        */
+        if (req.sink)
+          ((void (*)(int))req.sink)(req.fd);
+
+        (void) mysql_socket_shutdown(new_sock, SHUT_RDWR);
+        (void) mysql_socket_close(new_sock);
+        /*
+          The connection was refused by TCP wrappers.
+          There are no details (by client IP) available to update the host_cache.
+        */
+        statistic_increment(connection_tcpwrap_errors, &LOCK_status);
+        return;
+      }
+    }
+  }
+#endif /* HAVE_LIBWRAP */
+
+  /*
+  ** Don't allow too many connections
+  */
+
+  DBUG_PRINT("info", ("Creating THD for new connection"));
+  if (!(thd= get_cached_session()))
+  {
+    if (!(thd= new THD))
+    {
+      (void) mysql_socket_shutdown(new_sock, SHUT_RDWR);
+      (void) mysql_socket_close(new_sock);
+      statistic_increment(connection_errors_internal, &LOCK_status);
+      return;
+    }
+    /* Set to get io buffers to be part of THD */
+    set_current_thd(thd);
+  }
+
+  /* A cached THD still has the packet buffer of its last connection */
+  if (!(vio_tmp=
+        mysql_socket_vio_new(new_sock,
+                             is_unix_sock ? VIO_TYPE_SOCKET : VIO_TYPE_TCPIP,
+                             is_unix_sock ? VIO_LOCALHOST: 0)) ||
+      my_net_reinit(&thd->net, vio_tmp, MYF(MY_THREAD_SPECIFIC)))
+  {
+    /*
+      Only delete the temporary vio if we didn't already attach it to the
+      NET object. The destructor in THD will delete any initialized net
+      structure.
+    */
+    if (vio_tmp && thd->net.vio != vio_tmp)
+      vio_delete(vio_tmp);
+    else
+    {
+      (void) mysql_socket_shutdown(new_sock, SHUT_RDWR);
+      (void) mysql_socket_close(new_sock);
+    }
+    delete thd;
+    set_current_thd(0);
+    statistic_increment(connection_errors_internal, &LOCK_status);
+    return;
+  }
+
+  init_net_server_extension(thd);
+  if (is_unix_sock)
+    thd->security_ctx->host=(char*) my_localhost;
+
+  if (mysql_socket_getfd(sock) == mysql_socket_getfd(extra_ip_sock))
+  {
+    thd->extra_port= 1;
+    thd->scheduler= extra_thread_scheduler;
+  }
+  create_new_thread(thd);
+  set_current_thd(0);
+}
+
+
 void handle_connections_sockets()
 {
   MYSQL_SOCKET sock= mysql_socket_invalid();
   MYSQL_SOCKET new_sock= mysql_socket_invalid();
   uint error_count=0;
-  THD *thd;
   struct sockaddr_storage cAddr;
   int ip_flags __attribute__((unused))=0;
   int socket_flags __attribute__((unused))= 0;
   int extra_ip_flags __attribute__((unused))=0;
   int flags=0,retval;
-  st_vio *vio_tmp;
-  bool is_unix_sock;
 #ifdef HAVE_POLL
   int socket_count= 0;
   struct pollfd fds[3]; // for ip_sock, unix_sock and extra_ip_sock
@@ -6172,104 +6538,144 @@ void handle_connections_sockets()
       continue;
     }
 
-#ifdef HAVE_LIBWRAP
-    {
-      if (mysql_socket_getfd(sock) == mysql_socket_getfd(base_ip_sock) ||
-          mysql_socket_getfd(sock) == mysql_socket_getfd(extra_ip_sock))
-      {
-	struct request_info req;
-	signal(SIGCHLD, SIG_DFL);
-	request_init(&req, RQ_DAEMON, libwrapName, RQ_FILE,
-                     mysql_socket_getfd(new_sock), NULL);
-	my_fromhost(&req);
-	if (!my_hosts_access(&req))
-	{
-	  /*
-	    This may be stupid but refuse() includes an exit(0)
-	    which we surely don't want...
-	    clean_exit() - same stupid thing ...
-	  */
-	  syslog(deny_severity, "refused connect from %s",
-		 my_eval_client(&req));
-
-	  /*
-	    C++ sucks (the gibberish in front just translates the supplied
-	    sink function pointer in the req structure from a void (*sink)();
-	    to a void(*sink)(int) if you omit the cast, the C++ compiler
-	    will cry...
-	  */
-	  if (req.sink)
-	    ((void (*)(int))req.sink)(req.fd);
-
-	  (void) mysql_socket_shutdown(new_sock, SHUT_RDWR);
-	  (void) mysql_socket_close(new_sock);
-          /*
-            The connection was refused by TCP wrappers.
-            There are no details (by client IP) available to update the host_cache.
-          */
-          statistic_increment(connection_tcpwrap_errors, &LOCK_status);
-	  continue;
-	}
-      }
-    }
-#endif /* HAVE_LIBWRAP */
+    handle_new_connection(sock, new_sock);
+  }
+  DBUG_VOID_RETURN;
+}
 
-    /*
-    ** Don't allow too many connections
-    */
 
-    DBUG_PRINT("info", ("Creating THD for new connection"));
-    if (!(thd= new THD))
+#ifdef HAVE_ACCEPTOR_THREADS
+/**
+  Accept connections on one of the additional sockets bound to the main
+  port.
+
+  The socket is used only by this thread, so it stays non-blocking, and
+  all pending connections are accepted after every poll().
+*/
+
+pthread_handler_t handle_connections_acceptor(void *arg)
+{
+  MYSQL_SOCKET sock= *(MYSQL_SOCKET *) arg;
+  uint error_count= 0;
+  struct pollfd fds;
+
+  my_thread_init();
+  mysql_socket_set_thread_owner(sock);
+  fds.fd= mysql_socket_getfd(sock);
+  fds.events= POLLIN;
+  fcntl(fds.fd, F_SETFL, fcntl(fds.fd, F_GETFL, 0) | O_NONBLOCK);
+
+  while (!abort_loop)
+  {
+    if (poll(&fds, 1, -1) < 0)
     {
-      (void) mysql_socket_shutdown(new_sock, SHUT_RDWR);
-      (void) mysql_socket_close(new_sock);
-      statistic_increment(connection_errors_internal, &LOCK_status);
+      if (socket_errno != SOCKET_EINTR)
+        statistic_increment(connection_errors_accept, &LOCK_status);
       continue;
     }
-    /* Set to get io buffers to be part of THD */
-    set_current_thd(thd);
 
-    is_unix_sock= (mysql_socket_getfd(sock) ==
-                   mysql_socket_getfd(unix_sock));
-
-    if (!(vio_tmp=
-          mysql_socket_vio_new(new_sock,
-                               is_unix_sock ? VIO_TYPE_SOCKET : VIO_TYPE_TCPIP,
-                               is_unix_sock ? VIO_LOCALHOST: 0)) ||
-	my_net_init(&thd->net, vio_tmp, MYF(MY_THREAD_SPECIFIC)))
+    while (!abort_loop)
     {
-      /*
-        Only delete the temporary vio if we didn't already attach it to the
-        NET object. The destructor in THD will delete any initialized net
-        structure.
-      */
-      if (vio_tmp && thd->net.vio != vio_tmp)
-        vio_delete(vio_tmp);
-      else
+      struct sockaddr_storage cAddr;
+      size_socket length= sizeof(struct sockaddr_storage);
+      MYSQL_SOCKET new_sock= mysql_socket_accept(key_socket_client_connection,
+                                                 sock,
+                                                 (struct sockaddr *) &cAddr,
+                                                 &length);
+      if (mysql_socket_getfd(new_sock) == INVALID_SOCKET)
       {
-	(void) mysql_socket_shutdown(new_sock, SHUT_RDWR);
-	(void) mysql_socket_close(new_sock);
+        if (socket_errno == SOCKET_EAGAIN || socket_errno == SOCKET_EINTR)
+          break;                                /* No more connections */
+        statistic_increment(connection_errors_accept, &LOCK_status);
+        if ((error_count++ & 255) == 0)
+          sql_perror("Error in accept");
+        if (socket_errno == SOCKET_ENFILE || socket_errno == SOCKET_EMFILE)
+          sleep(1);
+        break;
       }
-      delete thd;
-      set_current_thd(0);
-      statistic_increment(connection_errors_internal, &LOCK_status);
-      continue;
+      handle_new_connection(sock, new_sock);
+    }
+  }
+
+  mysql_mutex_lock(&LOCK_thread_count);
+  acceptor_threads_in_use--;
+  mysql_cond_broadcast(&COND_thread_count);
+  mysql_mutex_unlock(&LOCK_thread_count);
+  my_thread_end();
+  return 0;
+}
+
+
+/* Start a thread for every additional socket bound to the main port */
+
+static void start_acceptor_threads()
+{
+  for (uint i= 0; i < acceptor_threads - 1; i++)
+  {
+    pthread_t thread;
+    int error;
+    mysql_mutex_lock(&LOCK_thread_count);
+    acceptor_threads_in_use++;
+    mysql_mutex_unlock(&LOCK_thread_count);
+    if ((error= mysql_thread_create(key_thread_handle_con_acceptor, &thread,
+                                    &connection_attrib,
+                                    handle_connections_acceptor,
+                                    (void*) &acceptor_socks[i])))
+    {
+      sql_print_warning("Can't create thread to accept connections "
+                        "(errno= %d)", error);
+      mysql_mutex_lock(&LOCK_thread_count);
+      acceptor_threads_in_use--;
+      mysql_mutex_unlock(&LOCK_thread_count);
+      /* The kernel must not give connections to a socket nobody accepts */
+      (void) mysql_socket_close(acceptor_socks[i]);
+      acceptor_socks[i]= MYSQL_INVALID_SOCKET;
     }
+  }
+}
+
+
+/**
+  Stop the additional acceptor threads and close their sockets.
+
+  Shutting down a listening socket wakes the thread polling it.
+*/
+
+static void stop_acceptor_threads()
+{
+  DBUG_ENTER("stop_acceptor_threads");
+  if (!acceptor_socks)
+    DBUG_VOID_RETURN;
 
-    init_net_server_extension(thd);
-    if (is_unix_sock)
-      thd->security_ctx->host=(char*) my_localhost;
+  for (uint i= 0; i < acceptor_threads - 1; i++)
+  {
+    if (mysql_socket_getfd(acceptor_socks[i]) != INVALID_SOCKET)
+      (void) mysql_socket_shutdown(acceptor_socks[i], SHUT_RDWR);
+  }
+
+  mysql_mutex_lock(&LOCK_thread_count);
+  for (uint tmp= 0; tmp < 10 && acceptor_threads_in_use; tmp++)
+  {
+    struct timespec abstime;
+    set_timespec(abstime, 2);
+    mysql_cond_timedwait(&COND_thread_count, &LOCK_thread_count, &abstime);
+  }
+  mysql_mutex_unlock(&LOCK_thread_count);
 
-    if (mysql_socket_getfd(sock) == mysql_socket_getfd(extra_ip_sock))
+  /* Threads still polling (should not happen) keep their sockets */
+  if (!acceptor_threads_in_use)
+  {
+    for (uint i= 0; i < acceptor_threads - 1; i++)
     {
-      thd->extra_port= 1;
-      thd->scheduler= extra_thread_scheduler;
+      if (mysql_socket_getfd(acceptor_socks[i]) != INVALID_SOCKET)
+        (void) mysql_socket_close(acceptor_socks[i]);
     }
-    create_new_thread(thd);
-    set_current_thd(0);
+    my_free(acceptor_socks);
+    acceptor_socks= NULL;
   }
   DBUG_VOID_RETURN;
 }
+#endif /* HAVE_ACCEPTOR_THREADS */
 
 
 #ifdef _WIN32
@@ -7872,6 +8278,8 @@ SHOW_VAR status_vars[]= {
   {"Select_range",             (char*) offsetof(STATUS_VAR, select_range_count_), SHOW_LONG_STATUS},
   {"Select_range_check",       (char*) offsetof(STATUS_VAR, select_range_check_count_), SHOW_LONG_STATUS},
   {"Select_scan",	       (char*) offsetof(STATUS_VAR, select_scan_count_), SHOW_LONG_STATUS},
+  {"Sessions_cached",          (char*) &cached_session_count,   SHOW_LONG_NOFLUSH},
+  {"Sessions_reused",          (char*) &sessions_reused,        SHOW_LONG},
   {"Slave_open_temp_tables",   (char*) &slave_open_temp_tables, SHOW_INT},
 #ifdef HAVE_REPLICATION
   {"Slave_heartbeat_period",   (char*) &show_heartbeat_period, SHOW_SIMPLE_FUNC},
@@ -7929,7 +8337,11 @@ SHOW_VAR status_vars[]= {
   {"Tc_log_page_waits",        (char*) &tc_log_page_waits,      SHOW_LONG},
 #endif
 #ifdef HAVE_POOL_OF_THREADS
+  {"Threadpool_high_prio_events", (char *) &tp_stats.high_prio_events, SHOW_LONGLONG},
   {"Threadpool_idle_threads",  (char *) &show_threadpool_idle_threads, SHOW_SIMPLE_FUNC},
+  {"Threadpool_low_prio_events", (char *) &tp_stats.low_prio_events, SHOW_LONGLONG},
+  {"Threadpool_prio_kickups",  (char *) &tp_stats.prio_kickups, SHOW_LONGLONG},
+  {"Threadpool_stolen_events", (char *) &tp_stats.stolen_events, SHOW_LONGLONG},
   {"Threadpool_threads",       (char *) &tp_stats.num_worker_threads, SHOW_INT},
 #endif
   {"Threads_cached",           (char*) &cached_thread_count,    SHOW_LONG_NOFLUSH},
@@ -122,18 +122,10 @@ extern void query_cache_insert(const char *packet, ulong length,
 
 static my_bool net_write_buff(NET *, const uchar *, ulong);
 
-/** Init with packet info. */
+/** Init the state of a NET which has its packet buffer. */
 
-my_bool my_net_init(NET *net, Vio* vio, uint my_flags)
+static void net_init_state(NET *net, Vio *vio, uint my_flags)
 {
-  DBUG_ENTER("my_net_init");
-  DBUG_PRINT("enter", ("my_flags: %u", my_flags));
-  net->vio = vio;
-  my_net_local_init(net);			/* Set some limits */
-  if (!(net->buff=(uchar*) my_malloc((size_t) net->max_packet+
-				     NET_HEADER_SIZE + COMP_HEADER_SIZE +1,
-				     MYF(MY_WME | my_flags))))
-    DBUG_RETURN(1);
   net->buff_end=net->buff+net->max_packet;
   net->error=0; net->return_status=0;
   net->pkt_nr=net->compress_pkt_nr=0;
@@ -162,10 +154,54 @@ my_bool my_net_init(NET *net, Vio* vio, uint my_flags)
 #endif
     vio_fastsend(vio);
   }
+}
+
+
+/** Init with packet info. */
+
+my_bool my_net_init(NET *net, Vio* vio, uint my_flags)
+{
+  DBUG_ENTER("my_net_init");
+  DBUG_PRINT("enter", ("my_flags: %u", my_flags));
+  net->vio = vio;
+  my_net_local_init(net);			/* Set some limits */
+  if (!(net->buff=(uchar*) my_malloc((size_t) net->max_packet+
+				     NET_HEADER_SIZE + COMP_HEADER_SIZE +1,
+				     MYF(MY_WME | my_flags))))
+    DBUG_RETURN(1);
+  net_init_state(net, vio, my_flags);
   DBUG_RETURN(0);
 }
 
 
+#ifdef MYSQL_SERVER
+/**
+  Init a NET that still has the packet buffer of a previous connection.
+
+  The buffer is kept if it has the size a new NET would get, otherwise
+  it's freed and a new one is allocated.
+*/
+
+my_bool my_net_reinit(NET *net, Vio* vio, uint my_flags)
+{
+  ulong old_max_packet= net->max_packet;
+  DBUG_ENTER("my_net_reinit");
+  if (!net->buff)
+    DBUG_RETURN(my_net_init(net, vio, my_flags));
+  net->vio = vio;
+  my_net_local_init(net);
+  if (net->max_packet != old_max_packet ||
+      net->thread_specific_malloc != MY_TEST(my_flags & MY_THREAD_SPECIFIC))
+  {
+    net_end(net);
+    DBUG_RETURN(my_net_init(net, vio, my_flags));
+  }
+  net_init_state(net, vio, my_flags);
+  DBUG_RETURN(0);
+}
+#endif
+
+
 void net_end(NET *net)
 {
   DBUG_ENTER("net_end");
@@ -898,6 +898,7 @@ class TABLE_READ_PLAN;
   class TRP_INDEX_INTERSECT;
   class TRP_INDEX_MERGE;
   class TRP_GROUP_MIN_MAX;
+  class TRP_SKIP_SCAN;
 
 struct st_index_scan_info;
 struct st_ror_scan_info;
@@ -944,6 +945,10 @@ TABLE_READ_PLAN *merge_same_index_scans(PARAM *param, SEL_IMERGE *imerge,
 static
 TRP_GROUP_MIN_MAX *get_best_group_min_max(PARAM *param, SEL_TREE *tree,
                                           double read_time);
+static key_map get_skip_scan_keys(TABLE *table);
+static
+TRP_SKIP_SCAN *get_best_skip_scan(PARAM *param, COND *cond,
+                                  key_map skip_scan_keys, double read_time);
 
 #ifndef DBUG_OFF
 static void print_sel_tree(PARAM *param, SEL_TREE *tree, key_map *tree_map,
@@ -2797,6 +2802,26 @@ public:
 };
 
 
+/*
+  Plan for a QUICK_SKIP_SCAN_SELECT scan.
+*/
+
+class TRP_SKIP_SCAN : public TABLE_READ_PLAN
+{
+public:
+  uint index;   /* The index chosen for data access */
+  SEL_ARG *key; /* The intervals over the second key part of the index */
+
+  TRP_SKIP_SCAN(uint index_arg, SEL_ARG *key_arg)
+    : index(index_arg), key(key_arg)
+  {}
+  virtual ~TRP_SKIP_SCAN() {}                 /* Remove gcc warning */
+
+  QUICK_SELECT_I *make_quick(PARAM *param, bool retrieve_full_rows,
+                             MEM_ROOT *parent_alloc);
+};
+
+
 typedef struct st_index_scan_info
 {
   uint      idx;      /* # of used key in param->keys */
@@ -2884,6 +2909,8 @@ static int fill_used_fields_bitmap(PARAM *param)
       limit             Query limit
       force_quick_range Prefer to use range (instead of full table scan) even
                         if it is more expensive.
+      try_skip_scan     Also try a skip scan, which can use indexes that are
+                        not in keys_to_use (see get_best_skip_scan())
 
   NOTES
     Updates the following in the select parameter:
@@ -2941,10 +2968,11 @@ static int fill_used_fields_bitmap(PARAM *param)
 int SQL_SELECT::test_quick_select(THD *thd, key_map keys_to_use,
 				  table_map prev_tables,
 				  ha_rows limit, bool force_quick_range, 
-                                  bool ordered_output)
+                                  bool ordered_output, bool try_skip_scan)
 {
   uint idx;
   double scan_time;
+  key_map skip_scan_keys;
   DBUG_ENTER("SQL_SELECT::test_quick_select");
   DBUG_PRINT("enter",("keys_to_use: %lu  prev_tables: %lu  const_tables: %lu",
 		      (ulong) keys_to_use.to_ulonglong(), (ulong) prev_tables,
@@ -2955,7 +2983,11 @@ int SQL_SELECT::test_quick_select(THD *thd, key_map keys_to_use,
   needed_reg.clear_all();
   quick_keys.clear_all();
   DBUG_ASSERT(!head->is_filled_at_execution());
-  if (keys_to_use.is_clear_all() || head->is_filled_at_execution())
+  skip_scan_keys.clear_all();
+  if (try_skip_scan && optimizer_flag(thd, OPTIMIZER_SWITCH_SKIP_SCAN))
+    skip_scan_keys= get_skip_scan_keys(head);
+  if ((keys_to_use.is_clear_all() && skip_scan_keys.is_clear_all()) ||
+      head->is_filled_at_execution())
     DBUG_RETURN(0);
   records= head->stat_records();
   if (!records)
@@ -2974,7 +3006,7 @@ int SQL_SELECT::test_quick_select(THD *thd, key_map keys_to_use,
   DBUG_PRINT("info",("Time to scan table: %g", read_time));
 
   keys_to_use.intersect(head->keys_in_use_for_query);
-  if (!keys_to_use.is_clear_all())
+  if (!keys_to_use.is_clear_all() || !skip_scan_keys.is_clear_all())
   {
     uchar buff[STACK_BUFF_ALLOC];
     MEM_ROOT alloc;
@@ -3071,7 +3103,7 @@ int SQL_SELECT::test_quick_select(THD *thd, key_map keys_to_use,
     TRP_GROUP_MIN_MAX *group_trp;
     double best_read_time= read_time;
 
-    if (cond)
+    if (cond && !keys_to_use.is_clear_all())
     {
       if ((tree= get_mm_tree(&param,cond)))
       {
@@ -3094,7 +3126,8 @@ int SQL_SELECT::test_quick_select(THD *thd, key_map keys_to_use,
       Try to construct a QUICK_GROUP_MIN_MAX_SELECT.
       Notice that it can be constructed no matter if there is a range tree.
     */
-    group_trp= get_best_group_min_max(&param, tree, best_read_time);
+    group_trp= keys_to_use.is_clear_all() ? NULL :
+               get_best_group_min_max(&param, tree, best_read_time);
     if (group_trp)
     {
       param.table->quick_condition_rows= MY_MIN(group_trp->records,
@@ -3202,6 +3235,18 @@ int SQL_SELECT::test_quick_select(THD *thd, key_map keys_to_use,
       }
     }
 
+    if (cond && !skip_scan_keys.is_clear_all())
+    {
+      TRP_SKIP_SCAN *skip_trp;
+      if ((skip_trp= get_best_skip_scan(&param, cond, skip_scan_keys,
+                                        best_read_time)))
+      {
+        set_if_smaller(param.table->quick_condition_rows, skip_trp->records);
+        best_trp= skip_trp;
+        best_read_time= best_trp->read_cost;
+      }
+    }
+
     thd->mem_root= param.old_root;
 
     /* If we got a read plan, create a quick select from it. */
@@ -3408,7 +3453,8 @@ double records_in_column_ranges(PARAM *param, uint idx,
 
   NOTE
     Currently the selectivities of range conditions over different columns are
-    considered independent. 
+    considered independent, except for equalities with constants over the
+    columns of a group with statistics in mysql.column_group_stats.
 
   RETURN
     FALSE  on success
@@ -3521,7 +3567,14 @@ bool calculate_cond_selectivity_for_table(THD *thd, TABLE *table, Item *cond)
     SEL_ARG **key, **end;
     double rows;
     uint idx= 0;
+    /* The columns compared with constants in equalities */
+    MY_BITMAP eq_fields;
+    my_bitmap_map* eq_buf;
   
+    if (!(eq_buf= (my_bitmap_map*)thd->alloc(table->s->column_bitmap_size)))
+      DBUG_RETURN(TRUE);
+    my_bitmap_init(&eq_fields, eq_buf, table->s->fields, FALSE);
+
     init_sql_alloc(&alloc, thd->variables.range_alloc_block_size, 0,
                    MYF(MY_THREAD_SPECIFIC));
     param.thd= thd;
@@ -3578,7 +3631,12 @@ bool calculate_cond_selectivity_for_table(THD *thd, TABLE *table, Item *cond)
         {
           rows= records_in_column_ranges(&param, idx, *key);
           if (rows != HA_POS_ERROR)
+          {
             (*key)->field->cond_selectivity= rows/table_records;
+            if ((*key)->elements == 1 && (*key)->is_singlepoint() &&
+                !(*key)->is_null_interval())
+              bitmap_set_bit(&eq_fields, (*key)->field->field_index);
+          }
         } 
       }
     }
@@ -3591,6 +3649,12 @@ bool calculate_cond_selectivity_for_table(THD *thd, TABLE *table, Item *cond)
         table->cond_selectivity*= table_field->cond_selectivity;
     }
 
+    /*
+      Take into account the correlation between the columns compared with
+      constants when statistics on groups of these columns is available
+    */
+    table->cond_selectivity*= get_column_group_selectivity(table, &eq_fields);
+
   free_alloc:
     thd->mem_root= param.old_root;
     free_root(&alloc, MYF(0));
@@ -7466,6 +7530,112 @@ static SEL_TREE *get_ne_mm_tree(RANGE_OPT_PARAM *param, Item_func *cond_func,
 }
    
 
+/*
+  Build a SEL_TREE for "field IN (c1, ..., cN)" from the sorted constants
+
+  SYNOPSIS
+    get_mm_tree_for_in_list()
+      param       PARAM from SQL_SELECT::test_quick_select
+      func        the IN predicate, its constants are in func->array
+      field       field in the predicate
+
+  DESCRIPTION
+    The general way to build the tree is to OR the trees built for every
+    "field = ci", which allocates a SEL_TREE per constant and merges it with
+    key_or(). For lists of thousands of constants most of the time of the
+    range optimizer is spent there.
+
+    Here the point intervals are built directly for every key part over the
+    field, walking the constants in the order of func->array, and appended
+    to the tree of intervals of the key. An interval that does not come
+    after the last one (this happens when the order of the key differs from
+    the order of the IN comparison, or when two constants are equal after
+    being stored in the field) is merged with key_or() instead. The result
+    is the same tree the general way builds.
+
+  RETURN
+    The built tree
+    NULL if no tree can be built
+*/
+
+static SEL_TREE *get_mm_tree_for_in_list(RANGE_OPT_PARAM *param,
+                                         Item_func_in *func, Field *field)
+{
+  in_vector *array= func->array;
+  KEY_PART *key_part= param->key_parts;
+  KEY_PART *end= param->key_parts_end;
+  SEL_TREE *tree= NULL;
+  bool all_impossible= TRUE;
+  DBUG_ENTER("get_mm_tree_for_in_list");
+
+  if (field->table != param->table)
+    DBUG_RETURN(NULL);
+
+  /* See the comment for NOT IN in get_func_mm_tree() */
+  MEM_ROOT *tmp_root= param->mem_root;
+  param->thd->mem_root= param->old_root;
+  Item *value_item= array->create_item();
+  param->thd->mem_root= tmp_root;
+  if (!value_item)
+    DBUG_RETURN(NULL);
+
+  for (; key_part != end; key_part++)
+  {
+    if (!field->eq(key_part->field))
+      continue;
+    if (!tree && !(tree= new SEL_TREE()))
+      DBUG_RETURN(NULL);                        // OOM
+
+    SEL_ARG *root= NULL, *last= NULL;
+    for (uint i= 0; i < array->used_count; i++)
+    {
+      if (i && !array->compare_elems(i, i - 1))
+        continue;                               // A duplicate constant
+      array->value_to_item(i, value_item);
+      SEL_ARG *sel_arg= get_mm_leaf(param, func, key_part->field, key_part,
+                                    Item_func::EQ_FUNC, value_item);
+      if (!sel_arg)
+      {
+        /* This key can't be used for one of the constants */
+        root= NULL;
+        all_impossible= FALSE;
+        break;
+      }
+      if (sel_arg->type == SEL_ARG::IMPOSSIBLE)
+        continue;
+      all_impossible= FALSE;
+      sel_arg->part= (uchar) key_part->part;
+      sel_arg->max_part_no= sel_arg->part + 1;
+      if (!root)
+        root= sel_arg;
+      else if (sel_arg->type == SEL_ARG::KEY_RANGE &&
+               root->type == SEL_ARG::KEY_RANGE &&
+               last->cmp_max_to_min(sel_arg) < 0)
+        root= root->insert(sel_arg);
+      else
+      {
+        if (!(root= key_or(param, root, sel_arg)))
+          break;
+        last= root->type == SEL_ARG::KEY_RANGE ? root->last() : root;
+        continue;
+      }
+      last= sel_arg;
+    }
+    if (root)
+    {
+      tree->keys[key_part->key]= root;
+      tree->keys_map.set_bit(key_part->key);
+    }
+  }
+
+  if (tree && all_impossible)
+    tree->type= SEL_TREE::IMPOSSIBLE;
+  else if (tree && tree->keys_map.is_clear_all())
+    tree= NULL;
+  DBUG_RETURN(tree);
+}
+
+
 /*
   Build a SEL_TREE for a simple predicate
  
@@ -7697,6 +7867,16 @@ static SEL_TREE *get_func_mm_tree(RANGE_OPT_PARAM *param, Item_func *cond_func,
         }
       }
     }
+    else if (func->array &&
+             ((func->array->result_type() == INT_RESULT &&
+               cmp_type == INT_RESULT && field->cmp_type() == INT_RESULT) ||
+              (func->array->result_type() == STRING_RESULT &&
+               cmp_type == STRING_RESULT &&
+               field->cmp_type() == STRING_RESULT)))
+    {
+      /* "t.key IN (c1, c2, ...)" where c{i} are constants */
+      tree= get_mm_tree_for_in_list(param, func, field);
+    }
     else
     {    
       tree= get_mm_parts(param, cond_func, field, Item_func::EQ_FUNC,
@@ -11179,10 +11359,18 @@ int read_keys_and_merge_scans(THD *thd,
     DBUG_EXECUTE_IF("only_one_Unique_may_be_created", 
                     DBUG_SET("+d,index_merge_may_not_create_a_Unique"); );
 
+    /*
+      A union can hash row positions: a row always has the same one. The
+      primary key images that are the refs of some engines may be equal
+      without being the same bytes, so they are sorted.
+    */
     unique= new Unique(refpos_order_cmp, (void *)file,
                        file->ref_length,
                        thd->variables.sortbuff_size,
-		       intersection ? quick_selects.elements : 0);                     
+		       intersection ? quick_selects.elements : 0,
+                       !intersection &&
+                       !(file->ha_table_flags() &
+                         HA_PRIMARY_KEY_REQUIRED_FOR_POSITION));
     if (!unique)
       goto err;
     *unique_ptr= unique;
@@ -12108,6 +12296,15 @@ Explain_quick_select* QUICK_GROUP_MIN_MAX_SELECT::get_explain(MEM_ROOT *alloc)
 }
 
 
+Explain_quick_select* QUICK_SKIP_SCAN_SELECT::get_explain(MEM_ROOT *alloc)
+{
+  Explain_quick_select *res;
+  if ((res= new (alloc) Explain_quick_select(QS_TYPE_SKIP_SCAN)))
+    res->range.set(alloc, head->key_info[index].name, max_used_key_length);
+  return res;
+}
+
+
 Explain_quick_select* QUICK_INDEX_SORT_SELECT::get_explain(MEM_ROOT *alloc)
 {
   Explain_quick_select *res;
@@ -14742,6 +14939,468 @@ void QUICK_GROUP_MIN_MAX_SELECT::add_keys_and_lengths(String *key_names,
 }
 
 
+/*******************************************************************************
+* Implementation of QUICK_SKIP_SCAN_SELECT
+*******************************************************************************/
+
+/*
+  Expected share of the rows of a table in a range over a column without
+  statistics
+*/
+#define SKIP_SCAN_RANGE_SELECTIVITY (1.0 / 3)
+
+/*
+  Get the indexes that a skip scan can use.
+
+  SYNOPSIS
+    get_skip_scan_keys()
+    table     The table
+
+  RETURN
+    The indexes of the table that are in use for the query and have at least
+    two key parts
+*/
+
+static key_map get_skip_scan_keys(TABLE *table)
+{
+  key_map keys;
+  keys.clear_all();
+  for (uint keynr= 0; keynr < table->s->keys; keynr++)
+  {
+    KEY *key_info= table->key_info + keynr;
+    if (table->keys_in_use_for_query.is_set(keynr) &&
+        key_info->user_defined_key_parts >= 2 &&
+        !(key_info->flags & (HA_SPATIAL | HA_FULLTEXT)))
+      keys.set_bit(keynr);
+  }
+  return keys;
+}
+
+
+/*
+  Find the best skip scan plan.
+
+  SYNOPSIS
+    get_best_skip_scan()
+    param          Parameter from test_quick_select
+    cond           The condition on the table
+    skip_scan_keys Indexes the skip scan can use, see get_skip_scan_keys()
+    read_time      Best read time found so far
+
+  DESCRIPTION
+    A skip scan is considered for each index that has range conditions on
+    its second key part but none on the first one. It makes an index lookup
+    for each distinct value of the first key part, whose number is
+    estimated from the cardinality of the first key part, and one for
+    each of the ranges for each of the values. The rows in the ranges are
+    estimated from the statistics of the column of the second key part if
+    the statistics from the statistical tables are used for the index,
+    otherwise from the cardinality of the first two key parts for
+    equalities and as a fixed share of the rows for other ranges.
+
+    The ranges are taken from a range tree of their own, built from the
+    first two key parts of the indexes in skip_scan_keys only. So the
+    indexes need not be among the keys of the other range plans, and
+    they do not become possible keys of the table: the skip scan is
+    never a candidate for ref access.
+
+  RETURN
+    The plan if it is cheaper than read_time, otherwise NULL
+*/
+
+static TRP_SKIP_SCAN *
+get_best_skip_scan(PARAM *param, COND *cond, key_map skip_scan_keys,
+                   double read_time)
+{
+  TABLE *table= param->table;
+  double table_records= rows2double(table->stat_records());
+  TRP_SKIP_SCAN *best_trp= NULL;
+  KEY_PART *save_key_parts= param->key_parts;
+  KEY_PART *save_key_parts_end= param->key_parts_end;
+  uint save_keys= param->keys;
+  KEY_PART *key_parts;
+  SEL_TREE *tree;
+  DBUG_ENTER("get_best_skip_scan");
+
+  if (table_records < 1 ||
+      save_keys + skip_scan_keys.bits_set() > MAX_KEY ||
+      !(key_parts= (KEY_PART*) alloc_root(param->mem_root,
+                                          sizeof(KEY_PART) * 2 *
+                                          skip_scan_keys.bits_set())))
+    DBUG_RETURN(NULL);
+
+  /*
+    Describe the first two key parts of the indexes after the keys of the
+    other plans, so that the plans built so far stay valid.
+  */
+  param->key_parts= key_parts;
+  for (uint keynr= 0; keynr < table->s->keys; keynr++)
+  {
+    KEY_PART_INFO *key_part_info= table->key_info[keynr].key_part;
+    if (!skip_scan_keys.is_set(keynr))
+      continue;
+    param->key[param->keys]= key_parts;
+    for (uint part= 0; part < 2; part++, key_parts++, key_part_info++)
+    {
+      key_parts->key=          param->keys;
+      key_parts->part=         part;
+      key_parts->length=       key_part_info->length;
+      key_parts->store_length= key_part_info->store_length;
+      key_parts->field=        key_part_info->field;
+      key_parts->null_bit=     key_part_info->null_bit;
+      key_parts->image_type=   Field::itRAW;
+      key_parts->flag=         (uint8) key_part_info->key_part_flag;
+    }
+    param->real_keynr[param->keys++]= keynr;
+  }
+  param->key_parts_end= key_parts;
+  param->alloced_sel_args= 0;
+
+  if (!(tree= get_mm_tree(param, cond)) ||
+      (tree->type != SEL_TREE::KEY && tree->type != SEL_TREE::KEY_SMALLER))
+    goto end;
+
+  for (uint idx= save_keys; idx < param->keys; idx++)
+  {
+    SEL_ARG *key= tree->keys[idx];
+    uint keynr= param->real_keynr[idx];
+    KEY *key_info= table->key_info + keynr;
+    KEY_PART_INFO *key_part= key_info->key_part;
+    double rec_per_prefix, prefixes, rows= 0, cost;
+    uint ranges= 0;
+
+    if (!key || key->type != SEL_ARG::KEY_RANGE || key->part != 1 ||
+        ((key_part[0].key_part_flag | key_part[1].key_part_flag) &
+         (HA_PART_KEY_SEG | HA_BLOB_PART)) ||
+        (table->file->index_flags(keynr, 1, 1) &
+         (HA_READ_NEXT | HA_READ_ORDER | HA_READ_RANGE)) !=
+        (HA_READ_NEXT | HA_READ_ORDER | HA_READ_RANGE) ||
+        (rec_per_prefix= key_info->actual_rec_per_key(0)) <= 0)
+      continue;
+    prefixes= MY_MAX(table_records / rec_per_prefix, 1.0);
+
+    for (SEL_ARG *sel_range= key->first(); sel_range;
+         sel_range= sel_range->next)
+    {
+      uint length= key_part[1].store_length;
+      uint range_flag= sel_range->min_flag | sel_range->max_flag;
+      bool eq_range= !range_flag && !memcmp(sel_range->min_value,
+                                            sel_range->max_value, length);
+      ranges++;
+      if (key_info->is_statistics_from_stat_tables &&
+          key_part[1].field->read_stats)
+      {
+        key_range min_key= { sel_range->min_value, length, 1, HA_READ_KEY_EXACT };
+        key_range max_key= { sel_range->max_value, length, 1, HA_READ_KEY_EXACT };
+        rows+= get_column_range_cardinality(key_part[1].field,
+                                            (range_flag & NO_MIN_RANGE) ?
+                                            NULL : &min_key,
+                                            (range_flag & NO_MAX_RANGE) ?
+                                            NULL : &max_key,
+                                            range_flag);
+      }
+      else if (eq_range && key_info->actual_rec_per_key(1) > 0)
+        rows+= prefixes * key_info->actual_rec_per_key(1);
+      else
+        rows+= table_records * SKIP_SCAN_RANGE_SELECTIVITY;
+    }
+    set_if_smaller(rows, table_records);
+
+    /* One lookup for each prefix and each of its ranges */
+    double lookups= prefixes * (ranges + 1);
+    set_if_smaller(lookups, (double) UINT_MAX32);
+    if (table->covering_keys.is_set(keynr))
+      cost= table->file->keyread_time(keynr, (uint) lookups, (ha_rows) rows);
+    else
+      cost= table->file->read_time(keynr, (uint) lookups, (ha_rows) rows);
+    cost+= rows / TIME_FOR_COMPARE;
+
+    DBUG_PRINT("info", ("index %u: %g prefixes, %u ranges, %g rows, cost %g",
+                        keynr, prefixes, ranges, rows, cost));
+    if (cost < read_time)
+    {
+      if (!(best_trp= new (param->mem_root) TRP_SKIP_SCAN(keynr, key)))
+        break;
+      best_trp->read_cost= read_time= cost;
+      best_trp->records= (ha_rows) rows;
+    }
+  }
+
+end:
+  param->key_parts= save_key_parts;
+  param->key_parts_end= save_key_parts_end;
+  param->keys= save_keys;
+  DBUG_RETURN(best_trp);
+}
+
+
+/*
+  Construct a new skip scan quick select from the plan.
+
+  SYNOPSIS
+    TRP_SKIP_SCAN::make_quick()
+    param              Parameter from test_quick_select
+    retrieve_full_rows ignored
+    parent_alloc       ignored
+
+  NOTES
+    Make_quick ignores retrieve_full_rows as QUICK_SKIP_SCAN_SELECT
+    doesn't distinguish between 'index only' scans and full record
+    retrieval scans.
+
+  RETURN
+    New QUICK_SKIP_SCAN_SELECT object if successfully created,
+    NULL otherwise.
+*/
+
+QUICK_SELECT_I *
+TRP_SKIP_SCAN::make_quick(PARAM *param, bool retrieve_full_rows,
+                          MEM_ROOT *parent_alloc)
+{
+  QUICK_SKIP_SCAN_SELECT *quick;
+  DBUG_ENTER("TRP_SKIP_SCAN::make_quick");
+
+  if ((quick= new QUICK_SKIP_SCAN_SELECT(param->thd, param->table, index,
+                                         read_cost, records)))
+  {
+    for (SEL_ARG *sel_range= key->first(); sel_range;
+         sel_range= sel_range->next)
+    {
+      if (quick->add_range(sel_range))
+      {
+        delete quick;
+        quick= NULL;
+        break;
+      }
+    }
+  }
+  param->thd->mem_root= param->old_root;
+  DBUG_RETURN(quick);
+}
+
+
+QUICK_SKIP_SCAN_SELECT::
+QUICK_SKIP_SCAN_SELECT(THD *thd, TABLE *table, uint use_index,
+                       double read_cost_arg, ha_rows records_arg)
+  :file(table->file), index_info(table->key_info + use_index),
+   min_key(NULL), max_key(NULL), cur_range(0), have_prefix(FALSE),
+   in_range(FALSE)
+{
+  head=   table;
+  index=  use_index;
+  record= head->record[0];
+  read_time= read_cost_arg;
+  records= records_arg;
+  used_key_parts= 2;
+  prefix_len= index_info->key_part[0].store_length;
+  max_used_key_length= prefix_len + index_info->key_part[1].store_length;
+  my_init_dynamic_array(&ranges, sizeof(QUICK_RANGE*), 16, 16,
+                        MYF(MY_THREAD_SPECIFIC));
+  /* The ranges are allocated in alloc */
+  init_sql_alloc(&alloc, thd->variables.range_alloc_block_size, 0,
+                 MYF(MY_THREAD_SPECIFIC));
+  thd->mem_root= &alloc;
+}
+
+
+int QUICK_SKIP_SCAN_SELECT::init()
+{
+  if (min_key) /* Already initialized. */
+    return 0;
+  if (!(min_key= (uchar*) alloc_root(&alloc, max_used_key_length)) ||
+      !(max_key= (uchar*) alloc_root(&alloc, max_used_key_length)))
+    return 1;
+  return 0;
+}
+
+
+QUICK_SKIP_SCAN_SELECT::~QUICK_SKIP_SCAN_SELECT()
+{
+  DBUG_ENTER("QUICK_SKIP_SCAN_SELECT::~QUICK_SKIP_SCAN_SELECT");
+  range_end();
+  delete_dynamic(&ranges);
+  free_root(&alloc, MYF(0));
+  DBUG_VOID_RETURN;
+}
+
+
+/*
+  Add a range over the second key part, made from a SEL_ARG interval.
+
+  RETURN
+    FALSE on success
+    TRUE  otherwise
+*/
+
+bool QUICK_SKIP_SCAN_SELECT::add_range(SEL_ARG *sel_range)
+{
+  QUICK_RANGE *range;
+  uint length= index_info->key_part[1].store_length;
+
+  range= new QUICK_RANGE(sel_range->min_value, length, make_keypart_map(1),
+                         sel_range->max_value, length, make_keypart_map(1),
+                         sel_range->min_flag | sel_range->max_flag);
+  return !range || insert_dynamic(&ranges, (uchar*) &range);
+}
+
+
+int QUICK_SKIP_SCAN_SELECT::reset()
+{
+  int result;
+  DBUG_ENTER("QUICK_SKIP_SCAN_SELECT::reset");
+
+  cur_range= 0;
+  have_prefix= in_range= FALSE;
+  if (file->inited == handler::RND && (result= file->ha_rnd_end()))
+    DBUG_RETURN(result);
+  if (file->inited == handler::NONE && (result= file->ha_index_init(index, 1)))
+  {
+    file->print_error(result, MYF(0));
+    DBUG_RETURN(result);
+  }
+  DBUG_RETURN(0);
+}
+
+
+void QUICK_SKIP_SCAN_SELECT::range_end()
+{
+  if (file->inited != handler::NONE)
+    file->ha_index_or_rnd_end();
+}
+
+
+/*
+  Find the next value of the first key part and store it at the start of
+  min_key and max_key.
+
+  RETURN
+    0                  on success
+    HA_ERR_END_OF_FILE if there are no more values
+    other              if some error occurred
+*/
+
+int QUICK_SKIP_SCAN_SELECT::next_prefix()
+{
+  int result;
+
+  /* The end of the last range must not stop the jump */
+  file->set_end_range(NULL);
+  if (!have_prefix)
+    result= file->ha_index_first(record);
+  else
+    result= file->ha_index_read_map(record, min_key, make_prev_keypart_map(1),
+                                    HA_READ_AFTER_KEY);
+  if (result)
+    return result == HA_ERR_KEY_NOT_FOUND ? HA_ERR_END_OF_FILE : result;
+  key_copy(min_key, record, index_info, prefix_len);
+  memcpy(max_key, min_key, prefix_len);
+  have_prefix= TRUE;
+  return 0;
+}
+
+
+/*
+  Read the first row of a range for the current value of the first key part.
+
+  RETURN
+    0                  on success
+    HA_ERR_END_OF_FILE if there are no rows in the range
+    other              if some error occurred
+*/
+
+int QUICK_SKIP_SCAN_SELECT::read_first_in_range(QUICK_RANGE *range)
+{
+  key_range start_key, end_key;
+
+  start_key.key= min_key;
+  start_key.length= prefix_len;
+  start_key.keypart_map= make_prev_keypart_map(1);
+  start_key.flag= HA_READ_KEY_OR_NEXT;
+  if (!(range->flag & NO_MIN_RANGE))
+  {
+    memcpy(min_key + prefix_len, range->min_key, range->min_length);
+    start_key.length+= range->min_length;
+    start_key.keypart_map= make_prev_keypart_map(2);
+    if (range->flag & NEAR_MIN)
+      start_key.flag= HA_READ_AFTER_KEY;
+  }
+
+  end_key.key= max_key;
+  end_key.length= prefix_len;
+  end_key.keypart_map= make_prev_keypart_map(1);
+  end_key.flag= HA_READ_AFTER_KEY;
+  if (!(range->flag & NO_MAX_RANGE))
+  {
+    memcpy(max_key + prefix_len, range->max_key, range->max_length);
+    end_key.length+= range->max_length;
+    end_key.keypart_map= make_prev_keypart_map(2);
+    if (range->flag & NEAR_MAX)
+      end_key.flag= HA_READ_BEFORE_KEY;
+  }
+
+  return file->read_range_first(&start_key, &end_key, FALSE, TRUE);
+}
+
+
+/*
+  Get the next row of the skip scan.
+
+  DESCRIPTION
+    The ranges are read one after another for the current value of the
+    first key part. When they are all read, the scan jumps to the next
+    value of the first key part.
+
+  RETURN
+    0                  on success
+    HA_ERR_END_OF_FILE if returned all rows
+    other              if some error occurred
+*/
+
+int QUICK_SKIP_SCAN_SELECT::get_next()
+{
+  int result;
+  DBUG_ENTER("QUICK_SKIP_SCAN_SELECT::get_next");
+
+  for (;;)
+  {
+    if (in_range)
+    {
+      if ((result= file->read_range_next()) != HA_ERR_END_OF_FILE)
+        DBUG_RETURN(result);
+      in_range= FALSE;
+      cur_range++;
+    }
+    else if (!have_prefix || cur_range == ranges.elements)
+    {
+      if ((result= next_prefix()))
+        DBUG_RETURN(result);
+      cur_range= 0;
+    }
+    else
+    {
+      QUICK_RANGE *range= *dynamic_element(&ranges, cur_range, QUICK_RANGE**);
+      if (!(result= read_first_in_range(range)))
+      {
+        in_range= TRUE;
+        DBUG_RETURN(0);
+      }
+      if (result != HA_ERR_END_OF_FILE)
+        DBUG_RETURN(result);
+      cur_range++;
+    }
+  }
+}
+
+
+void QUICK_SKIP_SCAN_SELECT::add_keys_and_lengths(String *key_names,
+                                                  String *used_lengths)
+{
+  bool first= TRUE;
+
+  add_key_and_length(key_names, used_lengths, &first);
+}
+
+
 #ifndef DBUG_OFF
 
 static void print_sel_tree(PARAM *param, SEL_TREE *tree, key_map *tree_map,
@@ -14994,5 +15653,15 @@ void QUICK_GROUP_MIN_MAX_SELECT::dbug_dump(int indent, bool verbose)
 }
 
 
+void QUICK_SKIP_SCAN_SELECT::dbug_dump(int indent, bool verbose)
+{
+  fprintf(DBUG_FILE,
+          "%*squick_skip_scan_select: index %s (%d), length: %d, "
+          "%d ranges\n",
+	  indent, "", index_info->name, index, max_used_key_length,
+          ranges.elements);
+}
+
+
 #endif /* !DBUG_OFF */
 
@@ -304,7 +304,8 @@ public:
     QS_TYPE_FULLTEXT   = 4,
     QS_TYPE_ROR_INTERSECT = 5,
     QS_TYPE_ROR_UNION = 6,
-    QS_TYPE_GROUP_MIN_MAX = 7
+    QS_TYPE_GROUP_MIN_MAX = 7,
+    QS_TYPE_SKIP_SCAN = 8
   };
 
   /* Get type of this quick select - one of the QS_TYPE_* values */
@@ -944,6 +945,57 @@ public:
 };
 
 
+/*
+  Skip scan of an index for range conditions on its second key part
+
+  The query has range conditions on the second key part of the index but
+  none on the first one. For each distinct value of the first key part,
+  found by jumping over the index entries with the previous value as
+  QUICK_GROUP_MIN_MAX_SELECT does, the ranges over the second key part
+  are read with that value prepended to their bounds. The records are
+  returned in key order.
+*/
+
+class QUICK_SKIP_SCAN_SELECT : public QUICK_SELECT_I
+{
+private:
+  handler * const file;  /* The handler used to get data. */
+  KEY *index_info;       /* The index chosen for data access */
+  uint prefix_len;       /* Length of the first key part */
+  /*
+    The bounds of the current range, both starting with the current value
+    of the first key part
+  */
+  uchar *min_key, *max_key;
+  DYNAMIC_ARRAY ranges;  /* Array of range ptrs for the second key part */
+  uint cur_range;
+  bool have_prefix;      /* TRUE <=> min_key has a value of the first part */
+  bool in_range;         /* TRUE <=> reading the rows of cur_range */
+  MEM_ROOT alloc;        /* Memory pool for this quick select's data */
+
+  int next_prefix();
+  int read_first_in_range(QUICK_RANGE *range);
+public:
+  QUICK_SKIP_SCAN_SELECT(THD *thd, TABLE *table, uint use_index,
+                         double read_cost, ha_rows records);
+  ~QUICK_SKIP_SCAN_SELECT();
+  bool add_range(SEL_ARG *sel_range);
+  int init();
+  void need_sorted_output() { /* always do it */ }
+  int reset();
+  int get_next();
+  void range_end();
+  bool reverse_sorted() { return false; }
+  bool unique_key_range() { return false; }
+  int get_type() { return QS_TYPE_SKIP_SCAN; }
+  void add_keys_and_lengths(String *key_names, String *used_lengths);
+#ifndef DBUG_OFF
+  void dbug_dump(int indent, bool verbose);
+#endif
+  Explain_quick_select *get_explain(MEM_ROOT *alloc);
+};
+
+
 class QUICK_SELECT_DESC: public QUICK_RANGE_SELECT
 {
 public:
@@ -994,7 +1046,8 @@ class SQL_SELECT :public Sql_alloc {
   {
     key_map tmp;
     tmp.set_all();
-    return test_quick_select(thd, tmp, 0, limit, force_quick_range, FALSE) < 0;
+    return test_quick_select(thd, tmp, 0, limit, force_quick_range,
+                             FALSE, TRUE) < 0;
   }
   /* 
     RETURN
@@ -1011,7 +1064,7 @@ class SQL_SELECT :public Sql_alloc {
   }
   int test_quick_select(THD *thd, key_map keys, table_map prev_tables,
 			ha_rows limit, bool force_quick_range, 
-                        bool ordered_output);
+                        bool ordered_output, bool try_skip_scan= FALSE);
 };
 
 
@@ -29,6 +29,7 @@
 #include "sql_priv.h"
 #include "records.h"
 #include "filesort.h"            // filesort_free_buffers
+#include "sql_sort.h"            // PACKED_ADDON_LENGTH_BYTES
 #include "opt_range.h"                          // SQL_SELECT
 #include "sql_class.h"                          // THD
 #include "sql_base.h"
@@ -37,6 +38,7 @@ static int rr_quick(READ_RECORD *info);
 int rr_sequential(READ_RECORD *info);
 static int rr_from_tempfile(READ_RECORD *info);
 static int rr_unpack_from_tempfile(READ_RECORD *info);
+static int rr_unpack_packed_from_tempfile(READ_RECORD *info);
 static int rr_unpack_from_buffer(READ_RECORD *info);
 static int rr_from_pointers(READ_RECORD *info);
 static int rr_from_cache(READ_RECORD *info);
@@ -148,6 +150,10 @@ void init_read_record_idx(READ_RECORD *info, THD *thd, TABLE *table,
       Same as rr_unpack_from_buffer except that references are fetched from
       temporary file. Should obviously not really happen other than in
       strange configurations.
+    rr_unpack_packed_from_tempfile:
+    -------------------------------
+      Same as rr_unpack_from_tempfile for records that are of different
+      lengths as their fields are packed (table->sort.using_packed_addons).
 
     rr_from_tempfile:
     -----------------
@@ -219,8 +225,10 @@ bool init_read_record(READ_RECORD *info,THD *thd, TABLE *table,
       !(select && select->quick)) 
   {
     DBUG_PRINT("info",("using rr_from_tempfile"));
-    info->read_record= (table->sort.addon_field ?
-                        rr_unpack_from_tempfile : rr_from_tempfile);
+    info->read_record= (!table->sort.addon_field ? rr_from_tempfile :
+                        table->sort.using_packed_addons ?
+                        rr_unpack_packed_from_tempfile :
+                        rr_unpack_from_tempfile);
     info->io_cache=tempfile;
     reinit_io_cache(info->io_cache,READ_CACHE,0L,0,0);
     info->ref_pos=table->file->ref;
@@ -529,6 +537,35 @@ static int rr_unpack_from_tempfile(READ_RECORD *info)
   return 0;
 }
 
+
+/**
+  Read a result set record with packed fields from a temporary file after
+  sorting. The record starts with its length.
+
+  @retval
+    0   Record successfully read.
+  @retval
+    -1   There is no record to be read anymore.
+*/
+
+static int rr_unpack_packed_from_tempfile(READ_RECORD *info)
+{
+  uchar *buff= info->rec_buf;
+  uint length;
+  if (my_b_read(info->io_cache, buff, PACKED_ADDON_LENGTH_BYTES))
+    return -1;
+  length= uint2korr(buff);
+  DBUG_ASSERT(length >= PACKED_ADDON_LENGTH_BYTES &&
+              length <= info->ref_length);
+  if (my_b_read(info->io_cache, buff + PACKED_ADDON_LENGTH_BYTES,
+                length - PACKED_ADDON_LENGTH_BYTES))
+    return -1;
+  TABLE *table= info->table;
+  (*table->sort.unpack)(table->sort.addon_field, buff, buff + length);
+
+  return 0;
+}
+
 static int rr_from_pointers(READ_RECORD *info)
 {
   int tmp;
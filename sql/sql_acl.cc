@@ -728,6 +728,8 @@ static bool initialized=0;
 static bool allow_all_hosts=1;
 static HASH acl_check_hosts, column_priv_hash, proc_priv_hash, func_priv_hash;
 static DYNAMIC_ARRAY acl_wild_hosts;
+/* acl_users by user name, the anonymous users have the empty name */
+static HASH acl_users_by_name;
 static Hash_filo<acl_entry> *acl_cache;
 static uint grant_version=0; /* Version of priv tables. incremented by acl_load */
 static ulong get_access(TABLE *form,uint fieldnr, uint *next_field=0);
@@ -736,6 +738,8 @@ static int acl_compare(ACL_ACCESS *a,ACL_ACCESS *b);
 static ulong get_sort(uint count,...);
 static void init_check_host(void);
 static void rebuild_check_host(void);
+static void init_acl_user_index(void);
+static void rebuild_acl_user_index(void);
 static void rebuild_role_grants(void);
 static ACL_USER *find_user_exact(const char *host, const char *user);
 static ACL_USER *find_user_wild(const char *host, const char *user, const char *ip= 0);
@@ -1321,6 +1325,7 @@ static my_bool acl_load(THD *thd, TABLE_LIST *tables)
 	   sizeof(ACL_USER),(qsort_cmp) acl_compare);
   end_read_record(&read_record_info);
   freeze_size(&acl_users);
+  init_acl_user_index();
 
   if (init_read_record(&read_record_info, thd, table=tables[2].table,
                        NULL, 1, 1, FALSE))
@@ -1483,6 +1488,7 @@ void acl_free(bool end)
   delete_dynamic(&acl_wild_hosts);
   delete_dynamic(&acl_proxy_users);
   my_hash_free(&acl_check_hosts);
+  my_hash_free(&acl_users_by_name);
   my_hash_free(&acl_roles_mappings);
   plugin_unlock(0, native_password_plugin);
   plugin_unlock(0, old_password_plugin);
@@ -1573,6 +1579,7 @@ my_bool acl_reload(THD *thd)
   old_mem= acl_memroot;
   delete_dynamic(&acl_wild_hosts);
   my_hash_free(&acl_check_hosts);
+  my_hash_free(&acl_users_by_name);
 
   if ((return_val= acl_load(thd, tables)))
   {					// Error. Revert to old list
@@ -1586,6 +1593,7 @@ my_bool acl_reload(THD *thd)
     acl_dbs= old_acl_dbs;
     acl_memroot= old_mem;
     init_check_host();
+    init_acl_user_index();
   }
   else
   {
@@ -1957,52 +1965,47 @@ static void acl_update_user(const char *user, const char *host,
 			    const LEX_STRING *plugin,
 			    const LEX_STRING *auth)
 {
+  ACL_USER *acl_user;
+
   mysql_mutex_assert_owner(&acl_cache->lock);
 
-  for (uint i=0 ; i < acl_users.elements ; i++)
+  if (!(acl_user= find_user_exact(host, user)))
+    return;
+  if (plugin->str[0])
   {
-    ACL_USER *acl_user=dynamic_element(&acl_users,i,ACL_USER*);
-    if (acl_user->eq(user, host))
+    acl_user->plugin= *plugin;
+    acl_user->auth_string.str= auth->str ?
+      strmake_root(&acl_memroot, auth->str, auth->length) : const_cast<char*>("");
+    acl_user->auth_string.length= auth->length;
+    if (fix_user_plugin_ptr(acl_user))
+      acl_user->plugin.str= strmake_root(&acl_memroot, plugin->str, plugin->length);
+  }
+  else
+    if (password[0])
     {
-      if (plugin->str[0])
-      {
-        acl_user->plugin= *plugin;
-        acl_user->auth_string.str= auth->str ?
-          strmake_root(&acl_memroot, auth->str, auth->length) : const_cast<char*>("");
-        acl_user->auth_string.length= auth->length;
-        if (fix_user_plugin_ptr(acl_user))
-          acl_user->plugin.str= strmake_root(&acl_memroot, plugin->str, plugin->length);
-      }
-      else
-        if (password[0])
-        {
-          acl_user->auth_string.str= strmake_root(&acl_memroot, password, password_len);
-          acl_user->auth_string.length= password_len;
-          set_user_salt(acl_user, password, password_len);
-          set_user_plugin(acl_user, password_len);
-        }
-      acl_user->access=privileges;
-      if (mqh->specified_limits & USER_RESOURCES::QUERIES_PER_HOUR)
-        acl_user->user_resource.questions=mqh->questions;
-      if (mqh->specified_limits & USER_RESOURCES::UPDATES_PER_HOUR)
-        acl_user->user_resource.updates=mqh->updates;
-      if (mqh->specified_limits & USER_RESOURCES::CONNECTIONS_PER_HOUR)
-        acl_user->user_resource.conn_per_hour= mqh->conn_per_hour;
-      if (mqh->specified_limits & USER_RESOURCES::USER_CONNECTIONS)
-        acl_user->user_resource.user_conn= mqh->user_conn;
-      if (ssl_type != SSL_TYPE_NOT_SPECIFIED)
-      {
-        acl_user->ssl_type= ssl_type;
-        acl_user->ssl_cipher= (ssl_cipher ? strdup_root(&acl_memroot,ssl_cipher) :
-                               0);
-        acl_user->x509_issuer= (x509_issuer ? strdup_root(&acl_memroot,x509_issuer) :
-                                0);
-        acl_user->x509_subject= (x509_subject ?
-                                 strdup_root(&acl_memroot,x509_subject) : 0);
-      }
-      /* search complete: */
-      break;
+      acl_user->auth_string.str= strmake_root(&acl_memroot, password, password_len);
+      acl_user->auth_string.length= password_len;
+      set_user_salt(acl_user, password, password_len);
+      set_user_plugin(acl_user, password_len);
     }
+  acl_user->access=privileges;
+  if (mqh->specified_limits & USER_RESOURCES::QUERIES_PER_HOUR)
+    acl_user->user_resource.questions=mqh->questions;
+  if (mqh->specified_limits & USER_RESOURCES::UPDATES_PER_HOUR)
+    acl_user->user_resource.updates=mqh->updates;
+  if (mqh->specified_limits & USER_RESOURCES::CONNECTIONS_PER_HOUR)
+    acl_user->user_resource.conn_per_hour= mqh->conn_per_hour;
+  if (mqh->specified_limits & USER_RESOURCES::USER_CONNECTIONS)
+    acl_user->user_resource.user_conn= mqh->user_conn;
+  if (ssl_type != SSL_TYPE_NOT_SPECIFIED)
+  {
+    acl_user->ssl_type= ssl_type;
+    acl_user->ssl_cipher= (ssl_cipher ? strdup_root(&acl_memroot,ssl_cipher) :
+                           0);
+    acl_user->x509_issuer= (x509_issuer ? strdup_root(&acl_memroot,x509_issuer) :
+                            0);
+    acl_user->x509_subject= (x509_subject ?
+                             strdup_root(&acl_memroot,x509_subject) : 0);
   }
 }
 
@@ -2079,6 +2082,7 @@ static void acl_insert_user(const char *user, const char *host,
 
   /* Rebuild 'acl_check_hosts' since 'acl_users' has been modified */
   rebuild_check_host();
+  rebuild_acl_user_index();
 
   /*
     Rebuild every user's role_grants since 'acl_users' has been sorted
@@ -2318,6 +2322,42 @@ void rebuild_check_host(void)
   init_check_host();
 }
 
+
+static uchar* acl_user_name_get_key(ACL_USER *entry, size_t *length,
+                                    my_bool not_used __attribute__((unused)))
+{
+  *length= entry->user.length;
+  return (uchar*) safe_str(entry->user.str);
+}
+
+
+/*
+  Index acl_users by user name
+
+  The hash has pointers to elements of 'acl_users', so like 'acl_check_hosts'
+  it must be rebuilt when users are added, dropped or renamed. Several
+  entries (different hosts) may have the same name.
+*/
+
+static void init_acl_user_index(void)
+{
+  DBUG_ENTER("init_acl_user_index");
+  (void) my_hash_init(&acl_users_by_name, &my_charset_bin,
+                      acl_users.elements, 0, 0,
+                      (my_hash_get_key) acl_user_name_get_key, 0, 0);
+  for (uint i=0 ; i < acl_users.elements ; i++)
+    (void) my_hash_insert(&acl_users_by_name,
+                          (uchar*) dynamic_element(&acl_users, i, ACL_USER*));
+  DBUG_VOID_RETURN;
+}
+
+
+static void rebuild_acl_user_index(void)
+{
+  my_hash_free(&acl_users_by_name);
+  init_acl_user_index();
+}
+
 /*
   Reset a role role_grants dynamic array.
   Also, the role's access bits are reset to the ones present in the table.
@@ -2692,26 +2732,72 @@ bool is_acl_user(const char *host, const char *user)
 }
 
 
+enum acl_user_match { USER_MATCH_EXACT, USER_MATCH_WILD, USER_MATCH_ANON };
+
 /*
-  unlike find_user_exact and find_user_wild,
-  this function finds anonymous users too, it's when a
-  user is not empty, but priv_user (acl_user->user) is empty.
+  Find the first entry of acl_users with the given name that matches
+
+  SYNOPSIS
+    find_user_by_name()
+    name        Key in acl_users_by_name, "" for the anonymous users
+    how         How to compare user, host and ip with the entries
+    found       Match found so far, or 0
+
+  NOTES
+    The entries of one name are in no particular order in the hash, so the
+    one that comes first in the sorted 'acl_users' is returned, as a scan
+    of the array would have done.
 */
-static ACL_USER *find_user_or_anon(const char *host, const char *user, const char *ip)
+
+static ACL_USER *find_user_by_name(const char *name, enum acl_user_match how,
+                                   const char *host, const char *user,
+                                   const char *ip, ACL_USER *found)
 {
-  ACL_USER *result= NULL;
+  HASH_SEARCH_STATE state;
+  size_t length= strlen(name);
   mysql_mutex_assert_owner(&acl_cache->lock);
-  for (uint i=0; i < acl_users.elements; i++)
-  {
-    ACL_USER *acl_user_tmp= dynamic_element(&acl_users, i, ACL_USER*);
-    if ((!acl_user_tmp->user.str ||
-         !strcmp(user, acl_user_tmp->user.str)) &&
-         compare_hostname(&acl_user_tmp->host, host, ip))
-    {
-      result= acl_user_tmp;
+
+  for (ACL_USER *acl_user= (ACL_USER*) my_hash_first(&acl_users_by_name,
+                                                     (uchar*) name, length,
+                                                     &state);
+       acl_user;
+       acl_user= (ACL_USER*) my_hash_next(&acl_users_by_name, (uchar*) name,
+                                          length, &state))
+  {
+    bool match;
+    if (found && acl_user > found)
+      continue;                                 // Later in acl_users
+    switch (how) {
+    case USER_MATCH_EXACT:
+      match= acl_user->eq(user, host);
+      break;
+    case USER_MATCH_WILD:
+      match= acl_user->wild_eq(user, host, ip);
+      break;
+    case USER_MATCH_ANON:
+    default:
+      match= (!acl_user->user.str || !strcmp(user, acl_user->user.str)) &&
+             compare_hostname(&acl_user->host, host, ip);
       break;
     }
+    if (match)
+      found= acl_user;
   }
+  return found;
+}
+
+
+/*
+  unlike find_user_exact and find_user_wild,
+  this function finds anonymous users too, it's when a
+  user is not empty, but priv_user (acl_user->user) is empty.
+*/
+static ACL_USER *find_user_or_anon(const char *host, const char *user, const char *ip)
+{
+  ACL_USER *result;
+  result= find_user_by_name(user, USER_MATCH_ANON, host, user, ip, NULL);
+  if (*user)
+    result= find_user_by_name("", USER_MATCH_ANON, host, user, ip, result);
   return result;
 }
 
@@ -2721,15 +2807,8 @@ static ACL_USER *find_user_or_anon(const char *host, const char *user, const cha
 */
 static ACL_USER * find_user_exact(const char *host, const char *user)
 {
-  mysql_mutex_assert_owner(&acl_cache->lock);
-
-  for (uint i=0 ; i < acl_users.elements ; i++)
-  {
-    ACL_USER *acl_user=dynamic_element(&acl_users,i,ACL_USER*);
-    if (acl_user->eq(user, host))
-      return acl_user;
-  }
-  return 0;
+  return find_user_by_name(safe_str(user), USER_MATCH_EXACT, host, user,
+                           NULL, NULL);
 }
 
 /*
@@ -2737,15 +2816,8 @@ static ACL_USER * find_user_exact(const char *host, const char *user)
 */
 static ACL_USER * find_user_wild(const char *host, const char *user, const char *ip)
 {
-  mysql_mutex_assert_owner(&acl_cache->lock);
-
-  for (uint i=0 ; i < acl_users.elements ; i++)
-  {
-    ACL_USER *acl_user=dynamic_element(&acl_users,i,ACL_USER*);
-    if (acl_user->wild_eq(user, host, ip))
-      return acl_user;
-  }
-  return 0;
+  return find_user_by_name(safe_str(user), USER_MATCH_WILD, host, user,
+                           ip, NULL);
 }
 
 /*
@@ -8300,21 +8372,13 @@ static int open_grant_tables(THD *thd, TABLE_LIST *tables)
 
 ACL_USER *check_acl_user(LEX_USER *user_name, uint *acl_acl_userdx)
 {
-  ACL_USER *acl_user= 0;
-  uint counter;
-
-  mysql_mutex_assert_owner(&acl_cache->lock);
+  ACL_USER *acl_user;
 
-  for (counter= 0 ; counter < acl_users.elements ; counter++)
-  {
-    acl_user= dynamic_element(&acl_users, counter, ACL_USER*);
-    if(acl_user->eq(user_name->user.str, user_name->host.str))
-      break;
-  }
-  if (counter == acl_users.elements)
+  if (!(acl_user= find_user_exact(user_name->host.str, user_name->user.str)))
     return 0;
 
-  *acl_acl_userdx= counter;
+  *acl_acl_userdx= (uint) (acl_user - dynamic_element(&acl_users, 0,
+                                                      ACL_USER*));
   return acl_user;
 }
 
@@ -8959,6 +9023,10 @@ static int handle_grant_struct(enum enum_acl_lists struct_no, bool drop,
   DBUG_PRINT("loop",("scan struct: %u  result %d", struct_no, result));
 #endif
 
+  /* Users were dropped or renamed, the lookups after us need the index */
+  if (struct_no == USER_ACL && result > 0 && (drop || user_to))
+    rebuild_acl_user_index();
+
   DBUG_RETURN(result);
 }
 
@@ -690,6 +690,50 @@ static bool mysql_admin_table(THD* thd, TABLE_LIST* tables,
         } 
         tab->file->column_bitmaps_signal(); 
       }
+
+      if (lex->column_group_list)
+      {
+        /* The columns of the groups are analyzed as well */
+        List<LEX_STRING> *column_group;
+        List_iterator_fast<List<LEX_STRING> > it(*lex->column_group_list);
+        while ((column_group= it++))
+        {
+          int pos;
+          uint positions[MAX_COLUMN_GROUP_COLUMNS], count= 0;
+          LEX_STRING *column_name;
+          List_iterator_fast<LEX_STRING> name_it(*column_group);
+          size_t names_length= column_group->elements - 1;
+          if (column_group->elements < 2 ||
+              column_group->elements > MAX_COLUMN_GROUP_COLUMNS)
+          {
+            compl_result_code= result_code= HA_ADMIN_INVALID;
+            break;
+          }
+          while ((column_name= name_it++))
+          {
+            names_length+= column_name->length;
+            if (tab->s->fieldnames.type_names == 0 ||
+                names_length > MAX_COLUMN_GROUP_NAMES_LENGTH ||
+                strchr(column_name->str, ',') ||
+                (pos= find_type(&tab->s->fieldnames, column_name->str,
+                                column_name->length, 1)) <= 0)
+            {
+              compl_result_code= result_code= HA_ADMIN_INVALID;
+              break;
+            }
+            for (uint i= 0; i < count; i++)
+            {
+              if (positions[i] == (uint) pos)
+                compl_result_code= result_code= HA_ADMIN_INVALID;
+            }
+            if (result_code == HA_ADMIN_INVALID)
+              break;
+            positions[count++]= pos;
+            bitmap_set_bit(tab->read_set, pos-1);
+          }
+        }
+        tab->file->column_bitmaps_signal(); 
+      }
       
       if (!lex->index_list)
       {
@@ -733,6 +777,9 @@ static bool mysql_admin_table(THD* thd, TABLE_LIST* tables,
     {
       if (!(compl_result_code=
             alloc_statistics_for_table(thd, table->table)) &&
+          !(compl_result_code=
+            alloc_column_groups_for_table(thd, table->table,
+                                          lex->column_group_list)) &&
           !(compl_result_code=
             collect_statistics_for_table(thd, table->table)))
         compl_result_code= update_statistics_for_table(thd, table->table);
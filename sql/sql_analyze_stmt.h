@@ -0,0 +1,120 @@
+#ifndef SQL_ANALYZE_STMT_INCLUDED
+#define SQL_ANALYZE_STMT_INCLUDED
+
+/*
+   Copyright (c) 2014, Monty Program Ab
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/**
+  @file
+
+  @brief
+  Counters collected while a statement is executed by ANALYZE.
+
+  The executor holds pointers to the trackers, which are NULL unless the
+  statement is an ANALYZE statement. Updating a counter costs a test of a
+  pointer that is almost always NULL when the statement is not analyzed.
+*/
+
+#include "my_rdtsc.h"
+
+extern MY_TIMER_INFO sys_timer_info;
+
+/*
+  Time spent in calls to a handler of a table, in CPU cycles
+*/
+
+class Exec_time_tracker
+{
+  ulonglong count;
+  ulonglong cycles;
+  ulonglong last_start;
+public:
+  Exec_time_tracker() : count(0), cycles(0), last_start(0) {}
+
+  void start_tracking()
+  {
+    last_start= my_timer_cycles();
+  }
+
+  void stop_tracking()
+  {
+    ulonglong end= my_timer_cycles();
+    count++;
+    /* The cycle counter may wrap around */
+    cycles+= end - last_start;
+  }
+
+  ulonglong get_loops() { return count; }
+
+  double get_time_ms()
+  {
+    if (!sys_timer_info.cycles.frequency)
+      return 0.0;
+    return 1000.0 * (double) cycles / (double) sys_timer_info.cycles.frequency;
+  }
+};
+
+
+#define ANALYZE_START_TRACKING(tracker) \
+  { if (unlikely(tracker)) (tracker)->start_tracking(); }
+
+#define ANALYZE_STOP_TRACKING(tracker) \
+  { if (unlikely(tracker)) (tracker)->stop_tracking(); }
+
+
+/*
+  Rows read from a table and rows that satisfied the condition attached
+  to the table
+*/
+
+class Table_access_tracker : public Sql_alloc
+{
+public:
+  Table_access_tracker() :
+    r_scans(0), r_rows(0), r_rows_after_where(0)
+  {}
+
+  /* Number of times the table was scanned (the loops) */
+  ha_rows r_scans;
+  /* Number of rows read from the table in all scans */
+  ha_rows r_rows;
+  /* Number of rows that satisfied the condition attached to the table */
+  ha_rows r_rows_after_where;
+
+  bool has_scans() { return r_scans != 0; }
+  ha_rows get_loops() { return r_scans; }
+
+  /* Average number of rows read in a scan */
+  double get_avg_rows()
+  {
+    return r_scans ? (double) r_rows / r_scans : 0.0;
+  }
+
+  /* The part of the rows read that satisfied the condition, in percent */
+  double get_filtered_after_where()
+  {
+    return r_rows ? 100.0 * (double) r_rows_after_where / r_rows : 100.0;
+  }
+
+  /* Time spent in the handler calls that read the rows */
+  Exec_time_tracker time_tracker;
+
+  inline void on_scan_init() { r_scans++; }
+  inline void on_record_read() { r_rows++; }
+  inline void on_record_after_where() { r_rows_after_where++; }
+};
+
+#endif /* SQL_ANALYZE_STMT_INCLUDED */
@@ -0,0 +1,558 @@
+/*
+   Copyright (c) 2014, Monty Program Ab
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/**
+  @file
+
+  @brief
+  Evaluation of the condition attached to a table over blocks of rows
+
+  @see Batch_cond
+*/
+
+#include "sql_priv.h"
+#include "sql_select.h"
+#include "sql_batch_cond.h"
+
+
+/* Check whether the values of the field can be compared in a block */
+
+static bool is_batch_field(Field *field, bool *temporal)
+{
+  switch (field->type()) {
+  case MYSQL_TYPE_TINY:
+  case MYSQL_TYPE_SHORT:
+  case MYSQL_TYPE_INT24:
+  case MYSQL_TYPE_LONG:
+  case MYSQL_TYPE_LONGLONG:
+    *temporal= FALSE;
+    return TRUE;
+  case MYSQL_TYPE_DATE:
+  case MYSQL_TYPE_NEWDATE:
+  case MYSQL_TYPE_DATETIME:
+  case MYSQL_TYPE_TIMESTAMP:
+  case MYSQL_TYPE_TIME:
+    *temporal= TRUE;
+    return TRUE;
+  default:
+    return FALSE;
+  }
+}
+
+
+/**
+  Build the block evaluation of the condition attached to a table
+
+  @param thd  the current thread
+  @param tab  the table
+
+  @return
+    The object, which is not usable if no part of the condition can be
+    evaluated in a block, or NULL if out of memory
+*/
+
+Batch_cond *Batch_cond::create(THD *thd, JOIN_TAB *tab)
+{
+  TABLE *table= tab->table;
+  uint reclength= table->s->reclength;
+  Batch_cond *batch;
+  DBUG_ENTER("Batch_cond::create");
+
+  if (!(batch= new Batch_cond(thd, table, tab->select_cond)))
+    DBUG_RETURN(NULL);
+
+  batch->max_rows= (uint) MY_MIN(BATCH_COND_MAX_ROWS,
+                                 thd->variables.join_buff_size / reclength);
+  if (batch->max_rows < BATCH_COND_MIN_ROWS)
+    DBUG_RETURN(batch);
+
+  batch->max_columns= table->s->fields;
+  if (!(batch->columns= (Batch_cond_column *)
+        thd->alloc(sizeof(Batch_cond_column) * batch->max_columns)))
+    DBUG_RETURN(NULL);
+  if (!(batch->root= batch->add_cond(tab->select_cond, TRUE)))
+  {
+    if (thd->is_fatal_error)
+      DBUG_RETURN(NULL);
+    DBUG_RETURN(batch);
+  }
+
+  if (!(batch->block= (uchar *) thd->alloc(batch->max_rows * reclength)) ||
+      !(batch->selected= (uint16 *) thd->alloc(batch->max_rows *
+                                                sizeof(uint16))))
+    DBUG_RETURN(NULL);
+  for (uint i= 0; i < batch->column_count; i++)
+  {
+    Batch_cond_column *column= batch->columns + i;
+    if (!(column->values= (longlong *) thd->alloc(batch->max_rows *
+                                                  sizeof(longlong))) ||
+        !(column->nulls= (uchar *) thd->alloc(batch->max_rows)))
+      DBUG_RETURN(NULL);
+  }
+  DBUG_PRINT("info", ("columns: %u  rows: %u  covers: %d",
+                      batch->column_count, batch->max_rows,
+                      (int) batch->covers_cond));
+  DBUG_RETURN(batch);
+}
+
+
+Batch_cond_node *Batch_cond::new_node(Batch_cond_node::node_type type)
+{
+  Batch_cond_node *node;
+  if (!(node= new Batch_cond_node) ||
+      !(node->result= (uchar *) thd->alloc(max_rows)))
+    return NULL;
+  node->type= type;
+  node->column= NULL;
+  node->value= NULL;
+  node->warn_item= NULL;
+  node->outcome= Batch_cond_node::COMPARE;
+  node->const_value= 0;
+  return node;
+}
+
+
+Batch_cond_column *Batch_cond::get_column(Field *field, bool temporal)
+{
+  Batch_cond_column *column;
+  for (column= columns; column != columns + column_count; column++)
+  {
+    if (column->field == field)
+      return column;
+  }
+  DBUG_ASSERT(column_count < max_columns);
+  column_count++;
+  column->field= field;
+  column->temporal= temporal;
+  column->unsigned_flag= !temporal && ((Field_num *) field)->unsigned_flag;
+  column->fuzzydate= TIME_FUZZY_DATES | TIME_INVALID_DATES;
+  if (field->type() == MYSQL_TYPE_TIME)
+    column->fuzzydate|= TIME_TIME_ONLY;
+  column->values= NULL;
+  column->nulls= NULL;
+  return column;
+}
+
+
+/**
+  Add a condition to the nodes evaluated in a block
+
+  @param item       the condition
+  @param top_level  TRUE <=> the condition is a conjunct of the condition
+                    attached to the table; its unsupported conjuncts are
+                    then left to the row by row evaluation
+
+  @return
+    The node for the condition, or NULL if it cannot be evaluated in a
+    block
+*/
+
+Batch_cond_node *Batch_cond::add_cond(Item *item, bool top_level)
+{
+  Batch_cond_node *node;
+  Item_func *func;
+  Item **args;
+
+  if (item->type() == Item::COND_ITEM)
+  {
+    Item_cond *cond= (Item_cond *) item;
+    bool is_and= cond->functype() == Item_func::COND_AND_FUNC;
+    if (!is_and && cond->functype() != Item_func::COND_OR_FUNC)
+      return NULL;
+    if (!(node= new_node(is_and ? Batch_cond_node::AND :
+                                  Batch_cond_node::OR)))
+      return NULL;
+    List_iterator_fast<Item> li(*cond->argument_list());
+    Item *arg;
+    while ((arg= li++))
+    {
+      Batch_cond_node *child= add_cond(arg, top_level && is_and);
+      if (!child)
+      {
+        if (thd->is_fatal_error || !(top_level && is_and))
+          return NULL;
+        covers_cond= FALSE;
+        continue;
+      }
+      if (node->children.push_back(child))
+        return NULL;
+    }
+    return node->children.is_empty() ? NULL : node;
+  }
+
+  if (item->type() != Item::FUNC_ITEM)
+    return NULL;
+
+  func= (Item_func *) item;
+  args= func->arguments();
+  switch (func->functype()) {
+  case Item_func::EQ_FUNC:
+  case Item_func::NE_FUNC:
+  case Item_func::LT_FUNC:
+  case Item_func::LE_FUNC:
+  case Item_func::GT_FUNC:
+  case Item_func::GE_FUNC:
+  {
+    Batch_cond_node::node_type type;
+    Item *cmp_args[2];
+    int field_arg= args[0]->const_item() ? 1 : 0;
+    switch (func->functype()) {
+    case Item_func::EQ_FUNC: type= Batch_cond_node::EQ; break;
+    case Item_func::NE_FUNC: type= Batch_cond_node::NE; break;
+    case Item_func::LT_FUNC: type= Batch_cond_node::LT; break;
+    case Item_func::LE_FUNC: type= Batch_cond_node::LE; break;
+    case Item_func::GT_FUNC: type= Batch_cond_node::GT; break;
+    default:                 type= Batch_cond_node::GE; break;
+    }
+    if (field_arg)
+    {
+      /* const op field: swap the arguments */
+      switch (type) {
+      case Batch_cond_node::LT: type= Batch_cond_node::GT; break;
+      case Batch_cond_node::LE: type= Batch_cond_node::GE; break;
+      case Batch_cond_node::GT: type= Batch_cond_node::LT; break;
+      case Batch_cond_node::GE: type= Batch_cond_node::LE; break;
+      default: break;
+      }
+    }
+    cmp_args[0]= args[field_arg];
+    cmp_args[1]= args[!field_arg];
+    node= add_cmp(type, cmp_args, args[field_arg],
+                  item_cmp_type(args[0]->cmp_type(), args[1]->cmp_type()));
+    if (node)
+      node->value= args + !field_arg;
+    return node;
+  }
+  case Item_func::BETWEEN:
+  {
+    Item_func_between *between= (Item_func_between *) func;
+    Batch_cond_node *low, *high;
+    Item *cmp_args[2];
+    if (between->negated ||
+        !(node= new_node(Batch_cond_node::AND)))
+      return NULL;
+    cmp_args[0]= args[0];
+    cmp_args[1]= args[1];
+    if (!(low= add_cmp(Batch_cond_node::GE, cmp_args,
+                       between->compare_as_dates, between->cmp_type)))
+      return NULL;
+    low->value= args + 1;
+    cmp_args[1]= args[2];
+    if (!(high= add_cmp(Batch_cond_node::LE, cmp_args,
+                        between->compare_as_dates, between->cmp_type)))
+      return NULL;
+    high->value= args + 2;
+    if (node->children.push_back(low) || node->children.push_back(high))
+      return NULL;
+    return node;
+  }
+  case Item_func::ISNULL_FUNC:
+  case Item_func::ISNOTNULL_FUNC:
+  {
+    Item *arg= args[0]->real_item();
+    Field *field;
+    bool temporal;
+    if (arg->type() != Item::FIELD_ITEM ||
+        (field= ((Item_field *) arg)->field)->table != table ||
+        !is_batch_field(field, &temporal) ||
+        !(node= new_node(func->functype() == Item_func::ISNULL_FUNC ?
+                         Batch_cond_node::IS_NULL :
+                         Batch_cond_node::IS_NOT_NULL)))
+      return NULL;
+    node->column= get_column(field, temporal);
+    return node;
+  }
+  default:
+    return NULL;
+  }
+}
+
+
+/**
+  Add a comparison of a column with a constant
+
+  @param type       the comparison
+  @param args       the column and the constant
+  @param warn_item  the item the constant is converted like when the
+                    comparison is temporal
+  @param cmp_type   the type of the comparison
+
+  @return
+    The node for the comparison, or NULL if it cannot be evaluated in a
+    block
+*/
+
+Batch_cond_node *Batch_cond::add_cmp(Batch_cond_node::node_type type,
+                                     Item **args, Item *warn_item,
+                                     Item_result cmp_type)
+{
+  Batch_cond_node *node;
+  Item *arg= args[0]->real_item();
+  Field *field;
+  bool temporal;
+
+  if (arg->type() != Item::FIELD_ITEM ||
+      (field= ((Item_field *) arg)->field)->table != table ||
+      !is_batch_field(field, &temporal) ||
+      cmp_type != (temporal ? TIME_RESULT : INT_RESULT) ||
+      !args[1]->const_item() || args[1]->is_expensive() ||
+      (!temporal && args[1]->cmp_type() != INT_RESULT) ||
+      !(node= new_node(type)))
+    return NULL;
+  node->column= get_column(field, temporal);
+  node->warn_item= warn_item;
+  return node;
+}
+
+
+/**
+  Evaluate the constants of the condition for the current execution
+
+  @retval FALSE  ok
+  @retval TRUE   an error occurred
+*/
+
+bool Batch_cond::prepare(THD *thd_arg)
+{
+  thd= thd_arg;
+  return prepare_node(root);
+}
+
+
+bool Batch_cond::prepare_node(Batch_cond_node *node)
+{
+  switch (node->type) {
+  case Batch_cond_node::AND:
+  case Batch_cond_node::OR:
+  {
+    List_iterator_fast<Batch_cond_node> li(node->children);
+    Batch_cond_node *child;
+    while ((child= li++))
+    {
+      if (prepare_node(child))
+        return TRUE;
+    }
+    return FALSE;
+  }
+  case Batch_cond_node::IS_NULL:
+  case Batch_cond_node::IS_NOT_NULL:
+    return FALSE;
+  default:
+    break;
+  }
+
+  Item *value= *node->value;
+  node->outcome= Batch_cond_node::COMPARE;
+  if (node->column->temporal)
+  {
+    Item **ptr= node->value;
+    bool is_null;
+    node->const_value= get_datetime_value(thd, &ptr, NULL, node->warn_item,
+                                          &is_null);
+    if (is_null)
+      node->outcome= Batch_cond_node::ALL_FALSE;
+    return thd->is_error();
+  }
+
+  node->const_value= value->val_int();
+  if (value->null_value)
+    node->outcome= Batch_cond_node::ALL_FALSE;
+  else if (node->column->unsigned_flag != MY_TEST(value->unsigned_flag) &&
+           node->const_value < 0)
+  {
+    /*
+      The constant is out of the range of the column: it is less than all
+      unsigned values or greater than all signed values
+    */
+    bool less= node->column->unsigned_flag;
+    switch (node->type) {
+    case Batch_cond_node::EQ:
+      node->outcome= Batch_cond_node::ALL_FALSE;
+      break;
+    case Batch_cond_node::NE:
+      node->outcome= Batch_cond_node::ALL_TRUE;
+      break;
+    case Batch_cond_node::LT:
+    case Batch_cond_node::LE:
+      node->outcome= less ? Batch_cond_node::ALL_FALSE :
+                            Batch_cond_node::ALL_TRUE;
+      break;
+    default:
+      node->outcome= less ? Batch_cond_node::ALL_TRUE :
+                            Batch_cond_node::ALL_FALSE;
+      break;
+    }
+  }
+  return thd->is_error();
+}
+
+
+/**
+  Read the values of the columns from the record buffer of the table
+
+  @param row  the number of the row in the block
+*/
+
+void Batch_cond::add_row(uint row)
+{
+  for (Batch_cond_column *column= columns; column != columns + column_count;
+       column++)
+  {
+    Field *field= column->field;
+    if ((column->nulls[row]= field->is_null()))
+      continue;
+    if (column->temporal)
+    {
+      MYSQL_TIME ltime;
+      column->values[row]= field->get_date(&ltime, column->fuzzydate) ?
+                           0 : pack_time(&ltime);
+    }
+    else
+      column->values[row]= field->val_int();
+  }
+}
+
+
+template <class T>
+static void compare_values(Batch_cond_node::node_type type,
+                           const longlong *values_arg, const uchar *nulls,
+                           longlong value_arg, uint rows, uchar *result)
+{
+  const T *values= (const T *) values_arg;
+  const T value= (T) value_arg;
+  uint i;
+
+  switch (type) {
+  case Batch_cond_node::EQ:
+    for (i= 0; i < rows; i++)
+      result[i]= !nulls[i] & (values[i] == value);
+    break;
+  case Batch_cond_node::NE:
+    for (i= 0; i < rows; i++)
+      result[i]= !nulls[i] & (values[i] != value);
+    break;
+  case Batch_cond_node::LT:
+    for (i= 0; i < rows; i++)
+      result[i]= !nulls[i] & (values[i] < value);
+    break;
+  case Batch_cond_node::LE:
+    for (i= 0; i < rows; i++)
+      result[i]= !nulls[i] & (values[i] <= value);
+    break;
+  case Batch_cond_node::GT:
+    for (i= 0; i < rows; i++)
+      result[i]= !nulls[i] & (values[i] > value);
+    break;
+  case Batch_cond_node::GE:
+    for (i= 0; i < rows; i++)
+      result[i]= !nulls[i] & (values[i] >= value);
+    break;
+  default:
+    DBUG_ASSERT(0);
+  }
+}
+
+
+/*
+  Evaluate a node for the rows of the block
+
+  NULL is evaluated as FALSE. As the nodes are combined only with AND and
+  OR, this gives the same rows as the evaluation of the condition does.
+*/
+
+void Batch_cond::evaluate_node(Batch_cond_node *node, uint rows)
+{
+  uchar *result= node->result;
+  uint i;
+
+  switch (node->type) {
+  case Batch_cond_node::AND:
+  case Batch_cond_node::OR:
+  {
+    List_iterator_fast<Batch_cond_node> li(node->children);
+    Batch_cond_node *child= li++;
+    evaluate_node(child, rows);
+    memcpy(result, child->result, rows);
+    while ((child= li++))
+    {
+      evaluate_node(child, rows);
+      if (node->type == Batch_cond_node::AND)
+      {
+        for (i= 0; i < rows; i++)
+          result[i]&= child->result[i];
+      }
+      else
+      {
+        for (i= 0; i < rows; i++)
+          result[i]|= child->result[i];
+      }
+    }
+    break;
+  }
+  case Batch_cond_node::IS_NULL:
+    memcpy(result, node->column->nulls, rows);
+    break;
+  case Batch_cond_node::IS_NOT_NULL:
+    for (i= 0; i < rows; i++)
+      result[i]= !node->column->nulls[i];
+    break;
+  default:
+    switch (node->outcome) {
+    case Batch_cond_node::ALL_FALSE:
+      bzero(result, rows);
+      break;
+    case Batch_cond_node::ALL_TRUE:
+      for (i= 0; i < rows; i++)
+        result[i]= !node->column->nulls[i];
+      break;
+    case Batch_cond_node::COMPARE:
+      if (node->column->unsigned_flag)
+        compare_values<ulonglong>(node->type, node->column->values,
+                                  node->column->nulls, node->const_value,
+                                  rows, result);
+      else
+        compare_values<longlong>(node->type, node->column->values,
+                                 node->column->nulls, node->const_value,
+                                 rows, result);
+      break;
+    }
+  }
+}
+
+
+/**
+  Evaluate the condition for the rows of the block
+
+  @param rows  the number of rows in the block
+
+  @return
+    The number of rows that satisfy the condition. Their numbers are
+    stored in selected[].
+*/
+
+uint Batch_cond::evaluate(uint rows)
+{
+  uint count= 0;
+  uchar *result= root->result;
+
+  evaluate_node(root, rows);
+  for (uint i= 0; i < rows; i++)
+  {
+    selected[count]= (uint16) i;
+    count+= result[i];
+  }
+  return count;
+}
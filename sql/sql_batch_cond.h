@@ -0,0 +1,145 @@
+#ifndef SQL_BATCH_COND_INCLUDED
+#define SQL_BATCH_COND_INCLUDED
+
+/*
+   Copyright (c) 2014, Monty Program Ab
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/**
+  @file
+
+  @brief
+  Evaluation of the condition attached to a table over blocks of rows
+*/
+
+#include "sql_list.h"
+
+/* Maximum number of rows in a block */
+#define BATCH_COND_MAX_ROWS 256
+
+/* A block with less rows than this is not worth it */
+#define BATCH_COND_MIN_ROWS 16
+
+class Item;
+class Field;
+class THD;
+struct TABLE;
+typedef struct st_join_table JOIN_TAB;
+
+
+/* A column of the table whose values are read into a Batch_cond block */
+
+struct Batch_cond_column
+{
+  Field *field;
+  /* TRUE <=> the values are packed temporal values, otherwise integers */
+  bool temporal;
+  bool unsigned_flag;
+  ulonglong fuzzydate;
+  longlong *values;
+  uchar *nulls;
+};
+
+
+/*
+  A node of a condition evaluated by a Batch_cond: AND or OR of other
+  nodes, or a comparison of a column with a constant
+*/
+
+struct Batch_cond_node :public Sql_alloc
+{
+  enum node_type {AND, OR, EQ, NE, LT, LE, GT, GE, IS_NULL, IS_NOT_NULL} type;
+  List<Batch_cond_node> children;
+  Batch_cond_column *column;
+  /* The constant of a comparison and the item it is converted like */
+  Item **value;
+  Item *warn_item;
+  /*
+    Set by Batch_cond::prepare(): the comparison is true for all rows with
+    a non-NULL value (ALL_TRUE), for no rows (ALL_FALSE) or is evaluated
+    against const_value
+  */
+  enum {COMPARE, ALL_TRUE, ALL_FALSE} outcome;
+  longlong const_value;
+  /* The value of the node for each row of the block */
+  uchar *result;
+};
+
+
+/*
+  Evaluation of the condition attached to a table over a block of rows
+
+  Calling Item::val_int() of the condition for each row goes through the
+  virtual calls of the whole item tree. A Batch_cond is built for the
+  condition when it consists of comparisons of integer and temporal
+  columns of the table with constants ('=', '<>', '<', '<=', '>', '>=',
+  BETWEEN, IS [NOT] NULL) combined with AND and OR. sub_select() then
+  copies the rows read from the table into a block. When the block is
+  full, the values of the columns are compared with the constants for all
+  rows of the block at once, and only the rows that satisfy the condition
+  are passed to evaluate_join_record().
+
+  When only some of the conjuncts of the condition are supported, they are
+  used to filter the rows of the block, and the rest of the condition is
+  evaluated row by row (covers_cond is FALSE).
+
+  The comparisons are done as Arg_comparator does them: as signed or
+  unsigned integers, or as packed temporal values obtained like
+  get_datetime_value() obtains them.
+*/
+
+class Batch_cond :public Sql_alloc
+{
+public:
+  /* The condition the object was built for */
+  Item *cond;
+  /* TRUE <=> the whole condition is evaluated for the block */
+  bool covers_cond;
+  /* Number of rows in a full block */
+  uint max_rows;
+  /* The rows of the block in the record format */
+  uchar *block;
+  /* Numbers of the rows of the last block that satisfy the condition */
+  uint16 *selected;
+
+  static Batch_cond *create(THD *thd, JOIN_TAB *tab);
+  bool is_usable() { return root != NULL; }
+  bool prepare(THD *thd);
+  void add_row(uint row);
+  uint evaluate(uint rows);
+
+private:
+  TABLE *table;
+  Batch_cond_node *root;
+  Batch_cond_column *columns;
+  uint column_count;
+  uint max_columns;
+  THD *thd;
+
+  Batch_cond(THD *thd_arg, TABLE *table_arg, Item *cond_arg)
+    :cond(cond_arg), covers_cond(TRUE), max_rows(0), block(0), selected(0),
+     table(table_arg), root(0), columns(0), column_count(0), max_columns(0),
+     thd(thd_arg)
+  {}
+  Batch_cond_node *add_cond(Item *item, bool top_level);
+  Batch_cond_node *add_cmp(Batch_cond_node::node_type type, Item **args,
+                           Item *warn_item, Item_result cmp_type);
+  Batch_cond_node *new_node(Batch_cond_node::node_type type);
+  Batch_cond_column *get_column(Field *field, bool temporal);
+  bool prepare_node(Batch_cond_node *node);
+  void evaluate_node(Batch_cond_node *node, uint rows);
+};
+
+#endif /* SQL_BATCH_COND_INCLUDED */
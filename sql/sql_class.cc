@@ -863,42 +863,11 @@ THD::THD()
    :Statement(&main_lex, &main_mem_root, STMT_CONVENTIONAL_EXECUTION,
               /* statement id */ 0),
    rli_fake(0), rgi_fake(0), rgi_slave(NULL),
-   in_sub_stmt(0), log_all_errors(0),
-   binlog_unsafe_warning_flags(0),
-   binlog_table_maps(0),
-   table_map_for_update(0),
-   arg_of_last_insert_id_function(FALSE),
-   first_successful_insert_id_in_prev_stmt(0),
-   first_successful_insert_id_in_prev_stmt_for_binlog(0),
-   first_successful_insert_id_in_cur_stmt(0),
-   stmt_depends_on_first_successful_insert_id_in_prev_stmt(FALSE),
-   m_examined_row_count(0),
-   accessed_rows_and_keys(0),
-   m_statement_psi(NULL),
-   m_idle_psi(NULL),
-   m_server_idle(false),
+   /* Set before main_da.init(), safemalloc accounts memory to thread_id */
    thread_id(0),
-   global_disable_checkpoint(0),
-   failed_com_change_user(0),
-   is_fatal_error(0),
-   transaction_rollback_request(0),
-   is_fatal_sub_stmt_error(0),
-   rand_used(0),
-   time_zone_used(0),
-   in_lock_tables(0),
-   bootstrap(0),
-   derived_tables_processing(FALSE),
-   spcont(NULL),
-   m_parser_state(NULL),
-#if defined(ENABLED_DEBUG_SYNC)
-   debug_sync_control(0),
-#endif /* defined(ENABLED_DEBUG_SYNC) */
-   wait_for_commit_ptr(0),
     main_da(0, false, false),
    m_stmt_da(&main_da)
 {
-  ulong tmp;
-
   mdl_context.init(this);
   /*
     We set THR_THD to temporally point to this THD to register all the
@@ -917,6 +886,97 @@ THD::THD()
   init_sql_alloc(&main_mem_root, ALLOC_ROOT_MIN_BLOCK_SIZE, 0,
                  MYF(MY_THREAD_SPECIFIC));
 
+  main_security_ctx.init();
+  my_hash_clear(&handler_tables_hash);
+  my_hash_clear(&ull_hash);
+  bzero(&variables, sizeof(variables));
+  bzero(ha_data, sizeof(ha_data));
+  mysys_var=0;
+
+#ifndef DBUG_OFF
+  dbug_sentry=THD_SENTRY_MAGIC;
+#endif
+#ifndef EMBEDDED_LIBRARY
+  mysql_audit_init_thd(this);
+#endif
+  net.vio=0;
+  net.buff= 0;
+  mysql_mutex_init(key_LOCK_thd_data, &LOCK_thd_data, MY_MUTEX_INIT_FAST);
+  mysql_mutex_init(key_LOCK_wakeup_ready, &LOCK_wakeup_ready, MY_MUTEX_INIT_FAST);
+  mysql_cond_init(key_COND_wakeup_ready, &COND_wakeup_ready, 0);
+  /*
+    LOCK_thread_count goes before LOCK_thd_data - the former is called around
+    'delete thd', the latter - in THD::~THD
+  */
+  mysql_mutex_record_order(&LOCK_thread_count, &LOCK_thd_data);
+
+  init_connection_state();
+#if defined(ENABLED_PROFILING)
+  profiling.set_thd(this);
+#endif
+
+  /* Protocol */
+  protocol_text.init(this);
+  protocol_binary.init(this);
+
+  /* Restore THR_THD */
+  set_current_thd(old_THR_THD);
+}
+
+
+/*
+  Initialize the members that belong to one connection
+
+  IMPLEMENTATION
+    Called by the constructor and by reset_for_reuse(), so a THD taken
+    from the session cache starts in the state of a new one. A member
+    that a connection can change must be initialized here, not in the
+    constructor; the constructor only sets up what is kept in the cache:
+    the object, its mutexes, the MDL context and the memory roots.
+*/
+
+void THD::init_connection_state()
+{
+  ulong tmp;
+
+  lex= &main_lex;
+  mem_root= &main_mem_root;
+  set_query(CSET_STRING());
+  id= 0;
+  in_sub_stmt= 0;
+  log_all_errors= 0;
+  binlog_unsafe_warning_flags= 0;
+  binlog_table_maps= 0;
+  table_map_for_update= 0;
+  arg_of_last_insert_id_function= FALSE;
+  first_successful_insert_id_in_prev_stmt= 0;
+  first_successful_insert_id_in_prev_stmt_for_binlog= 0;
+  first_successful_insert_id_in_cur_stmt= 0;
+  stmt_depends_on_first_successful_insert_id_in_prev_stmt= FALSE;
+  m_examined_row_count= 0;
+  accessed_rows_and_keys= 0;
+  m_statement_psi= NULL;
+  m_idle_psi= NULL;
+  m_server_idle= false;
+  thread_id= 0;
+  global_disable_checkpoint= 0;
+  failed_com_change_user= 0;
+  is_fatal_error= 0;
+  transaction_rollback_request= 0;
+  is_fatal_sub_stmt_error= 0;
+  rand_used= 0;
+  time_zone_used= 0;
+  in_lock_tables= 0;
+  bootstrap= 0;
+  derived_tables_processing= FALSE;
+  spcont= NULL;
+  m_parser_state= NULL;
+#if defined(ENABLED_DEBUG_SYNC)
+  debug_sync_control= 0;
+#endif /* defined(ENABLED_DEBUG_SYNC) */
+  wait_for_commit_ptr= 0;
+  m_stmt_da= &main_da;
+
   stmt_arena= this;
   thread_stack= 0;
   scheduler= thread_scheduler;                 // Will be fixed later
@@ -925,7 +985,6 @@ THD::THD()
   skip_wait_timeout= false;
   extra_port= 0;
   catalog= (char*)"std"; // the only catalog we have for now
-  main_security_ctx.init();
   security_ctx= &main_security_ctx;
   no_errors= 0;
   password= 0;
@@ -934,8 +993,6 @@ THD::THD()
   killed= NOT_KILLED;
   col_access=0;
   is_slave_error= thread_specific_used= FALSE;
-  my_hash_clear(&handler_tables_hash);
-  my_hash_clear(&ull_hash);
   tmp_table=0;
   cuted_fields= 0L;
   m_sent_row_count= 0L;
@@ -955,25 +1012,14 @@ THD::THD()
   connection_name.str= 0;
   connection_name.length= 0;
 
-  bzero(&variables, sizeof(variables));
   file_id = 0;
   query_id= 0;
   query_name_consts= 0;
   db_charset= global_system_variables.collation_database;
-  bzero(ha_data, sizeof(ha_data));
-  mysys_var=0;
   binlog_evt_union.do_union= FALSE;
   enable_slow_log= 0;
   durability_property= HA_REGULAR_DURABILITY;
 
-#ifndef DBUG_OFF
-  dbug_sentry=THD_SENTRY_MAGIC;
-#endif
-#ifndef EMBEDDED_LIBRARY
-  mysql_audit_init_thd(this);
-#endif
-  net.vio=0;
-  net.buff= 0;
   client_capabilities= 0;                       // minimalistic client
   system_thread= NON_SYSTEM_THREAD;
   cleanup_done= abort_on_warning= 0;
@@ -987,14 +1033,7 @@ THD::THD()
 #ifdef SIGNAL_WITH_VIO_CLOSE
   active_vio = 0;
 #endif
-  mysql_mutex_init(key_LOCK_thd_data, &LOCK_thd_data, MY_MUTEX_INIT_FAST);
-  mysql_mutex_init(key_LOCK_wakeup_ready, &LOCK_wakeup_ready, MY_MUTEX_INIT_FAST);
-  mysql_cond_init(key_COND_wakeup_ready, &COND_wakeup_ready, 0);
-  /*
-    LOCK_thread_count goes before LOCK_thd_data - the former is called around
-    'delete thd', the latter - in THD::~THD
-  */
-  mysql_mutex_record_order(&LOCK_thread_count, &LOCK_thd_data);
+  query_cache_tls.first_query_block= NULL;
 
   /* Variables with default values */
   proc_info="login";
@@ -1008,9 +1047,6 @@ THD::THD()
   reset_open_tables_state(this);
 
   init();
-#if defined(ENABLED_PROFILING)
-  profiling.set_thd(this);
-#endif
   user_connect=(USER_CONN *)0;
   my_hash_init(&user_vars, system_charset_info, USER_VARS_HASH_SIZE, 0, 0,
                (my_hash_get_key) get_var_key,
@@ -1026,11 +1062,7 @@ THD::THD()
   else
     bzero((char*) &user_var_events, sizeof(user_var_events));
 
-  /* Protocol */
   protocol= &protocol_text;			// Default protocol
-  protocol_text.init(this);
-  protocol_binary.init(this);
-
   tablespace_op=FALSE;
 
   /*
@@ -1052,8 +1084,6 @@ THD::THD()
   prepare_derived_at_open= FALSE;
   create_tmp_table_for_derived= FALSE;
   save_prep_leaf_list= FALSE;
-  /* Restore THR_THD */
-  set_current_thd(old_THR_THD);
 }
 
 
@@ -1502,6 +1532,89 @@ void THD::change_user(void)
 }
 
 
+/*
+  Free what a closed connection leaves in the THD before the THD is put
+  to the session cache
+
+  IMPLEMENTATION
+    Does what the destructor does, but keeps the object with its mutexes,
+    the MDL context, the packet buffer and the buffers of the hashes and
+    arrays for the next connection. Called after cleanup() by the thread
+    that served the connection.
+*/
+
+void THD::free_connection()
+{
+  DBUG_ENTER("THD::free_connection");
+  DBUG_ASSERT(cleanup_done);
+  DBUG_ASSERT(!rgi_fake && !rli_fake && !rgi_slave);
+
+  /* Ensure that no one is using THD */
+  mysql_mutex_lock(&LOCK_thd_data);
+  mysql_mutex_unlock(&LOCK_thd_data);
+
+#ifndef EMBEDDED_LIBRARY
+  if (net.vio)
+    vio_delete(net.vio);
+  net.vio= 0;
+  /*
+    A packet buffer that was grown by the connection is tagged with its
+    id in debug builds, and the next connection wants a small one anyway
+  */
+  if (net.max_packet != (uint) global_system_variables.net_buffer_length)
+    net_end(&net);
+#endif
+  stmt_map.reset();                     /* close all prepared statements */
+
+  ha_close_connection(this);
+  mysql_audit_release(this);
+  plugin_thdvar_cleanup(this);
+
+  main_security_ctx.destroy();
+  main_security_ctx.init();
+  my_free(db);
+  db= NULL;
+  db_length= 0;
+  /*
+    The blocks of the memory roots are tagged with the id of the connection
+    that allocated them in debug builds, so they are freed here and
+    preallocated again by init_for_queries() of the next connection
+  */
+  free_root(&transaction.mem_root, MYF(0));
+  free_root(&main_mem_root, MYF(0));
+  free_list= 0;
+  main_da.reset_diagnostics_area();
+  main_da.clear_warning_info(0);
+#if defined(ENABLED_PROFILING)
+  profiling.restart();
+#endif
+  auto_inc_intervals_forced.empty();
+  auto_inc_intervals_in_cur_stmt_for_binlog.empty();
+  /* The mysys_var of the thread that served the connection may go away */
+  mysys_var= 0;
+  DBUG_VOID_RETURN;
+}
+
+
+/*
+  Prepare a THD from the session cache for a new connection
+
+  IMPLEMENTATION
+    free_connection() and cleanup() have freed what the previous
+    connection left, init_connection_state() initializes everything a
+    connection uses, as for a new THD. Must be called with the THD as
+    current_thd, so that the memory it allocates is accounted to it.
+*/
+
+void THD::reset_for_reuse()
+{
+  DBUG_ENTER("THD::reset_for_reuse");
+  DBUG_ASSERT(cleanup_done && !net.vio);
+  init_connection_state();
+  DBUG_VOID_RETURN;
+}
+
+
 /* Do operations that may take a long time */
 
 void THD::cleanup(void)
@@ -2268,10 +2381,11 @@ CHANGED_TABLE_LIST* THD::changed_table_dup(const char *key, long key_length)
 }
 
 
-int THD::send_explain_fields(select_result *result)
+int THD::send_explain_fields(select_result *result, uint8 explain_flags,
+                             bool is_json)
 {
   List<Item> field_list;
-  make_explain_field_list(field_list);
+  make_explain_field_list(field_list, explain_flags, is_json);
   result->prepare(field_list, NULL);
   return (result->send_result_set_metadata(field_list,
                                            Protocol::SEND_NUM_ROWS | 
@@ -2281,19 +2395,28 @@ int THD::send_explain_fields(select_result *result)
 
 /*
   Populate the provided field_list with EXPLAIN output columns.
-  this->lex->describe has the EXPLAIN flags
+  explain_flags has the DESCRIBE_* flags, is_json means the output is a
+  single column with the JSON document.
 */
 
-void THD::make_explain_field_list(List<Item> &field_list)
+void THD::make_explain_field_list(List<Item> &field_list, uint8 explain_flags,
+                                  bool is_json)
 {
   Item *item;
   CHARSET_INFO *cs= system_charset_info;
+
+  if (is_json)
+  {
+    field_list.push_back(new Item_empty_string("EXPLAIN", 78, cs));
+    return;
+  }
+
   field_list.push_back(item= new Item_return_int("id",3, MYSQL_TYPE_LONGLONG));
   item->maybe_null= 1;
   field_list.push_back(new Item_empty_string("select_type", 19, cs));
   field_list.push_back(item= new Item_empty_string("table", NAME_CHAR_LEN, cs));
   item->maybe_null= 1;
-  if (lex->describe & DESCRIBE_PARTITIONS)
+  if (explain_flags & DESCRIBE_PARTITIONS)
   {
     /* Maximum length of string that make_used_partitions_str() can produce */
     item= new Item_empty_string("partitions", MAX_PARTITIONS * (1 + FN_LEN),
@@ -2317,11 +2440,21 @@ void THD::make_explain_field_list(List<Item> &field_list)
   item->maybe_null=1;
   field_list.push_back(item= new Item_return_int("rows", 10,
                                                  MYSQL_TYPE_LONGLONG));
-  if (lex->describe & DESCRIBE_EXTENDED)
+  if (explain_flags & DESCRIBE_ANALYZE)
+  {
+    item->maybe_null= 1;
+    field_list.push_back(item= new Item_float("r_rows", 0.1234, 2, 4));
+  }
+  if (explain_flags & DESCRIBE_EXTENDED)
   {
     field_list.push_back(item= new Item_float("filtered", 0.1234, 2, 4));
     item->maybe_null=1;
   }
+  if (explain_flags & DESCRIBE_ANALYZE)
+  {
+    field_list.push_back(item= new Item_float("r_filtered", 0.1234, 2, 4));
+    item->maybe_null=1;
+  }
   item->maybe_null= 1;
   field_list.push_back(new Item_empty_string("Extra", 255, cs));
 }
@@ -2555,6 +2688,34 @@ int select_send::send_data(List<Item> &items)
 }
 
 
+/*
+  Compute the values of a row of ANALYZE without sending it: the select
+  list may contain subqueries, which are executed only when the row is
+  produced.
+*/
+
+int select_send_analyze::send_data(List<Item> &items)
+{
+  char buff[MAX_FIELD_WIDTH];
+  String buffer(buff, sizeof(buff), &my_charset_bin);
+  List_iterator_fast<Item> it(items);
+  Item *item;
+  DBUG_ENTER("select_send_analyze::send_data");
+
+  if (unit && unit->offset_limit_cnt)
+  {
+    unit->offset_limit_cnt--;
+    DBUG_RETURN(FALSE);
+  }
+  while ((item= it++))
+  {
+    buffer.length(0);
+    item->val_str(&buffer);
+  }
+  DBUG_RETURN(thd->is_error());
+}
+
+
 bool select_send::send_eof()
 {
   /* 
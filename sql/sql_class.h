@@ -529,6 +529,7 @@ typedef struct system_variables
   ulong max_error_count;
   ulong max_length_for_sort_data;
   ulong max_sort_length;
+  ulong max_sort_threads;
   ulong max_tmp_tables;
   ulong max_insert_delayed_threads;
   ulong min_examined_row_limit;
@@ -543,11 +544,13 @@ typedef struct system_variables
   ulong optimizer_search_depth;
   ulong optimizer_selectivity_sampling_limit;
   ulong optimizer_use_condition_selectivity;
+  ulong parallel_scan_workers;
   ulong use_stat_tables;
   ulong histogram_size;
   ulong histogram_type;
   ulong preload_buff_size;
   ulong profiling_history_size;
+  ulong range_index_dive_limit;
   ulong read_buff_size;
   ulong read_rnd_buff_size;
   ulong mrr_buff_size;
@@ -638,6 +641,7 @@ typedef struct system_variables
   ulong wt_timeout_long, wt_deadlock_search_depth_long;
 
   double long_query_time_double;
+  double analyze_sample_percentage;
 
   my_bool pseudo_slave_mode;
 
@@ -2773,6 +2777,9 @@ public:
   void update_stats(void);
   void change_user(void);
   void cleanup(void);
+  void free_connection();
+  void init_connection_state();
+  void reset_for_reuse();
   void cleanup_after_query();
   bool store_globals();
   void reset_globals();
@@ -3057,8 +3064,10 @@ public:
   void add_changed_table(TABLE *table);
   void add_changed_table(const char *key, long key_length);
   CHANGED_TABLE_LIST * changed_table_dup(const char *key, long key_length);
-  int send_explain_fields(select_result *result);
-  void make_explain_field_list(List<Item> &field_list);
+  int send_explain_fields(select_result *result, uint8 explain_flags,
+                          bool is_json);
+  void make_explain_field_list(List<Item> &field_list, uint8 explain_flags,
+                               bool is_json);
   /**
     Clear the current error, if any.
     We do not clear is_fatal_error or is_fatal_sub_stmt_error since we
@@ -3960,6 +3969,20 @@ public:
 };
 
 
+/*
+  Result of ANALYZE SELECT: the rows are computed and thrown away, the
+  client is sent the EXPLAIN output with the counters instead
+*/
+
+class select_send_analyze : public select_send
+{
+  bool send_result_set_metadata(List<Item> &list, uint flags) { return 0; }
+  int send_data(List<Item> &items);
+  bool send_eof() { return 0; }
+  void abort_result_set() {}
+};
+
+
 class select_to_file :public select_result_interceptor {
 protected:
   sql_exchange *exchange;
@@ -4237,6 +4260,28 @@ public:
   TMP_TABLE_PARAM *get_tmp_table_param() { return &tmp_table_param; }
 };
 
+
+/*
+  Sends the rows of a UNION ALL to the result of the statement as the
+  SELECTs produce them. The table is created but not opened: its record
+  converts the row to the types of the UNION columns, that are sent
+  through the unit's item_list.
+*/
+
+class select_union_direct :public select_union
+{
+  select_result *result;
+public:
+  /* Number of rows sent to result */
+  ha_rows send_records;
+
+  select_union_direct(select_result *result_arg)
+    :result(result_arg), send_records(0) {}
+  int send_data(List<Item> &items);
+  bool flush() { return FALSE; }
+  void cleanup() {}
+};
+
 /* Base subselect interface class */
 class select_subselect :public select_result_interceptor
 {
@@ -4424,6 +4469,8 @@ typedef struct st_sort_field {
   Item	*item;				/* Item if not sorting fields */
   uint	 length;			/* Length of sort field */
   uint   suffix_length;                 /* Length suffix (0-4) */
+  uint   length_bytes;                  /* Length prefix if packed (0-4) */
+  uchar  *pad;                          /* Key of an empty value if packed */
   Item_result result_type;		/* Type of item */
   bool reverse;				/* if descending sort */
   bool need_strxnfrm;			/* If we have to use strxnfrm() */
@@ -4509,8 +4556,20 @@ user_var_entry *get_variable(HASH *hash, LEX_STRING &name,
    it's dumped to the file. User can request sorted values, or
    just iterate through them. In the last case tree merging is performed in
    memory simultaneously with iteration, so it should be ~2-3x faster.
+
+   When two elements are equal only if their bytes are equal (rowids,
+   numbers), the values can be put to an open addressing hash table
+   instead of the tree. When the table gets full, its elements are
+   written to the file in partitions by their hash values. Every partition
+   has less distinct values than the whole set and is deduplicated by its
+   own in the hash table, recursively if it is still too big. The values
+   are sorted only by get(); walk() visits them in no particular order.
  */
 
+/* Number of partitions the elements of a full hash table are written to */
+#define UNIQUE_HASH_PARTITION_BITS 4
+#define UNIQUE_HASH_PARTITIONS (1U << UNIQUE_HASH_PARTITION_BITS)
+
 class Unique :public Sql_alloc
 {
   DYNAMIC_ARRAY file_ptrs;
@@ -4526,18 +4585,44 @@ class Unique :public Sql_alloc
   uint min_dupl_count;   /* always 0 for unions, > 0 for intersections */
   bool with_counters;
 
+  /* The hash table, used instead of the tree if hash_mode is set */
+  bool hash_mode;
+  /* hash_capacity slots of 'size' bytes */
+  uchar *hash_slots;
+  /* A byte for every slot, 0 for a free slot */
+  uchar *hash_used;
+  ulong hash_capacity, hash_max_capacity;
+  ulong hash_elements;
+  /* Partitions of the elements written to the file (Unique_hash_chunk) */
+  DYNAMIC_ARRAY hash_chunks;
+
   bool merge(TABLE *table, uchar *buff, bool without_last_merge);
 
+  bool hash_alloc(ulong capacity);
+  void hash_free();
+  void hash_insert(const uchar *key, ulonglong hash);
+  bool hash_add(const uchar *key);
+  bool hash_spill(DYNAMIC_ARRAY *chunks, uint level);
+  bool hash_walk_partitions(DYNAMIC_ARRAY *chunks, uint level, uchar *buff,
+                            ulong buff_size, tree_walk_action action,
+                            void *walk_action_arg);
+  bool hash_walk(tree_walk_action action, void *walk_action_arg);
+  ulong hash_sort();
+  void hash_clear();
+
 public:
   ulong elements;
   Unique(qsort_cmp2 comp_func, void *comp_func_fixed_arg,
 	 uint size_arg, ulonglong max_in_memory_size_arg,
-         uint min_dupl_count_arg= 0);
+         uint min_dupl_count_arg= 0, bool hash_mode_arg= FALSE);
   ~Unique();
-  ulong elements_in_tree() { return tree.elements_in_tree; }
+  ulong elements_in_tree()
+  { return hash_mode ? hash_elements : tree.elements_in_tree; }
   inline bool unique_add(void *ptr)
   {
     DBUG_ENTER("unique_add");
+    if (hash_mode)
+      DBUG_RETURN(hash_add((uchar *) ptr));
     DBUG_PRINT("info", ("tree %u - %lu", tree.elements_in_tree, max_elements));
     if (!(tree.flag & TREE_ONLY_DUPS) && 
         tree.elements_in_tree >= max_elements && flush())
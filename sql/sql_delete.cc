@@ -224,6 +224,7 @@ bool mysql_delete(THD *thd, TABLE_LIST *table_list, COND *conds,
   THD::enum_binlog_query_type query_type= THD::ROW_QUERY_TYPE;
   bool with_select= !select_lex->item_list.is_empty();
   Delete_plan query_plan(thd->mem_root);
+  Table_access_tracker *tracker= NULL;
   query_plan.index= MAX_KEY;
   query_plan.using_filesort= FALSE;
   DBUG_ENTER("mysql_delete");
@@ -361,7 +362,7 @@ bool mysql_delete(THD *thd, TABLE_LIST *table_list, COND *conds,
     {
       limit= 0;
       query_plan.set_impossible_where();
-      if (thd->lex->describe)
+      if (thd->lex->describe || thd->lex->analyze_stmt)
         goto exit_without_my_ok;
     }
   }
@@ -372,7 +373,7 @@ bool mysql_delete(THD *thd, TABLE_LIST *table_list, COND *conds,
     free_underlaid_joins(thd, select_lex);
 
     query_plan.set_no_partitions();
-    if (thd->lex->describe)
+    if (thd->lex->describe || thd->lex->analyze_stmt)
       goto exit_without_my_ok;
 
     my_ok(thd, 0);
@@ -392,7 +393,7 @@ bool mysql_delete(THD *thd, TABLE_LIST *table_list, COND *conds,
   if ((select && select->check_quick(thd, safe_update, limit)) || !limit)
   {
     query_plan.set_impossible_where();
-    if (thd->lex->describe)
+    if (thd->lex->describe || thd->lex->analyze_stmt)
       goto exit_without_my_ok;
 
     delete select;
@@ -461,6 +462,13 @@ bool mysql_delete(THD *thd, TABLE_LIST *table_list, COND *conds,
   
   query_plan.save_explain_data(thd->lex->explain);
 
+  if (thd->lex->analyze_stmt)
+  {
+    tracker= &thd->lex->explain->get_upd_del_plan()->tracker;
+    table->file->tracker= &tracker->time_tracker;
+    tracker->on_scan_init();
+  }
+
   DBUG_EXECUTE_IF("show_explain_probe_delete_exec_start", 
                   dbug_serve_apcs(thd, 1););
 
@@ -489,6 +497,13 @@ bool mysql_delete(THD *thd, TABLE_LIST *table_list, COND *conds,
         DBUG_RETURN(TRUE);
       }
       thd->inc_examined_row_count(examined_rows);
+      /* The loop below reads the sorted rows again, don't count them */
+      if (tracker)
+      {
+        tracker->r_rows+= examined_rows;
+        tracker->r_rows_after_where+= found_rows;
+        tracker= NULL;
+      }
       /*
         Filesort has already found and selected the rows we want to delete,
         so we don't need the where clause
@@ -546,9 +561,14 @@ bool mysql_delete(THD *thd, TABLE_LIST *table_list, COND *conds,
                             table->triggers ? VCOL_UPDATE_ALL :
                                               VCOL_UPDATE_FOR_READ);
     thd->inc_examined_row_count(1);
+    if (tracker)
+      tracker->on_record_read();
     // thd->is_error() is tested to disallow delete row on error
     if (!select || select->skip_record(thd) > 0)
     {
+      if (tracker)
+        tracker->on_record_after_where();
+
       if (table->triggers &&
           table->triggers->process_triggers(thd, TRG_EVENT_DELETE,
                                             TRG_ACTION_BEFORE, FALSE))
@@ -669,7 +689,15 @@ cleanup:
   if (error < 0 || 
       (thd->lex->ignore && !thd->is_error() && !thd->is_fatal_error))
   {
-    if (!with_select)
+    if (thd->lex->analyze_stmt)
+    {
+      /* ANALYZE DELETE sends the EXPLAIN output instead of the OK packet */
+      if (!thd->lex->explain->get_upd_del_plan())
+        query_plan.save_explain_data(thd->lex->explain);
+      if (thd->lex->explain->send_explain(thd))
+        error= 1;
+    }
+    else if (!with_select)
       my_ok(thd, deleted);
     else
       result->send_eof();
@@ -958,7 +986,9 @@ multi_delete::initialize_tables(JOIN *join)
     *tempfiles_ptr++= new Unique (refpos_order_cmp,
 				  (void *) table->file,
 				  table->file->ref_length,
-				  MEM_STRIP_BUF_SIZE);
+				  MEM_STRIP_BUF_SIZE, 0,
+                                  !(table->file->ha_table_flags() &
+                                    HA_PRIMARY_KEY_REQUIRED_FOR_POSITION));
   }
   init_ftfuncs(thd, thd->lex->current_select, 1);
   DBUG_RETURN(thd->is_fatal_error != 0);
@@ -1283,7 +1313,7 @@ bool multi_delete::send_eof()
   if (local_error != 0)
     error_handled= TRUE; // to force early leave from ::abort_result_set()
 
-  if (!local_error)
+  if (!local_error && !thd->lex->analyze_stmt)
   {
     ::my_ok(thd, deleted);
   }
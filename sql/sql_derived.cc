@@ -965,3 +965,363 @@ bool mysql_derived_reinit(THD *thd, LEX *lex, TABLE_LIST *derived)
   DBUG_RETURN(FALSE);
 }
 
+
+/*
+  Build the copy of a column of a materialized derived table used in a
+  condition pushed into the derived table.
+
+  @param thd        thread handle
+  @param field      the column of the derived table
+  @param sl         the SELECT of the derived table
+  @param for_having TRUE <=> the copy is for the HAVING clause of sl
+
+  @details
+  In WHERE the column is replaced by the field it is selected from, which
+  must be a grouping column when sl is grouped. In HAVING it is replaced
+  by a reference to the select list item, as if HAVING used its alias.
+
+  @return the copy, or NULL if the column cannot be used at the requested
+          place
+*/
+
+static Item *derived_column_for_cond(THD *thd, Item_field *field,
+                                     SELECT_LEX *sl, bool for_having)
+{
+  uint idx= field->field->field_index;
+  List_iterator_fast<Item> it(sl->item_list);
+  Item *item;
+  for (uint i= 0; (item= it++); i++)
+  {
+    if (i == idx)
+      break;
+  }
+  if (!item || item->with_subselect || item->is_expensive() ||
+      (item->used_tables() & RAND_TABLE_BIT))
+    return NULL;
+
+  if (for_having)
+    return new Item_ref(&sl->context, &sl->ref_pointer_array[idx],
+                        NullS, item->name);
+
+  Item *real= item->real_item();
+  if (real->type() != Item::FIELD_ITEM)
+    return NULL;
+  if (sl->group_list.elements)
+  {
+    ORDER *ord;
+    for (ord= sl->group_list.first; ord; ord= ord->next)
+    {
+      if ((*ord->item)->real_item()->eq(real, 0))
+        break;
+    }
+    if (!ord)
+      return NULL;
+  }
+  else if (sl->with_sum_func)
+    return NULL;
+  return new Item_field(thd, (Item_field *) real);
+}
+
+
+/*
+  Check if a function of a condition pushed into the WHERE of a grouped
+  derived table can tell apart values of a grouping column that are in
+  the same group.
+
+  @param func     the function of the condition over the derived table
+  @param derived  the derived table
+
+  @details
+  Values of a string column are grouped by the collation of the column.
+  A comparison by another collation, e.g. a case sensitive comparison of
+  a column grouped case insensitively, can be true for some rows of a
+  group and false for the others: evaluated in WHERE it would change the
+  groups and the value the derived table shows for them. Such a condition
+  is pushed into HAVING instead, where it is evaluated on the grouped
+  value as the outer query does.
+
+  @return TRUE if func compares a string column of the derived table by a
+          collation other than the one of the column
+*/
+
+static bool compares_finer_than_grouping(Item_func *func,
+                                         TABLE_LIST *derived)
+{
+  CHARSET_INFO *cs= func->compare_collation();
+  for (uint i= 0; i < func->argument_count(); i++)
+  {
+    Item *real= func->arguments()[i]->real_item();
+    Field *field;
+    if (real->type() != Item::FIELD_ITEM)
+      continue;
+    field= ((Item_field *) real)->field;
+    if (field->table == derived->table &&
+        field->cmp_type() == STRING_RESULT &&
+        field->charset() != &my_charset_bin && field->charset() != cs)
+      return TRUE;
+  }
+  return FALSE;
+}
+
+
+/*
+  Build the copy of a condition over the columns of a materialized derived
+  table that is evaluated inside the derived table.
+
+  @param thd        thread handle
+  @param cond       the condition, it depends only on the derived table
+  @param derived    the derived table
+  @param sl         the SELECT of the derived table
+  @param for_having TRUE <=> the copy is for the HAVING clause of sl
+
+  @details
+  Only AND/OR combinations of comparisons, BETWEEN, IN lists, IS [NOT] NULL
+  and NOT over columns and constants are copied. A condition for the WHERE
+  of a grouped SELECT must compare string columns by their own collations,
+  see compares_finer_than_grouping().
+
+  @return the copy, or NULL if the condition cannot be copied
+*/
+
+static Item *copy_cond_for_derived(THD *thd, Item *cond, TABLE_LIST *derived,
+                                   SELECT_LEX *sl, bool for_having)
+{
+  if (cond->type() == Item::COND_ITEM)
+  {
+    Item_cond *cond_item= (Item_cond *) cond;
+    List<Item> args;
+    List_iterator_fast<Item> li(*cond_item->argument_list());
+    Item *item;
+    while ((item= li++))
+    {
+      Item *copy;
+      if (!(copy= copy_cond_for_derived(thd, item, derived, sl, for_having)) ||
+          args.push_back(copy))
+        return NULL;
+    }
+    if (cond_item->functype() == Item_func::COND_AND_FUNC)
+      return new Item_cond_and(args);
+    if (cond_item->functype() == Item_func::COND_OR_FUNC)
+      return new Item_cond_or(args);
+    return NULL;
+  }
+
+  Item *real= cond->real_item();
+  if (real->type() == Item::FIELD_ITEM)
+  {
+    if (((Item_field *) real)->field->table != derived->table)
+      return NULL;
+    return derived_column_for_cond(thd, (Item_field *) real, sl, for_having);
+  }
+  if (cond->basic_const_item())
+    return cond->clone_item();
+  if (cond->type() != Item::FUNC_ITEM)
+    return NULL;
+
+  Item_func *func= (Item_func *) cond;
+  uint arg_count= func->argument_count();
+  Item **args;
+  Item *copy= NULL;
+  if (!for_having && sl->group_list.elements &&
+      compares_finer_than_grouping(func, derived))
+    return NULL;
+  if (!(args= (Item **) thd->alloc(sizeof(Item *) * (arg_count + 1))))
+    return NULL;
+  for (uint i= 0; i < arg_count; i++)
+  {
+    if (!(args[i]= copy_cond_for_derived(thd, func->arguments()[i], derived,
+                                         sl, for_having)))
+      return NULL;
+  }
+
+  switch (func->functype()) {
+  case Item_func::EQ_FUNC:
+    copy= new Item_func_eq(args[0], args[1]);
+    break;
+  case Item_func::EQUAL_FUNC:
+    copy= new Item_func_equal(args[0], args[1]);
+    break;
+  case Item_func::NE_FUNC:
+    copy= new Item_func_ne(args[0], args[1]);
+    break;
+  case Item_func::LT_FUNC:
+    copy= new Item_func_lt(args[0], args[1]);
+    break;
+  case Item_func::LE_FUNC:
+    copy= new Item_func_le(args[0], args[1]);
+    break;
+  case Item_func::GE_FUNC:
+    copy= new Item_func_ge(args[0], args[1]);
+    break;
+  case Item_func::GT_FUNC:
+    copy= new Item_func_gt(args[0], args[1]);
+    break;
+  case Item_func::ISNULL_FUNC:
+    copy= new Item_func_isnull(args[0]);
+    break;
+  case Item_func::ISNOTNULL_FUNC:
+    copy= new Item_func_isnotnull(args[0]);
+    break;
+  case Item_func::NOT_FUNC:
+    copy= new Item_func_not(args[0]);
+    break;
+  case Item_func::BETWEEN:
+  {
+    Item_func_between *between;
+    if ((between= new Item_func_between(args[0], args[1], args[2])))
+      between->negated= ((Item_func_between *) func)->negated;
+    copy= between;
+    break;
+  }
+  case Item_func::IN_FUNC:
+  {
+    List<Item> list;
+    Item_func_in *in;
+    for (uint i= 0; i < arg_count; i++)
+    {
+      if (list.push_back(args[i]))
+        return NULL;
+    }
+    if ((in= new Item_func_in(list)))
+      in->negated= ((Item_func_in *) func)->negated;
+    copy= in;
+    break;
+  }
+  default:
+    break;
+  }
+  return copy;
+}
+
+
+/*
+  AND conditions pushed into a derived table to its WHERE or HAVING.
+
+  The AND of the existing condition is not changed, a new one is built: it
+  may be the WHERE of a prepared statement, which is used again on the
+  next execution.
+*/
+
+bool add_conds_for_derived(THD *thd, Item **cond, List<Item> &pushed)
+{
+  List<Item> conjuncts;
+  Item *item= *cond;
+  if (pushed.is_empty())
+    return FALSE;
+  if (item && item->type() == Item::COND_ITEM &&
+      ((Item_cond *) item)->functype() == Item_func::COND_AND_FUNC)
+  {
+    List_iterator_fast<Item> li(*((Item_cond *) item)->argument_list());
+    Item *arg;
+    while ((arg= li++))
+    {
+      if (conjuncts.push_back(arg))
+        return TRUE;
+    }
+  }
+  else if (item && conjuncts.push_back(item))
+    return TRUE;
+  conjuncts.concat(&pushed);
+
+  if (conjuncts.elements == 1)
+    item= conjuncts.head();
+  else if (!(item= new Item_cond_and(conjuncts)))
+    return TRUE;
+  if (!item->fixed && item->fix_fields(thd, &item))
+    return TRUE;
+  *cond= item;
+  return FALSE;
+}
+
+
+/**
+  Push the conditions over the columns of a materialized derived table
+  into the derived table.
+
+  @param thd     thread handle
+  @param cond    the WHERE condition of the SELECT that uses the derived table
+  @param derived the derived table
+
+  @details
+  Every conjunct of cond that depends only on the derived table is copied
+  into the SELECT of the derived table, so that the rows that do not
+  satisfy it are not materialized. The copy goes into WHERE if all the
+  columns used are selected from grouping columns (or from any column if
+  the SELECT is not grouped) and string grouping columns are compared by
+  their own collations, and into HAVING otherwise. The conjunct
+  remains in cond.
+
+  The SELECT of the derived table must not be a UNION, have LIMIT or
+  WITH ROLLUP, and must not have been optimized yet. The derived table
+  must not be an inner table of an outer join: the WHERE condition is
+  also evaluated on its NULL-complemented rows, which do not come from
+  the derived table, so a condition like 'dt.b IS NULL' cannot be used to
+  filter the rows of the derived table.
+
+  @return FALSE ok.
+  @return TRUE if an error occur.
+*/
+
+bool pushdown_cond_for_derived(THD *thd, Item *cond, TABLE_LIST *derived)
+{
+  SELECT_LEX_UNIT *unit= derived->get_unit();
+  SELECT_LEX *sl;
+  List<Item> where_list;
+  List<Item> having_list;
+  DBUG_ENTER("pushdown_cond_for_derived");
+
+  if (!cond || !unit || unit->optimized || unit->is_union())
+    DBUG_RETURN(FALSE);
+  sl= unit->first_select();
+  if (!sl->join || sl->select_limit || sl->offset_limit ||
+      sl->olap == ROLLUP_TYPE)
+    DBUG_RETURN(FALSE);
+  for (TABLE_LIST *tbl= derived; tbl; tbl= tbl->embedding)
+  {
+    if (tbl->outer_join)
+      DBUG_RETURN(FALSE);
+  }
+
+  table_map map= derived->table->map;
+  bool grouped= sl->group_list.elements || sl->with_sum_func;
+  bool is_and= (cond->type() == Item::COND_ITEM &&
+                ((Item_cond *) cond)->functype() == Item_func::COND_AND_FUNC);
+  List<Item> single;
+  if (!is_and && single.push_back(cond))
+    DBUG_RETURN(TRUE);
+  List_iterator_fast<Item> li(is_and ? *((Item_cond *) cond)->argument_list() :
+                                       single);
+  Item *item;
+  while ((item= li++))
+  {
+    Item *copy;
+    if (item->used_tables() != map || item->with_subselect ||
+        item->is_expensive())
+      continue;
+    if ((copy= copy_cond_for_derived(thd, item, derived, sl, FALSE)))
+      where_list.push_back(copy);
+    else if (grouped &&
+             (copy= copy_cond_for_derived(thd, item, derived, sl, TRUE)))
+      having_list.push_back(copy);
+    if (thd->is_fatal_error)
+      DBUG_RETURN(TRUE);
+  }
+
+  SELECT_LEX *save_current_select= thd->lex->current_select;
+  thd->lex->current_select= sl;
+  bool res= FALSE;
+  List_iterator<Item> wi(where_list);
+  while ((item= wi++))
+  {
+    if ((res= item->fix_fields(thd, wi.ref())))
+      break;
+  }
+  if (!res)
+  {
+    /* WHERE is extended by JOIN::optimize(), see JOIN::pushed_where */
+    sl->join->pushed_where.concat(&where_list);
+    res= add_conds_for_derived(thd, &sl->join->having, having_list);
+  }
+  thd->lex->current_select= save_current_select;
+  DBUG_RETURN(res);
+}
@@ -19,10 +19,14 @@
 struct TABLE_LIST;
 class THD;
 struct LEX;
+class Item;
+template <class T> class List;
 
 bool mysql_handle_derived(LEX *lex, uint phases);
 bool mysql_handle_single_derived(LEX *lex, TABLE_LIST *derived, uint phases);
 bool mysql_handle_list_of_derived(LEX *lex, TABLE_LIST *dt_list, uint phases);
+bool pushdown_cond_for_derived(THD *thd, Item *cond, TABLE_LIST *derived);
+bool add_conds_for_derived(THD *thd, Item **cond, List<Item> &pushed);
 
 /**
    Cleans up the SELECT_LEX_UNIT for the derived table (if any).
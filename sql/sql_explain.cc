@@ -20,6 +20,7 @@
 
 #include "sql_priv.h"
 #include "sql_select.h"
+#include "my_json_writer.h"
 
 
 Explain_query::Explain_query(THD *thd_arg) : 
@@ -128,19 +129,31 @@ void Explain_query::query_plan_ready()
 
 /*
   Send EXPLAIN output to the client.
+
+  ANALYZE sends the same output after the statement has been run, with the
+  columns of the counters added.
 */
 
 int Explain_query::send_explain(THD *thd)
 {
   select_result *result;
   LEX *lex= thd->lex;
+  uint8 explain_flags= lex->describe;
+
+  if (lex->analyze_stmt)
+    explain_flags|= DESCRIBE_EXTENDED | DESCRIBE_ANALYZE;
  
   if (!(result= new select_send()) || 
-      thd->send_explain_fields(result))
+      thd->send_explain_fields(result, explain_flags, lex->explain_json))
     return 1;
 
   int res;
-  if ((res= print_explain(result, lex->describe)))
+  if (lex->explain_json)
+    res= print_explain_json(result, lex->analyze_stmt);
+  else
+    res= print_explain(result, explain_flags);
+
+  if (res)
     result->abort_result_set();
   else
     result->send_eof();
@@ -177,6 +190,38 @@ int Explain_query::print_explain(select_result_sink *output,
 }
 
 
+/*
+  Print EXPLAIN FORMAT=JSON of the entire query as a single row
+*/
+
+int Explain_query::print_explain_json(select_result_sink *output,
+                                      bool is_analyze)
+{
+  Json_writer writer;
+
+  if (upd_del_plan)
+    upd_del_plan->print_explain_json(this, &writer, is_analyze);
+  else if (insert_plan)
+    insert_plan->print_explain_json(this, &writer, is_analyze);
+  else
+  {
+    /* Start printing from node with id=1 */
+    Explain_node *node= get_node(1);
+    if (!node)
+      return 1; /* No query plan */
+    node->print_explain_json(this, &writer, is_analyze);
+  }
+
+  const CHARSET_INFO *cs= system_charset_info;
+  List<Item> item_list;
+  String *buf= &writer.output;
+  item_list.push_back(new Item_string(buf->ptr(), buf->length(), cs));
+  if (output->send_data(item_list))
+    return 1;
+  return 0;
+}
+
+
 bool print_explain_query(LEX *lex, THD *thd, String *str)
 {
   return lex->explain->print_explain_str(thd, str);
@@ -190,7 +235,7 @@ bool print_explain_query(LEX *lex, THD *thd, String *str)
 bool Explain_query::print_explain_str(THD *thd, String *out_str)
 {
   List<Item> fields;
-  thd->make_explain_field_list(fields);
+  thd->make_explain_field_list(fields, thd->lex->describe, false);
 
   select_result_text_buffer output_buf(thd);
   output_buf.send_result_set_metadata(fields, thd->lex->describe);
@@ -215,6 +260,39 @@ static void push_string(List<Item> *item_list, String *str)
 }
 
 
+/*
+  Write the name of the UNION RESULT table, something like "<union1,2>", into
+  a buffer of SAFE_NAME_LEN bytes and return its length
+*/
+
+uint Explain_union::make_union_table_name(char *buf)
+{
+  uint childno= 0;
+  uint len= 6, lastop= 0;
+  memcpy(buf, STRING_WITH_LEN("<union"));
+
+  for (; childno < union_members.elements() && len + lastop + 5 < NAME_LEN;
+       childno++)
+  {
+    len+= lastop;
+    lastop= my_snprintf(buf + len, NAME_LEN - len,
+                        "%u,", union_members.at(childno));
+  }
+
+  if (childno < union_members.elements() || len + lastop >= NAME_LEN)
+  {
+    memcpy(buf + len, STRING_WITH_LEN("...>") + 1);
+    len+= 4;
+  }
+  else
+  {
+    len+= lastop;
+    buf[len - 1]= '>';  // change ',' to '>'
+  }
+  return len;
+}
+
+
 int Explain_union::print_explain(Explain_query *query, 
                                  select_result_sink *output,
                                  uint8 explain_flags)
@@ -228,6 +306,9 @@ int Explain_union::print_explain(Explain_query *query,
     sel->print_explain(query, output, explain_flags);
   }
 
+  if (!using_tmp_table)
+    return print_explain_for_children(query, output, explain_flags);
+
   /* Print a line with "UNION RESULT" */
   List<Item> item_list;
   Item *item_null= new Item_null();
@@ -240,28 +321,7 @@ int Explain_union::print_explain(Explain_query *query,
 
   /* `table` column: something like "<union1,2>" */
   {
-    uint childno= 0;
-    uint len= 6, lastop= 0;
-    memcpy(table_name_buffer, STRING_WITH_LEN("<union"));
-
-    for (; childno < union_members.elements() && len + lastop + 5 < NAME_LEN;
-         childno++)
-    {
-      len+= lastop;
-      lastop= my_snprintf(table_name_buffer + len, NAME_LEN - len,
-                          "%u,", union_members.at(childno));
-    }
-
-    if (childno < union_members.elements() || len + lastop >= NAME_LEN)
-    {
-      memcpy(table_name_buffer + len, STRING_WITH_LEN("...>") + 1);
-      len+= 4;
-    }
-    else
-    {
-      len+= lastop;
-      table_name_buffer[len - 1]= '>';  // change ',' to '>'
-    }
+    uint len= make_union_table_name(table_name_buffer);
     const CHARSET_INFO *cs= system_charset_info;
     item_list.push_back(new Item_string(table_name_buffer, len, cs));
   }
@@ -288,10 +348,18 @@ int Explain_union::print_explain(Explain_query *query,
   /* `rows` */
   item_list.push_back(item_null);
 
+  /* `r_rows` */
+  if (explain_flags & DESCRIBE_ANALYZE)
+    item_list.push_back(item_null);
+
   /* `filtered` */
   if (explain_flags & DESCRIBE_EXTENDED)
     item_list.push_back(item_null);
 
+  /* `r_filtered` */
+  if (explain_flags & DESCRIBE_ANALYZE)
+    item_list.push_back(item_null);
+
   /* `Extra` */
   StringBuffer<256> extra_buf;
   if (using_filesort)
@@ -361,6 +429,12 @@ int Explain_select::print_explain(Explain_query *query,
       item_list.push_back(item_null);
     if (explain_flags & DESCRIBE_EXTENDED)
       item_list.push_back(item_null);
+    /* `r_rows` and `r_filtered` */
+    if (explain_flags & DESCRIBE_ANALYZE)
+    {
+      item_list.push_back(item_null);
+      item_list.push_back(item_null);
+    }
 
     item_list.push_back(new Item_string(message,strlen(message),cs));
 
@@ -402,9 +476,6 @@ int Explain_table_access::print_explain(select_result_sink *output, uint8 explai
                                     bool using_temporary, bool using_filesort)
 {
   const CHARSET_INFO *cs= system_charset_info;
-  const char *hash_key_prefix= "#hash#";
-  bool is_hj= (type == JT_HASH || type == JT_HASH_NEXT || 
-               type == JT_HASH_RANGE || type == JT_HASH_INDEX_MERGE);
 
   List<Item> item_list;
   Item *item_null= new Item_null();
@@ -446,25 +517,7 @@ int Explain_table_access::print_explain(select_result_sink *output, uint8 explai
 
   /* `key` */
   StringBuffer<64> key_str;
-  if (key.get_key_name())
-  {
-    if (is_hj)
-      key_str.append(hash_key_prefix, strlen(hash_key_prefix), cs);
-
-    key_str.append(key.get_key_name());
-
-    if (is_hj && type != JT_HASH)
-      key_str.append(':');
-  }
-  
-  if (quick_info)
-  {
-    StringBuffer<64> buf2;
-    quick_info->print_key(&buf2);
-    key_str.append(buf2);
-  }
-  if (type == JT_HASH_NEXT)
-    key_str.append(hash_next_key.get_key_name());
+  fill_key_str(&key_str);
   
   if (key_str.length() > 0)
     push_string(&item_list, &key_str);
@@ -473,31 +526,7 @@ int Explain_table_access::print_explain(select_result_sink *output, uint8 explai
 
   /* `key_len` */
   StringBuffer<64> key_len_str;
-
-  if (key.get_key_len() != (uint)-1)
-  {
-    char buf[64];
-    size_t length;
-    length= longlong10_to_str(key.get_key_len(), buf, 10) - buf;
-    key_len_str.append(buf, length);
-    if (is_hj && type != JT_HASH)
-      key_len_str.append(':');
-  }
-
-  if (quick_info)
-  {
-    StringBuffer<64> buf2;
-    quick_info->print_key_len(&buf2);
-    key_len_str.append(buf2);
-  } 
-
-  if (type == JT_HASH_NEXT)
-  {
-    char buf[64];
-    size_t length;
-    length= longlong10_to_str(hash_next_key.get_key_len(), buf, 10) - buf;
-    key_len_str.append(buf, length);
-  }
+  fill_key_len_str(&key_len_str);
 
   if (key_len_str.length() > 0)
     push_string(&item_list, &key_len_str);
@@ -519,6 +548,15 @@ int Explain_table_access::print_explain(select_result_sink *output, uint8 explai
   else
     item_list.push_back(item_null);
 
+  /* `r_rows` */
+  if (explain_flags & DESCRIBE_ANALYZE)
+  {
+    if (tracker && tracker->has_scans())
+      item_list.push_back(new Item_float(tracker->get_avg_rows(), 2));
+    else
+      item_list.push_back(item_null);
+  }
+
   /* `filtered` */
   if (explain_flags & DESCRIBE_EXTENDED)
   {
@@ -530,6 +568,16 @@ int Explain_table_access::print_explain(select_result_sink *output, uint8 explai
       item_list.push_back(item_null);
   }
 
+  /* `r_filtered` */
+  if (explain_flags & DESCRIBE_ANALYZE)
+  {
+    if (tracker && tracker->has_scans())
+      item_list.push_back(new Item_float(tracker->get_filtered_after_where(),
+                                         2));
+    else
+      item_list.push_back(item_null);
+  }
+
   /* `Extra` */
   StringBuffer<256> extra_buf;
   bool first= true;
@@ -569,6 +617,75 @@ int Explain_table_access::print_explain(select_result_sink *output, uint8 explai
 }
 
 
+/*
+  Make the text of the `key` column
+*/
+
+void Explain_table_access::fill_key_str(String *key_str)
+{
+  const CHARSET_INFO *cs= system_charset_info;
+  const char *hash_key_prefix= "#hash#";
+  bool is_hj= (type == JT_HASH || type == JT_HASH_NEXT || 
+               type == JT_HASH_RANGE || type == JT_HASH_INDEX_MERGE);
+
+  if (key.get_key_name())
+  {
+    if (is_hj)
+      key_str->append(hash_key_prefix, strlen(hash_key_prefix), cs);
+
+    key_str->append(key.get_key_name());
+
+    if (is_hj && type != JT_HASH)
+      key_str->append(':');
+  }
+  
+  if (quick_info)
+  {
+    StringBuffer<64> buf2;
+    quick_info->print_key(&buf2);
+    key_str->append(buf2);
+  }
+  if (type == JT_HASH_NEXT)
+    key_str->append(hash_next_key.get_key_name());
+}
+
+
+/*
+  Make the text of the `key_len` column
+*/
+
+void Explain_table_access::fill_key_len_str(String *key_len_str)
+{
+  bool is_hj= (type == JT_HASH || type == JT_HASH_NEXT || 
+               type == JT_HASH_RANGE || type == JT_HASH_INDEX_MERGE);
+
+  if (key.get_key_len() != (uint)-1)
+  {
+    char buf[64];
+    size_t length;
+    length= longlong10_to_str(key.get_key_len(), buf, 10) - buf;
+    key_len_str->append(buf, length);
+    if (is_hj && type != JT_HASH)
+      key_len_str->append(':');
+  }
+
+  if (quick_info)
+  {
+    StringBuffer<64> buf2;
+    quick_info->print_key_len(&buf2);
+    key_len_str->append(buf2);
+  } 
+
+  if (type == JT_HASH_NEXT)
+  {
+    char buf[64];
+    size_t length;
+    length= longlong10_to_str(hash_next_key.get_key_len(), buf, 10) - buf;
+    key_len_str->append(buf, length);
+  }
+}
+
+
 /*
   Elements in this array match members of enum Extra_tag, defined in
   sql_explain.h
@@ -606,6 +723,9 @@ const char * extra_tag_text[]=
   "FirstMatch", // special handling
 
   "Using join buffer", // special handling 
+  "Using merge join",
+  "Using parallel scan",
+  "Using skip scan",
 
   "const row not found",
   "unique row not found",
@@ -690,7 +810,8 @@ void Explain_quick_select::print_extra(String *str)
 {
   if (quick_type == QUICK_SELECT_I::QS_TYPE_RANGE || 
       quick_type == QUICK_SELECT_I::QS_TYPE_RANGE_DESC ||
-      quick_type == QUICK_SELECT_I::QS_TYPE_GROUP_MIN_MAX)
+      quick_type == QUICK_SELECT_I::QS_TYPE_GROUP_MIN_MAX ||
+      quick_type == QUICK_SELECT_I::QS_TYPE_SKIP_SCAN)
   {
     /* print nothing */
   }
@@ -753,7 +874,8 @@ void Explain_quick_select::print_key(String *str)
 {
   if (quick_type == QUICK_SELECT_I::QS_TYPE_RANGE || 
       quick_type == QUICK_SELECT_I::QS_TYPE_RANGE_DESC || 
-      quick_type == QUICK_SELECT_I::QS_TYPE_GROUP_MIN_MAX)
+      quick_type == QUICK_SELECT_I::QS_TYPE_GROUP_MIN_MAX ||
+      quick_type == QUICK_SELECT_I::QS_TYPE_SKIP_SCAN)
   {
     if (str->length() > 0)
       str->append(',');
@@ -779,7 +901,8 @@ void Explain_quick_select::print_key_len(String *str)
 {
   if (quick_type == QUICK_SELECT_I::QS_TYPE_RANGE || 
       quick_type == QUICK_SELECT_I::QS_TYPE_RANGE_DESC ||
-      quick_type == QUICK_SELECT_I::QS_TYPE_GROUP_MIN_MAX)
+      quick_type == QUICK_SELECT_I::QS_TYPE_GROUP_MIN_MAX ||
+      quick_type == QUICK_SELECT_I::QS_TYPE_SKIP_SCAN)
   {
     char buf[64];
     size_t length;
@@ -893,6 +1016,10 @@ int Explain_update::print_explain(Explain_query *query,
     "Using index condition" is also not possible (which is an unjustified limitation)
   */
 
+  double r_rows= tracker.get_avg_rows();
+  double r_filtered= tracker.get_filtered_after_where();
+  bool has_scans= tracker.has_scans();
+
   print_explain_row(output, explain_flags, 
                     1, /* id */
                     select_type,
@@ -904,6 +1031,8 @@ int Explain_update::print_explain(Explain_query *query,
                     key_len_buf.length() ? key_len_buf.c_ptr() : NULL,
                     NULL, /* 'ref' is always NULL in single-table EXPLAIN DELETE */
                     &rows,
+                    has_scans ? &r_rows : NULL,
+                    has_scans ? &r_filtered : NULL,
                     extra_str.c_ptr_safe());
 
   return print_explain_for_children(query, output, explain_flags);
@@ -926,12 +1055,322 @@ int Explain_insert::print_explain(Explain_query *query,
                     NULL, // key_len
                     NULL, // ref
                     NULL, // rows
+                    NULL, // r_rows
+                    NULL, // r_filtered
                     NULL);
 
   return print_explain_for_children(query, output, explain_flags);
 }
 
 
+/*
+  EXPLAIN FORMAT=JSON
+
+  Every node is printed as an object with a "query_block" member. The tables
+  of a join are the elements of its "nested_loop" array, subqueries and
+  derived tables are the elements of the "subqueries" array of the node
+  they are used in.
+*/
+
+/*
+  Print a comma-separated list of index names as an array
+*/
+
+static void write_key_list(Json_writer *writer, const char *name, String *list)
+{
+  const char *ptr= list->ptr();
+  const char *end= ptr + list->length();
+
+  writer->add_member(name).start_array();
+  while (ptr < end)
+  {
+    const char *comma= (const char *) memchr(ptr, ',', end - ptr);
+    if (!comma)
+      comma= end;
+    writer->add_str(ptr, comma - ptr);
+    ptr= comma + 1;
+  }
+  writer->end_array();
+}
+
+
+/*
+  Print the loops, the rows and the time measured by ANALYZE
+*/
+
+static void write_analyze_counters(Json_writer *writer,
+                                   Table_access_tracker *tracker)
+{
+  writer->add_member("r_loops").add_ll(tracker ? tracker->get_loops() : 0);
+  writer->add_member("r_rows");
+  if (tracker && tracker->has_scans())
+    writer->add_double(tracker->get_avg_rows());
+  else
+    writer->add_null();
+  writer->add_member("r_total_time_ms").
+    add_double(tracker ? tracker->time_tracker.get_time_ms() : 0.0);
+}
+
+
+static void write_r_filtered(Json_writer *writer,
+                             Table_access_tracker *tracker)
+{
+  writer->add_member("r_filtered");
+  if (tracker && tracker->has_scans())
+    writer->add_double(tracker->get_filtered_after_where());
+  else
+    writer->add_null();
+}
+
+
+/*
+  Print a query block that has a message instead of a plan
+*/
+
+static void write_message_block(Json_writer *writer, int select_id,
+                                const char *message)
+{
+  writer->add_member("select_id").add_ll(select_id);
+  writer->add_member("table").start_object();
+  writer->add_member("message").add_str(message);
+  writer->end_object();
+}
+
+
+void Explain_node::print_explain_json_for_children(Explain_query *query,
+                                                   Json_writer *writer,
+                                                   bool is_analyze)
+{
+  if (!children.elements())
+    return;
+
+  writer->add_member("subqueries").start_array();
+  for (int i= 0; i < (int) children.elements(); i++)
+  {
+    Explain_node *node= query->get_node(children.at(i));
+    if (node)
+      node->print_explain_json(query, writer, is_analyze);
+  }
+  writer->end_array();
+}
+
+
+void Explain_select::print_explain_json(Explain_query *query,
+                                        Json_writer *writer, bool is_analyze)
+{
+  writer->start_object();
+  writer->add_member("query_block").start_object();
+  if (message)
+    write_message_block(writer, select_id, message);
+  else
+  {
+    writer->add_member("select_id").add_ll(select_id);
+    if (using_temporary)
+      writer->add_member("using_temporary_table").add_bool(true);
+    if (using_filesort)
+      writer->add_member("using_filesort").add_bool(true);
+
+    writer->add_member("nested_loop").start_array();
+    for (uint i= 0; i < n_join_tabs; i++)
+      join_tabs[i]->print_explain_json(writer, is_analyze);
+    writer->end_array();
+  }
+  print_explain_json_for_children(query, writer, is_analyze);
+  writer->end_object();
+  writer->end_object();
+}
+
+
+void Explain_union::print_explain_json(Explain_query *query,
+                                       Json_writer *writer, bool is_analyze)
+{
+  char table_name_buffer[SAFE_NAME_LEN];
+  uint len= make_union_table_name(table_name_buffer);
+
+  writer->start_object();
+  writer->add_member("query_block").start_object();
+  writer->add_member("union_result").start_object();
+  if (using_tmp_table)
+  {
+    writer->add_member("table_name").add_str(table_name_buffer, len);
+    writer->add_member("access_type").add_str(join_type_str[JT_ALL]);
+  }
+  if (using_filesort)
+    writer->add_member("using_filesort").add_bool(true);
+
+  writer->add_member("query_specifications").start_array();
+  for (int i= 0; i < (int) union_members.elements(); i++)
+  {
+    Explain_select *sel= query->get_select(union_members.at(i));
+    sel->print_explain_json(query, writer, is_analyze);
+  }
+  writer->end_array();
+  writer->end_object();
+
+  print_explain_json_for_children(query, writer, is_analyze);
+  writer->end_object();
+  writer->end_object();
+}
+
+
+void Explain_table_access::print_explain_json(Json_writer *writer,
+                                              bool is_analyze)
+{
+  writer->start_object();
+  writer->add_member("table").start_object();
+
+  writer->add_member("table_name").add_str(table_name);
+  if (sjm_nest_select_id)
+    writer->add_member("materialized_select_id").add_ll(sjm_nest_select_id);
+  if (used_partitions_set)
+    writer->add_member("partitions").add_str(used_partitions);
+  writer->add_member("access_type").add_str(join_type_str[type]);
+
+  if (possible_keys_str.length() > 0)
+    write_key_list(writer, "possible_keys", &possible_keys_str);
+
+  StringBuffer<64> key_str;
+  fill_key_str(&key_str);
+  if (key_str.length() > 0)
+    writer->add_member("key").add_str(key_str);
+
+  StringBuffer<64> key_len_str;
+  fill_key_len_str(&key_len_str);
+  if (key_len_str.length() > 0)
+    writer->add_member("key_length").add_str(key_len_str);
+
+  if (ref_set)
+    writer->add_member("ref").add_str(ref);
+
+  if (rows_set)
+    writer->add_member("rows").add_ll((longlong) rows);
+
+  if (is_analyze)
+    write_analyze_counters(writer, tracker);
+
+  if (filtered_set)
+    writer->add_member("filtered").add_double(filtered);
+
+  if (is_analyze)
+    write_r_filtered(writer, tracker);
+
+  if (extra_tags.elements())
+  {
+    StringBuffer<256> extra_buf;
+    for (int i=0; i < (int)extra_tags.elements(); i++)
+    {
+      if (i)
+        extra_buf.append(STRING_WITH_LEN("; "));
+      append_tag_name(&extra_buf, extra_tags.at(i));
+    }
+    writer->add_member("extra").add_str(extra_buf);
+  }
+
+  writer->end_object();
+  writer->end_object();
+}
+
+
+void Explain_update::print_explain_json(Explain_query *query,
+                                        Json_writer *writer, bool is_analyze)
+{
+  writer->start_object();
+  writer->add_member("query_block").start_object();
+
+  if (impossible_where || no_partitions)
+  {
+    const char *msg= impossible_where ? 
+                     "Impossible WHERE" : 
+                     "No matching rows after partition pruning";
+    write_message_block(writer, 1, msg);
+  }
+  else
+  {
+    writer->add_member("select_id").add_ll(1);
+    writer->add_member("table").start_object();
+    writer->add_member(get_type() == EXPLAIN_DELETE ? "delete" : "update").
+      add_bool(true);
+    writer->add_member("table_name").add_str(table_name);
+    if (used_partitions_set)
+      writer->add_member("partitions").add_str(used_partitions);
+    writer->add_member("access_type").add_str(join_type_str[jtype]);
+
+    if (possible_keys_line.length() > 0)
+      write_key_list(writer, "possible_keys", &possible_keys_line);
+
+    StringBuffer<64> key_buf;
+    StringBuffer<64> key_len_buf;
+    if (quick_info)
+    {
+      quick_info->print_key(&key_buf);
+      quick_info->print_key_len(&key_len_buf);
+    }
+    else
+    {
+      key_buf.copy(key_str);
+      key_len_buf.copy(key_len_str);
+    }
+    if (key_buf.length() > 0)
+      writer->add_member("key").add_str(key_buf);
+    if (key_len_buf.length() > 0)
+      writer->add_member("key_length").add_str(key_len_buf);
+
+    writer->add_member("rows").add_ll((longlong) rows);
+    if (is_analyze)
+    {
+      write_analyze_counters(writer, &tracker);
+      write_r_filtered(writer, &tracker);
+    }
+
+    if (using_where)
+      writer->add_member("using_where").add_bool(true);
+    if (mrr_type.length() != 0)
+      writer->add_member("mrr_type").add_str(mrr_type);
+    if (using_filesort)
+      writer->add_member("using_filesort").add_bool(true);
+    if (using_io_buffer)
+      writer->add_member("using_io_buffer").add_bool(true);
+    writer->end_object();
+  }
+
+  print_explain_json_for_children(query, writer, is_analyze);
+  writer->end_object();
+  writer->end_object();
+}
+
+
+void Explain_delete::print_explain_json(Explain_query *query,
+                                        Json_writer *writer, bool is_analyze)
+{
+  if (deleting_all_rows)
+  {
+    writer->start_object();
+    writer->add_member("query_block").start_object();
+    write_message_block(writer, 1, "Deleting all rows");
+    writer->end_object();
+    writer->end_object();
+  }
+  else
+    Explain_update::print_explain_json(query, writer, is_analyze);
+}
+
+
+void Explain_insert::print_explain_json(Explain_query *query,
+                                        Json_writer *writer, bool is_analyze)
+{
+  writer->start_object();
+  writer->add_member("query_block").start_object();
+  writer->add_member("select_id").add_ll(1);
+  writer->add_member("table").start_object();
+  writer->add_member("insert").add_bool(true);
+  writer->add_member("table_name").add_str(table_name);
+  writer->end_object();
+  print_explain_json_for_children(query, writer, is_analyze);
+  writer->end_object();
+  writer->end_object();
+}
+
+
 void delete_explain_query(LEX *lex)
 {
   delete lex->explain;
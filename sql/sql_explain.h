@@ -21,15 +21,19 @@
 
   These structures
   - Can be produced inexpensively from query plan.
-  - Store sufficient information to produce tabular EXPLAIN output (the goal is 
-    to be able to produce JSON also)
+  - Store sufficient information to produce tabular and JSON EXPLAIN output
+  - Point to the counters of ANALYZE, which are updated while the query runs
+    and printed after it has finished
 
 *************************************************************************************/
 
+#include "sql_analyze_stmt.h"
+
 
 const int FAKE_SELECT_LEX_ID= (int)UINT_MAX;
 
 class Explain_query;
+class Json_writer;
 
 /* 
   A node can be either a SELECT, or a UNION.
@@ -64,6 +68,12 @@ public:
   
   int print_explain_for_children(Explain_query *query, select_result_sink *output, 
                                  uint8 explain_flags);
+
+  /* Print the node as a JSON object */
+  virtual void print_explain_json(Explain_query *query, Json_writer *writer,
+                                  bool is_analyze)= 0;
+  void print_explain_json_for_children(Explain_query *query,
+                                       Json_writer *writer, bool is_analyze);
   virtual ~Explain_node(){}
 };
 
@@ -135,6 +145,8 @@ public:
   
   int print_explain(Explain_query *query, select_result_sink *output, 
                     uint8 explain_flags);
+  void print_explain_json(Explain_query *query, Json_writer *writer,
+                          bool is_analyze);
 };
 
 
@@ -173,9 +185,15 @@ public:
   }
   int print_explain(Explain_query *query, select_result_sink *output, 
                     uint8 explain_flags);
+  void print_explain_json(Explain_query *query, Json_writer *writer,
+                          bool is_analyze);
 
   const char *fake_select_type;
   bool using_filesort;
+  /* FALSE <=> the rows are sent as the SELECTs produce them */
+  bool using_tmp_table;
+private:
+  uint make_union_table_name(char *buf);
 };
 
 
@@ -232,6 +250,8 @@ public:
   /* This will return a select, or a union */
   Explain_node *get_node(uint select_id);
 
+  Explain_update *get_upd_del_plan() { return upd_del_plan; }
+
   /* This will return a select (even if there is a union with this id) */
   Explain_select *get_select(uint select_id);
   
@@ -239,8 +259,11 @@ public:
  
   /* Produce a tabular EXPLAIN output */
   int print_explain(select_result_sink *output, uint8 explain_flags);
+
+  /* Produce EXPLAIN FORMAT=JSON output, a single row with the document */
+  int print_explain_json(select_result_sink *output, bool is_analyze);
   
-  /* Send tabular EXPLAIN to the client */
+  /* Send EXPLAIN or the result of ANALYZE to the client */
   int send_explain(THD *thd);
   
   /* Return tabular EXPLAIN output as a text string */
@@ -311,6 +334,9 @@ enum explain_extra_tag
   ET_FIRST_MATCH,
   
   ET_USING_JOIN_BUFFER,
+  ET_USING_MERGE_JOIN,
+  ET_USING_PARALLEL_SCAN,
+  ET_USING_SKIP_SCAN,
 
   ET_CONST_ROW_NOT_FOUND,
   ET_UNIQUE_ROW_NOT_FOUND,
@@ -458,11 +484,17 @@ public:
   
   StringBuffer<32> firstmatch_table_name;
 
+  /* Counters of ANALYZE, NULL if the statement is not analyzed */
+  Table_access_tracker *tracker;
+
   int print_explain(select_result_sink *output, uint8 explain_flags, 
                     uint select_id, const char *select_type,
                     bool using_temporary, bool using_filesort);
+  void print_explain_json(Json_writer *writer, bool is_analyze);
 private:
   void append_tag_name(String *str, enum explain_extra_tag tag);
+  void fill_key_str(String *key_str);
+  void fill_key_len_str(String *key_len_str);
 };
 
 
@@ -502,8 +534,13 @@ public:
   bool using_filesort;
   bool using_io_buffer;
 
+  /* Counters of ANALYZE, updated only when the statement is analyzed */
+  Table_access_tracker tracker;
+
   virtual int print_explain(Explain_query *query, select_result_sink *output, 
                             uint8 explain_flags);
+  virtual void print_explain_json(Explain_query *query, Json_writer *writer,
+                                  bool is_analyze);
 };
 
 
@@ -524,6 +561,8 @@ public:
 
   int print_explain(Explain_query *query, select_result_sink *output, 
                     uint8 explain_flags);
+  void print_explain_json(Explain_query *query, Json_writer *writer,
+                          bool is_analyze);
 };
 
 
@@ -545,6 +584,8 @@ public:
 
   virtual int print_explain(Explain_query *query, select_result_sink *output, 
                             uint8 explain_flags);
+  virtual void print_explain_json(Explain_query *query, Json_writer *writer,
+                                  bool is_analyze);
 };
 
 
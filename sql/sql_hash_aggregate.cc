@@ -0,0 +1,579 @@
+/*
+   Copyright (c) 2014, Monty Program Ab
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/**
+  @file
+
+  @brief
+  Grouping of rows in an in-memory hash table for GROUP BY queries that
+  are executed through a temporary table
+
+  @see Hash_aggregate
+*/
+
+#include "sql_priv.h"
+#include "sql_hash_aggregate.h"
+#include "sql_class.h"
+#include "mysqld.h"                             // mysql_tmpdir
+
+
+/*
+  Check whether the records of two partial groups can be merged for the
+  aggregate function (see Hash_aggregate::merge_sum_fields())
+*/
+
+static bool is_mergeable(Item_sum *item, TABLE *table)
+{
+  Field *field= item->result_field;
+  if (!field || field->table != table)
+    return FALSE;
+  switch (item->sum_func()) {
+  case Item_sum::COUNT_FUNC:
+    return TRUE;
+  case Item_sum::SUM_FUNC:
+  case Item_sum::AVG_FUNC:
+    return item->result_type() == DECIMAL_RESULT ||
+           item->result_type() == REAL_RESULT;
+  case Item_sum::MIN_FUNC:
+  case Item_sum::MAX_FUNC:
+    /*
+      Field::cmp() must order the values the way Item_sum_hybrid does.
+      This is not so for temporal values, that are compared as strings,
+      and for ENUM and SET values, that are compared by their numbers.
+    */
+    if (field->type() == MYSQL_TYPE_BIT ||
+        field->real_type() == MYSQL_TYPE_ENUM ||
+        field->real_type() == MYSQL_TYPE_SET)
+      return FALSE;
+    switch (field->cmp_type()) {
+    case INT_RESULT:
+    case REAL_RESULT:
+    case DECIMAL_RESULT:
+      return TRUE;
+    case STRING_RESULT:
+      return field->real_type() == MYSQL_TYPE_VARCHAR ||
+             field->real_type() == MYSQL_TYPE_VAR_STRING ||
+             field->real_type() == MYSQL_TYPE_STRING;
+    default:
+      return FALSE;
+    }
+  default:
+    return FALSE;
+  }
+}
+
+
+/*
+  Check whether the grouping into join->tmp_table done by end_update() can
+  be done by a Hash_aggregate
+*/
+
+bool Hash_aggregate::is_applicable(JOIN *join)
+{
+  TABLE *table= join->tmp_table;
+  TMP_TABLE_PARAM *param= &join->tmp_table_param;
+
+  if (!optimizer_flag(join->thd, OPTIMIZER_SWITCH_HASH_AGGREGATE))
+    return FALSE;
+  if (!table || !table->group || !table->s->keys || !param->group_buff ||
+      param->precomputed_group_by || table->s->blob_fields)
+    return FALSE;
+  for (ORDER *group= table->group; group; group= group->next)
+  {
+    if (!group->field || group->field->type() == MYSQL_TYPE_BIT)
+      return FALSE;
+  }
+  for (Item_sum **func_ptr= join->sum_funcs; *func_ptr; func_ptr++)
+  {
+    if (!is_mergeable(*func_ptr, table))
+      return FALSE;
+  }
+  return TRUE;
+}
+
+
+bool Hash_aggregate::init(JOIN *join_arg)
+{
+  THD *thd= join_arg->thd;
+  uint part_count= 0;
+  size_t block_size;
+  DBUG_ENTER("Hash_aggregate::init");
+
+  join= join_arg;
+  table= join->tmp_table;
+  param= &join->tmp_table_param;
+
+  for (ORDER *group= table->group; group; group= group->next)
+    part_count++;
+  if (!(parts= (Hash_aggregate_part*)
+        my_malloc(part_count * sizeof(Hash_aggregate_part),
+                  MYF(MY_THREAD_SPECIFIC | MY_WME))))
+    DBUG_RETURN(TRUE);
+
+  key_length= 0;
+  parts_end= parts;
+  for (ORDER *group= table->group; group; group= group->next, parts_end++)
+  {
+    Field *field= group->field;
+    parts_end->field= field;
+    parts_end->offset= (uint) ((uchar*) group->buff - param->group_buff);
+    parts_end->length= field->pack_length();
+    parts_end->maybe_null= (*group->item)->maybe_null;
+    parts_end->is_real= field->real_type() == MYSQL_TYPE_FLOAT ||
+                        field->real_type() == MYSQL_TYPE_DOUBLE;
+    parts_end->use_cmp= field->real_type() == MYSQL_TYPE_VARCHAR ||
+                        field->real_type() == MYSQL_TYPE_VAR_STRING ||
+                        field->real_type() == MYSQL_TYPE_STRING ||
+                        parts_end->is_real;
+    set_if_bigger(key_length, parts_end->offset + parts_end->length);
+  }
+  rec_length= table->s->reclength;
+  entry_length= ALIGN_SIZE(sizeof(uchar*) + key_length + rec_length);
+
+  max_memory= MY_MIN(thd->variables.tmp_table_size,
+                     thd->variables.max_heap_table_size);
+
+  capacity= HASH_AGG_INIT_SLOTS;
+  if (!(slots= (Slot*) my_malloc(capacity * sizeof(Slot),
+                                 MYF(MY_THREAD_SPECIFIC | MY_ZEROFILL |
+                                     MY_WME))))
+    DBUG_RETURN(TRUE);
+  used_memory= capacity * sizeof(Slot);
+
+  block_size= MY_MAX(entry_length * 16, 8192);
+  init_alloc_root(&entry_root, block_size, 0, MYF(MY_THREAD_SPECIFIC));
+
+  DBUG_PRINT("info", ("key_length: %u  rec_length: %u  max_memory: %llu",
+                      key_length, rec_length, max_memory));
+  DBUG_RETURN(FALSE);
+}
+
+
+void Hash_aggregate::cleanup()
+{
+  for (uint i= 0; i < HASH_AGG_MAX_LEVELS; i++)
+  {
+    if (!files[i])
+      continue;
+    for (uint j= 0; j < HASH_AGG_PARTITIONS; j++)
+      close_cached_file(&files[i][j]);
+    my_free(files[i]);
+    files[i]= 0;
+    file_rows[i]= 0;
+  }
+  free_root(&entry_root, MYF(0));
+  my_free(slots);
+  slots= 0;
+  my_free(parts);
+  parts= parts_end= 0;
+}
+
+
+/* Calculate the hash value of the key in group_buff */
+
+ulonglong Hash_aggregate::hash_key()
+{
+  ulong nr1= 1, nr2= 4;
+  ulonglong h;
+
+  for (Hash_aggregate_part *part= parts; part != parts_end; part++)
+  {
+    if (part->maybe_null && param->group_buff[part->offset - 1])
+      nr1^= (nr1 << 1) | 1;
+    else if (part->is_real && part->field->val_real() == 0.0)
+    {
+      /* -0.0 and 0.0 are the same group, see key_equal() */
+      static const uchar zero[sizeof(double)]= {0};
+      my_charset_bin.coll->hash_sort(&my_charset_bin, zero, part->length,
+                                     &nr1, &nr2);
+    }
+    else
+      part->field->hash(&nr1, &nr2);
+  }
+
+  /* Spread the bits, the partitions are chosen by the high ones */
+  h= (ulonglong) nr1;
+  h^= h >> 33;
+  h*= 0xff51afd7ed558ccdULL;
+  h^= h >> 33;
+  h*= 0xc4ceb9fe1a85ec53ULL;
+  h^= h >> 33;
+  return h;
+}
+
+
+/*
+  Compare the key of an entry with the key in group_buff. CHAR and VARCHAR
+  values are compared by their collation and FLOAT and DOUBLE values by
+  their numbers, as the keys of the temporary table compare them; so -0.0
+  and 0.0 are one group. Other values are compared as bytes.
+*/
+
+bool Hash_aggregate::key_equal(const uchar *key)
+{
+  for (Hash_aggregate_part *part= parts; part != parts_end; part++)
+  {
+    const uchar *a= param->group_buff + part->offset;
+    const uchar *b= key + part->offset;
+    if (part->maybe_null)
+    {
+      if (a[-1] != b[-1])
+        return FALSE;
+      if (a[-1])
+        continue;
+    }
+    if (part->use_cmp ? part->field->cmp(a, b) != 0 :
+                        memcmp(a, b, part->length) != 0)
+      return FALSE;
+  }
+  return TRUE;
+}
+
+
+uchar *Hash_aggregate::find_group()
+{
+  ulong mask= capacity - 1;
+  ulong idx;
+
+  curr_hash= hash_key();
+  for (idx= (ulong) curr_hash & mask; slots[idx].entry; idx= (idx + 1) & mask)
+  {
+    uchar *key= slots[idx].entry + sizeof(uchar*);
+    if (slots[idx].hash == curr_hash && key_equal(key))
+      return key + key_length;
+  }
+  return 0;
+}
+
+
+/* Double the number of slots of the hash table */
+
+bool Hash_aggregate::grow()
+{
+  ulong new_capacity= capacity * 2;
+  ulong mask= new_capacity - 1;
+  Slot *new_slots;
+
+  if (!(new_slots= (Slot*) my_malloc(new_capacity * sizeof(Slot),
+                                     MYF(MY_THREAD_SPECIFIC | MY_ZEROFILL |
+                                         MY_WME))))
+    return TRUE;
+  for (Slot *slot= slots; slot < slots + capacity; slot++)
+  {
+    ulong idx;
+    if (!slot->entry)
+      continue;
+    for (idx= (ulong) slot->hash & mask; new_slots[idx].entry;
+         idx= (idx + 1) & mask)
+    {}
+    new_slots[idx]= *slot;
+  }
+  my_free(slots);
+  slots= new_slots;
+  used_memory+= (new_capacity - capacity) * sizeof(Slot);
+  capacity= new_capacity;
+  return FALSE;
+}
+
+
+bool Hash_aggregate::add_group()
+{
+  bool need_grow= (groups + 1) * 2 > capacity;
+  ulong mask;
+  ulong idx;
+  uchar *entry;
+
+  if (level < HASH_AGG_MAX_LEVELS &&
+      (full ||
+       used_memory + entry_length > max_memory ||
+       (need_grow &&
+        used_memory + entry_length + capacity * sizeof(Slot) > max_memory)))
+  {
+    /*
+      Once a group has been spilled, all new groups have to be spilled as
+      well: a group must never be partly in memory and partly on disk.
+    */
+    full= TRUE;
+    return spill_group();
+  }
+  if (need_grow && grow())
+    return TRUE;
+
+  if (!(entry= (uchar*) alloc_root(&entry_root, entry_length)))
+    return TRUE;
+  *(uchar**) entry= 0;
+  memcpy(entry + sizeof(uchar*), param->group_buff, key_length);
+  memcpy(entry + sizeof(uchar*) + key_length, table->record[0], rec_length);
+  *last_next= entry;
+  last_next= (uchar**) entry;
+
+  mask= capacity - 1;
+  for (idx= (ulong) curr_hash & mask; slots[idx].entry; idx= (idx + 1) & mask)
+  {}
+  slots[idx].hash= curr_hash;
+  slots[idx].entry= entry;
+  groups++;
+  used_memory+= entry_length;
+  return FALSE;
+}
+
+
+/*
+  Write the key in group_buff and the record in record[0] into the
+  partition file of the current level chosen by the hash value of the key
+*/
+
+bool Hash_aggregate::spill_group()
+{
+  uint part;
+  IO_CACHE *file;
+
+  if (!files[level])
+  {
+    DBUG_PRINT("info", ("Spilling groups to partitions of level %u  "
+                        "groups in memory: %lu", level, groups));
+    if (!my_multi_malloc(MYF(MY_THREAD_SPECIFIC | MY_ZEROFILL | MY_WME),
+                         &files[level], HASH_AGG_PARTITIONS * sizeof(IO_CACHE),
+                         &file_rows[level],
+                         HASH_AGG_PARTITIONS * sizeof(ha_rows),
+                         NullS))
+      return TRUE;
+    for (uint i= 0; i < HASH_AGG_PARTITIONS; i++)
+    {
+      if (open_cached_file(&files[level][i], mysql_tmpdir, TEMP_PREFIX,
+                           HASH_AGG_PARTITION_BUFF_SIZE, MYF(MY_WME)))
+        return TRUE;
+    }
+  }
+
+  part= (uint) (curr_hash >> (64 - HASH_AGG_PARTITION_BITS * (level + 1))) &
+        (HASH_AGG_PARTITIONS - 1);
+  file= &files[level][part];
+  if (my_b_write(file, param->group_buff, key_length) ||
+      my_b_write(file, table->record[0], rec_length))
+    return TRUE;
+  file_rows[level][part]++;
+  return FALSE;
+}
+
+
+/* Remove all groups from memory */
+
+void Hash_aggregate::reset()
+{
+  free_root(&entry_root, MYF(MY_MARK_BLOCKS_FREE));
+  bzero(slots, capacity * sizeof(Slot));
+  groups= 0;
+  first_entry= 0;
+  last_next= &first_entry;
+  used_memory= capacity * sizeof(Slot);
+  full= FALSE;
+}
+
+
+/* Write the groups in memory into the temporary table */
+
+bool Hash_aggregate::write_groups()
+{
+  int error;
+
+  for (uchar *entry= first_entry; entry; entry= *(uchar**) entry)
+  {
+    memcpy(table->record[0], entry + sizeof(uchar*) + key_length,
+           rec_length);
+    if ((error= table->file->ha_write_tmp_row(table->record[0])))
+    {
+      if (create_internal_tmp_table_from_heap(join->thd, table,
+                                              param->start_recinfo,
+                                              &param->recinfo,
+                                              error, 0, NULL))
+        return TRUE;                            // Not a table_is_full error
+    }
+    join->send_records++;
+  }
+  return FALSE;
+}
+
+
+/*
+  Merge the values of the aggregate functions of the record 'from' into
+  the record 'to'. Both records are of the same group.
+*/
+
+void Hash_aggregate::merge_sum_fields(uchar *to, uchar *from)
+{
+  my_ptrdiff_t to_diff= to - table->record[0];
+  my_ptrdiff_t from_diff= from - table->record[0];
+
+  for (Item_sum **func_ptr= join->sum_funcs; *func_ptr; func_ptr++)
+  {
+    Item_sum *item= *func_ptr;
+    Field *field= item->result_field;
+    uchar *to_ptr= field->ptr + to_diff;
+    uchar *from_ptr= field->ptr + from_diff;
+
+    switch (item->sum_func()) {
+    case Item_sum::COUNT_FUNC:
+      int8store(to_ptr, sint8korr(to_ptr) + sint8korr(from_ptr));
+      break;
+    case Item_sum::SUM_FUNC:
+      if (field->is_null(from_diff))
+        break;
+      if (field->is_null(to_diff))
+      {
+        memcpy(to_ptr, from_ptr, field->pack_length());
+        field->set_notnull(to_diff);
+        break;
+      }
+      if (item->result_type() == DECIMAL_RESULT)
+      {
+        my_decimal to_buff, from_buff, sum;
+        my_decimal *to_val, *from_val;
+        field->move_field_offset(from_diff);
+        from_val= field->val_decimal(&from_buff);
+        field->move_field_offset(to_diff - from_diff);
+        to_val= field->val_decimal(&to_buff);
+        my_decimal_add(E_DEC_FATAL_ERROR, &sum, to_val, from_val);
+        field->store_decimal(&sum);
+        field->move_field_offset(-to_diff);
+      }
+      else
+      {
+        double to_nr, from_nr;
+        float8get(to_nr, to_ptr);
+        float8get(from_nr, from_ptr);
+        to_nr+= from_nr;
+        float8store(to_ptr, to_nr);
+      }
+      break;
+    case Item_sum::AVG_FUNC:
+    {
+      /* The sum followed by the count, see Item_sum_avg::update_field() */
+      Item_sum_avg *avg= (Item_sum_avg*) item;
+      if (item->result_type() == DECIMAL_RESULT)
+      {
+        my_decimal to_val, from_val, sum;
+        binary2my_decimal(E_DEC_FATAL_ERROR, to_ptr, &to_val,
+                          avg->f_precision, avg->f_scale);
+        binary2my_decimal(E_DEC_FATAL_ERROR, from_ptr, &from_val,
+                          avg->f_precision, avg->f_scale);
+        my_decimal_add(E_DEC_FATAL_ERROR, &sum, &to_val, &from_val);
+        my_decimal2binary(E_DEC_FATAL_ERROR, &sum, to_ptr,
+                          avg->f_precision, avg->f_scale);
+        to_ptr+= avg->dec_bin_size;
+        from_ptr+= avg->dec_bin_size;
+      }
+      else
+      {
+        double to_nr, from_nr;
+        float8get(to_nr, to_ptr);
+        float8get(from_nr, from_ptr);
+        to_nr+= from_nr;
+        float8store(to_ptr, to_nr);
+        to_ptr+= sizeof(double);
+        from_ptr+= sizeof(double);
+      }
+      int8store(to_ptr, sint8korr(to_ptr) + sint8korr(from_ptr));
+      break;
+    }
+    case Item_sum::MIN_FUNC:
+    case Item_sum::MAX_FUNC:
+      if (field->is_null(from_diff))
+        break;
+      if (!field->is_null(to_diff))
+      {
+        int cmp= field->cmp(to_ptr, from_ptr);
+        if (item->sum_func() == Item_sum::MIN_FUNC ? cmp <= 0 : cmp >= 0)
+          break;
+      }
+      memcpy(to_ptr, from_ptr, field->pack_length());
+      field->set_notnull(to_diff);
+      break;
+    default:
+      DBUG_ASSERT(0);
+    }
+  }
+}
+
+
+/*
+  Group the records of the partitions of the given level one partition at
+  a time and write the groups into the temporary table
+*/
+
+bool Hash_aggregate::process_partitions(uint file_level)
+{
+  THD *thd= join->thd;
+  DBUG_ENTER("Hash_aggregate::process_partitions");
+
+  for (uint i= 0; i < HASH_AGG_PARTITIONS; i++)
+  {
+    IO_CACHE *file= &files[file_level][i];
+    ha_rows rows= file_rows[file_level][i];
+    if (!rows)
+      continue;
+    DBUG_PRINT("info", ("level: %u  partition: %u  records: %lu",
+                        file_level, i, (ulong) rows));
+
+    if (reinit_io_cache(file, READ_CACHE, 0L, 0, 0))
+      DBUG_RETURN(TRUE);
+    reset();
+    level= file_level + 1;
+    for ( ; rows; rows--)
+    {
+      uchar *rec;
+      if (my_b_read(file, param->group_buff, key_length) ||
+          my_b_read(file, table->record[0], rec_length))
+        DBUG_RETURN(TRUE);
+      if ((rec= find_group()))
+        merge_sum_fields(rec, table->record[0]);
+      else if (add_group())
+        DBUG_RETURN(TRUE);
+    }
+    file_rows[file_level][i]= 0;
+    if (reinit_io_cache(file, WRITE_CACHE, 0L, 0, 0))
+      DBUG_RETURN(TRUE);
+
+    if (write_groups())
+      DBUG_RETURN(TRUE);
+    if (file_level + 1 < HASH_AGG_MAX_LEVELS && file_rows[file_level + 1] &&
+        process_partitions(file_level + 1))
+      DBUG_RETURN(TRUE);
+
+    if (thd->check_killed() && thd->killed_errno())
+    {
+      thd->send_kill_message();
+      DBUG_RETURN(TRUE);
+    }
+  }
+  DBUG_RETURN(FALSE);
+}
+
+
+/*
+  Write all groups into the temporary table. Called by do_select() after
+  all rows of the join have been grouped.
+*/
+
+bool Hash_aggregate::end()
+{
+  DBUG_ENTER("Hash_aggregate::end");
+  if (write_groups())
+    DBUG_RETURN(TRUE);
+  if (file_rows[0] && process_partitions(0))
+    DBUG_RETURN(TRUE);
+  DBUG_RETURN(FALSE);
+}
@@ -0,0 +1,176 @@
+#ifndef SQL_HASH_AGGREGATE_INCLUDED
+#define SQL_HASH_AGGREGATE_INCLUDED
+
+/*
+   Copyright (c) 2014, Monty Program Ab
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/**
+  @file
+
+  @brief
+  Grouping of rows in an in-memory hash table for GROUP BY queries that
+  are executed through a temporary table
+*/
+
+#include "sql_select.h"
+
+/* Initial number of slots of the hash table, must be a power of 2 */
+#define HASH_AGG_INIT_SLOTS 1024
+
+/* Number of partitions the groups that do not fit in memory are split into */
+#define HASH_AGG_PARTITION_BITS 4
+#define HASH_AGG_PARTITIONS (1 << HASH_AGG_PARTITION_BITS)
+
+/*
+  Maximum number of times a partition can be split further. The groups of
+  a partition at the last level are kept in memory regardless of the limit.
+*/
+#define HASH_AGG_MAX_LEVELS 4
+
+/* Size of the buffer of a partition file */
+#define HASH_AGG_PARTITION_BUFF_SIZE (IO_SIZE * 4)
+
+
+/* A component of the GROUP BY key as stored in TMP_TABLE_PARAM::group_buff */
+
+struct Hash_aggregate_part
+{
+  /* The key field, its value is at 'offset' in group_buff */
+  Field *field;
+  uint offset;
+  uint length;
+  /* TRUE <=> the byte before the value is the NULL flag */
+  bool maybe_null;
+  /* TRUE <=> values are compared with Field::cmp(), otherwise as bytes */
+  bool use_cmp;
+  /* TRUE <=> FLOAT or DOUBLE value, -0.0 is hashed as 0.0 */
+  bool is_real;
+};
+
+
+/*
+  Hash aggregation for GROUP BY
+
+  When GROUP BY is executed through a temporary table with a key over the
+  group columns, end_update() looks up the group of every row with an
+  index read in the temporary table and updates the found row, or writes
+  a new one. When the HEAP table is full, it is converted to an on-disk
+  table and the rest of the rows are grouped through that table.
+
+  With optimizer_switch='hash_aggregate=on' the groups are kept instead in
+  an open addressing hash table in memory until all rows have been read.
+  An entry of the table is the group key in the format of
+  TMP_TABLE_PARAM::group_buff followed by the record of the temporary
+  table, with the values of the aggregate functions in the result fields
+  as Item_sum::update_field() maintains them. The entries are chained in
+  the order the groups were created and are written into the temporary
+  table in this order by end(), so that the temporary table gets the same
+  rows in the same order as with end_update().
+
+  The memory used by the hash table is limited by the smaller of
+  @@tmp_table_size and @@max_heap_table_size. When no more groups fit in
+  memory, the groups found in the hash table are still updated in memory,
+  while a new group is written with the values of its first row into one
+  of HASH_AGG_PARTITIONS partition files, chosen by the hash value of the
+  key. After the groups in memory have been written into the temporary
+  table, the partitions are read back one at a time and their records are
+  merged by group. A partition that again does not fit in memory is
+  split further by other bits of the hash value.
+
+  Records of the same group are merged by adding the values of COUNT(),
+  SUM() and AVG() and by comparing the values of MIN() and MAX(), so the
+  hash aggregation is used only when all aggregate functions are of these
+  kinds and can be merged this way (see is_mergeable()).
+*/
+
+class Hash_aggregate
+{
+  JOIN *join;
+  TABLE *table;
+  TMP_TABLE_PARAM *param;
+
+  Hash_aggregate_part *parts, *parts_end;
+  uint key_length;
+  uint rec_length;
+  /* Size of an entry of the hash table: next pointer, key, record */
+  uint entry_length;
+
+  struct Slot
+  {
+    ulonglong hash;
+    uchar *entry;
+  };
+  Slot *slots;
+  /* Number of slots, a power of 2 */
+  ulong capacity;
+  ulong groups;
+  uchar *first_entry, **last_next;
+  MEM_ROOT entry_root;
+
+  /* The memory used by the hash table and the limit for it */
+  ulonglong used_memory;
+  ulonglong max_memory;
+  /* TRUE <=> new groups of the current level go to the partition files */
+  bool full;
+
+  /* The hash value of the key last looked up by find_group() */
+  ulonglong curr_hash;
+
+  /*
+    Level of the partitions that new groups are spilled into when the hash
+    table is full: 0 while the rows of the join are read, n + 1 while a
+    partition of level n is read back
+  */
+  uint level;
+  IO_CACHE *files[HASH_AGG_MAX_LEVELS];
+  ha_rows *file_rows[HASH_AGG_MAX_LEVELS];
+
+  ulonglong hash_key();
+  bool key_equal(const uchar *key);
+  bool grow();
+  bool spill_group();
+  void reset();
+  bool write_groups();
+  bool process_partitions(uint file_level);
+  void merge_sum_fields(uchar *to, uchar *from);
+
+public:
+  Hash_aggregate()
+    :join(0), table(0), param(0), parts(0), parts_end(0), slots(0),
+     capacity(0), groups(0), first_entry(0), last_next(&first_entry),
+     used_memory(0), max_memory(0), full(FALSE), curr_hash(0), level(0)
+  {
+    bzero(&entry_root, sizeof(entry_root));
+    bzero(files, sizeof(files));
+    bzero(file_rows, sizeof(file_rows));
+  }
+  ~Hash_aggregate() { cleanup(); }
+
+  static bool is_applicable(JOIN *join);
+  bool init(JOIN *join_arg);
+  void cleanup();
+
+  /*
+    Find the group of the key in group_buff. Returns the record of the
+    group or 0 if there is no such group in memory.
+  */
+  uchar *find_group();
+  /* Add the record in record[0] as a new group with the key in group_buff */
+  bool add_group();
+  bool end();
+};
+
+#endif /* SQL_HASH_AGGREGATE_INCLUDED */
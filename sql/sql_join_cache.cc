@@ -34,6 +34,16 @@
 
 #define NO_MORE_RECORDS_IN_BUFFER  (uint)(-1)
 
+/* Parameters of partitioning used by BNLHG join caches */
+#define JOIN_CACHE_MAX_PARTITIONS        64
+#define JOIN_CACHE_PARTITION_FILL_FACTOR 0.75
+#define JOIN_CACHE_PARTITION_BUFF_SIZE   (IO_SIZE*4)
+
+/* Parameters of the Bloom filters built by BNLH/BNLHG join caches */
+#define JOIN_CACHE_BLOOM_BITS_PER_KEY     8
+#define JOIN_CACHE_BLOOM_MIN_BITS_PER_KEY 4
+#define JOIN_CACHE_BLOOM_PROBES           3
+
 static void save_or_restore_used_tabs(JOIN_TAB *join_tab, bool save);
 
 /*****************************************************************************
@@ -2585,6 +2595,9 @@ void JOIN_CACHE::save_explain_data(struct st_explain_bka_type *explain)
   case BKAH_JOIN_ALG:
     explain->join_alg= "BKAH";
     break;
+  case BNLHG_JOIN_ALG:
+    explain->join_alg= "BNLHG";
+    break;
   default:
     DBUG_ASSERT(0);
   }
@@ -2677,6 +2690,7 @@ int JOIN_CACHE_HASHED::init()
   ref_used_key_parts= join_tab->ref.key_parts;
 
   hash_func= &JOIN_CACHE_HASHED::get_hash_idx_simple;
+  hash_value_func= &JOIN_CACHE_HASHED::get_hash_value_simple;
   hash_cmp_func= &JOIN_CACHE_HASHED::equal_keys_simple;
 
   KEY_PART_INFO *key_part= ref_key_info->key_part;
@@ -2686,6 +2700,7 @@ int JOIN_CACHE_HASHED::init()
     if (!key_part->field->eq_cmp_as_binary())
     {
       hash_func= &JOIN_CACHE_HASHED::get_hash_idx_complex;
+      hash_value_func= &JOIN_CACHE_HASHED::get_hash_value_complex;
       hash_cmp_func= &JOIN_CACHE_HASHED::equal_keys_complex;
       break;
     }
@@ -2693,6 +2708,9 @@ int JOIN_CACHE_HASHED::init()
       
   init_hash_table();
 
+  if (init_bloom_filter())
+    DBUG_RETURN(1);
+
   rec_fields_offset= get_size_of_rec_offset()+get_size_of_rec_length()+
                      (prev_cache ? prev_cache->get_size_of_rec_offset() : 0);
 
@@ -2768,6 +2786,53 @@ int JOIN_CACHE_HASHED::init_hash_table()
 }
 
 
+/* 
+  Initialize the Bloom filter of a hashed join cache 
+
+  SYNOPSIS
+    init_bloom_filter()
+
+  DESCRIPTION
+    The function allocates the Bloom filter for the keys of the records
+    from the join buffer if optimizer_switch='join_cache_bloom_filter=on'
+    and the cache is used for a BNLH or a BNLHG join, i.e. when join_tab
+    is scanned and every record of it is looked up in the hash table.
+    The filter allows to discard the records of join_tab that have no
+    matches in the join buffer right after they have been read, before
+    the condition pushed to join_tab is evaluated for them.
+    The number of bits in the filter is chosen to be the smallest power
+    of 2 that gives JOIN_CACHE_BLOOM_BITS_PER_KEY bits for each hash entry
+    of the hash table, but the filter is never larger than 1/8 of the join
+    buffer.
+
+  RETURN VALUE
+    FALSE   the filter has been allocated or it is not needed
+    TRUE    otherwise
+*/
+
+bool JOIN_CACHE_HASHED::init_bloom_filter()
+{
+  bloom_filter= 0;
+  bloom_filter_mask= 0;
+  bloom_filter_keys= 0;
+  keep_bloom_filter= FALSE;
+
+  if (!optimizer_flag(join->thd, OPTIMIZER_SWITCH_JOIN_CACHE_BLOOM_FILTER) ||
+      (get_join_alg() != BNLH_JOIN_ALG && get_join_alg() != BNLHG_JOIN_ALG))
+    return FALSE;
+
+  ulong bits= 64;
+  while (bits < (ulong) hash_entries * JOIN_CACHE_BLOOM_BITS_PER_KEY &&
+         bits < buff_size)
+    bits<<= 1;
+  if (!(bloom_filter= (uchar*) sql_alloc(bits / 8)))
+    return TRUE;
+  bloom_filter_mask= bits - 1;
+  cleanup_bloom_filter();
+  return FALSE;
+}
+
+
 /*
   Reallocate the join buffer of a hashed join cache
  
@@ -2853,6 +2918,8 @@ void JOIN_CACHE_HASHED::reset(bool for_writing)
   this->JOIN_CACHE::reset(for_writing);
   if (for_writing && hash_table)
     cleanup_hash_table();
+  if (for_writing && bloom_filter && !keep_bloom_filter)
+    cleanup_bloom_filter();
   curr_key_entry= hash_table;
 }
 
@@ -2878,6 +2945,8 @@ void JOIN_CACHE_HASHED::reset(bool for_writing)
     the record from the partial join.
     If the match flag field of a record contains MATCH_IMPOSSIBLE the key is
     not created for this record. 
+    A key that is added into the hash table is added into the Bloom filter
+    as well if the cache uses one.
     
   RETURN VALUE
     TRUE    if it has been decided that it should be the last record
@@ -2960,6 +3029,8 @@ bool JOIN_CACHE_HASHED::put_record()
     DBUG_ASSERT(last_key_entry >= end_pos);
     /* Increment the counter of key_entries in the hash table */ 
     key_entries++;
+    if (bloom_filter)
+      add_key_to_bloom_filter(key);
   }  
   return is_full;
 }
@@ -3114,6 +3185,26 @@ bool JOIN_CACHE_HASHED::key_search(uchar *key, uint key_len,
 
 inline
 uint JOIN_CACHE_HASHED::get_hash_idx_simple(uchar* key, uint key_len)
+{
+  return (uint) (get_hash_value_simple(key, key_len) % hash_entries);
+}
+
+
+/*
+  Calculate the hash value of a key considered as byte array
+
+  SYNOPSIS
+    get_hash_value_simple()
+      key             pointer to the key value
+      key_len         key value length
+
+  RETURN VALUE
+    the hash value for the given key, get_hash_idx_simple() takes
+    the remainder of it
+*/
+
+inline
+ulong JOIN_CACHE_HASHED::get_hash_value_simple(uchar* key, uint key_len)
 {
   ulong nr= 1;
   ulong nr2= 4;
@@ -3124,7 +3215,7 @@ uint JOIN_CACHE_HASHED::get_hash_idx_simple(uchar* key, uint key_len)
     nr^= (ulong) ((((uint) nr & 63)+nr2)*((uint) *pos))+ (nr << 8);
     nr2+= 3;
   }
-  return nr % hash_entries;
+  return nr;
 }
 
 
@@ -3154,8 +3245,27 @@ uint JOIN_CACHE_HASHED::get_hash_idx_simple(uchar* key, uint key_len)
 inline
 uint JOIN_CACHE_HASHED::get_hash_idx_complex(uchar *key, uint key_len)
 {
-  return 
-    (uint) (key_hashnr(ref_key_info, ref_used_key_parts, key) % hash_entries);
+  return (uint) (get_hash_value_complex(key, key_len) % hash_entries);
+}
+
+
+/*
+  Calculate the hash value of a key taking into account the used collations
+
+  SYNOPSIS
+    get_hash_value_complex()
+      key             pointer to the key value
+      key_len         key value length
+
+  RETURN VALUE
+    the hash value for the given key, get_hash_idx_complex() takes
+    the remainder of it
+*/
+
+inline
+ulong JOIN_CACHE_HASHED::get_hash_value_complex(uchar *key, uint key_len)
+{
+  return key_hashnr(ref_key_info, ref_used_key_parts, key);
 }
 
 
@@ -3239,6 +3349,127 @@ void JOIN_CACHE_HASHED:: cleanup_hash_table()
 }
 
 
+/*
+  Calculate the hash value of a key used for the Bloom filter
+
+  SYNOPSIS
+    get_bloom_hash()
+      key             pointer to the key value
+
+  DESCRIPTION
+    The function mixes up the bits of the hash value calculated for the key
+    by the hash function used for the keys of the hash table, so that any
+    two keys that are equal for the hash table get the same value. The
+    positions of the bits of the key in the filter are derived from the
+    lower and the upper halves of the result.
+
+  RETURN VALUE
+    the hash value for the given key
+*/
+
+inline
+ulonglong JOIN_CACHE_HASHED::get_bloom_hash(uchar *key)
+{
+  ulonglong h= (ulonglong) (this->*hash_value_func)(key, key_length);
+  h^= h >> 33;
+  h*= 0xff51afd7ed558ccdULL;
+  h^= h >> 33;
+  h*= 0xc4ceb9fe1a85ec53ULL;
+  h^= h >> 33;
+  return h;
+}
+
+
+/*
+  Add a key into the Bloom filter of a hashed join cache
+
+  SYNOPSIS
+    add_key_to_bloom_filter()
+      key             pointer to the key value
+
+  DESCRIPTION
+    The function sets JOIN_CACHE_BLOOM_PROBES bits of the Bloom filter
+    for the given key.
+
+  RETURN VALUE
+    none
+*/
+
+void JOIN_CACHE_HASHED::add_key_to_bloom_filter(uchar *key)
+{
+  ulonglong h= get_bloom_hash(key);
+  uint32 h1= (uint32) h;
+  uint32 h2= (uint32) (h >> 32) | 1;
+  for (uint i= 0; i < JOIN_CACHE_BLOOM_PROBES; i++, h1+= h2)
+  {
+    ulong bit= h1 & bloom_filter_mask;
+    bloom_filter[bit >> 3]|= (uchar) (1 << (bit & 7));
+  }
+  bloom_filter_keys++;
+}
+
+
+/*
+  Check whether the record of join_tab certainly has no matches in the buffer
+
+  SYNOPSIS
+    has_no_matches_in_buffer()
+
+  DESCRIPTION
+    This implementation of the virtual function builds the join key
+    out of the record of join_tab read into its record buffer and checks
+    it against the Bloom filter built for the keys of the records from
+    the join buffer. If not all bits of the key are set in the filter
+    the key cannot be found in the hash table.
+    When too many keys have been added to the filter for its size most
+    keys pass the filter, so it is not checked at all.
+
+  RETURN VALUE
+    TRUE    the key of the record is not in the join buffer
+    FALSE   the record may have matches in the join buffer
+*/
+
+bool JOIN_CACHE_HASHED::has_no_matches_in_buffer()
+{
+  if (!bloom_filter ||
+      bloom_filter_keys * JOIN_CACHE_BLOOM_MIN_BITS_PER_KEY >
+      bloom_filter_mask)
+    return FALSE;
+
+  TABLE_REF *ref= &join_tab->ref;
+  KEY *keyinfo= join_tab->get_keyinfo_by_key_no(ref->key);
+  key_copy(key_buff, join_tab->table->record[0], keyinfo, key_length, TRUE);
+
+  ulonglong h= get_bloom_hash(key_buff);
+  uint32 h1= (uint32) h;
+  uint32 h2= (uint32) (h >> 32) | 1;
+  for (uint i= 0; i < JOIN_CACHE_BLOOM_PROBES; i++, h1+= h2)
+  {
+    ulong bit= h1 & bloom_filter_mask;
+    if (!(bloom_filter[bit >> 3] & (1 << (bit & 7))))
+      return TRUE;
+  }
+  return FALSE;
+}
+
+
+/* 
+  Clean up the Bloom filter of a hashed join cache
+
+  SYNOPSIS
+    cleanup_bloom_filter()
+
+  RETURN VALUE
+    none  
+*/
+
+void JOIN_CACHE_HASHED::cleanup_bloom_filter()
+{
+  bzero(bloom_filter, (bloom_filter_mask + 1) / 8);
+  bloom_filter_keys= 0;
+}
+
+
 /*
   Check whether all records in a key chain have their match flags set on   
 
@@ -3326,6 +3557,8 @@ int JOIN_TAB_SCAN::open()
 {
   save_or_restore_used_tabs(join_tab, FALSE);
   is_first_record= TRUE;
+  if (join_tab->tracker)
+    join_tab->tracker->on_scan_init();
   return join_init_read_record(join_tab);
 }
 
@@ -3341,7 +3574,9 @@ int JOIN_TAB_SCAN::open()
     match some records in the buffer of the join cache 'cache'. To do
     this the function calls the function that scans table records and
     looks for the next one that meets the condition pushed to the
-    joined table join_tab.
+    joined table join_tab. The records that the cache knows to have
+    no matches in the join buffer are skipped before the condition is
+    checked for them.
 
   NOTES
     The function catches the signal that kills the query.
@@ -3354,7 +3589,7 @@ int JOIN_TAB_SCAN::open()
 int JOIN_TAB_SCAN::next()
 {
   int err= 0;
-  int skip_rc;
+  int skip_rc= 0;
   READ_RECORD *info= &join_tab->read_record;
   SQL_SELECT *select= join_tab->cache_select;
   TABLE *table= join_tab->table;
@@ -3364,20 +3599,29 @@ int JOIN_TAB_SCAN::next()
     is_first_record= FALSE;
   else
     err= info->read_record(info);
+  if (!err && join_tab->tracker)
+    join_tab->tracker->on_record_read();
   if (!err && table->vfield)
     update_virtual_fields(thd, table);
-  while (!err && select && (skip_rc= select->skip_record(thd)) <= 0)
+  while (!err &&
+         (cache->has_no_matches_in_buffer() ||
+          (select && (skip_rc= select->skip_record(thd)) <= 0)))
   {
     if (thd->check_killed() || skip_rc < 0) 
       return 1;
     /* 
-      Move to the next record if the last retrieved record does not
-      meet the condition pushed to the table join_tab.
+      Move to the next record if the last retrieved record cannot have
+      matches in the join buffer or does not meet the condition pushed
+      to the table join_tab.
     */
     err= info->read_record(info);
+    if (!err && join_tab->tracker)
+      join_tab->tracker->on_record_read();
     if (!err && table->vfield)
       update_virtual_fields(thd, table);
   } 
+  if (!err && join_tab->tracker)
+    join_tab->tracker->on_record_after_where();
   return err; 
 }
 
@@ -3783,6 +4027,580 @@ int JOIN_CACHE_BNLH::init()
 }
 
 
+/*
+  Initiate an iteration process over records of a partition file
+
+  SYNOPSIS
+    open()
+
+  DESCRIPTION
+    The function initiates the process of iteration over the records of
+    join_tab saved in the partition file set by the last call of set_file.
+    The file is positioned at its very beginning.
+
+  RETURN VALUE   
+    0            the initiation is a success 
+    error code   otherwise     
+*/
+
+int JOIN_TAB_SCAN_PARTITION::open()
+{
+  DBUG_ASSERT(file);
+  save_or_restore_used_tabs(join_tab, FALSE);
+  return reinit_io_cache(file, READ_CACHE, 0L, 0, 0);
+}
+
+
+/* 
+  Read the next record of join_tab from a partition file
+
+  SYNOPSIS
+    next()
+
+  DESCRIPTION
+    The function reads the next record image saved in the partition file
+    into the record buffer of join_tab. The condition pushed to join_tab
+    is not checked as only the records that meet it are saved in the file.
+
+  RETURN VALUE   
+    0            the next record exists and has been successfully read 
+    -1           there are no more records in the partition file
+    1            an error has occurred when reading from the file
+*/
+
+int JOIN_TAB_SCAN_PARTITION::next()
+{
+  TABLE *table= join_tab->table;
+  if (my_b_read(file, table->record[0], table->s->reclength))
+    return file->error == -1 ? 1 : -1;
+  table->status= 0;
+  return 0;
+}
+
+
+/*
+  Initialize the BNLHG join cache 
+
+  SYNOPSIS
+    init
+
+  DESCRIPTION
+    The function initializes the cache structure. It is supposed to be called
+    right after a constructor for the JOIN_CACHE_BNLHG.
+
+  NOTES
+    The function first constructs a companion object of the type
+    JOIN_TAB_SCAN_PARTITION used to iterate over the partition files of
+    join_tab records, then it calls the init method of the parent class.
+    
+  RETURN VALUE  
+    0   initialization with buffer allocations has been succeeded
+    1   otherwise
+*/
+
+int JOIN_CACHE_BNLHG::init()
+{
+  DBUG_ENTER("JOIN_CACHE_BNLHG::init");
+
+  DBUG_ASSERT(!prev_cache);
+  if (!(partition_scan= new JOIN_TAB_SCAN_PARTITION(join, join_tab)))
+    DBUG_RETURN(1);
+
+  DBUG_RETURN(JOIN_CACHE_BNLH::init());
+}
+
+
+/*
+  Get the number of the partition for a key value
+
+  SYNOPSIS
+    get_partition_no()
+      key   pointer to the key value
+
+  DESCRIPTION
+    The function calculates the number of the partition where the records
+    with the join key 'key' are to be placed. Any two keys that are equal
+    for the hash table of the join buffer get the same partition number.
+    The lower bits of the hash value are used to find a hash entry in
+    the join buffer, so the value is mixed up before taking the remainder.
+    Otherwise all records of a partition would go to the same small subset
+    of the hash entries.
+
+  RETURN VALUE
+    the number of the partition for the key
+*/
+
+uint JOIN_CACHE_BNLHG::get_partition_no(uchar *key)
+{
+  uint32 nr= (uint32) key_hashnr(ref_key_info, ref_used_key_parts, key);
+  nr*= 2654435761U;
+  return (nr >> 16) % partitions;
+}
+
+
+/*
+  Get the join key for the current partial join record
+
+  SYNOPSIS
+    get_curr_outer_key()
+
+  DESCRIPTION
+    The function builds the join key for the partial join record whose
+    fields are in the record buffers and that has been written at the
+    position curr_rec_pos of the join buffer.
+
+  RETURN VALUE
+    pointer to the join key for the current partial join record
+*/
+
+uchar *JOIN_CACHE_BNLHG::get_curr_outer_key()
+{
+  uchar *key;
+  if (use_emb_key)
+    key= get_curr_emb_key();
+  else
+  {
+    TABLE_REF *ref= &join_tab->ref;
+    cp_buffer_from_ref(join->thd, join_tab->table, ref);
+    key= ref->key_buff;
+  }
+  return key;
+}
+
+
+/*
+  Write a partial join record into its partition file
+
+  SYNOPSIS
+    write_outer_record()
+      key   the join key for the record
+      rec   pointer to the record in the join buffer
+      len   length of the record
+
+  DESCRIPTION
+    The function writes the partial join record that has been put at the
+    position 'rec' of the join buffer into the partition file determined
+    by its join key 'key'. The record is written starting from its length
+    prefix, without the reference to the next record in the key chain.
+    The fields of the record are supposed to be in the record buffers.
+
+  RETURN VALUE
+    FALSE   the record has been written successfully
+    TRUE    otherwise
+*/
+
+bool JOIN_CACHE_BNLHG::write_outer_record(uchar *key, uchar *rec, uint len)
+{
+  uint no= get_partition_no(key);
+  if (my_b_write(&outer_files[no], rec, len))
+  {
+    write_error= TRUE;
+    return TRUE;
+  }
+  outer_records[no]++;
+  return FALSE;
+}
+
+
+/*
+  Switch the cache to the partitioning mode
+
+  SYNOPSIS
+    start_partitioning()
+
+  DESCRIPTION
+    The function is called when the join buffer has become full for the
+    first time. It chooses the number of partitions, opens the partition
+    files and moves all records from the join buffer into the files.
+    The number of partitions is chosen so that any partition of the
+    expected number of partial join records fits into the join buffer
+    with some reserve. The files are opened as cached files, so they are
+    not created on disk until their buffers overflow.
+    If the partitioning cannot be used the function does nothing and
+    the cache continues to work as a BNLH cache.
+
+  RETURN VALUE
+    FALSE   the cache has been switched to the partitioning mode
+    TRUE    otherwise
+*/
+
+bool JOIN_CACHE_BNLHG::start_partitioning()
+{
+  uint i;
+  size_t cnt;
+  DBUG_ENTER("JOIN_CACHE_BNLHG::start_partitioning");
+
+  /*
+    Records with blob values or with rowids of join_tab cannot be moved
+    out of the join buffer.
+  */ 
+  if (blobs || join_tab->keep_current_rowid)
+    DBUG_RETURN(TRUE);
+  DBUG_ASSERT(with_length && !with_match_flag);
+
+  double rows= (join_tab-1)->get_partial_join_cardinality();
+  set_if_bigger(rows, 2.0 * records);
+  double n= rows / (records * JOIN_CACHE_PARTITION_FILL_FACTOR) + 1;
+  partitions= n < JOIN_CACHE_MAX_PARTITIONS ?
+                (uint) n : JOIN_CACHE_MAX_PARTITIONS;
+  set_if_bigger(partitions, 2);
+
+  if (!my_multi_malloc(MYF(MY_THREAD_SPECIFIC | MY_ZEROFILL | MY_WME),
+                       &outer_files, partitions*sizeof(IO_CACHE),
+                       &inner_files, partitions*sizeof(IO_CACHE),
+                       &outer_records, partitions*sizeof(ha_rows),
+                       &rec_buff, pack_length,
+                       NullS))
+  {
+    partitions= 0;
+    DBUG_RETURN(TRUE);
+  }
+  for (i= 0; i < partitions; i++)
+  {
+    if (open_cached_file(&outer_files[i], mysql_tmpdir, TEMP_PREFIX,
+                         JOIN_CACHE_PARTITION_BUFF_SIZE, MYF(MY_WME)) ||
+        open_cached_file(&inner_files[i], mysql_tmpdir, TEMP_PREFIX,
+                         JOIN_CACHE_PARTITION_BUFF_SIZE, MYF(MY_WME)))
+    {
+      free_partitions();
+      DBUG_RETURN(TRUE);
+    }
+  }
+
+  DBUG_PRINT("info", ("records in buffer: %lu  partitions: %u",
+                      (ulong) records, partitions));
+
+  /* Move all records from the join buffer into the partition files */
+  reset(FALSE);
+  for (cnt= records; cnt; cnt--)
+  {
+    uchar *rec= pos + get_size_of_rec_offset();
+    get_record();
+    if (write_outer_record(get_curr_outer_key(), rec, (uint) (pos-rec)))
+      break;
+  }
+  /*
+    The Bloom filter already contains the keys of the moved records.
+    The keys of the records written into the partition files later are
+    added to it, so that join_tab records without matches are not
+    written into the partition files.
+  */
+  keep_bloom_filter= has_bloom_filter();
+  reset(TRUE);
+  partitioned= TRUE;
+  DBUG_RETURN(write_error);
+}
+
+
+/*
+  Write the current partial join record into its partition file
+
+  SYNOPSIS
+    partition_curr_outer_record()
+
+  DESCRIPTION
+    The function is called in the partitioning mode for each new partial
+    join record. The record is packed at the beginning of the join buffer
+    in the same format as it would be put there by put_record and then
+    it is written into its partition file. The key entry for the record
+    is not added to the hash table, yet the key is added to the Bloom
+    filter if the filter is kept for the records of the partition files.
+
+  RETURN VALUE
+    FALSE   the record has been written successfully
+    TRUE    otherwise
+*/
+
+bool JOIN_CACHE_BNLHG::partition_curr_outer_record()
+{
+  bool is_full;
+  /* Do not clean up the hash table as it is not used in this mode */
+  JOIN_CACHE::reset(TRUE);
+  pos+= get_size_of_rec_offset();
+  uchar *rec= pos;
+  write_record_data(0, &is_full);
+  uchar *key= get_curr_outer_key();
+  if (keep_bloom_filter)
+    add_key_to_bloom_filter(key);
+  return write_outer_record(key, rec, (uint) (end_pos-rec));
+}
+
+
+/* 
+  Add a record into the buffer of a BNLHG cache or into a partition file
+
+  SYNOPSIS
+    put_record()
+
+  DESCRIPTION
+    Until the join buffer becomes full this implementation of the virtual
+    function put_record adds the record into the join buffer as the
+    implementation for JOIN_CACHE_HASHED does. When the buffer becomes full
+    the function tries to switch to the partitioning mode. In this mode
+    the record is written into the partition file for its join key.
+    
+  RETURN VALUE
+    TRUE    if it has been decided that it should be the last record
+            in the join buffer, or if writing into a partition file
+            has failed
+    FALSE   otherwise
+*/
+
+bool JOIN_CACHE_BNLHG::put_record()
+{
+  if (partitioned)
+    return partition_curr_outer_record();
+  if (!JOIN_CACHE_HASHED::put_record())
+    return FALSE;
+  /* The buffer is full: try to distribute the records among partitions */
+  return start_partitioning();
+}
+
+
+/*
+  Distribute the records of join_tab among the partition files
+
+  SYNOPSIS
+    partition_inner_records()
+
+  DESCRIPTION
+    The function scans join_tab once and writes the images of the record
+    buffer of join_tab for the records that meet the condition pushed to
+    the table into the partition files determined by the join keys built
+    for the records. The records whose partitions do not contain any
+    partial join records are skipped. If the cache uses a Bloom filter
+    the records whose keys are not in it are skipped by join_tab_scan.
+
+  RETURN VALUE
+    return one of enum_nested_loop_state
+*/
+
+enum_nested_loop_state JOIN_CACHE_BNLHG::partition_inner_records()
+{
+  int error;
+  enum_nested_loop_state rc= NESTED_LOOP_OK;
+  TABLE *table= join_tab->table;
+  TABLE_REF *ref= &join_tab->ref;
+  KEY *keyinfo= join_tab->get_keyinfo_by_key_no(ref->key);
+  DBUG_ENTER("JOIN_CACHE_BNLHG::partition_inner_records");
+
+  table->null_row= 0;
+  if ((rc= join_tab_execution_startup(join_tab)) < 0)
+    DBUG_RETURN(rc);
+
+  if ((error= join_tab_scan->open()))
+    goto finish;
+
+  while (!(error= join_tab_scan->next()))   
+  {
+    if (join->thd->check_killed())
+    {
+      /* The user has aborted the execution of the query */
+      join->thd->send_kill_message();
+      rc= NESTED_LOOP_KILLED;
+      goto finish; 
+    }
+    key_copy(key_buff, table->record[0], keyinfo, key_length, TRUE);
+    uint no= get_partition_no(key_buff);
+    if (!outer_records[no])
+      continue;
+    if (my_b_write(&inner_files[no], table->record[0], table->s->reclength))
+    {
+      rc= NESTED_LOOP_ERROR;
+      goto finish;
+    }
+  }
+
+finish:
+  if (error)
+    rc= error < 0 ? NESTED_LOOP_NO_MORE_ROWS: NESTED_LOOP_ERROR;
+  join_tab_scan->close();
+  DBUG_RETURN(rc);
+}
+
+
+/*
+  Join the records from the join buffer with the records of a partition
+
+  SYNOPSIS
+    join_partition_records()
+      no   the number of the partition
+
+  DESCRIPTION
+    The function finds all matches for the partial join records loaded
+    into the join buffer from the partition 'no' among the records of
+    join_tab from the same partition. The records of join_tab are read
+    from the partition file. If there is a cache linked to this one all
+    extensions of the records in the next cache are generated as well,
+    since the buffer will be refilled after this.
+
+  RETURN VALUE
+    return one of enum_nested_loop_state
+*/
+
+enum_nested_loop_state JOIN_CACHE_BNLHG::join_partition_records(uint no)
+{
+  enum_nested_loop_state rc;
+  JOIN_TAB_SCAN *table_scan= join_tab_scan;
+
+  partition_scan->set_file(&inner_files[no]);
+  join_tab_scan= partition_scan;
+  rc= JOIN_CACHE::join_matching_records(FALSE);
+  join_tab_scan= table_scan;
+  if ((rc == NESTED_LOOP_OK || rc == NESTED_LOOP_NO_MORE_ROWS) && next_cache)
+    rc= next_cache->join_records(FALSE);
+  return rc;
+}
+
+
+/*
+  Join a partition of partial join records with the partition of join_tab
+
+  SYNOPSIS
+    join_partition()
+      no   the number of the partition
+
+  DESCRIPTION
+    The function reads partial join records of the partition 'no' from
+    the partition file, unpacks them into the record buffers and puts them
+    into the join buffer building the hash table over their join keys.
+    Then all matches for them are found among the records of join_tab
+    from the same partition. If the partition does not fit into the join
+    buffer the matches are looked for each time the buffer is full.
+
+  RETURN VALUE
+    return one of enum_nested_loop_state
+*/
+
+enum_nested_loop_state JOIN_CACHE_BNLHG::join_partition(uint no)
+{
+  ha_rows cnt;
+  IO_CACHE *file= &outer_files[no];
+  uint rec_len_size= get_size_of_rec_length();
+  enum_nested_loop_state rc= NESTED_LOOP_OK;
+  DBUG_ENTER("JOIN_CACHE_BNLHG::join_partition");
+  DBUG_PRINT("info", ("partition: %u  records: %lu",
+                      no, (ulong) outer_records[no]));
+
+  if (!outer_records[no])
+    DBUG_RETURN(NESTED_LOOP_OK);
+  if (reinit_io_cache(file, READ_CACHE, 0L, 0, 0))
+    DBUG_RETURN(NESTED_LOOP_ERROR);
+
+  reset(TRUE);
+  for (cnt= outer_records[no]; cnt; cnt--)
+  {
+    if (my_b_read(file, rec_buff, rec_len_size) ||
+        my_b_read(file, rec_buff+rec_len_size, get_rec_length(rec_buff)))
+      DBUG_RETURN(NESTED_LOOP_ERROR);
+
+    /* Read the fields of the record into the record buffers */
+    uchar *save_pos= pos;
+    pos= rec_buff+rec_len_size;
+    read_flag_fields();
+    CACHE_FIELD *copy= field_descr+flag_fields;
+    CACHE_FIELD *copy_end= field_descr+fields;
+    for ( ; copy < copy_end; copy++)
+      read_record_field(copy, FALSE);
+    pos= save_pos;
+
+    if (JOIN_CACHE_HASHED::put_record())
+    {
+      /* The partition does not fit into the join buffer */
+      rc= join_partition_records(no);
+      if (rc != NESTED_LOOP_OK && rc != NESTED_LOOP_NO_MORE_ROWS)
+        DBUG_RETURN(rc);
+      reset(TRUE);
+    }
+  }
+  if (records)
+    rc= join_partition_records(no);
+  DBUG_RETURN(rc);
+}
+
+
+/*   
+  Find matches from the next table for records from the join buffer 
+
+  SYNOPSIS
+    join_matching_records()
+      skip_last    do not look for matches for the last partial join record 
+
+  DESCRIPTION
+    If the cache has not been switched to the partitioning mode the function
+    works as the implementation for JOIN_CACHE does. Otherwise it distributes
+    the records of join_tab among the partition files and then joins the
+    partitions with the same numbers one by one. After this the partition
+    files are closed and the cache can be used to accumulate new records.
+
+  RETURN VALUE
+    return one of enum_nested_loop_state
+*/ 
+
+enum_nested_loop_state JOIN_CACHE_BNLHG::join_matching_records(bool skip_last)
+{
+  enum_nested_loop_state rc;
+  DBUG_ENTER("JOIN_CACHE_BNLHG::join_matching_records");
+
+  if (!partitioned)
+    DBUG_RETURN(JOIN_CACHE_BNLH::join_matching_records(skip_last));
+
+  DBUG_ASSERT(!skip_last);
+  if (write_error)
+    rc= NESTED_LOOP_ERROR;
+  else
+    rc= partition_inner_records();
+  for (uint i= 0;
+       i < partitions && (rc == NESTED_LOOP_OK || rc == NESTED_LOOP_NO_MORE_ROWS);
+       i++)
+    rc= join_partition(i);
+  free_partitions();
+  DBUG_RETURN(rc);
+}
+
+
+/*
+  Close the partition files of a BNLHG cache
+
+  SYNOPSIS
+    free_partitions()
+
+  DESCRIPTION
+    The function closes all partition files and frees the memory allocated
+    for them. After this the cache works as a BNLH cache until its join
+    buffer becomes full again.
+
+  RETURN VALUE
+    none
+*/
+
+void JOIN_CACHE_BNLHG::free_partitions()
+{
+  if (outer_files)
+  {
+    for (uint i= 0; i < partitions; i++)
+    {
+      close_cached_file(&outer_files[i]);
+      close_cached_file(&inner_files[i]);
+    }
+    my_free(outer_files);
+  }
+  outer_files= inner_files= 0;
+  outer_records= 0;
+  rec_buff= 0;
+  partitions= 0;
+  partitioned= write_error= FALSE;
+  keep_bloom_filter= FALSE;
+}
+
+
+void JOIN_CACHE_BNLHG::free()
+{
+  free_partitions();
+  JOIN_CACHE::free();
+}
+
+
 /* 
   Calculate the increment of the MRR buffer for a record write       
 
@@ -3855,6 +4673,8 @@ int JOIN_TAB_SCAN_MRR::open()
   ranges= cache->get_number_of_ranges_for_mrr();
   if (!join_tab->cache_idx_cond)
     range_seq_funcs.skip_index_tuple= 0;
+  if (join_tab->tracker)
+    join_tab->tracker->on_scan_init();
   return file->multi_range_read_init(&range_seq_funcs, (void*) cache,
                                      ranges, mrr_mode, &mrr_buff);
 }
@@ -3896,6 +4716,11 @@ int JOIN_TAB_SCAN_MRR::next()
     */
     if (join_tab->table->vfield)
       update_virtual_fields(join->thd, join_tab->table);
+    if (join_tab->tracker)
+    {
+      join_tab->tracker->on_record_read();
+      join_tab->tracker->on_record_after_where();
+    }
   }
   return rc;
 }
@@ -22,6 +22,7 @@
 #define JOIN_CACHE_INCREMENTAL_BIT           1
 #define JOIN_CACHE_HASHED_BIT                2
 #define JOIN_CACHE_BKA_BIT                   4
+#define JOIN_CACHE_GRACE_BIT                 8
 
 /* 
   Categories of data fields of variable length written into join cache buffers.
@@ -72,7 +73,8 @@ struct st_explain_bka_type;
   - Batched Key Access (BKA) Join Algorithm.
 
   The first algorithm is supported by the derived class JOIN_CACHE_BNL,
-  the second algorithm is supported by the derived class JOIN_CACHE_BNLH,
+  the second algorithm is supported by the derived class JOIN_CACHE_BNLH
+  and by its variant with Grace partitioning JOIN_CACHE_BNLHG,
   while the third algorithm is implemented in two variant supported by
   the classes JOIN_CACHE_BKA and JOIN_CACHE_BKAH.
   These three algorithms have a lot in common. Each of them first accumulates
@@ -455,6 +457,12 @@ protected:
   */
   virtual bool skip_if_not_needed_match();
 
+  /*
+    Shall return TRUE if it is known that the record of join_tab read
+    into its record buffer cannot match any record from the join buffer
+  */
+  virtual bool has_no_matches_in_buffer() { return FALSE; }
+
   /* 
     True if rec_ptr points to the record whose blob data stay in
     record buffers
@@ -568,7 +576,8 @@ public:
     BNL_JOIN_ALG,     /* Block Nested Loop Join algorithm                  */
     BNLH_JOIN_ALG,    /* Block Nested Loop Hash Join algorithm             */
     BKA_JOIN_ALG,     /* Batched Key Access Join algorithm                 */
-    BKAH_JOIN_ALG    /* Batched Key Access with Hash Table Join Algorithm */
+    BKAH_JOIN_ALG,    /* Batched Key Access with Hash Table Join Algorithm */
+    BNLHG_JOIN_ALG    /* Block Nested Loop Hash Join with Grace partitioning */
   };
 
   /* 
@@ -665,7 +674,7 @@ public:
 
   virtual ~JOIN_CACHE() {}
   void reset_join(JOIN *j) { join= j; }
-  void free()
+  virtual void free()
   { 
     my_free(buff);
     buff= 0;
@@ -761,6 +770,8 @@ class JOIN_CACHE_HASHED: public JOIN_CACHE
 {
 
   typedef uint (JOIN_CACHE_HASHED::*Hash_func) (uchar *key, uint key_len);
+  typedef ulong (JOIN_CACHE_HASHED::*Hash_value_func) (uchar *key,
+                                                       uint key_len);
   typedef bool (JOIN_CACHE_HASHED::*Hash_cmp_func) (uchar *key1, uchar *key2,
                                                     uint key_len);
   
@@ -788,6 +799,9 @@ private:
   /* The offset of the data fields from the beginning of the record fields */
   uint data_fields_offset;
 
+  inline ulong get_hash_value_simple(uchar *key, uint key_len);
+  inline ulong get_hash_value_complex(uchar *key, uint key_len);
+
   inline uint get_hash_idx_simple(uchar *key, uint key_len);
   inline uint get_hash_idx_complex(uchar *key, uint key_len);
 
@@ -796,6 +810,22 @@ private:
 
   int init_hash_table();
   void cleanup_hash_table();
+
+  /*
+    The Bloom filter built over the keys of the records from the join
+    buffer when optimizer_switch='join_cache_bloom_filter=on', or 0.
+    The number of bits in the filter is a power of 2.
+  */
+  uchar *bloom_filter;
+  /* The number of bits in the Bloom filter minus 1 */
+  ulong bloom_filter_mask;
+  /* The number of keys added to the Bloom filter */
+  ulong bloom_filter_keys;
+
+  inline ulonglong get_bloom_hash(uchar *key);
+
+  bool init_bloom_filter();
+  void cleanup_bloom_filter();
   
 protected:
 
@@ -815,6 +845,8 @@ protected:
     usually set by the init() method
   */ 
   Hash_func hash_func;
+  /* The hash function used for the keys of the Bloom filter */
+  Hash_value_func hash_value_func;
   /*
     The function to check whether two key entries in the hash table
     are equal or not, usually set by the init() method
@@ -844,6 +876,13 @@ protected:
   */ 
   uint rec_fields_offset;
 
+  /*
+    TRUE <=> the Bloom filter is not cleaned up when the join buffer is
+    reset for writing, as it is built for the keys of the records that
+    are kept outside of the join buffer
+  */
+  bool keep_bloom_filter;
+
   uint get_size_of_key_offset() { return size_of_key_ofs; }
 
   /* 
@@ -969,6 +1008,14 @@ protected:
   /* Search for a key in the hash table of the join buffer */
   bool key_search(uchar *key, uint key_len, uchar **key_ref_ptr);
 
+  /* Add a key to the Bloom filter */
+  void add_key_to_bloom_filter(uchar *key);
+
+  bool has_bloom_filter() { return bloom_filter != 0; }
+
+  /* Check the key of the record of join_tab against the Bloom filter */
+  bool has_no_matches_in_buffer();
+
   /* Reallocate the join buffer of a hashed join cache */
   int realloc_buffer();
 
@@ -977,7 +1024,8 @@ protected:
     used to join table 'tab' to the result of joining the previous tables 
     specified by the 'j' parameter.
   */   
-  JOIN_CACHE_HASHED(JOIN *j, JOIN_TAB *tab) :JOIN_CACHE(j, tab) {}
+  JOIN_CACHE_HASHED(JOIN *j, JOIN_TAB *tab)
+    :JOIN_CACHE(j, tab), bloom_filter(0), keep_bloom_filter(FALSE) {}
 
   /* 
     This constructor creates a linked hashed join cache. The cache is to be
@@ -986,7 +1034,8 @@ protected:
     cache object to which this cache is linked.
   */   
   JOIN_CACHE_HASHED(JOIN *j, JOIN_TAB *tab, JOIN_CACHE *prev) 
-		    :JOIN_CACHE(j, tab, prev) {}
+		    :JOIN_CACHE(j, tab, prev), bloom_filter(0),
+                     keep_bloom_filter(FALSE) {}
 
 public:
 
@@ -1203,6 +1252,139 @@ public:
 };
 
 
+/*
+  The class JOIN_TAB_SCAN_PARTITION is a companion class for the class
+  JOIN_CACHE_BNLHG. It implements the iterator over the records of join_tab
+  that have been saved into one of the partition files of the cache.
+  The records are stored in the files as images of the record buffer of
+  join_tab and are read back into this buffer by the function next.
+  No condition is checked for the records: the condition pushed to join_tab
+  is applied when the records are written into the partition files.
+*/
+
+class JOIN_TAB_SCAN_PARTITION: public JOIN_TAB_SCAN
+{
+  /* The partition file to iterate over */
+  IO_CACHE *file;
+
+public:
+
+  JOIN_TAB_SCAN_PARTITION(JOIN *j, JOIN_TAB *tab)
+    :JOIN_TAB_SCAN(j, tab), file(0) {}
+
+  /* Set the partition file for the next iteration */
+  void set_file(IO_CACHE *f) { file= f; }
+
+  int open();
+
+  int next();
+};
+
+
+/*
+  The class JOIN_CACHE_BNLHG is used when the BNLH join algorithm with
+  Grace partitioning is employed to perform a join operation.
+
+  As long as all partial join records fit into the join buffer the class
+  works exactly as JOIN_CACHE_BNLH does. When the buffer becomes full for
+  the first time, instead of scanning join_tab for the records accumulated
+  so far, the cache switches to the partitioning mode:
+  - the records from the join buffer and all records that come after them
+    are distributed among several partition files by the hash value of
+    their join keys,
+  - when all partial join records have been received join_tab is scanned
+    only once and its records are distributed among the partition files
+    for join_tab in the same way,
+  - the pairs of partition files with the same number are joined one by
+    one: the records of the partition of partial join records are loaded
+    into the join buffer with the hash table built for them and the
+    records from the corresponding partition of join_tab are probed
+    against this hash table.
+  If a partition of partial join records does not fit into the join buffer
+  the partition of join_tab records is read once per buffer refill, so
+  any record of join_tab is still read a bounded number of times.
+
+  Partitioning is possible only when the records can be saved outside of
+  the join buffer, that is when no blob values are stored in the buffer,
+  join_tab has no blob columns and rowids of join_tab are not needed.
+  The cache is not used for inner tables of outer joins and semi-joins.
+*/
+
+class JOIN_CACHE_BNLHG :public JOIN_CACHE_BNLH
+{
+private:
+
+  /* The number of partitions the records are distributed among */
+  uint partitions;
+
+  /* Partition files for partial join records */
+  IO_CACHE *outer_files;
+  /* Partition files for records of join_tab */
+  IO_CACHE *inner_files;
+
+  /* The number of partial join records in each partition */
+  ha_rows *outer_records;
+
+  /* Buffer to read a partial join record from a partition file into */
+  uchar *rec_buff;
+
+  /* The iterator over a partition file of join_tab records */
+  JOIN_TAB_SCAN_PARTITION *partition_scan;
+
+  /* TRUE <=> the records are distributed among partition files */
+  bool partitioned;
+
+  /* TRUE <=> writing into a partition file has failed */
+  bool write_error;
+
+  /* Get the number of the partition for a key value */
+  uint get_partition_no(uchar *key);
+
+  /* Get the join key for the current partial join record */
+  uchar *get_curr_outer_key();
+
+  bool start_partitioning();
+
+  bool write_outer_record(uchar *key, uchar *rec, uint len);
+
+  bool partition_curr_outer_record();
+
+  enum_nested_loop_state partition_inner_records();
+
+  enum_nested_loop_state join_partition(uint no);
+
+  enum_nested_loop_state join_partition_records(uint no);
+
+  void free_partitions();
+
+protected:
+
+  enum_nested_loop_state join_matching_records(bool skip_last);
+
+public:
+
+  /* 
+    This constructor creates a BNLHG join cache. The cache is to be used
+    to join table 'tab' to the result of joining the previous tables 
+    specified by the 'j' parameter. A BNLHG cache is never linked.
+  */   
+  JOIN_CACHE_BNLHG(JOIN *j, JOIN_TAB *tab)
+    :JOIN_CACHE_BNLH(j, tab), partitions(0), outer_files(0), inner_files(0),
+     outer_records(0), rec_buff(0), partition_scan(0),
+     partitioned(FALSE), write_error(FALSE) {}
+
+  /* Initialize the BNLHG cache */       
+  int init();
+
+  enum Join_algorithm get_join_alg() { return BNLHG_JOIN_ALG; }
+
+  /* Add a record into the buffer or into a partition file */
+  bool put_record();
+
+  void free();
+};
+
+
 /*
   The class JOIN_TAB_SCAN_MRR is a companion class for the classes
   JOIN_CACHE_BKA and JOIN_CACHE_BKAH. Actually the class implements the
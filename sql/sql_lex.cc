@@ -465,6 +465,7 @@ void lex_start(THD *thd)
   lex->with_persistent_for_clause= FALSE;
   lex->column_list= NULL;
   lex->index_list= NULL;
+  lex->column_group_list= NULL;
   lex->prepared_stmt_params.empty();
   lex->auxiliary_table_list.empty();
   lex->unit.next= lex->unit.master=
@@ -483,6 +484,8 @@ void lex_start(THD *thd)
   if (lex->select_lex.group_list_ptrs)
     lex->select_lex.group_list_ptrs->clear();
   lex->describe= 0;
+  lex->analyze_stmt= 0;
+  lex->explain_json= 0;
   lex->subqueries= FALSE;
   lex->context_analysis_only= 0;
   lex->derived_tables= 0;
@@ -1809,6 +1812,7 @@ void st_select_lex_unit::init_query()
   cleaned= 0;
   item_list.empty();
   describe= 0;
+  union_direct= 0;
   found_rows_for_union= 0;
   insert_table_with_stored_vcol= 0;
   derived= 0;
@@ -1854,6 +1858,7 @@ void st_select_lex::init_query()
   first_execution= 1;
   first_natural_join_processing= 1;
   first_cond_optimization= 1;
+  saved_join_order= 0;
   parsing_place= NO_MATTER;
   exclude_from_table_unique_test= no_wrap_view_item= FALSE;
   nest_level= 0;
@@ -4224,6 +4229,7 @@ int st_select_lex_unit::save_union_explain(Explain_query *output)
 
   eu->fake_select_type= "UNION RESULT";
   eu->using_filesort= MY_TEST(global_parameters->order_list.first);
+  eu->using_tmp_table= !union_direct;
 
   // Save the UNION node
   output->add_node(eu);
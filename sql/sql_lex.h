@@ -132,6 +132,11 @@ struct sys_var_with_base
   additional "partitions" column even if partitioning is not compiled in.
 */
 #define DESCRIBE_PARTITIONS	4
+/*
+  Not set in LEX::describe: passed to the functions printing EXPLAIN output
+  for an ANALYZE statement to add the counters collected at execution
+*/
+#define DESCRIBE_ANALYZE	8
 
 #ifdef MYSQL_SERVER
 
@@ -532,6 +537,7 @@ typedef class st_select_lex_node SELECT_LEX_NODE;
 class THD;
 class select_result;
 class JOIN;
+struct Saved_join_order;
 class select_union;
 class Procedure;
 class Explain_query;
@@ -601,6 +607,8 @@ public:
 
   st_select_lex *union_distinct; /* pointer to the last UNION DISTINCT */
   bool describe; /* union exec() called for EXPLAIN */
+  /* TRUE <=> the rows of the UNION ALL are sent without the table */
+  bool union_direct;
   Procedure *last_procedure;	 /* Pointer to procedure, if such exists */
 
   /* 
@@ -629,6 +637,7 @@ public:
   bool prepare(THD *thd, select_result *result, ulong additional_options);
   bool optimize();
   bool exec();
+  bool exec_direct();
   bool cleanup();
   inline void unclean() { cleaned= 0; }
   void reinit_exec_mechanism();
@@ -643,6 +652,7 @@ public:
   void set_limit(st_select_lex *values);
   void set_thd(THD *thd_arg) { thd= thd_arg; }
   inline bool is_union (); 
+  bool union_needs_tmp_table();
 
   void set_unique_exclude();
 
@@ -808,6 +818,12 @@ public:
   bool first_execution;
   bool first_natural_join_processing;
   bool first_cond_optimization;
+  /*
+    The join order found by the last full search of the join optimizer,
+    it can be reused when the statement is executed again
+    (see optimizer_switch='reuse_join_order=on')
+  */
+  Saved_join_order *saved_join_order;
   /* do not wrap view fields with Item_ref */
   bool no_wrap_view_item;
   /* exclude this select from check of unique_table() */
@@ -2368,6 +2384,8 @@ struct LEX: public Query_tables_list
   List<LEX_STRING>    view_list; // view list (list of field names in view)
   List<LEX_STRING>   *column_list; // list of column names (in ANALYZE)
   List<LEX_STRING>   *index_list;  // list of index names (in ANALYZE)
+  /* list of groups of column names (in ANALYZE) */
+  List<List<LEX_STRING> > *column_group_list;
   /*
     A stack of name resolution contexts for the query. This stack is used
     at parse time to set local name resolution contexts for various parts
@@ -2459,6 +2477,10 @@ struct LEX: public Query_tables_list
   */
   uint table_count;
   uint8 describe;
+  /* TRUE <=> ANALYZE statement: execute and print the plan with counters */
+  bool analyze_stmt;
+  /* TRUE <=> FORMAT=JSON was specified for EXPLAIN or ANALYZE */
+  bool explain_json;
   /*
     A flag that indicates what kinds of derived tables are present in the
     query (0 if no derived tables, otherwise a combination of flags
@@ -0,0 +1,1140 @@
+/*
+   Copyright (c) 2014, Monty Program Ab
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/**
+  @file
+
+  @brief
+  Parallel scan of a single table for queries with aggregate functions
+  and without GROUP BY
+
+  @see Parallel_scan
+*/
+
+#include "sql_priv.h"
+#include "sql_parallel_scan.h"
+#include "sql_class.h"
+#include "mysqld.h"
+#include "sql_parse.h"                          // check_stack_overrun
+#include "transaction.h"                        // trans_commit_stmt
+
+
+/* Maximum number of bisection steps when looking for a range boundary */
+#define PARALLEL_SCAN_MAX_SPLIT_STEPS 32
+
+
+/* Check whether the values of the field can be split into ranges */
+
+static bool is_split_field(Field *field)
+{
+  switch (field->real_type()) {
+  case MYSQL_TYPE_TINY:
+  case MYSQL_TYPE_SHORT:
+  case MYSQL_TYPE_INT24:
+  case MYSQL_TYPE_LONG:
+  case MYSQL_TYPE_LONGLONG:
+    return TRUE;
+  default:
+    return FALSE;
+  }
+}
+
+
+/*
+  Map a value of an integer field to an unsigned number so that the
+  order of the values is preserved
+*/
+
+static inline ulonglong to_ordered(longlong value, bool unsigned_flag)
+{
+  return unsigned_flag ? (ulonglong) value :
+                         (ulonglong) value ^ (1ULL << 63);
+}
+
+
+static inline longlong from_ordered(ulonglong value, bool unsigned_flag)
+{
+  return unsigned_flag ? (longlong) value : (longlong) (value ^ (1ULL << 63));
+}
+
+
+/*
+  Check whether an item refers to a column of the table outside of an
+  aggregate function, or contains a subquery
+*/
+
+static bool uses_unaggregated_column(Item *item)
+{
+  if (item->with_subselect)
+    return TRUE;
+  if (!item->with_field)
+    return FALSE;
+  switch (item->type()) {
+  case Item::SUM_FUNC_ITEM:
+    return FALSE;
+  case Item::REF_ITEM:
+    return uses_unaggregated_column(*((Item_ref *) item)->ref);
+  case Item::FUNC_ITEM:
+  {
+    Item_func *func= (Item_func *) item;
+    Item **arg= func->arguments(), **arg_end= arg + func->argument_count();
+    for ( ; arg != arg_end; arg++)
+    {
+      if (uses_unaggregated_column(*arg))
+        return TRUE;
+    }
+    return FALSE;
+  }
+  case Item::COND_ITEM:
+  {
+    List_iterator_fast<Item> li(*((Item_cond *) item)->argument_list());
+    Item *arg;
+    while ((arg= li++))
+    {
+      if (uses_unaggregated_column(arg))
+        return TRUE;
+    }
+    return FALSE;
+  }
+  default:
+    return TRUE;
+  }
+}
+
+
+/**
+  Check whether a join can be executed by a parallel scan
+
+  @param join  the join, after the choice of the execution plan
+
+  @return
+    the parallel scan to be used when executing the join, or 0 if the
+    join must be executed as usual
+*/
+
+Parallel_scan *Parallel_scan::create(JOIN *join)
+{
+  THD *thd= join->thd;
+  JOIN_TAB *tab= join->join_tab;
+  TABLE *table;
+  Parallel_scan *scan;
+  List_iterator_fast<Item> it(join->all_fields);
+  Item *item;
+  uint sum_count= 0;
+  uint cond_count= 0;
+  Parallel_scan_sum *sum;
+  DBUG_ENTER("Parallel_scan::create");
+
+  if (thd->variables.parallel_scan_workers < 2 ||
+      !join->select_lex->with_sum_func || join->group_list ||
+      join->table_count != 1 || join->const_tables ||
+      join->need_tmp || join->select_distinct || join->procedure ||
+      join->mixed_implicit_grouping ||
+      join->rollup.state != ROLLUP::STATE_NONE ||
+      join->outer_ref_cond || join->pseudo_bits_cond ||
+      join->unit->item || thd->lex->limit_rows_examined ||
+      join->select_lex->ftfunc_list->elements)
+    DBUG_RETURN(0);
+
+  table= tab->table;
+  if (!(table->file->ha_table_flags() & HA_CAN_PARALLEL_SCAN) ||
+      table->s->tmp_table != NO_TMP_TABLE ||
+      table->reginfo.lock_type > TL_READ_NO_INSERT ||
+      table->s->keys == 0)
+    DBUG_RETURN(0);
+
+  while ((item= it++))
+  {
+    if (item->type() == Item::SUM_FUNC_ITEM)
+      sum_count++;
+    else if (uses_unaggregated_column(item))
+      DBUG_RETURN(0);
+  }
+  if (!sum_count ||
+      (join->having && uses_unaggregated_column(join->having)))
+    DBUG_RETURN(0);
+
+  if (!(scan= new Parallel_scan(join, table)) ||
+      !(scan->sums= (Parallel_scan_sum *)
+        thd->alloc(sizeof(Parallel_scan_sum) * sum_count)))
+    DBUG_RETURN(0);
+
+  it.rewind();
+  sum= scan->sums;
+  while ((item= it++))
+  {
+    if (item->type() != Item::SUM_FUNC_ITEM)
+      continue;
+    if (scan->add_sum((Item_sum *) item, sum++))
+      DBUG_RETURN(0);
+  }
+  scan->sums_end= sum;
+
+  if (join->conds)
+  {
+    /* Every conjunct makes at most two conditions (BETWEEN) */
+    if (join->conds->type() == Item::COND_ITEM)
+      cond_count= ((Item_cond *) join->conds)->argument_list()->elements * 2;
+    else
+      cond_count= 2;
+    if (!(scan->conds= (Parallel_scan_cond *)
+          thd->alloc(sizeof(Parallel_scan_cond) * cond_count)))
+      DBUG_RETURN(0);
+    scan->conds_end= scan->conds;
+    if (scan->add_cond(join->conds))
+      DBUG_RETURN(0);
+  }
+
+  if (scan->choose_index())
+    DBUG_RETURN(0);
+
+  DBUG_PRINT("info", ("parallel scan of index %u with %u workers",
+                      scan->keyno, scan->planned_workers));
+  DBUG_RETURN(scan);
+}
+
+
+/**
+  Add an aggregate function computed by the workers
+
+  @retval FALSE  the function can be computed by the workers
+  @retval TRUE   the function cannot be computed by a parallel scan
+*/
+
+bool Parallel_scan::add_sum(Item_sum *item, Parallel_scan_sum *sum)
+{
+  Item *arg;
+  Field *field;
+
+  sum->item= item;
+  sum->type= item->sum_func();
+  sum->field= 0;
+  sum->offset= 0;
+  sum->field_index= 0;
+  sum->decimal_sum= FALSE;
+
+  switch (sum->type) {
+  case Item_sum::COUNT_FUNC:
+  case Item_sum::SUM_FUNC:
+  case Item_sum::AVG_FUNC:
+  case Item_sum::MIN_FUNC:
+  case Item_sum::MAX_FUNC:
+  case Item_sum::APPROX_COUNT_DISTINCT_FUNC:
+    break;
+  default:
+    return TRUE;
+  }
+  if (item->get_arg_count() != 1)
+    return TRUE;
+
+  arg= item->get_arg(0);
+  if (sum->type == Item_sum::COUNT_FUNC && arg->const_item())
+  {
+    /* COUNT(*) */
+    return arg->maybe_null || arg->is_expensive();
+  }
+
+  arg= arg->real_item();
+  if (arg->type() != Item::FIELD_ITEM)
+    return TRUE;
+  field= ((Item_field *) arg)->field;
+  if (field->table != table)
+    return TRUE;
+
+  switch (field->real_type()) {
+  case MYSQL_TYPE_BIT:
+  case MYSQL_TYPE_ENUM:
+  case MYSQL_TYPE_SET:
+  case MYSQL_TYPE_TINY_BLOB:
+  case MYSQL_TYPE_MEDIUM_BLOB:
+  case MYSQL_TYPE_LONG_BLOB:
+  case MYSQL_TYPE_BLOB:
+  case MYSQL_TYPE_GEOMETRY:
+  case MYSQL_TYPE_TIMESTAMP:
+  case MYSQL_TYPE_TIMESTAMP2:
+    /*
+      The order of Field::cmp() differs from the order used by MIN()/MAX()
+      for ENUM/SET, and is not monotonic in the session time zone for
+      TIMESTAMP.
+    */
+    if (sum->type != Item_sum::COUNT_FUNC)
+      return TRUE;
+    break;
+  default:
+    break;
+  }
+
+  if (sum->type == Item_sum::SUM_FUNC || sum->type == Item_sum::AVG_FUNC)
+  {
+    switch (field->cmp_type()) {
+    case INT_RESULT:
+    case REAL_RESULT:
+    case DECIMAL_RESULT:
+      break;
+    default:
+      return TRUE;
+    }
+    sum->decimal_sum= item->result_type() == DECIMAL_RESULT;
+  }
+
+  sum->field= field;
+  sum->offset= (uint) (field->ptr - table->record[0]);
+  sum->field_index= field->field_index;
+  return FALSE;
+}
+
+
+/**
+  Add the conjuncts of a condition to the conditions checked by workers
+
+  @retval FALSE  the condition can be checked by the workers
+  @retval TRUE   the condition cannot be checked by a parallel scan
+*/
+
+bool Parallel_scan::add_cond(Item *cond)
+{
+  Item_func *func;
+  Item **args;
+
+  if (cond->type() == Item::COND_ITEM)
+  {
+    if (((Item_cond *) cond)->functype() != Item_func::COND_AND_FUNC)
+      return TRUE;
+    List_iterator_fast<Item> li(*((Item_cond *) cond)->argument_list());
+    Item *item;
+    while ((item= li++))
+    {
+      if (add_cond(item))
+        return TRUE;
+    }
+    return FALSE;
+  }
+  if (cond->type() != Item::FUNC_ITEM)
+    return TRUE;
+
+  func= (Item_func *) cond;
+  args= func->arguments();
+  switch (func->functype()) {
+  case Item_func::EQ_FUNC:
+    return add_cmp_cond(Parallel_scan_cond::EQ, args[0], args[1]);
+  case Item_func::NE_FUNC:
+    return add_cmp_cond(Parallel_scan_cond::NE, args[0], args[1]);
+  case Item_func::LT_FUNC:
+    return add_cmp_cond(Parallel_scan_cond::LT, args[0], args[1]);
+  case Item_func::LE_FUNC:
+    return add_cmp_cond(Parallel_scan_cond::LE, args[0], args[1]);
+  case Item_func::GT_FUNC:
+    return add_cmp_cond(Parallel_scan_cond::GT, args[0], args[1]);
+  case Item_func::GE_FUNC:
+    return add_cmp_cond(Parallel_scan_cond::GE, args[0], args[1]);
+  case Item_func::BETWEEN:
+    if (((Item_func_between *) func)->negated)
+      return TRUE;
+    return add_cmp_cond(Parallel_scan_cond::GE, args[0], args[1]) ||
+           add_cmp_cond(Parallel_scan_cond::LE, args[0], args[2]);
+  case Item_func::ISNULL_FUNC:
+    return add_cmp_cond(Parallel_scan_cond::IS_NULL, args[0], 0);
+  case Item_func::ISNOTNULL_FUNC:
+    return add_cmp_cond(Parallel_scan_cond::IS_NOT_NULL, args[0], 0);
+  default:
+    return TRUE;
+  }
+}
+
+
+/**
+  Add a condition 'field op const' or 'const op field'
+
+  @param type       the comparison
+  @param field_arg  the first argument of the comparison
+  @param value_arg  the second argument, 0 for IS [NOT] NULL
+
+  @retval FALSE  the condition can be checked by the workers
+  @retval TRUE   the condition cannot be checked by a parallel scan
+*/
+
+bool Parallel_scan::add_cmp_cond(Parallel_scan_cond::cond_type type,
+                                 Item *field_arg, Item *value_arg)
+{
+  THD *thd= join->thd;
+  Parallel_scan_cond *cond= conds_end;
+  Field *field, *value_field;
+  my_bitmap_map *old_map;
+  int res;
+
+  if (value_arg && field_arg->const_item())
+  {
+    /* const op field: swap the arguments */
+    swap_variables(Item *, field_arg, value_arg);
+    switch (type) {
+    case Parallel_scan_cond::LT: type= Parallel_scan_cond::GT; break;
+    case Parallel_scan_cond::LE: type= Parallel_scan_cond::GE; break;
+    case Parallel_scan_cond::GT: type= Parallel_scan_cond::LT; break;
+    case Parallel_scan_cond::GE: type= Parallel_scan_cond::LE; break;
+    default: break;
+    }
+  }
+
+  field_arg= field_arg->real_item();
+  if (field_arg->type() != Item::FIELD_ITEM)
+    return TRUE;
+  field= ((Item_field *) field_arg)->field;
+  if (field->table != table || !is_split_field(field))
+    return TRUE;
+
+  cond->type= type;
+  cond->field= field;
+  cond->offset= (uint) (field->ptr - table->record[0]);
+  cond->field_index= field->field_index;
+  cond->value= 0;
+
+  if (value_arg)
+  {
+    if (!value_arg->const_item() || value_arg->is_expensive() ||
+        value_arg->result_type() != INT_RESULT)
+      return TRUE;
+    if (!(cond->value= (uchar *) thd->memdup(table->s->default_values,
+                                             table->s->reclength)) ||
+        !(value_field= field->clone(thd->mem_root,
+                                    cond->value - table->record[0])))
+      return TRUE;
+    value_field->set_notnull();
+    old_map= dbug_tmp_use_all_columns(table, table->write_set);
+    /* NULL and values out of the range of the field are not handled here */
+    res= value_arg->save_in_field(value_field, 1);
+    dbug_tmp_restore_column_map(table->write_set, old_map);
+    if (res || value_field->is_null())
+      return TRUE;
+  }
+  conds_end++;
+  return FALSE;
+}
+
+
+/*
+  Get the bounds of the values of the first component of the index
+  following from the conditions
+
+  @param[out] min_rec  the record with the lower bound, or 0
+  @param[out] max_rec  the record with the upper bound, or 0
+
+  @note
+  The bounds are inclusive. A condition 'field > const' gives the bound
+  'const' as the rows with the value 'const' are filtered out anyway.
+*/
+
+void Parallel_scan::get_key_bounds(uchar **min_rec, uchar **max_rec)
+{
+  *min_rec= *max_rec= 0;
+  for (Parallel_scan_cond *cond= conds; cond != conds_end; cond++)
+  {
+    if (cond->field != key_field || !cond->value)
+      continue;
+    switch (cond->type) {
+    case Parallel_scan_cond::EQ:
+    case Parallel_scan_cond::GT:
+    case Parallel_scan_cond::GE:
+      if (!*min_rec ||
+          key_field->cmp(cond->value + key_offset, *min_rec + key_offset) > 0)
+        *min_rec= cond->value;
+      break;
+    default:
+      break;
+    }
+    switch (cond->type) {
+    case Parallel_scan_cond::EQ:
+    case Parallel_scan_cond::LT:
+    case Parallel_scan_cond::LE:
+      if (!*max_rec ||
+          key_field->cmp(cond->value + key_offset, *max_rec + key_offset) < 0)
+        *max_rec= cond->value;
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+
+/*
+  Make the key image of the value of the first component of an index
+
+  @param key  the index
+  @param rec  the record with the value
+*/
+
+uchar *Parallel_scan::make_key(uint key, uchar *rec)
+{
+  KEY_PART_INFO *key_part= table->key_info[key].key_part;
+  Field *field= key_part->field;
+  uchar *buff, *pos;
+
+  if (!(buff= pos= (uchar *) join->thd->alloc(key_part->store_length)))
+    return 0;
+  if (key_part->null_bit)
+    *pos++= 0;
+  field->move_field_offset((my_ptrdiff_t) (rec - table->record[0]));
+  field->get_key_image(pos, key_part->length, Field::itRAW);
+  field->move_field_offset((my_ptrdiff_t) (table->record[0] - rec));
+  return buff;
+}
+
+
+/*
+  Estimate the number of index entries in a range of values of the first
+  component of an index
+
+  @param key            the index
+  @param min_rec        the record with the inclusive lower bound, or 0
+  @param max_rec        the record with the upper bound, or 0
+  @param max_inclusive  TRUE <=> the upper bound belongs to the range
+
+  @return
+    the estimate, or HA_POS_ERROR if the engine cannot provide it
+*/
+
+ha_rows Parallel_scan::estimate_rows(uint key, uchar *min_rec, uchar *max_rec,
+                                     bool max_inclusive)
+{
+  KEY_PART_INFO *key_part= table->key_info[key].key_part;
+  key_range min_range, max_range;
+
+  if (!min_rec && !max_rec)
+    return table->file->stats.records;
+
+  if (min_rec)
+  {
+    if (!(min_range.key= make_key(key, min_rec)))
+      return HA_POS_ERROR;
+    min_range.length= key_part->store_length;
+    min_range.keypart_map= 1;
+    min_range.flag= HA_READ_KEY_EXACT;
+  }
+  if (max_rec)
+  {
+    if (!(max_range.key= make_key(key, max_rec)))
+      return HA_POS_ERROR;
+    max_range.length= key_part->store_length;
+    max_range.keypart_map= 1;
+    max_range.flag= max_inclusive ? HA_READ_AFTER_KEY : HA_READ_BEFORE_KEY;
+  }
+  return table->file->records_in_range(key, min_rec ? &min_range : 0,
+                                       max_rec ? &max_range : 0);
+}
+
+
+/**
+  Choose the index to split and the number of workers
+
+  @retval FALSE  the index is chosen
+  @retval TRUE   the parallel scan is not worth using
+*/
+
+bool Parallel_scan::choose_index()
+{
+  ulong max_workers= join->thd->variables.parallel_scan_workers;
+  ha_rows best_rows= HA_POS_ERROR;
+  bool best_covering= FALSE;
+  uint best_key= MAX_KEY;
+  ha_rows rows;
+
+  for (uint key= 0; key < table->s->keys; key++)
+  {
+    KEY *info= table->key_info + key;
+    ulong flags;
+    uchar *min_rec, *max_rec;
+    bool covering;
+
+    if (!table->keys_in_use_for_query.is_set(key) ||
+        (info->flags & (HA_FULLTEXT | HA_SPATIAL)))
+      continue;
+    flags= table->file->index_flags(key, 0, 1);
+    if ((flags & (HA_READ_NEXT | HA_READ_ORDER | HA_READ_RANGE)) !=
+        (HA_READ_NEXT | HA_READ_ORDER | HA_READ_RANGE) ||
+        !is_split_field(info->key_part->field))
+      continue;
+
+    key_field= info->key_part->field;
+    key_offset= (uint) (key_field->ptr - table->record[0]);
+    get_key_bounds(&min_rec, &max_rec);
+    rows= estimate_rows(key, min_rec, max_rec, TRUE);
+    covering= table->covering_keys.is_set(key) && !table->no_keyread &&
+              (flags & HA_KEYREAD_ONLY);
+    if (best_key == MAX_KEY || rows < best_rows ||
+        (rows == best_rows && covering && !best_covering))
+    {
+      best_key= key;
+      best_rows= rows;
+      best_covering= covering;
+    }
+  }
+
+  if (best_key == MAX_KEY || best_rows == HA_POS_ERROR)
+    return TRUE;
+  planned_workers= (uint) MY_MIN(max_workers,
+                                 best_rows / PARALLEL_SCAN_MIN_RANGE_ROWS);
+  if (planned_workers < 2)
+    return TRUE;
+
+  keyno= best_key;
+  key_info= table->key_info + keyno;
+  key_field= key_info->key_part->field;
+  key_offset= (uint) (key_field->ptr - table->record[0]);
+  key_field_index= key_field->field_index;
+  keyread= best_covering;
+  get_key_bounds(&min_value, &max_value);
+  return FALSE;
+}
+
+
+/*
+  Allocate a record with the given value of the first component of the
+  index to split
+*/
+
+uchar *Parallel_scan::alloc_record(ulonglong value)
+{
+  bool unsigned_flag= MY_TEST(key_field->flags & UNSIGNED_FLAG);
+  my_bitmap_map *old_map;
+  uchar *rec;
+
+  if (!(rec= (uchar *) join->thd->memdup(table->s->default_values,
+                                         table->s->reclength)))
+    return 0;
+  old_map= dbug_tmp_use_all_columns(table, table->write_set);
+  key_field->move_field_offset((my_ptrdiff_t) (rec - table->record[0]));
+  key_field->set_notnull();
+  key_field->store(from_ordered(value, unsigned_flag), unsigned_flag);
+  key_field->move_field_offset((my_ptrdiff_t) (table->record[0] - rec));
+  dbug_tmp_restore_column_map(table->write_set, old_map);
+  return rec;
+}
+
+
+/**
+  Read the smallest and the largest non-NULL values of the index to split
+
+  @param[out] min_val  the smallest value, mapped by to_ordered()
+  @param[out] max_val  the largest value, mapped by to_ordered()
+  @param[out] empty    TRUE <=> there are no such values
+
+  @retval FALSE  ok
+  @retval TRUE   an error occurred
+*/
+
+bool Parallel_scan::read_key_domain(ulonglong *min_val, ulonglong *max_val,
+                                    bool *empty)
+{
+  handler *file= table->file;
+  bool unsigned_flag= MY_TEST(key_field->flags & UNSIGNED_FLAG);
+  uchar *rec= table->record[0];
+  my_bitmap_map *old_map;
+  int error= 0;
+
+  *empty= FALSE;
+  if (min_value && max_value)
+    goto read_bounds;
+
+  if ((error= file->ha_index_init(keyno, 1)))
+  {
+    file->print_error(error, MYF(0));
+    return TRUE;
+  }
+  if (!min_value)
+  {
+    if (key_field->real_maybe_null())
+    {
+      /* Skip the NULLs that are sorted first */
+      KEY_PART_INFO *key_part= key_info->key_part;
+      uchar *key= (uchar *) join->thd->calloc(key_part->store_length);
+      if (!key)
+      {
+        file->ha_index_end();
+        return TRUE;
+      }
+      key[0]= 1;
+      error= file->ha_index_read_map(rec, key, (key_part_map) 1,
+                                     HA_READ_AFTER_KEY);
+    }
+    else
+      error= file->ha_index_first(rec);
+    if (!error && key_field->is_null())
+      error= HA_ERR_END_OF_FILE;
+    if (error)
+      goto end;
+    old_map= dbug_tmp_use_all_columns(table, table->read_set);
+    *min_val= to_ordered(key_field->val_int(), unsigned_flag);
+    dbug_tmp_restore_column_map(table->read_set, old_map);
+  }
+  if (!max_value)
+  {
+    error= file->ha_index_last(rec);
+    if (!error && key_field->is_null())
+      error= HA_ERR_END_OF_FILE;
+    if (error)
+      goto end;
+    old_map= dbug_tmp_use_all_columns(table, table->read_set);
+    *max_val= to_ordered(key_field->val_int(), unsigned_flag);
+    dbug_tmp_restore_column_map(table->read_set, old_map);
+  }
+
+end:
+  file->ha_index_end();
+  if (error == HA_ERR_END_OF_FILE || error == HA_ERR_KEY_NOT_FOUND)
+  {
+    *empty= TRUE;
+    return FALSE;
+  }
+  if (error)
+  {
+    file->print_error(error, MYF(0));
+    return TRUE;
+  }
+
+read_bounds:
+  old_map= dbug_tmp_use_all_columns(table, table->read_set);
+  if (min_value)
+  {
+    key_field->move_field_offset((my_ptrdiff_t) (min_value - rec));
+    *min_val= to_ordered(key_field->val_int(), unsigned_flag);
+    key_field->move_field_offset((my_ptrdiff_t) (rec - min_value));
+  }
+  if (max_value)
+  {
+    key_field->move_field_offset((my_ptrdiff_t) (max_value - rec));
+    *max_val= to_ordered(key_field->val_int(), unsigned_flag);
+    key_field->move_field_offset((my_ptrdiff_t) (rec - max_value));
+  }
+  dbug_tmp_restore_column_map(table->read_set, old_map);
+  if (*min_val > *max_val)
+    *empty= TRUE;
+  return FALSE;
+}
+
+
+/**
+  Split the index into ranges with about the same number of entries
+
+  @param[out] bounds  the boundaries between the ranges, mapped by
+                      to_ordered()
+  @param[out] count   the number of ranges
+
+  @details
+  The boundary between the ranges i-1 and i is the smallest value v such
+  that records_in_range() estimates the range [min, v) to contain i/n of
+  the entries in [min, max]. It is found by bisection. If the engine cannot
+  estimate the ranges, the values are split into ranges of equal width.
+
+  @retval FALSE  ok
+  @retval TRUE   an error occurred
+*/
+
+bool Parallel_scan::split_ranges(ulonglong **bounds, uint *count)
+{
+  ulonglong min_val, max_val, prev;
+  uchar *min_rec, *max_rec;
+  ha_rows total;
+  bool empty;
+  uint n= planned_workers;
+
+  *count= 1;
+  if (read_key_domain(&min_val, &max_val, &empty))
+    return TRUE;
+  if (empty || min_val == max_val)
+    return FALSE;
+  if (max_val - min_val < n)
+    n= (uint) (max_val - min_val) + 1;
+  if (!(*bounds= (ulonglong *) join->thd->alloc(sizeof(ulonglong) * n)) ||
+      !(min_rec= alloc_record(min_val)))
+    return TRUE;
+
+  if (!(max_rec= alloc_record(max_val)))
+    return TRUE;
+  total= estimate_rows(keyno, min_rec, max_rec, TRUE);
+
+  prev= min_val;
+  for (uint i= 1; i < n; i++)
+  {
+    ulonglong left= prev + 1, right= max_val, bound;
+
+    if (total == HA_POS_ERROR || total == 0)
+      bound= min_val + (max_val - min_val) / n * i;
+    else
+    {
+      ha_rows target= total * i / n;
+      for (uint step= 0;
+           left < right && step < PARALLEL_SCAN_MAX_SPLIT_STEPS;
+           step++)
+      {
+        ulonglong middle= left + (right - left) / 2;
+        ha_rows rows;
+        if (!(max_rec= alloc_record(middle)))
+          return TRUE;
+        rows= estimate_rows(keyno, min_rec, max_rec, FALSE);
+        if (rows == HA_POS_ERROR)
+          break;
+        if (rows < target)
+          left= middle + 1;
+        else
+          right= middle;
+      }
+      bound= left;
+    }
+    if (bound <= prev || bound > max_val)
+      continue;
+    (*bounds)[(*count)++ - 1]= bound;
+    prev= bound;
+  }
+  return FALSE;
+}
+
+
+/**
+  Set up the workers of the scan: the ranges and the instances of the table
+
+  @retval FALSE  ok
+  @retval TRUE   an error occurred
+*/
+
+bool Parallel_scan::init_workers()
+{
+  THD *thd= join->thd;
+  ulonglong *bounds= 0;
+  uint count;
+  int error;
+  uint sum_count= (uint) (sums_end - sums);
+
+  if (split_ranges(&bounds, &count) ||
+      !(workers= new (thd->mem_root) Parallel_scan_worker[count]))
+    return TRUE;
+
+  for (uint i= 0; i < count; i++)
+  {
+    Parallel_scan_worker *worker= workers + i;
+    TABLE *worker_table;
+    worker->scan= this;
+
+    if (i > 0)
+    {
+      if (!(worker->start_key= make_key(keyno, alloc_record(bounds[i - 1]))))
+        return TRUE;
+    }
+    else if (min_value && !(worker->start_key= make_key(keyno, min_value)))
+      return TRUE;
+
+    if (i < count - 1)
+    {
+      if (!(worker->end_record= alloc_record(bounds[i])))
+        return TRUE;
+    }
+    else
+    {
+      worker->end_record= max_value;
+      worker->end_inclusive= TRUE;
+    }
+
+    if (!(worker->partials= new (thd->mem_root)
+          Parallel_scan_partial[sum_count]))
+      return TRUE;
+
+    for (uint j= 0; j < sum_count; j++)
+    {
+      Parallel_scan_sum *sum= sums + j;
+      Parallel_scan_partial *partial= worker->partials + j;
+      if ((sum->type == Item_sum::MIN_FUNC ||
+           sum->type == Item_sum::MAX_FUNC) && sum->field &&
+          !(partial->row= (uchar *) thd->alloc(table->s->reclength)))
+        return TRUE;
+      if (sum->type == Item_sum::APPROX_COUNT_DISTINCT_FUNC &&
+          !(partial->sketch= (uchar *) thd->calloc(HLL_REGISTERS)))
+        return TRUE;
+    }
+
+    /* Opening a table takes up a lot of stack, like handler::clone() */
+    if (check_stack_overrun(thd, 5*STACK_MIN_SIZE, (uchar*) &error))
+      return TRUE;
+    if (!(worker_table= (TABLE *) thd->alloc(sizeof(TABLE))))
+      return TRUE;
+    if (open_table_from_share(thd, table->s, table->alias.c_ptr(),
+                              (uint) (HA_OPEN_KEYFILE | HA_OPEN_RNDFILE |
+                                      HA_GET_INDEX | HA_TRY_READ_ONLY),
+                              READ_KEYINFO | COMPUTE_TYPES | EXTRA_RECORD,
+                              HA_OPEN_IGNORE_IF_LOCKED, worker_table, FALSE))
+      return TRUE;
+    worker->table= worker_table;
+    worker_count= i + 1;
+
+    bitmap_copy(worker_table->read_set, table->read_set);
+    bitmap_set_bit(worker_table->read_set, key_field_index);
+    if (keyread)
+      worker_table->file->extra(HA_EXTRA_KEYREAD);
+    /* The handler is used by the thread that reads the range */
+    worker_table->file->unbind_psi();
+  }
+  return FALSE;
+}
+
+
+/* Close the instances of the table of the workers */
+
+void Parallel_scan::cleanup_workers()
+{
+  for (uint i= 0; i < worker_count; i++)
+  {
+    Parallel_scan_worker *worker= workers + i;
+    if (!worker->table)
+      continue;
+    worker->table->file->rebind_psi();
+    if (keyread)
+      worker->table->file->extra(HA_EXTRA_NO_KEYREAD);
+    closefrm(worker->table, FALSE);
+    worker->table= 0;
+  }
+  worker_count= 0;
+}
+
+
+/* Add a row that satisfies the WHERE condition to the partial results */
+
+void Parallel_scan::add_row(Parallel_scan_partial *partials,
+                            TABLE *worker_table)
+{
+  Parallel_scan_partial *partial= partials;
+  for (Parallel_scan_sum *sum= sums; sum != sums_end; sum++, partial++)
+  {
+    Field *field= sum->field ? worker_table->field[sum->field_index] : 0;
+    if (field && field->is_null())
+      continue;
+    switch (sum->type) {
+    case Item_sum::SUM_FUNC:
+    case Item_sum::AVG_FUNC:
+      if (sum->decimal_sum)
+      {
+        my_decimal value;
+        my_decimal *val= field->val_decimal(&value);
+        my_decimal_add(E_DEC_FATAL_ERROR,
+                       partial->dec_buffs + (partial->curr_dec_buff^1),
+                       val, partial->dec_buffs + partial->curr_dec_buff);
+        partial->curr_dec_buff^= 1;
+      }
+      else
+        partial->sum+= field->val_real();
+      break;
+    case Item_sum::MIN_FUNC:
+    case Item_sum::MAX_FUNC:
+    {
+      int cmp;
+      if (partial->count)
+      {
+        cmp= field->cmp(field->ptr, partial->row + sum->offset);
+        if (sum->type == Item_sum::MIN_FUNC ? cmp >= 0 : cmp <= 0)
+          break;
+      }
+      memcpy(partial->row, worker_table->record[0], table->s->reclength);
+      break;
+    }
+    case Item_sum::APPROX_COUNT_DISTINCT_FUNC:
+    {
+      ulonglong hash;
+      if (!Item_sum_approx_count_distinct::hash_field(field, &hash))
+        Item_sum_approx_count_distinct::add_hash(partial->sketch, hash);
+      break;
+    }
+    default:
+      break;
+    }
+    partial->count++;
+  }
+}
+
+
+/* Merge the partial results of the workers into the aggregate functions */
+
+void Parallel_scan::merge_partials()
+{
+  uint sum_count= (uint) (sums_end - sums);
+  for (uint j= 0; j < sum_count; j++)
+  {
+    Parallel_scan_sum *sum= sums + j;
+    Item_sum *item= sum->item;
+
+    item->aggregator_clear();
+    for (uint i= 0; i < worker_count; i++)
+    {
+      Parallel_scan_partial *partial= workers[i].partials + j;
+      my_decimal *dec= partial->dec_buffs + partial->curr_dec_buff;
+      if (!partial->count)
+        continue;
+      switch (sum->type) {
+      case Item_sum::COUNT_FUNC:
+        ((Item_sum_count *) item)->add_count(partial->count);
+        break;
+      case Item_sum::SUM_FUNC:
+        ((Item_sum_sum *) item)->add_partial_sum(dec, partial->sum);
+        break;
+      case Item_sum::AVG_FUNC:
+        ((Item_sum_avg *) item)->add_partial_sum(dec, partial->sum,
+                                                 partial->count);
+        break;
+      case Item_sum::MIN_FUNC:
+      case Item_sum::MAX_FUNC:
+        memcpy(table->record[0], partial->row, table->s->reclength);
+        item->aggregator_add();
+        break;
+      case Item_sum::APPROX_COUNT_DISTINCT_FUNC:
+        ((Item_sum_approx_count_distinct *) item)->
+          merge_sketch(partial->sketch);
+        break;
+      default:
+        break;
+      }
+    }
+  }
+}
+
+
+/**
+  Read the range of the worker with the current thread
+
+  @param thd  the THD of the thread, see Pool_task::run()
+*/
+
+void Parallel_scan_worker::run(THD *thd)
+{
+  THD *stmt_thd= scan->get_thd();
+  handler *file= table->file;
+  int res;
+
+  pool_thread= thd != stmt_thd;
+  /* memory_used is not cleared: the THD of the pool still owns memory */
+  if (pool_thread)
+    thd->set_status_var_init();
+  table->in_use= thd;
+  file->rebind_psi();
+  if (!(res= file->ha_external_lock(thd, F_RDLCK)))
+  {
+    res= scan_range();
+    file->ha_external_lock(thd, F_UNLCK);
+  }
+  /* End the read-only transaction the engine registered for the pool THD */
+  if (pool_thread)
+    trans_commit_stmt(thd);
+  file->unbind_psi();
+  table->in_use= stmt_thd;
+  if (pool_thread)
+    status_var= thd->status_var;
+  error= res;
+}
+
+
+/* Read a range of the index and compute the partial aggregates */
+
+int Parallel_scan_worker::scan_range()
+{
+  THD *stmt_thd= scan->get_thd();
+  handler *file= table->file;
+  uchar *record= table->record[0];
+  int res;
+
+  if ((res= file->ha_index_init(scan->get_keyno(), 1)))
+    return res;
+
+  if (start_key)
+    res= file->ha_index_read_map(record, start_key, (key_part_map) 1,
+                                 HA_READ_KEY_OR_NEXT);
+  else
+    res= file->ha_index_first(record);
+
+  for ( ; !res; res= file->ha_index_next(record))
+  {
+    if (end_record && scan->after_range_end(table, end_record,
+                                            end_inclusive))
+      break;
+    if (!(++rows_read % PARALLEL_SCAN_KILL_CHECK_ROWS) && stmt_thd->killed)
+      break;
+    if (scan->check_row(table))
+    {
+      rows_matched++;
+      scan->add_row(partials, table);
+    }
+  }
+  if (res == HA_ERR_END_OF_FILE || res == HA_ERR_KEY_NOT_FOUND)
+    res= 0;
+  file->ha_index_end();
+  return res;
+}
+
+
+/**
+  Execute the scan and merge the partial results of the workers
+
+  @details
+  The first range is read by the thread of the query, the other ranges
+  by the threads of the task pool. A range that no thread of the pool
+  has picked up when the thread of the query is done with its own range
+  is read by the thread of the query as well.
+*/
+
+enum_nested_loop_state Parallel_scan::exec()
+{
+  THD *thd= join->thd;
+  enum_nested_loop_state rc= NESTED_LOOP_OK;
+  Pool_task **tasks;
+  ha_rows rows_read= 0, rows_matched= 0;
+  int error= 0;
+  DBUG_ENTER("Parallel_scan::exec");
+
+  if (init_workers() ||
+      !(tasks= (Pool_task **) thd->alloc(sizeof(Pool_task *) * worker_count)))
+  {
+    cleanup_workers();
+    DBUG_RETURN(NESTED_LOOP_ERROR);
+  }
+
+  for (uint i= 0; i < worker_count; i++)
+    tasks[i]= workers + i;
+  run_pool_tasks(thd, tasks, worker_count);
+
+  for (uint i= 0; i < worker_count; i++)
+  {
+    if (workers[i].pool_thread)
+      add_to_status(&thd->status_var, &workers[i].status_var);
+    rows_read+= workers[i].rows_read;
+    rows_matched+= workers[i].rows_matched;
+    if (!error)
+      error= workers[i].error;
+  }
+  join->examined_rows+= rows_read;
+
+  if (thd->check_killed())
+  {
+    thd->send_kill_message();
+    rc= NESTED_LOOP_KILLED;
+  }
+  else if (error)
+  {
+    table->file->print_error(error, MYF(0));
+    rc= NESTED_LOOP_ERROR;
+  }
+  else
+  {
+    merge_partials();
+    join->first_record= rows_matched != 0;
+  }
+
+  cleanup_workers();
+  DBUG_RETURN(rc);
+}
@@ -0,0 +1,279 @@
+#ifndef SQL_PARALLEL_SCAN_INCLUDED
+#define SQL_PARALLEL_SCAN_INCLUDED
+
+/*
+   Copyright (c) 2014, Monty Program Ab
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/**
+  @file
+
+  @brief
+  Parallel scan of a single table for queries with aggregate functions
+  and without GROUP BY
+*/
+
+#include "sql_select.h"
+#include "sql_task_pool.h"
+
+/* Maximum number of threads reading a table in a parallel scan */
+#define PARALLEL_SCAN_MAX_WORKERS 64
+
+/* A range of index entries is not split if it has less rows than this */
+#define PARALLEL_SCAN_MIN_RANGE_ROWS 1000
+
+/* How often (in rows) a worker checks whether the query has been killed */
+#define PARALLEL_SCAN_KILL_CHECK_ROWS 1024
+
+class Parallel_scan;
+
+
+/*
+  A conjunct of the WHERE condition of the form 'field op const'.
+  The workers evaluate it directly on the rows they read.
+*/
+
+struct Parallel_scan_cond
+{
+  enum cond_type {EQ, NE, LT, LE, GT, GE, IS_NULL, IS_NOT_NULL} type;
+  Field *field;
+  /* Offset of the field in the record */
+  uint offset;
+  uint field_index;
+  /* The record that contains the constant at 'offset' */
+  uchar *value;
+};
+
+
+/* An aggregate function computed by the workers */
+
+struct Parallel_scan_sum
+{
+  Item_sum *item;
+  Item_sum::Sumfunctype type;
+  /* The argument of the function, 0 for COUNT(*) */
+  Field *field;
+  uint offset;
+  uint field_index;
+  /* TRUE <=> SUM()/AVG() accumulates decimals, otherwise doubles */
+  bool decimal_sum;
+};
+
+
+/* The partial result of an aggregate function computed by one worker */
+
+struct Parallel_scan_partial :public Sql_alloc
+{
+  /* Number of non-NULL values aggregated so far */
+  ulonglong count;
+  double sum;
+  my_decimal dec_buffs[2];
+  uint curr_dec_buff;
+  /* The record with the current MIN()/MAX() value */
+  uchar *row;
+  /* The sketch of APPROX_COUNT_DISTINCT() */
+  uchar *sketch;
+
+  Parallel_scan_partial()
+    :count(0), sum(0.0), curr_dec_buff(0), row(0), sketch(0)
+  {
+    my_decimal_set_zero(dec_buffs);
+  }
+};
+
+
+/*
+  A range of a parallel scan
+
+  Each worker reads a range of the index entries of the scan through an
+  instance of the table of its own, opened from the TABLE_SHARE of the
+  scanned table by open_table_from_share(). The worker owns that TABLE,
+  its Field objects, record buffers and handler: a worker never reads or
+  changes a Field or handler of the statement's TABLE or of another
+  worker. The range is read by a thread of the task pool (see
+  run_pool_tasks()), whose THD is the in_use of the worker's TABLE and
+  takes the external lock of the worker's handler while the range is read.
+  The range is [start_key, end_record) or, for the last worker,
+  [start_key, end_record].
+*/
+
+class Parallel_scan_worker :public Pool_task, public Sql_alloc
+{
+public:
+  Parallel_scan *scan;
+  TABLE *table;
+  /* Start of the range in the key format, 0 means the first index entry */
+  uchar *start_key;
+  /* The record with the end of the range, 0 means the last index entry */
+  uchar *end_record;
+  bool end_inclusive;
+  Parallel_scan_partial *partials;
+  ha_rows rows_read;
+  ha_rows rows_matched;
+  int error;
+  /*
+    TRUE <=> the range was read by a thread of the pool, whose status
+    counters are in status_var and are added to the statement's THD
+  */
+  bool pool_thread;
+  STATUS_VAR status_var;
+
+  Parallel_scan_worker()
+    :scan(0), table(0), start_key(0), end_record(0), end_inclusive(FALSE),
+     partials(0), rows_read(0), rows_matched(0), error(0), pool_thread(FALSE)
+  {}
+
+  void run(THD *thd);
+  int scan_range();
+};
+
+
+/*
+  Parallel scan of a single table with aggregation
+
+  The scan is chosen at the end of the optimization of a join over one
+  table with aggregate functions and without GROUP BY when all of the
+  following holds:
+  - the session allows more than one worker (@@parallel_scan_workers),
+  - the engine supports concurrent reads through handler clones
+    (HA_CAN_PARALLEL_SCAN),
+  - the table has an index whose first component is an integer column,
+  - every aggregate function is COUNT(), SUM(), AVG(), MIN(), MAX() or
+    APPROX_COUNT_DISTINCT() without DISTINCT over a column of the table
+    or, for COUNT(), a non-NULL constant,
+  - the WHERE condition is a conjunction of comparisons of integer
+    columns with constants, and no column is referenced outside of an
+    aggregate function.
+
+  At execution the index is split into ranges with about the same number
+  of rows as estimated by handler::records_in_range(). Each range is read
+  by a separate worker that computes the partial results of all aggregate
+  functions, and the partial results are merged into the Item_sum objects
+  before the only row of the result is sent by end_send_group().
+*/
+
+class Parallel_scan :public Sql_alloc
+{
+  JOIN *join;
+  TABLE *table;
+  /* The index whose entries are split into ranges */
+  uint keyno;
+  KEY *key_info;
+  /* The first component of the index */
+  Field *key_field;
+  uint key_offset;
+  uint key_field_index;
+  /* TRUE <=> all columns used by the query are in the index */
+  bool keyread;
+
+  Parallel_scan_cond *conds, *conds_end;
+  Parallel_scan_sum *sums, *sums_end;
+
+  /*
+    The bounds of the values of key_field following from the conditions,
+    0 if there are no such bounds.
+  */
+  uchar *min_value, *max_value;
+
+  /* Number of ranges the scan is planned to be split into */
+  uint planned_workers;
+
+  Parallel_scan_worker *workers;
+  uint worker_count;
+
+  Parallel_scan(JOIN *join_arg, TABLE *table_arg)
+    :join(join_arg), table(table_arg), conds(0), conds_end(0),
+     sums(0), sums_end(0), min_value(0), max_value(0), workers(0),
+     worker_count(0)
+  {}
+
+  bool add_cond(Item *cond);
+  bool add_cmp_cond(Parallel_scan_cond::cond_type type, Item *field_arg,
+                    Item *value_arg);
+  bool add_sum(Item_sum *item, Parallel_scan_sum *sum);
+  bool choose_index();
+  void get_key_bounds(uchar **min_rec, uchar **max_rec);
+  ha_rows estimate_rows(uint key, uchar *min_rec, uchar *max_rec,
+                        bool max_inclusive);
+  uchar *alloc_record(ulonglong value);
+  uchar *make_key(uint key, uchar *rec);
+  bool split_ranges(ulonglong **bounds, uint *count);
+  bool read_key_domain(ulonglong *min_val, ulonglong *max_val, bool *empty);
+  bool init_workers();
+  void cleanup_workers();
+  void merge_partials();
+
+public:
+  static Parallel_scan *create(JOIN *join);
+
+  /* Check the conditions on the current record of a worker's table */
+  bool check_row(TABLE *worker_table)
+  {
+    for (Parallel_scan_cond *cond= conds; cond != conds_end; cond++)
+    {
+      Field *field= worker_table->field[cond->field_index];
+      int cmp;
+      if (field->is_null())
+      {
+        if (cond->type != Parallel_scan_cond::IS_NULL)
+          return FALSE;
+        continue;
+      }
+      switch (cond->type) {
+      case Parallel_scan_cond::IS_NULL:
+        return FALSE;
+      case Parallel_scan_cond::IS_NOT_NULL:
+        continue;
+      default:
+        break;
+      }
+      cmp= field->cmp(field->ptr, cond->value + cond->offset);
+      switch (cond->type) {
+      case Parallel_scan_cond::EQ: if (cmp != 0) return FALSE; break;
+      case Parallel_scan_cond::NE: if (cmp == 0) return FALSE; break;
+      case Parallel_scan_cond::LT: if (cmp >= 0) return FALSE; break;
+      case Parallel_scan_cond::LE: if (cmp > 0) return FALSE; break;
+      case Parallel_scan_cond::GT: if (cmp <= 0) return FALSE; break;
+      case Parallel_scan_cond::GE: if (cmp < 0) return FALSE; break;
+      default: break;
+      }
+    }
+    return TRUE;
+  }
+
+  void add_row(Parallel_scan_partial *partials, TABLE *worker_table);
+
+  /*
+    TRUE <=> the key value of the current record of a worker's table is
+    beyond the end of the range that ends at end_rec
+  */
+  bool after_range_end(TABLE *worker_table, const uchar *end_rec,
+                       bool inclusive)
+  {
+    Field *field= worker_table->field[key_field_index];
+    int cmp;
+    if (field->is_null())
+      return FALSE;
+    cmp= field->cmp(field->ptr, end_rec + key_offset);
+    return inclusive ? cmp > 0 : cmp >= 0;
+  }
+
+  uint get_keyno() const { return keyno; }
+  THD *get_thd() const { return join->thd; }
+
+  enum_nested_loop_state exec();
+};
+
+#endif /* SQL_PARALLEL_SCAN_INCLUDED */
@@ -3567,7 +3567,12 @@ end_with_restore_list:
     unit->set_limit(select_lex);
 
     MYSQL_DELETE_START(thd->query());
-    if (!(sel_result= lex->result) && !(sel_result= new select_send()))
+    /* ANALYZE DELETE ... RETURNING sends the EXPLAIN output, not the rows */
+    if (lex->analyze_stmt)
+      sel_result= new select_send_analyze();
+    else if (!(sel_result= lex->result))
+      sel_result= new select_send();
+    if (!sel_result)
       return 1;                       
     res = mysql_delete(thd, all_tables, 
                        select_lex->where, &select_lex->order_list,
@@ -3627,7 +3632,7 @@ end_with_restore_list:
           result->abort_result_set(); /* for both DELETE and EXPLAIN DELETE */
         else
         {
-          if (explain)
+          if (explain || lex->analyze_stmt)
             res= thd->lex->explain->send_explain(thd);
         }
         delete result;
@@ -5217,7 +5222,7 @@ static bool execute_sqlcom_select(THD *thd, TABLE_LIST *all_tables)
       */
       if (!(result= new select_send()))
         return 1;                               /* purecov: inspected */
-      thd->send_explain_fields(result);
+      thd->send_explain_fields(result, lex->describe, lex->explain_json);
         
       /*
         This will call optimize() for all parts of query. The query plan is
@@ -5233,7 +5238,10 @@ static bool execute_sqlcom_select(THD *thd, TABLE_LIST *all_tables)
           top-level LIMIT
         */        
         result->reset_offset_limit(); 
-        thd->lex->explain->print_explain(result, thd->lex->describe);
+        if (lex->explain_json)
+          thd->lex->explain->print_explain_json(result, false);
+        else
+          thd->lex->explain->print_explain(result, thd->lex->describe);
         if (lex->describe & DESCRIBE_EXTENDED)
         {
           char buff[1024];
@@ -5255,6 +5263,19 @@ static bool execute_sqlcom_select(THD *thd, TABLE_LIST *all_tables)
         result->send_eof();
       delete result;
     }
+    else if (lex->analyze_stmt)
+    {
+      /*
+        Run the query without sending its rows, then send the EXPLAIN
+        output with the counters collected while it ran.
+      */
+      if (!(result= new select_send_analyze()))
+        return 1;                               /* purecov: inspected */
+      res= handle_select(thd, lex, result, 0);
+      if (!res)
+        res= thd->lex->explain->send_explain(thd);
+      delete result;
+    }
     else
     {
       if (!result && !(result= new select_send()))
@@ -1537,7 +1537,7 @@ static int mysql_test_select(Prepared_statement *stmt,
   */
   if (unit->prepare(thd, 0, 0))
     goto error;
-  if (!lex->describe && !stmt->is_sql_prepare())
+  if (!lex->describe && !lex->analyze_stmt && !stmt->is_sql_prepare())
   {
     /* Make copy of item list, as change_columns may change it */
     List<Item> fields(lex->select_lex.item_list);
@@ -3763,7 +3763,7 @@ bool Prepared_statement::validate_metadata(Prepared_statement *copy)
     return FALSE -- the metadata of the original SELECT,
     if any, has not been sent to the client.
   */
-  if (is_sql_prepare() || lex->describe)
+  if (is_sql_prepare() || lex->describe || lex->analyze_stmt)
     return FALSE;
 
   if (lex->select_lex.item_list.elements !=
@@ -230,7 +230,16 @@ template <class T> bool valid_buffer_range(T jump,
 #define OPTIMIZER_SWITCH_TABLE_ELIMINATION         (1ULL << 26)
 #define OPTIMIZER_SWITCH_EXTENDED_KEYS             (1ULL << 27)
 #define OPTIMIZER_SWITCH_EXISTS_TO_IN              (1ULL << 28)
-#define OPTIMIZER_SWITCH_USE_CONDITION_SELECTIVITY (1ULL << 29)
+#define OPTIMIZER_SWITCH_JOIN_CACHE_GRACE          (1ULL << 29)
+#define OPTIMIZER_SWITCH_MERGE_JOIN                (1ULL << 30)
+#define OPTIMIZER_SWITCH_SKIP_SCAN                 (1ULL << 31)
+#define OPTIMIZER_SWITCH_BATCH_CONDITION           (1ULL << 32)
+#define OPTIMIZER_SWITCH_HASH_AGGREGATE            (1ULL << 33)
+#define OPTIMIZER_SWITCH_JOIN_CACHE_BLOOM_FILTER   (1ULL << 34)
+#define OPTIMIZER_SWITCH_REUSE_JOIN_ORDER          (1ULL << 35)
+#define OPTIMIZER_SWITCH_COND_PUSHDOWN_FOR_DERIVED (1ULL << 36)
+#define OPTIMIZER_SWITCH_UNION_ALL_STREAMING       (1ULL << 37)
+#define OPTIMIZER_SWITCH_USE_CONDITION_SELECTIVITY (1ULL << 38)
 
 #define OPTIMIZER_SWITCH_DEFAULT   (OPTIMIZER_SWITCH_INDEX_MERGE | \
                                     OPTIMIZER_SWITCH_INDEX_MERGE_UNION | \
@@ -336,6 +336,19 @@ PROFILING::~PROFILING()
     delete current;
 }
 
+/**
+  Forget all the profiles, for a THD that is reused by a new connection.
+*/
+void PROFILING::restart()
+{
+  while (! history.is_empty())
+    delete history.pop();
+
+  delete current;
+  current= last= NULL;
+  profile_id_counter= 1;
+}
+
 /**
   A new state is given, and that signals the profiler to start a new
   timed step for the current query's profile.
@@ -268,6 +268,7 @@ private:
 public:
   PROFILING();
   ~PROFILING();
+  void restart();
   void set_query_source(char *query_source_arg, uint query_length_arg);
 
   void start_new_query(const char *initial_state= "starting");
@@ -52,6 +52,9 @@
 #include "log_slow.h"
 #include "sql_derived.h"
 #include "sql_statistics.h"
+#include "sql_parallel_scan.h"
+#include "sql_batch_cond.h"
+#include "sql_hash_aggregate.h"
 
 #include "debug_sync.h"          // DEBUG_SYNC
 #include <m_ctype.h>
@@ -86,6 +89,8 @@ void best_access_path(JOIN *join, JOIN_TAB *s,
                              bool disable_jbuf, double record_count,
                              POSITION *pos, POSITION *loose_scan_pos);
 static void optimize_straight_join(JOIN *join, table_map join_tables);
+static bool reuse_saved_join_order(JOIN *join, table_map join_tables);
+static void save_join_order(JOIN *join);
 static bool greedy_search(JOIN *join, table_map remaining_tables,
                           uint depth, uint prune_level,
                           uint use_cond_selectivity);
@@ -158,7 +163,8 @@ bool const_expression_in_where(COND *conds,Item *item, Item **comp_item);
 static int do_select(JOIN *join,List<Item> *fields,TABLE *tmp_table,
 		     Procedure *proc);
 
-static enum_nested_loop_state evaluate_join_record(JOIN *, JOIN_TAB *, int);
+static enum_nested_loop_state evaluate_join_record(JOIN *, JOIN_TAB *, int,
+                                                   bool cond_checked= FALSE);
 static enum_nested_loop_state
 evaluate_null_complemented_join_record(JOIN *join, JOIN_TAB *join_tab);
 static enum_nested_loop_state
@@ -169,6 +175,8 @@ static enum_nested_loop_state
 end_update(JOIN *join, JOIN_TAB *join_tab, bool end_of_records);
 static enum_nested_loop_state
 end_unique_update(JOIN *join, JOIN_TAB *join_tab, bool end_of_records);
+static enum_nested_loop_state
+end_hash_update(JOIN *join, JOIN_TAB *join_tab, bool end_of_records);
 
 static int test_if_group_changed(List<Cached_item> &list);
 static int join_read_const_table(JOIN_TAB *tab, POSITION *pos);
@@ -177,6 +185,8 @@ static int join_read_const(JOIN_TAB *tab);
 static int join_read_key(JOIN_TAB *tab);
 static void join_read_key_unlock_row(st_join_table *tab);
 static int join_read_always_key(JOIN_TAB *tab);
+static int join_read_merge_key(JOIN_TAB *tab);
+static int join_read_merge_next(READ_RECORD *info);
 static int join_read_last_key(JOIN_TAB *tab);
 static int join_no_more_records(READ_RECORD *info);
 static int join_read_next(READ_RECORD *info);
@@ -1077,6 +1087,22 @@ JOIN::optimize_inner()
   set_allowed_join_cache_types();
   need_distinct= TRUE;
 
+  /*
+    Push the conditions over the columns of materialized derived tables
+    into them before they are optimized.
+  */
+  if (optimizer_flag(thd, OPTIMIZER_SWITCH_COND_PUSHDOWN_FOR_DERIVED) && conds)
+  {
+    List_iterator_fast<TABLE_LIST> li(select_lex->leaf_tables);
+    TABLE_LIST *tbl;
+    while ((tbl= li++))
+    {
+      if (tbl->is_materialized_derived() &&
+          pushdown_cond_for_derived(thd, conds, tbl))
+        DBUG_RETURN(1);
+    }
+  }
+
   /* Run optimize phase for all derived tables/views used in this SELECT. */
   if (select_lex->handle_derived(thd->lex, DT_OPTIMIZE))
     DBUG_RETURN(1);
@@ -1188,6 +1214,11 @@ TODO: make view to decide if it is possible to write to WHERE directly or make S
     if (arena)
       thd->restore_active_arena(arena, &backup);
   }
+
+  /* Add the conditions pushed from the SELECT that uses this derived table */
+  if (!pushed_where.is_empty() &&
+      add_conds_for_derived(thd, &conds, pushed_where))
+    DBUG_RETURN(1);
   
   if (setup_jtbm_semi_joins(this, join_list, &conds))
     DBUG_RETURN(1);
@@ -1870,6 +1901,9 @@ TODO: make view to decide if it is possible to write to WHERE directly or make S
     }
   }
 
+  /* Check whether the only table can be read by several threads */
+  parallel_scan= Parallel_scan::create(this);
+
   tmp_having= having;
   if (select_options & SELECT_DESCRIBE)
   {
@@ -3338,7 +3372,7 @@ static ha_rows get_quick_record_count(THD *thd, SQL_SELECT *select,
     select->head=table;
     table->reginfo.impossible_range=0;
     if ((error= select->test_quick_select(thd, *(key_map *)keys,(table_map) 0,
-                                          limit, 0, FALSE)) == 1)
+                                          limit, 0, FALSE, TRUE)) == 1)
       DBUG_RETURN(select->quick->records);
     if (error == -1)
     {
@@ -3921,7 +3955,12 @@ make_join_statistics(JOIN *join, List<TABLE_LIST> &tables_list,
       bool impossible_range= FALSE;
       ha_rows records= HA_POS_ERROR;
       SQL_SELECT *select= 0;
-      if (!s->const_keys.is_clear_all())
+      /*
+        A skip scan can use indexes that are not in const_keys, see
+        SQL_SELECT::test_quick_select()
+      */
+      if (!s->const_keys.is_clear_all() ||
+          optimizer_flag(join->thd, OPTIMIZER_SWITCH_SKIP_SCAN))
       {
         select= make_select(s->table, found_const_table_map,
 			    found_const_table_map,
@@ -4015,8 +4054,12 @@ make_join_statistics(JOIN *join, List<TABLE_LIST> &tables_list,
     /* Find an optimal join order of the non-constant tables. */
     if (join->const_tables != join->table_count)
     {
-      if (choose_plan(join, all_table_map & ~join->const_table_map))
-        goto error;
+      if (!reuse_saved_join_order(join, all_table_map & ~join->const_table_map))
+      {
+        if (choose_plan(join, all_table_map & ~join->const_table_map))
+          goto error;
+        save_join_order(join);
+      }
     }
     else
     {
@@ -5554,6 +5597,7 @@ void set_position(JOIN *join,uint idx,JOIN_TAB *table,KEYUSE *key)
 //  join->positions[idx].loosescan_key= MAX_KEY; /* Not a LooseScan */
   join->positions[idx].sj_strategy= SJ_OPT_NONE;
   join->positions[idx].use_join_buffer= FALSE;
+  join->positions[idx].use_merge_join= FALSE;
 
   /* Move the const table as down as possible in best_ref */
   JOIN_TAB **pos=join->best_ref+idx+1;
@@ -5625,6 +5669,98 @@ double matching_candidates_in_table(JOIN_TAB *s, bool with_found_constraint,
 }
 
 
+/**
+  @brief
+  Get the index whose order the rows of a table are retrieved in by a scan
+
+  @param tab  the table to be scanned
+
+  @details
+  A range scan returns rows in the order of the index it is performed over.
+  A full scan of a table with a clustered primary key returns rows in the
+  order of the primary key.
+
+  @return
+    the number of the index, or MAX_KEY if no order is known for the scan
+*/
+
+static uint get_scan_order_key(JOIN_TAB *tab)
+{
+  TABLE *table= tab->table;
+  if (tab->quick)
+  {
+    return tab->quick->get_type() == QUICK_SELECT_I::QS_TYPE_RANGE ?
+           tab->quick->index : MAX_KEY;
+  }
+  if (table->s->primary_key != MAX_KEY &&
+      table->file->primary_key_is_clustered())
+    return table->s->primary_key;
+  return MAX_KEY;
+}
+
+
+/**
+  @brief
+  Check whether ref access to a table can be performed as a merge join
+
+  @param join       the join being optimized
+  @param s          the table to be accessed by ref
+  @param start_key  the first KEYUSE element for the ref key
+  @param idx        the length of the partial plan
+
+  @details
+  The function checks whether the rows of the partial plan are expected to
+  come ordered by the value the first key part of the ref key is compared
+  with. At present this is checked only when the partial plan consists of
+  one table scanned in the order of an index whose first column is used
+  to build the ref key. The columns must be compared in the same way.
+
+  @note
+  The ordering is only a precondition for the cost estimate: the merge
+  join read functions check the order of the lookup keys and fall back to
+  index lookups when the keys come unordered.
+
+  @retval TRUE   merge join can be used
+  @retval FALSE  otherwise
+*/
+
+static bool merge_join_is_possible(JOIN *join, JOIN_TAB *s, KEYUSE *start_key,
+                                   uint idx)
+{
+  TABLE *table= s->table;
+  uint key= start_key->key;
+
+  if (!optimizer_flag(join->thd, OPTIMIZER_SWITCH_MERGE_JOIN) ||
+      idx != join->const_tables + 1 || start_key->keypart != 0)
+    return FALSE;
+  if (!(table->file->index_flags(key, 0, 1) & HA_READ_ORDER))
+    return FALSE;
+
+  POSITION *prev= join->positions + idx - 1;
+  uint order_key;
+  if (prev->key || (order_key= get_scan_order_key(prev->table)) == MAX_KEY)
+    return FALSE;
+
+  Field *order_field= prev->table->table->key_info[order_key].key_part[0].field;
+  Field *key_field= table->key_info[key].key_part[0].field;
+  if (order_field->cmp_type() != key_field->cmp_type() ||
+      (order_field->cmp_type() == STRING_RESULT &&
+       order_field->charset() != key_field->charset()))
+    return FALSE;
+
+  for (KEYUSE *keyuse= start_key;
+       keyuse->table == table && keyuse->key == key && keyuse->keypart == 0;
+       keyuse++)
+  {
+    Item *val= keyuse->val->real_item();
+    if (val->type() == Item::FIELD_ITEM &&
+        ((Item_field *) val)->field->eq(order_field))
+      return TRUE;
+  }
+  return FALSE;
+}
+
+
 /**
   Find the best access path for an extension of a partial execution
   plan and add this path to the plan.
@@ -5675,6 +5811,7 @@ best_access_path(JOIN      *join,
   double tmp;
   ha_rows rec;
   bool best_uses_jbuf= FALSE;
+  bool best_uses_merge= FALSE;
   MY_BITMAP *eq_join_set= &s->table->eq_join_set;
   KEYUSE *hj_start_key= 0;
 
@@ -5710,6 +5847,7 @@ best_access_path(JOIN      *join,
       key_part_map const_part= 0;
       /* The or-null keypart in ref-or-null access: */
       key_part_map ref_or_null_part= 0;
+      bool merge_join= FALSE;
       if (is_hash_join_key_no(key))
       {
         /* 
@@ -6061,6 +6199,28 @@ best_access_path(JOIN      *join,
             tmp= best_time;                    // Do nothing
         }
 
+        /*
+          If the rows of the join prefix come ordered by the first key part
+          of the ref key, all lookups can be served by one forward pass
+          over the index (merge join). Each row of the index is read at most
+          once then, while every lookup costs only a key comparison.
+        */
+        if (found_ref && (found_part & 1) && !ref_or_null_part &&
+            merge_join_is_possible(join, s, start_key, idx))
+        {
+          double merge_tmp;
+          if (table->covering_keys.is_set(key))
+            merge_tmp= table->file->keyread_time(key, 1, s->records);
+          else
+            merge_tmp= table->file->read_time(key, 1, s->records);
+          merge_tmp+= record_count / (double) TIME_FOR_COMPARE;
+          if (merge_tmp < tmp)
+          {
+            tmp= merge_tmp;
+            merge_join= TRUE;
+          }
+        }
+
         tmp += s->startup_cost;
         loose_scan_opt.check_ref_access_part2(key, start_key, records, tmp);
       } /* not ft_key */
@@ -6072,6 +6232,7 @@ best_access_path(JOIN      *join,
         best_key= start_key;
         best_max_key_part= max_key_part;
         best_ref_depends_map= found_ref;
+        best_uses_merge= merge_join;
       }
     } /* for each key */
     records= best_records;
@@ -6251,6 +6412,8 @@ best_access_path(JOIN      *join,
   pos->ref_depend_map= best_ref_depends_map;
   pos->loosescan_picker.loosescan_key= MAX_KEY;
   pos->use_join_buffer= best_uses_jbuf;
+  pos->use_merge_join= best_uses_merge && best_key &&
+                       !best_key->is_for_hash_join();
    
   loose_scan_opt.save_to_position(s, loose_scan_pos);
 
@@ -6782,6 +6945,149 @@ optimize_straight_join(JOIN *join, table_map join_tables)
 }
 
 
+/*
+  The maximum ratio between an estimate and the value it had when the join
+  order was saved that still allows to reuse the saved join order
+*/
+#define JOIN_ORDER_REUSE_MAX_RATIO 2.0
+
+
+/**
+  Check whether the join order of a select can be saved and reused
+*/
+
+static bool can_reuse_join_order(JOIN *join)
+{
+  THD *thd= join->thd;
+  return optimizer_flag(thd, OPTIMIZER_SWITCH_REUSE_JOIN_ORDER) &&
+         !thd->stmt_arena->is_conventional() &&
+         !(join->select_options & SELECT_STRAIGHT_JOIN) &&
+         !join->emb_sjm_nest;
+}
+
+
+static bool join_order_estimates_are_close(ha_rows saved, ha_rows current)
+{
+  double a= (double) saved + 1.0;
+  double b= (double) current + 1.0;
+  return a <= b * JOIN_ORDER_REUSE_MAX_RATIO &&
+         b <= a * JOIN_ORDER_REUSE_MAX_RATIO;
+}
+
+
+/**
+  Build the query plan in the join order saved by a previous execution.
+
+  When a prepared statement or a statement of a stored procedure is
+  executed again the join order of its select found by the last full
+  search is used if:
+  - the same tables are not constant,
+  - the estimated number of records to be read from each table after
+    the range analysis and the number of records in each table differ
+    from the values the search was based on by less than
+    JOIN_ORDER_REUSE_MAX_RATIO times.
+  The access methods for the tables are chosen anew by
+  optimize_straight_join(), as they depend on the values of the parameters,
+  while the cost of the search for the join order is saved.
+
+  @param join         pointer to the structure providing all context info for
+                      the query
+  @param join_tables  set of the non-constant tables in the query
+
+  @retval
+    TRUE        the plan has been built in the saved join order
+  @retval
+    FALSE       the saved join order cannot be used, a search is needed
+*/
+
+static bool reuse_saved_join_order(JOIN *join, table_map join_tables)
+{
+  Saved_join_order *saved= join->select_lex->saved_join_order;
+  JOIN_TAB **tabs= join->best_ref + join->const_tables;
+  uint i, j;
+  DBUG_ENTER("reuse_saved_join_order");
+
+  if (!saved || !can_reuse_join_order(join) ||
+      saved->tables != join->table_count - join->const_tables)
+    DBUG_RETURN(FALSE);
+
+  for (i= 0; i < saved->tables; i++)
+  {
+    for (j= i; j < saved->tables; j++)
+    {
+      if (tabs[j]->table->pos_in_table_list == saved->order[i])
+        break;
+    }
+    if (j == saved->tables ||
+        !join_order_estimates_are_close(saved->found_records[i],
+                                        tabs[j]->found_records) ||
+        !join_order_estimates_are_close(saved->stat_records[i],
+                                        tabs[j]->table->stat_records()))
+    {
+      DBUG_PRINT("info", ("saved join order is not reused at table %u", i));
+      DBUG_RETURN(FALSE);
+    }
+    swap_variables(JOIN_TAB*, tabs[i], tabs[j]);
+  }
+
+  join->cur_embedding_map= 0;
+  join->cur_dups_producing_tables= 0;
+  reset_nj_counters(join, join->join_list);
+  join->cur_sj_inner_tables= 0;
+  optimize_straight_join(join, join_tables);
+  if (join->thd->lex->is_single_level_stmt())
+    join->thd->status_var.last_query_cost= join->best_read;
+  DBUG_PRINT("info", ("saved join order is reused"));
+  DBUG_RETURN(TRUE);
+}
+
+
+/**
+  Save the join order chosen by a full search of the join optimizer
+
+  The order is saved in the SELECT_LEX on the memory of the statement, so
+  that it can be reused by reuse_saved_join_order() when the statement is
+  executed again.
+*/
+
+static void save_join_order(JOIN *join)
+{
+  THD *thd= join->thd;
+  Saved_join_order *saved= join->select_lex->saved_join_order;
+  uint tables= join->table_count - join->const_tables;
+
+  if (!can_reuse_join_order(join))
+    return;
+
+  if (!saved || saved->max_tables < tables)
+  {
+    MEM_ROOT *mem_root= thd->stmt_arena->mem_root;
+    if (!(saved= new (mem_root) Saved_join_order) ||
+        !(saved->order=
+            (TABLE_LIST**) alloc_root(mem_root, sizeof(TABLE_LIST*)*tables)) ||
+        !(saved->found_records=
+            (ha_rows*) alloc_root(mem_root, sizeof(ha_rows)*tables)) ||
+        !(saved->stat_records=
+            (ha_rows*) alloc_root(mem_root, sizeof(ha_rows)*tables)))
+    {
+      join->select_lex->saved_join_order= 0;
+      return;
+    }
+    saved->max_tables= tables;
+    join->select_lex->saved_join_order= saved;
+  }
+
+  saved->tables= tables;
+  for (uint i= 0; i < tables; i++)
+  {
+    JOIN_TAB *tab= join->best_positions[join->const_tables + i].table;
+    saved->order[i]= tab->table->pos_in_table_list;
+    saved->found_records[i]= tab->found_records;
+    saved->stat_records[i]= tab->table->stat_records();
+  }
+}
+
+
 /**
   Find a good, possibly optimal, query execution plan (QEP) by a greedy search.
 
@@ -7994,6 +8300,36 @@ bool JOIN_TAB::hash_join_is_possible()
 }
 
 
+/**
+  @brief
+  Check whether Grace partitioning can be used by a hash join with this table
+
+  @details
+  A BNLH join cache with Grace partitioning saves the records of this table
+  and the partial join records from the join buffer into temporary files.
+  This is possible only when the records of the table do not contain blobs.
+  The function also returns FALSE if the table is an inner table of an outer
+  join or of a semi-join, as the records from the join buffer need match
+  flags in these cases.
+
+  @note
+  The presence of blob columns among the columns of the previous tables
+  stored in the join buffer is checked when the join buffer becomes full.
+
+  @retval TRUE    it's possible to use Grace partitioning for this table
+  @retval FALSE   otherwise
+*/
+
+bool JOIN_TAB::grace_hash_join_is_possible()
+{
+  if (first_inner || emb_sj_nest || first_sj_inner_tab || bush_root_tab)
+    return FALSE;
+  if (check_only_first_match())
+    return FALSE;
+  return !table->s->blob_fields;
+}
+
+
 static uint
 cache_record_length(JOIN *join,uint idx)
 {
@@ -8449,6 +8785,9 @@ get_best_combination(JOIN *join)
     if (keyuse && create_ref_for_key(join, j, keyuse, TRUE, used_tables))
       DBUG_RETURN(TRUE);                        // Something went wrong
 
+    j->use_merge_join= join->best_positions[tablenr].use_merge_join &&
+                       (j->type == JT_REF || j->type == JT_EQ_REF);
+
     if ((j->type == JT_REF || j->type == JT_EQ_REF) &&
         is_hash_join_key_no(j->ref.key))
       join->hash_join= TRUE; 
@@ -9619,7 +9958,7 @@ make_join_select(JOIN *join,SQL_SELECT *select,COND *cond)
 					OPTION_FOUND_ROWS ?
 					HA_POS_ERROR :
 					join->unit->select_limit_cnt), 0,
-                                        FALSE) < 0)
+                                        FALSE, TRUE) < 0)
             {
 	      /*
 		Before reporting "Impossible WHERE" for the whole query
@@ -9633,7 +9972,7 @@ make_join_select(JOIN *join,SQL_SELECT *select,COND *cond)
                                           OPTION_FOUND_ROWS ?
                                           HA_POS_ERROR :
                                           join->unit->select_limit_cnt),0,
-                                          FALSE) < 0)
+                                          FALSE, TRUE) < 0)
 		DBUG_RETURN(1);			// Impossible WHERE
             }
             else
@@ -10144,6 +10483,12 @@ pick_table_access_method(JOIN_TAB *tab)
   switch (tab->type) 
   {
   case JT_REF:
+    if (tab->use_merge_join)
+    {
+      tab->read_first_record= join_read_merge_key;
+      tab->read_record.read_record= join_read_merge_next;
+      break;
+    }
     tab->read_first_record= join_read_always_key;
     tab->read_record.read_record= join_read_next_same;
     break;
@@ -10159,6 +10504,12 @@ pick_table_access_method(JOIN_TAB *tab)
     break;
 
   case JT_EQ_REF:
+    if (tab->use_merge_join)
+    {
+      tab->read_first_record= join_read_merge_key;
+      tab->read_record.read_record= join_read_merge_next;
+      break;
+    }
     tab->read_first_record= join_read_key;
     tab->read_record.read_record= join_no_more_records;
     break;
@@ -10355,6 +10706,12 @@ end_sj_materialize(JOIN *join, JOIN_TAB *join_tab, bool end_of_records)
     join_cache_level==7|8 then a JOIN_CACHE_BKAH object is employed. 
     If the value of join_cache_level is odd then creation of a non-linked 
     join cache is forced.
+    If the optimizer switch join_cache_grace is on and the records of
+    the joined table can be saved into temporary files then a
+    JOIN_CACHE_BNLHG object is employed instead of a JOIN_CACHE_BNLH object.
+    Such a cache is never linked. When its join buffer becomes full it
+    partitions the records of both join operands into temporary files
+    and joins the partitions one by one (Grace hash join).
 
     Currently for any join operation a join cache of the  level of the
     highest allowed and applicable level is used.
@@ -10441,6 +10798,8 @@ uint check_join_cache_usage(JOIN_TAB *tab,
          !(join->allowed_join_cache_types & JOIN_CACHE_HASHED_BIT);
   bool no_bka_cache= 
          !(join->allowed_join_cache_types & JOIN_CACHE_BKA_BIT);
+  bool no_grace_cache=
+         !(join->allowed_join_cache_types & JOIN_CACHE_GRACE_BIT);
 
   join->return_tab= 0;
 
@@ -10460,6 +10819,9 @@ uint check_join_cache_usage(JOIN_TAB *tab,
   if (tab->use_quick == 2)
     goto no_join_cache;
 
+  if (tab->use_merge_join)
+    goto no_join_cache;
+
   if (tab->table->map & join->complex_firstmatch_tables)
     goto no_join_cache;
   
@@ -10575,7 +10937,14 @@ uint check_join_cache_usage(JOIN_TAB *tab,
         goto no_join_cache;
       if (cache_level == 3)
         prev_cache= 0;
-      if ((tab->cache= new JOIN_CACHE_BNLH(join, tab, prev_cache)) &&
+      if (!no_grace_cache && tab->grace_hash_join_is_possible())
+      {
+        prev_cache= 0;
+        tab->cache= new JOIN_CACHE_BNLHG(join, tab);
+      }
+      else
+        tab->cache= new JOIN_CACHE_BNLH(join, tab, prev_cache);
+      if (tab->cache &&
           ((options & SELECT_DESCRIBE) || !tab->cache->init()))
       {
         tab->icp_other_tables_ok= FALSE;        
@@ -10741,7 +11110,8 @@ void JOIN_TAB::remove_redundant_bnl_scan_conds()
 {
   if (!(select_cond && cache_select && cache &&
         (cache->get_join_alg() == JOIN_CACHE::BNL_JOIN_ALG ||
-         cache->get_join_alg() == JOIN_CACHE::BNLH_JOIN_ALG)))
+         cache->get_join_alg() == JOIN_CACHE::BNLH_JOIN_ALG ||
+         cache->get_join_alg() == JOIN_CACHE::BNLHG_JOIN_ALG)))
     return;
 
   /*
@@ -10805,6 +11175,47 @@ void JOIN_TAB::remove_redundant_bnl_scan_conds()
 }
 
 
+/*
+  Prepare a table to be accessed by ref through a merge join
+
+  SYNOPSIS
+    init_merge_join()
+      tab  join table accessed by ref
+
+  DESCRIPTION
+    The function allocates the buffers used by the merge join read functions
+    for the table. Merge join is not used when the read rows are locked, as
+    the rows with the keys between the lookup keys would be locked too, or
+    when the ref access is triggered.
+
+  RETURN
+    FALSE  ok
+    TRUE   out of memory
+*/
+
+static bool init_merge_join(JOIN_TAB *tab)
+{
+  TABLE *table= tab->table;
+  uint key_length= table->s->max_key_length;
+
+  if (table->reginfo.lock_type >= TL_READ_WITH_SHARED_LOCKS ||
+      tab->ref.is_access_triggered() || tab->cache)
+  {
+    tab->use_merge_join= FALSE;
+    return FALSE;
+  }
+  if (!(tab->merge_prev_key= (uchar*) tab->join->thd->alloc(2*key_length +
+                                                            table->s->reclength)))
+    return TRUE;
+  tab->merge_next_key= tab->merge_prev_key + key_length;
+  tab->merge_next_rec= tab->merge_next_key + key_length;
+  tab->merge_state= JOIN_TAB::MERGE_NOT_POSITIONED;
+  /* The rows must be read in the order of the index */
+  tab->sorted= TRUE;
+  return FALSE;
+}
+
+
 /*
   Plan refinement stage: do various setup things for the executor
 
@@ -10910,13 +11321,17 @@ make_join_readinfo(JOIN *join, ulonglong options, uint no_jbuf_after)
         return TRUE; /* purecov: inspected */
       tab->sorted= TRUE;
     }
+    if (tab->use_merge_join && init_merge_join(tab))
+      DBUG_RETURN(TRUE); /* purecov: inspected */
     table->status=STATUS_NO_RECORD;
     pick_table_access_method (tab);
 
     if (jcl)
        tab[-1].next_select=sub_select_cache;
 
-    if (tab->cache && tab->cache->get_join_alg() == JOIN_CACHE::BNLH_JOIN_ALG)
+    if (tab->cache &&
+        (tab->cache->get_join_alg() == JOIN_CACHE::BNLH_JOIN_ALG ||
+         tab->cache->get_join_alg() == JOIN_CACHE::BNLHG_JOIN_ALG))
       tab->type= JT_HASH;
       
     switch (tab->type) {
@@ -10932,12 +11347,14 @@ make_join_readinfo(JOIN *join, ulonglong options, uint no_jbuf_after)
         push_index_cond(tab, tab->ref.key);
       break;
     case JT_EQ_REF:
-      tab->read_record.unlock_row= join_read_key_unlock_row;
+      if (!tab->use_merge_join)
+        tab->read_record.unlock_row= join_read_key_unlock_row;
       /* fall through */
       if (table->covering_keys.is_set(tab->ref.key) &&
 	  !table->no_keyread)
         table->enable_keyread();
-      else if ((!jcl || jcl > 4) && !tab->ref.is_access_triggered())
+      else if ((!jcl || jcl > 4) && !tab->ref.is_access_triggered() &&
+               !tab->use_merge_join)
         push_index_cond(tab, tab->ref.key);
       break;
     case JT_REF_OR_NULL:
@@ -10952,7 +11369,8 @@ make_join_readinfo(JOIN *join, ulonglong options, uint no_jbuf_after)
       if (table->covering_keys.is_set(tab->ref.key) &&
 	  !table->no_keyread)
         table->enable_keyread();
-      else if ((!jcl || jcl > 4) && !tab->ref.is_access_triggered())
+      else if ((!jcl || jcl > 4) && !tab->ref.is_access_triggered() &&
+               !tab->use_merge_join)
         push_index_cond(tab, tab->ref.key);
       break;
     case JT_ALL:
@@ -11175,6 +11593,7 @@ void JOIN_TAB::cleanup()
     cache= 0;
   }
   limit= 0;
+  merge_state= MERGE_NOT_POSITIONED;
   if (table)
   {
     table->disable_keyread();
@@ -15458,6 +15877,7 @@ Field *create_tmp_field(THD *thd, TABLE *table,Item *item, Item::Type type,
   case Item::COND_ITEM:
   case Item::FIELD_AVG_ITEM:
   case Item::FIELD_STD_ITEM:
+  case Item::FIELD_APPROX_COUNT_DISTINCT_ITEM:
   case Item::SUBSELECT_ITEM:
     /* The following can only happen with 'CREATE TABLE ... SELECT' */
   case Item::PROC_ITEM:
@@ -17151,6 +17571,7 @@ do_select(JOIN *join,List<Item> *fields,TABLE *table,Procedure *procedure)
   int rc= 0;
   enum_nested_loop_state error= NESTED_LOOP_OK;
   JOIN_TAB *join_tab;
+  Hash_aggregate hash_agg;
   DBUG_ENTER("do_select");
   LINT_INIT(join_tab);
   
@@ -17175,6 +17596,14 @@ do_select(JOIN *join,List<Item> *fields,TABLE *table,Procedure *procedure)
   }
   /* Set up select_end */
   Next_select_func end_select= setup_end_select_func(join);
+  if (end_select == end_update && Hash_aggregate::is_applicable(join))
+  {
+    if (hash_agg.init(join))
+      DBUG_RETURN(-1);
+    DBUG_PRINT("info",("Using end_hash_update"));
+    end_select= end_hash_update;
+    join->hash_aggregate= &hash_agg;
+  }
   if (join->table_count)
   {
     join->join_tab[join->top_join_tab_count - 1].next_select= end_select;
@@ -17236,6 +17665,8 @@ do_select(JOIN *join,List<Item> *fields,TABLE *table,Procedure *procedure)
 
     if (join->outer_ref_cond && !join->outer_ref_cond->val_int())
       error= NESTED_LOOP_NO_MORE_ROWS;
+    else if (join->parallel_scan && end_select == end_send_group)
+      error= join->parallel_scan->exec();
     else
       error= sub_select(join,join_tab,0);
     if ((error == NESTED_LOOP_OK || error == NESTED_LOOP_NO_MORE_ROWS) &&
@@ -17247,6 +17678,14 @@ do_select(JOIN *join,List<Item> *fields,TABLE *table,Procedure *procedure)
   if (error == NESTED_LOOP_NO_MORE_ROWS || join->thd->killed == ABORT_QUERY)
     error= NESTED_LOOP_OK;
 
+  if (join->hash_aggregate)
+  {
+    /* Write the groups collected by end_hash_update() */
+    if (error == NESTED_LOOP_OK && hash_agg.end())
+      error= NESTED_LOOP_ERROR;
+    join->hash_aggregate= NULL;
+  }
+
   if (table)
   {
     int tmp, new_errno= 0;
@@ -17392,6 +17831,130 @@ sub_select_cache(JOIN *join, JOIN_TAB *join_tab, bool end_of_records)
   DBUG_RETURN(rc);
 }
 
+
+/**
+  Get the block evaluation of the condition attached to a table
+
+  @details
+    The condition attached to the table is evaluated over blocks of rows
+    (see Batch_cond) when the optimizer switch batch_condition is on, the
+    table is scanned (not read by ref access) and the rows of the table
+    can be read ahead of their processing: the statement reads the rows
+    without locking them and without the positions of the rows, the scan
+    is not stopped after the first match, and the table has no BLOB and
+    virtual columns, whose values are not in the record buffer.
+
+  @return
+    The object, or NULL if the condition is evaluated row by row or an
+    error occurred (thd->is_fatal_error is set then)
+*/
+
+static Batch_cond *get_batch_cond(JOIN *join, JOIN_TAB *tab)
+{
+  THD *thd= join->thd;
+  TABLE *table= tab->table;
+
+  if (!optimizer_flag(thd, OPTIMIZER_SWITCH_BATCH_CONDITION) ||
+      !tab->select_cond || (tab->type != JT_ALL && tab->type != JT_NEXT) ||
+      thd->lex->sql_command != SQLCOM_SELECT ||
+      table->reginfo.lock_type >= TL_READ_WITH_SHARED_LOCKS ||
+      table->s->blob_fields || table->vfield ||
+      tab->last_inner || tab->first_inner || tab->first_unmatched ||
+      tab->keep_current_rowid || tab->loosescan_match_tab ||
+      tab->check_weed_out_table || tab->do_firstmatch ||
+      tab->shortcut_for_distinct)
+    return NULL;
+
+  if (!tab->batch_cond || tab->batch_cond->cond != tab->select_cond)
+    tab->batch_cond= Batch_cond::create(thd, tab);
+  if (!tab->batch_cond || !tab->batch_cond->is_usable())
+    return NULL;
+  return tab->batch_cond;
+}
+
+
+/**
+  Read the rows of a table in blocks and evaluate the condition attached
+  to the table over each block
+
+  @details
+    This is the loop of sub_select() over the rows of join_tab when its
+    condition is evaluated in blocks. The rows read from the table are
+    copied into the block of the Batch_cond. When the block is full, the
+    condition is evaluated for all its rows. The rows that satisfy it are
+    copied back into the record buffer of the table one by one and passed
+    to evaluate_join_record(), which evaluates the rest of the condition
+    if the Batch_cond does not cover it.
+
+  @return
+    one of enum_nested_loop_state
+*/
+
+static enum_nested_loop_state
+sub_select_batch(JOIN *join, JOIN_TAB *join_tab, Batch_cond *batch)
+{
+  THD *thd= join->thd;
+  TABLE *table= join_tab->table;
+  READ_RECORD *info= &join_tab->read_record;
+  uint reclength= table->s->reclength;
+  enum_nested_loop_state rc= NESTED_LOOP_OK;
+  int error;
+  DBUG_ENTER("sub_select_batch");
+
+  if (batch->prepare(thd))
+    DBUG_RETURN(NESTED_LOOP_ERROR);
+
+  error= (*join_tab->read_first_record)(join_tab);
+  while (rc == NESTED_LOOP_OK && join->return_tab >= join_tab)
+  {
+    uint rows, count, next_row= 0, read_status;
+
+    for (rows= 0; !error; )
+    {
+      memcpy(batch->block + rows * reclength, table->record[0], reclength);
+      batch->add_row(rows);
+      if (++rows == batch->max_rows)
+        break;
+      error= info->read_record(info);
+    }
+    if (join_tab->tracker)
+      join_tab->tracker->r_rows+= rows;
+    read_status= table->status;
+    if (thd->check_killed())
+    {
+      thd->send_kill_message();
+      DBUG_RETURN(NESTED_LOOP_KILLED);
+    }
+
+    count= batch->evaluate(rows);
+    join->examined_rows+= rows - count;
+    for (uint i= 0;
+         i < count && rc == NESTED_LOOP_OK && join->return_tab >= join_tab;
+         i++)
+    {
+      uint row= batch->selected[i];
+      /* Count the rejected rows for the row numbers of the warnings */
+      for (; next_row < row; next_row++)
+        thd->get_stmt_da()->inc_current_row_for_warning();
+      next_row++;
+      memcpy(table->record[0], batch->block + row * reclength, reclength);
+      table->status= 0;
+      rc= evaluate_join_record(join, join_tab, 0, batch->covers_cond);
+    }
+    table->status= read_status;
+    if (rc != NESTED_LOOP_OK || join->return_tab < join_tab)
+      break;
+    if (error)
+    {
+      rc= evaluate_join_record(join, join_tab, error);
+      break;
+    }
+    /* Read the first row of the next block */
+    error= info->read_record(info);
+  }
+  DBUG_RETURN(rc);
+}
+
 /**
   Retrieve records ends with a given beginning from the result of a join.
 
@@ -17572,7 +18135,21 @@ sub_select(JOIN *join,JOIN_TAB *join_tab,bool end_of_records)
 
   if (rc != NESTED_LOOP_NO_MORE_ROWS)
   {
+    Batch_cond *batch;
+    if (join_tab->tracker)
+      join_tab->tracker->on_scan_init();
+    if ((batch= get_batch_cond(join, join_tab)))
+    {
+      rc= sub_select_batch(join, join_tab, batch);
+      if (rc == NESTED_LOOP_NO_MORE_ROWS)
+        rc= NESTED_LOOP_OK;
+      DBUG_RETURN(rc);
+    }
+    if (join->thd->is_fatal_error)
+      DBUG_RETURN(NESTED_LOOP_ERROR);
     error= (*join_tab->read_first_record)(join_tab);
+    if (!error && join_tab->tracker)
+      join_tab->tracker->on_record_read();
     if (!error && join_tab->keep_current_rowid)
       join_tab->table->file->position(join_tab->table->record[0]);    
     rc= evaluate_join_record(join, join_tab, error);
@@ -17595,6 +18172,8 @@ sub_select(JOIN *join,JOIN_TAB *join_tab,bool end_of_records)
     }
 
     error= info->read_record(info);
+    if (!error && join_tab->tracker)
+      join_tab->tracker->on_record_read();
 
     if (skip_over && !error) 
     {
@@ -17639,16 +18218,18 @@ sub_select(JOIN *join,JOIN_TAB *join_tab,bool end_of_records)
   @param  error > 0: Error, terminate processing
                 = 0: (Partial) row is available
                 < 0: No more rows available at this level
+  @param  cond_checked - TRUE <=> the row is known to satisfy
+                         join_tab->select_cond
   @return Nested loop state (Ok, No_more_rows, Error, Killed)
 */
 
 static enum_nested_loop_state
 evaluate_join_record(JOIN *join, JOIN_TAB *join_tab,
-                     int error)
+                     int error, bool cond_checked)
 {
   bool shortcut_for_distinct= join_tab->shortcut_for_distinct;
   ha_rows found_records=join->found_records;
-  COND *select_cond= join_tab->select_cond;
+  COND *select_cond= cond_checked ? NULL : join_tab->select_cond;
   bool select_cond_result= TRUE;
 
   DBUG_ENTER("evaluate_join_record");
@@ -17686,6 +18267,8 @@ evaluate_join_record(JOIN *join, JOIN_TAB *join_tab,
       condition is true => a match is found.
     */
     bool found= 1;
+    if (join_tab->tracker)
+      join_tab->tracker->on_record_after_where();
     while (join_tab->first_unmatched && found)
     {
       /*
@@ -18415,6 +18998,169 @@ join_read_prev_same(READ_RECORD *info)
 }
 
 
+/*
+  The maximum number of rows with smaller keys the merge join skips over
+  before it looks up the next key in the index
+*/
+#define MERGE_JOIN_MAX_SKIPPED_ROWS 8
+
+/*
+  Handle the end of rows or an error when reading rows for a merge join
+*/
+
+static int
+merge_join_read_error(JOIN_TAB *tab, int error)
+{
+  TABLE *table= tab->table;
+  if (error != HA_ERR_END_OF_FILE && error != HA_ERR_KEY_NOT_FOUND)
+  {
+    tab->merge_state= JOIN_TAB::MERGE_NOT_POSITIONED;
+    return report_error(table, error);
+  }
+  tab->merge_state= JOIN_TAB::MERGE_AT_END;
+  table->status= STATUS_NOT_FOUND;
+  return -1;
+}
+
+
+/*
+  Check the row read by a merge join whose key is not less than the lookup key
+
+  DESCRIPTION
+    If the key of the row differs from the lookup key the row is saved as
+    the first row after the lookup key, so that the next lookup with a
+    greater key could start from it.
+*/
+
+static int
+merge_join_check_row(JOIN_TAB *tab)
+{
+  TABLE *table= tab->table;
+  TABLE_REF *ref= &tab->ref;
+  if (!key_cmp_if_same(table, ref->key_buff, ref->key, ref->key_length))
+  {
+    tab->merge_state= JOIN_TAB::MERGE_IN_GROUP;
+    return 0;
+  }
+  key_copy(tab->merge_next_key, table->record[0], table->key_info+ref->key,
+           ref->key_length);
+  memcpy(tab->merge_next_rec, table->record[0], table->s->reclength);
+  tab->merge_state= JOIN_TAB::MERGE_AHEAD;
+  table->status= STATUS_NOT_FOUND;
+  return -1;
+}
+
+
+/*
+  Merge join access method implementation: "read_first" function
+
+  SYNOPSIS
+    join_read_merge_key()
+      tab  JOIN_TAB of the accessed table
+
+  DESCRIPTION
+    This is the "read_first" function for the ref access performed as a
+    merge join. While the lookup keys come in ascending order the index is
+    read forward from the position where the previous lookup stopped, so
+    that every row of the index is read at most once. Only when the next
+    rows are too far from the lookup key, or the lookup keys come unordered,
+    the function looks the key up in the index as join_read_always_key does.
+    A lookup also positions the cursor at the first row after the key when
+    there is no row with the key.
+
+  RETURN
+    0  - Ok
+   -1  - Row not found
+    1  - Error
+*/
+
+static int
+join_read_merge_key(JOIN_TAB *tab)
+{
+  int error;
+  TABLE *table= tab->table;
+  TABLE_REF *ref= &tab->ref;
+  KEY_PART_INFO *key_part= table->key_info[ref->key].key_part;
+
+  if (!table->file->inited)
+  {
+    if ((error= table->file->ha_index_init(ref->key, tab->sorted)))
+    {
+      (void) report_error(table, error);
+      return 1;
+    }
+    tab->merge_state= JOIN_TAB::MERGE_NOT_POSITIONED;
+  }
+
+  if (cp_buffer_from_ref(tab->join->thd, table, ref))
+    return -1;
+
+  if (tab->merge_state != JOIN_TAB::MERGE_NOT_POSITIONED &&
+      key_tuple_cmp(key_part, ref->key_buff, tab->merge_prev_key,
+                    ref->key_length) > 0)
+  {
+    /* The rows before the cursor have smaller keys than the lookup key */
+    memcpy(tab->merge_prev_key, ref->key_buff, ref->key_length);
+    if (tab->merge_state == JOIN_TAB::MERGE_AT_END)
+    {
+      table->status= STATUS_NOT_FOUND;
+      return -1;
+    }
+    if (tab->merge_state == JOIN_TAB::MERGE_AHEAD)
+    {
+      int cmp= key_tuple_cmp(key_part, tab->merge_next_key, ref->key_buff,
+                             ref->key_length);
+      if (cmp > 0)
+      {
+        table->status= STATUS_NOT_FOUND;
+        return -1;
+      }
+      if (cmp == 0)
+      {
+        memcpy(table->record[0], tab->merge_next_rec, table->s->reclength);
+        table->status= 0;
+        tab->merge_state= JOIN_TAB::MERGE_IN_GROUP;
+        return 0;
+      }
+    }
+    for (uint i= 0; i < MERGE_JOIN_MAX_SKIPPED_ROWS; i++)
+    {
+      if ((error= table->file->ha_index_next(table->record[0])))
+        return merge_join_read_error(tab, error);
+      if (key_cmp(key_part, ref->key_buff, ref->key_length) >= 0)
+        return merge_join_check_row(tab);
+    }
+  }
+  else
+    memcpy(tab->merge_prev_key, ref->key_buff, ref->key_length);
+
+  if ((error= table->file->prepare_index_key_scan_map(ref->key_buff, make_prev_keypart_map(ref->key_parts))))
+  {
+    report_error(table,error);
+    return -1;
+  }
+  if ((error= table->file->ha_index_read_map(table->record[0],
+                                             ref->key_buff,
+                                             make_prev_keypart_map(ref->key_parts),
+                                             HA_READ_KEY_OR_NEXT)))
+    return merge_join_read_error(tab, error);
+  return merge_join_check_row(tab);
+}
+
+
+static int
+join_read_merge_next(READ_RECORD *info)
+{
+  int error;
+  TABLE *table= info->table;
+  JOIN_TAB *tab=table->reginfo.join_tab;
+
+  if ((error= table->file->ha_index_next(table->record[0])))
+    return merge_join_read_error(tab, error);
+  return merge_join_check_row(tab);
+}
+
+
 static int
 join_init_quick_read_record(JOIN_TAB *tab)
 {
@@ -18446,7 +19192,7 @@ test_if_quick_select(JOIN_TAB *tab)
   tab->select->quick=0;
   return tab->select->test_quick_select(tab->join->thd, tab->keys,
 					(table_map) 0, HA_POS_ERROR, 0,
-                                        FALSE);
+                                        FALSE, TRUE);
 }
 
 
@@ -18940,25 +19686,11 @@ end:
   DBUG_RETURN(NESTED_LOOP_OK);
 }
 
-/* ARGSUSED */
-/** Group by searching after group record and updating it if possible. */
+/** Make the key of the group index of a temporary table in group_buff */
 
-static enum_nested_loop_state
-end_update(JOIN *join, JOIN_TAB *join_tab __attribute__((unused)),
-	   bool end_of_records)
+static void make_group_key(TABLE *table)
 {
-  TABLE *table=join->tmp_table;
-  ORDER   *group;
-  int	  error;
-  DBUG_ENTER("end_update");
-
-  if (end_of_records)
-    DBUG_RETURN(NESTED_LOOP_OK);
-
-  join->found_records++;
-  copy_fields(&join->tmp_table_param);		// Groups are copied twice.
-  /* Make a key of group index */
-  for (group=table->group ; group ; group=group->next)
+  for (ORDER *group=table->group ; group ; group=group->next)
   {
     Item *item= *group->item;
     if (group->fast_field_copier_setup != group->field)
@@ -18975,6 +19707,26 @@ end_update(JOIN *join, JOIN_TAB *join_tab __attribute__((unused)),
     if (item->maybe_null)
       group->buff[-1]= (char) group->field->is_null();
   }
+}
+
+
+/* ARGSUSED */
+/** Group by searching after group record and updating it if possible. */
+
+static enum_nested_loop_state
+end_update(JOIN *join, JOIN_TAB *join_tab __attribute__((unused)),
+	   bool end_of_records)
+{
+  TABLE *table=join->tmp_table;
+  int	  error;
+  DBUG_ENTER("end_update");
+
+  if (end_of_records)
+    DBUG_RETURN(NESTED_LOOP_OK);
+
+  join->found_records++;
+  copy_fields(&join->tmp_table_param);		// Groups are copied twice.
+  make_group_key(table);
   if (!table->file->ha_index_read_map(table->record[1],
                                       join->tmp_table_param.group_buff,
                                       HA_WHOLE_KEY,
@@ -19071,6 +19823,49 @@ end_unique_update(JOIN *join, JOIN_TAB *join_tab __attribute__((unused)),
 }
 
 
+/**
+  Like end_update, but the groups are kept in memory by a Hash_aggregate
+  and are written into the temporary table by do_select() at the end.
+*/
+
+static enum_nested_loop_state
+end_hash_update(JOIN *join, JOIN_TAB *join_tab __attribute__((unused)),
+                bool end_of_records)
+{
+  TABLE *table=join->tmp_table;
+  Hash_aggregate *hash_agg= join->hash_aggregate;
+  uchar *group_rec;
+  DBUG_ENTER("end_hash_update");
+
+  if (end_of_records)
+    DBUG_RETURN(NESTED_LOOP_OK);
+
+  join->found_records++;
+  copy_fields(&join->tmp_table_param);		// Groups are copied twice.
+  make_group_key(table);
+  if ((group_rec= hash_agg->find_group()))
+  {						/* Update old record */
+    memcpy(table->record[0], group_rec, table->s->reclength);
+    update_tmptable_sum_func(join->sum_funcs,table);
+    memcpy(group_rec, table->record[0], table->s->reclength);
+  }
+  else
+  {
+    init_tmptable_sum_functions(join->sum_funcs);
+    if (copy_funcs(join->tmp_table_param.items_to_copy, join->thd))
+      DBUG_RETURN(NESTED_LOOP_ERROR);         /* purecov: inspected */
+    if (hash_agg->add_group())
+      DBUG_RETURN(NESTED_LOOP_ERROR);
+  }
+  if (join->thd->check_killed())
+  {
+    join->thd->send_kill_message();
+    DBUG_RETURN(NESTED_LOOP_KILLED);             /* purecov: inspected */
+  }
+  DBUG_RETURN(NESTED_LOOP_OK);
+}
+
+
 	/* ARGSUSED */
 enum_nested_loop_state
 end_write_group(JOIN *join, JOIN_TAB *join_tab __attribute__((unused)),
@@ -20038,7 +20833,8 @@ test_if_skip_sort_order(JOIN_TAB *tab,ORDER *order,ha_rows select_limit,
     if (quick_type == QUICK_SELECT_I::QS_TYPE_INDEX_MERGE ||
         quick_type == QUICK_SELECT_I::QS_TYPE_INDEX_INTERSECT ||
         quick_type == QUICK_SELECT_I::QS_TYPE_ROR_UNION || 
-        quick_type == QUICK_SELECT_I::QS_TYPE_ROR_INTERSECT)
+        quick_type == QUICK_SELECT_I::QS_TYPE_ROR_INTERSECT ||
+        quick_type == QUICK_SELECT_I::QS_TYPE_SKIP_SCAN)
       ref_key= MAX_KEY;
     else
     {
@@ -20211,7 +21007,8 @@ check_reverse_order:
           quick_type == QUICK_SELECT_I::QS_TYPE_INDEX_INTERSECT ||
           quick_type == QUICK_SELECT_I::QS_TYPE_ROR_INTERSECT ||
           quick_type == QUICK_SELECT_I::QS_TYPE_ROR_UNION ||
-          quick_type == QUICK_SELECT_I::QS_TYPE_GROUP_MIN_MAX)
+          quick_type == QUICK_SELECT_I::QS_TYPE_GROUP_MIN_MAX ||
+          quick_type == QUICK_SELECT_I::QS_TYPE_SKIP_SCAN)
       {
         tab->limit= 0;
         goto use_filesort;               // Use filesort
@@ -22944,10 +23741,18 @@ int print_explain_message_line(select_result_sink *result,
   else
     item_list.push_back(item_null);
 
+  /* `r_rows` */
+  if (options & DESCRIBE_ANALYZE)
+    item_list.push_back(item_null);
+
   /* `filtered` */
   if (options & DESCRIBE_EXTENDED)
     item_list.push_back(item_null);
 
+  /* `r_filtered` */
+  if (options & DESCRIBE_ANALYZE)
+    item_list.push_back(item_null);
+
   /* `Extra` */
   if (message)
     item_list.push_back(new Item_string(message,strlen(message),cs));
@@ -23007,6 +23812,8 @@ int print_explain_row(select_result_sink *result,
                       const char *key_len,
                       const char *ref,
                       ha_rows *rows,
+                      double *r_rows,
+                      double *r_filtered,
                       const char *extra)
 {
   const CHARSET_INFO *cs= system_charset_info;
@@ -23059,10 +23866,28 @@ int print_explain_row(select_result_sink *result,
   else
     item_list.push_back(item_null);
 
+  /* 'r_rows' */
+  if (options & DESCRIBE_ANALYZE)
+  {
+    if (r_rows)
+      item_list.push_back(new Item_float(*r_rows, 2));
+    else
+      item_list.push_back(item_null);
+  }
+
   /* 'filtered' */
   const double filtered=100.0;
   if (options & DESCRIBE_EXTENDED)
     item_list.push_back(new Item_float(filtered, 2));
+
+  /* 'r_filtered' */
+  if (options & DESCRIBE_ANALYZE)
+  {
+    if (r_filtered)
+      item_list.push_back(new Item_float(*r_filtered, 2));
+    else
+      item_list.push_back(item_null);
+  }
   
   /* 'Extra' */
   if (extra)
@@ -23290,6 +24115,21 @@ int JOIN::save_explain_data_intern(Explain_query *output, bool need_tmp_table,
       xpl_sel->add_table(eta);
       eta->key.set(thd->mem_root, NULL, (uint)-1);
       eta->quick_info= NULL;
+      eta->tracker= NULL;
+
+      if (thd->lex->analyze_stmt)
+      {
+        /*
+          The counters live in the JOIN_TAB that is executed, so that they
+          survive when the plan is saved again after the execution.
+        */
+        JOIN_TAB *exec_tab= saved_join_tab ? saved_join_tab : tab;
+        if (!exec_tab->tracker &&
+            !(exec_tab->tracker= new (thd->mem_root) Table_access_tracker))
+          DBUG_RETURN(1);
+        eta->tracker= exec_tab->tracker;
+        table->file->tracker= &exec_tab->tracker->time_tracker;
+      }
       
       /* id */
       if (tab->bush_root_tab)
@@ -23529,6 +24369,8 @@ int JOIN::save_explain_data_intern(Explain_query *output, bool need_tmp_table,
         {
           eta->push_extra(ET_USING);
         }
+        else if (quick_type == QUICK_SELECT_I::QS_TYPE_SKIP_SCAN)
+          eta->push_extra(ET_USING_SKIP_SCAN);
 	if (tab->select)
 	{
 	  if (tab->use_quick == 2)
@@ -23663,6 +24505,11 @@ int JOIN::save_explain_data_intern(Explain_query *output, bool need_tmp_table,
           eta->push_extra(ET_USING_JOIN_BUFFER);
           tab->cache->save_explain_data(&eta->bka_type);
         }
+        else if (tab->use_merge_join)
+          eta->push_extra(ET_USING_MERGE_JOIN);
+
+        if (join->parallel_scan)
+          eta->push_extra(ET_USING_PARALLEL_SCAN);
       }
       
       if (saved_join_tab)
@@ -24307,7 +25154,9 @@ bool JOIN::change_result(select_result *res)
     bit 1 is set if tjoin buffers are allowed to be incremental
     bit 2 is set if the join buffers are allowed to be hashed
     but 3 is set if the join buffers are allowed to be used for BKA
-  join algorithms.
+  join algorithms
+    bit 4 is set if the hashed join buffers are allowed to use
+  Grace partitioning.
   The allowed types are read from system variables.
   Besides the function sets maximum allowed join cache level that is
   also read from a system variable.
@@ -24322,6 +25171,8 @@ void JOIN::set_allowed_join_cache_types()
     allowed_join_cache_types|= JOIN_CACHE_HASHED_BIT;
   if (optimizer_flag(thd, OPTIMIZER_SWITCH_JOIN_CACHE_BKA))
     allowed_join_cache_types|= JOIN_CACHE_BKA_BIT;
+  if (optimizer_flag(thd, OPTIMIZER_SWITCH_JOIN_CACHE_GRACE))
+    allowed_join_cache_types|= JOIN_CACHE_GRACE_BIT;
   allowed_semijoin_with_cache=
     optimizer_flag(thd, OPTIMIZER_SWITCH_SEMIJOIN_WITH_CACHE);
   allowed_outer_join_with_cache=
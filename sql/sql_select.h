@@ -196,6 +196,10 @@ int rr_sequential_and_unpack(READ_RECORD *info);
  *************************************************************************************/
 
 class JOIN_CACHE;
+class Parallel_scan;
+class Batch_cond;
+class Table_access_tracker;
+class Hash_aggregate;
 class SJ_TMP_TABLE;
 class JOIN_TAB_RANGE;
 
@@ -394,6 +398,28 @@ typedef struct st_join_table {
 
   /* Used by LooseScan. TRUE<=> there has been a matching record combination */
   bool found_match;
+
+  /*
+    TRUE <=> ref access to this table is performed as a merge join: the
+    index is read forward while the lookup keys come in ascending order
+    (see join_read_merge_key). This is a copy of POSITION::use_merge_join.
+  */
+  bool use_merge_join;
+
+  /* State of the index cursor used by the merge join */
+  enum enum_merge_state
+  {
+    MERGE_NOT_POSITIONED, /* the cursor position is unknown */
+    MERGE_IN_GROUP,       /* the cursor is on a row with the last lookup key */
+    MERGE_AHEAD,          /* the cursor is on the first row after that key */
+    MERGE_AT_END          /* there are no rows after the last lookup key */
+  } merge_state;
+
+  /* The last lookup key and the key of the row in the cursor (MERGE_AHEAD) */
+  uchar *merge_prev_key;
+  uchar *merge_next_key;
+  /* Copy of the row in the cursor when merge_state == MERGE_AHEAD */
+  uchar *merge_next_rec;
   
   /*
     Used by DuplicateElimination. tab->table->ref must have the rowid
@@ -401,6 +427,15 @@ typedef struct st_join_table {
   */
   int  keep_current_rowid;
 
+  /*
+    Block evaluation of select_cond (see sub_select_batch()), built on the
+    first scan of the table, or NULL
+  */
+  Batch_cond *batch_cond;
+
+  /* Counters of ANALYZE, or NULL when the statement is not analyzed */
+  Table_access_tracker *tracker;
+
   /* NestedOuterJoins: Bitmap of nested joins this table is part of */
   nested_join_map embedding_map;
 
@@ -514,6 +549,7 @@ typedef struct st_join_table {
   }
   double get_partial_join_cardinality() { return partial_join_cardinality; }
   bool hash_join_is_possible();
+  bool grace_hash_join_is_possible();
   int make_scan_filter();
   bool is_ref_for_hash_join() { return is_hash_join_key_no(ref.key); }
   KEY *get_keyinfo_by_key_no(uint key) 
@@ -803,6 +839,12 @@ typedef struct st_position :public Sql_alloc
     *very* imprecise guesses made in best_access_path(). 
   */
   bool use_join_buffer;
+
+  /*
+    TRUE <=> ref access is to be performed as a merge join, as the rows of
+    the join prefix are expected to come ordered by the ref key.
+  */
+  bool use_merge_join;
  
   /*
     Current optimization state: Semi-join strategy to be used for this
@@ -835,6 +877,29 @@ typedef struct st_position :public Sql_alloc
   Sj_materialization_picker sjmat_picker;
 } POSITION;
 
+
+/*
+  The join order of the non-constant tables of a select that has been
+  chosen by a full search of the join optimizer. It is kept in the
+  SELECT_LEX of a statement that is executed many times, i.e. of a
+  prepared statement or of a statement of a stored procedure, together
+  with the estimates the search was based on. When the statement is
+  executed again with close estimates the tables are joined in the same
+  order without searching for it (see reuse_saved_join_order()).
+*/
+
+struct Saved_join_order :public Sql_alloc
+{
+  /* The number of tables in the order and the size of the arrays */
+  uint tables, max_tables;
+  /* The tables in the join order */
+  TABLE_LIST **order;
+  /* JOIN_TAB::found_records for the tables at the time of the search */
+  ha_rows *found_records;
+  /* The number of records in the tables at the time of the search */
+  ha_rows *stat_records;
+};
+
 typedef struct st_rollup
 {
   enum State { STATE_NONE, STATE_INITED, STATE_READY };
@@ -943,6 +1008,10 @@ public:
   
   JOIN_TAB **map2table;    ///< mapping between table indexes and JOIN_TABs
   JOIN_TAB *join_tab_save; ///< saved join_tab for subquery reexecution
+  /* Not 0 <=> the only table is read by several threads (Parallel_scan) */
+  Parallel_scan *parallel_scan;
+  /* Not 0 <=> do_select() groups rows in memory (Hash_aggregate) */
+  Hash_aggregate *hash_aggregate;
 
   List<JOIN_TAB_RANGE> join_tab_ranges;
   
@@ -1191,6 +1260,12 @@ public:
   ORDER *order, *group_list, *proc_param; //hold parameters of mysql_select
   COND *conds;                            // ---"---
   Item *conds_history;                    // store WHERE for explain
+  /*
+    Conditions pushed into this SELECT of a derived table by the SELECT
+    that uses it, see pushdown_cond_for_derived(). They are added to conds
+    after conds is saved for the next executions.
+  */
+  List<Item> pushed_where;
   COND *outer_ref_cond;       ///<part of conds containing only outer references
   COND *pseudo_bits_cond;     // part of conds containing special bita
   TABLE_LIST *tables_list;           ///<hold 'tables' parameter of mysql_select
@@ -1289,6 +1364,7 @@ public:
     sum_funcs= sum_funcs2= 0;
     procedure= 0;
     having= tmp_having= having_history= 0;
+    pushed_where.empty();
     select_options= select_options_arg;
     result= result_arg;
     lock= thd_arg->lock;
@@ -1334,6 +1410,8 @@ public:
     pre_sort_join_tab= NULL;
     emb_sjm_nest= NULL;
     sjm_lookup_tables= 0;
+    parallel_scan= NULL;
+    hash_aggregate= NULL;
 
     exec_saved_explain= false;
     /* 
@@ -1826,7 +1904,7 @@ Item_equal *find_item_equal(COND_EQUAL *cond_equal, Field *field,
 extern bool test_if_ref(Item *, 
                  Item_field *left_item,Item *right_item);
 
-inline bool optimizer_flag(THD *thd, uint flag)
+inline bool optimizer_flag(THD *thd, ulonglong flag)
 { 
   return (thd->variables.optimizer_switch & flag);
 }
@@ -1872,6 +1950,8 @@ int print_explain_row(select_result_sink *result,
                       const char *key_len,
                       const char *ref,
                       ha_rows *rows,
+                      double *r_rows,
+                      double *r_filtered,
                       const char *extra);
 void make_possible_keys_line(TABLE *table, key_map possible_keys, String *line);
 
@@ -33,11 +33,26 @@ struct TABLE;
 #define MERGEBUFF		7
 #define MERGEBUFF2		15
 
+/* Maximum number of threads sorting the sort buffer of a filesort */
+#define MAX_SORT_THREADS	64
+/* The sort buffer is split between threads only if each gets this many keys */
+#define MIN_KEYS_PER_SORT_THREAD 4096
+
+/* String parts of sort keys shorter than this are never packed */
+#define MIN_PACKED_SORT_FIELD_LENGTH 32
+/* Length of the length prefix of packed sort keys */
+#define PACKED_SORT_KEY_LENGTH_BYTES 4
+/* Length of the length prefix of packed addon fields */
+#define PACKED_ADDON_LENGTH_BYTES 2
+
 /*
    The structure SORT_ADDON_FIELD describes a fixed layout
    for field values appended to sorted values in records to be sorted
    in the sort buffer.
-   Only fixed layout is supported now.
+   If the values are packed (see Sort_param::using_packed_addons), only
+   'null_offset' and 'null_bit' are used: the values follow each other
+   after the null bit maps, and the first of them starts at the 'offset'
+   of the first field.
    Null bit maps for the appended values is placed before the values 
    themselves. Offsets are from the last sorted field, that is from the
    record referefence, which is still last component of sorted records.
@@ -75,6 +90,18 @@ public:
   uint res_length;            // Length of records in final sorted file/buffer.
   uint max_keys_per_buffer;   // Max keys / buffer.
   uint min_dupl_count;
+  uint sort_threads;          // Max threads sorting the sort buffer.
+  /*
+    TRUE <=> the string parts of the sort keys are stored without their
+    padding, preceded by their length (SORT_FIELD::length_bytes), and the
+    key starts with its total length.
+  */
+  bool using_packed_keys;
+  /*
+    TRUE <=> the addon fields are packed one after another, and preceded
+    by their total length.
+  */
+  bool using_packed_addons;
   ha_rows max_rows;           // Select limit, or HA_POS_ERROR if unlimited.
   ha_rows examined_rows;      // Number of examined rows.
   TABLE *sort_form;           // For quicker make_sortkey.
@@ -84,6 +111,8 @@ public:
   uchar *unique_buff;
   bool not_killable;
   char* tmp_buffer;
+  uchar *tmp_record;          // A packed record is made here first.
+  uchar *pad_buffer;          // SORT_FIELD::pad of the packed sort fields.
   // The fields below are used only by Unique class.
   qsort2_cmp compare;
   BUFFPEK_COMPARE_CONTEXT cmp_context;
@@ -95,8 +124,37 @@ public:
   void init_for_filesort(uint sortlen, TABLE *table,
                          ulong max_length_for_sort_data,
                          ha_rows maxrows, bool sort_positions);
+  bool init_packed_records();
+
+  /*
+    The records have different lengths. rec_length is then the maximum
+    length of a record.
+  */
+  bool using_packed_records() const
+  { return using_packed_keys || using_packed_addons; }
+
+  /* Length of the sort key of a record, including the record reference */
+  uint get_sort_key_length(const uchar *rec) const
+  { return using_packed_keys ? uint4korr(rec) : sort_length; }
+
+  uint get_record_length(const uchar *rec) const
+  {
+    uint key_length= get_sort_key_length(rec);
+    if (using_packed_addons)
+      return key_length + uint2korr(rec + key_length);
+    return key_length + addon_length;
+  }
+
+  /* The part of the record stored in the result of the sort */
+  uchar *get_result(uchar *rec) const
+  { return rec + get_sort_key_length(rec) - (addon_field ? 0 : ref_length); }
+
+  uint get_result_length(const uchar *res) const
+  { return using_packed_addons ? uint2korr(res) : res_length; }
 };
 
+int cmp_packed_sort_keys(const Sort_param *param, uchar **a, uchar **b);
+
 
 int merge_many_buff(Sort_param *param, uchar *sort_buffer,
 		    BUFFPEK *buffpek,
@@ -55,8 +55,8 @@
   equal to "never".
 */ 
    
-/* Currently there are only 3 persistent statistical tables */
-static const uint STATISTICS_TABLES= 3;
+/* Currently there are only 4 persistent statistical tables */
+static const uint STATISTICS_TABLES= 4;
 
 /* 
   The names of the statistical tables in this array must correspond the
@@ -66,12 +66,23 @@ static const LEX_STRING stat_table_name[STATISTICS_TABLES]=
 {
   { C_STRING_WITH_LEN("table_stats") },
   { C_STRING_WITH_LEN("column_stats") },
-  { C_STRING_WITH_LEN("index_stats") }
+  { C_STRING_WITH_LEN("index_stats") },
+  { C_STRING_WITH_LEN("column_group_stats") }
 };
 
 /* Name of database to which the statistical tables belong */
 static const LEX_STRING stat_tables_db_name= { C_STRING_WITH_LEN("mysql") };
 
+/*
+  Number of rows ANALYZE samples to collect column statistics when
+  analyze_sample_percentage is set to 0
+*/
+static const ha_rows ANALYZE_SAMPLE_ROWS= 100000;
+
+/* Seeds of the generator that chooses the rows of the sample */
+static const ulong ANALYZE_SAMPLE_SEED1= 0x12345678L;
+static const ulong ANALYZE_SAMPLE_SEED2= 0x2468ACE0L;
+
 
 /**
   @details
@@ -178,18 +189,48 @@ private:
   ulonglong column_total_length; /* To accumulate the size of column values */
   Count_distinct_field *count_distinct; /* The container for distinct 
                                            column values */
+  ha_rows sampled_values; /* The number of values put into count_distinct */
 
   bool is_single_pk_col; /* TRUE <-> the only column of the primary key */ 
 
 public:
 
   inline void init(THD *thd, Field * table_field);
-  inline void add(ha_rows rowno);
+  inline void add(ha_rows rowno, bool sampled);
   inline void finish(ha_rows rows); 
   inline void cleanup();
 };
 
 
+/*
+  The class Column_group_statistics_collected is a helper class used to
+  collect statistics on a group of table columns. Additionally to the fields
+  of the class Column_group_statistics it contains the counters of rows
+  and a container for the distinct combinations of the values of the
+  columns used to calculate the average number of records per distinct
+  combination.
+*/
+
+class Column_group_statistics_collected :public Column_group_statistics
+{
+
+private:
+  Field *fields[MAX_COLUMN_GROUP_COLUMNS]; /* The columns of the group */
+  Unique *tree;     /* The container for distinct combinations of values */
+  uint tree_key_length; /* The length of the elements of 'tree' */
+  uchar *key_buff;  /* The buffer to build the elements of 'tree' in */
+  ha_rows values;   /* The number of rows without nulls in the group */
+  ha_rows sampled_values; /* The number of combinations put into 'tree' */
+
+public:
+
+  inline void init(THD *thd, TABLE *table);
+  inline void add(bool sampled);
+  inline void finish();
+  inline void cleanup();
+};
+
+
 /**
   Stat_table is the base class for classes Table_stat, Column_stat and
   Index_stat. The methods of these classes allow us to read statistical
@@ -306,6 +347,11 @@ private:
   uchar *record[2];     /* Record buffers used to access/update stat_table */
   uint stat_key_idx;    /* The number of the key to access stat_table */
 
+  /* The key prefix for the scan started by start_prefix_scan() */
+  uchar prefix_key[MAX_KEY_LENGTH];
+  uint prefix_key_length;
+  bool prefix_scan_is_on; /* TRUE <-> the index is initialized for a scan */
+
   /* This is a helper function used only by the Stat_table constructors */
   void common_init_stat_table()
   {
@@ -316,6 +362,7 @@ private:
     stat_key_length= stat_key_info->key_length;
     record[0]= stat_table->record[0];
     record[1]= stat_table->record[1];
+    prefix_scan_is_on= FALSE;
   }
 
 protected:
@@ -493,6 +540,53 @@ public:
   }
    
 
+  /**
+    @brief
+    Start a scan of the records of the statistical table by a key prefix
+
+    @details
+    The function reads the first record of stat_table whose key starts with
+    the value of 'prefix_parts' major components of the primary index. It
+    assumes that the key prefix fields have been already stored in the
+    record buffer of stat_table. The following records with the same key
+    prefix are read by next_in_prefix_scan(). Unlike find_next_stat_for_prefix
+    this allows to visit records that are not deleted during the scan.
+    The scan must be ended by end_prefix_scan() whatever the result is.
+
+    @retval
+    FALSE    the record is not found
+    @retval
+    TRUE     the record is found
+  */
+
+  bool start_prefix_scan(uint prefix_parts)
+  {
+    prefix_key_length= 0;
+    for (uint i= 0; i < prefix_parts; i++)
+      prefix_key_length+= stat_key_info->key_part[i].store_length;
+    key_copy(prefix_key, record[0], stat_key_info, prefix_key_length);
+    if (stat_file->ha_index_init(stat_key_idx, FALSE))
+      return FALSE;
+    prefix_scan_is_on= TRUE;
+    key_part_map prefix_map= (key_part_map) ((1 << prefix_parts) - 1);
+    return !stat_file->ha_index_read_map(record[0], prefix_key, prefix_map,
+                                         HA_READ_KEY_EXACT);
+  }
+
+  bool next_in_prefix_scan()
+  {
+    return !stat_file->ha_index_next_same(record[0], prefix_key,
+                                          prefix_key_length);
+  }
+
+  void end_prefix_scan()
+  {
+    if (prefix_scan_is_on)
+      stat_file->ha_index_end();
+    prefix_scan_is_on= FALSE;
+  }
+
+
   /**
     @brief
     Update/insert a record in the statistical table with new statistics
@@ -1263,6 +1357,260 @@ public:
 
 };
 
+/*
+  An object of the class Column_group_stat is created to read statistical
+  data on groups of table columns from the statistical table
+  column_group_stats, to update column_group_stats with such statistical
+  data, or to update columns of the primary key, or to delete the record
+  by its primary key or its prefix.
+  A group of columns is identified in column_group_stats by the names of
+  its columns separated by commas in the order they are defined in the table.
+*/
+
+class Column_group_stat: public Stat_table
+{
+
+private:
+
+  Field *db_name_field;      /* Field for column_group_stats.db_name */
+  Field *table_name_field;   /* Field for column_group_stats.table_name */
+  Field *column_names_field; /* Field for column_group_stats.column_names */
+
+  /* The group of columns to read/update statistics on */
+  Column_group_statistics *column_group;
+
+  void common_init_column_group_stat_table()
+  {
+    db_name_field= stat_table->field[COLUMN_GROUP_STAT_DB_NAME];
+    table_name_field= stat_table->field[COLUMN_GROUP_STAT_TABLE_NAME];
+    column_names_field= stat_table->field[COLUMN_GROUP_STAT_COLUMN_NAMES];
+  }
+
+  void change_full_table_name(LEX_STRING *db, LEX_STRING *tab)
+  {
+     db_name_field->store(db->str, db->length, system_charset_info);
+     table_name_field->store(tab->str, tab->length, system_charset_info);
+  }
+
+public:
+
+  /**
+    @details
+    The constructor 'tunes' the private and protected members of the
+    constructed object for the statistical table column_group_stats to
+    read/update statistics on groups of columns of the table 'tab'.
+    The TABLE structure for the table column_group_stats must be passed
+    as a value for the parameter 'stat'.
+  */
+
+  Column_group_stat(TABLE *stat, TABLE *tab) :Stat_table(stat, tab)
+  {
+    common_init_column_group_stat_table();
+  }
+
+
+  /**
+    @details
+    The constructor 'tunes' the private and protected members of the
+    object constructed for the statistical table column_group_stats for
+    the future updates/deletes of the records concerning the table 'tab'
+    from the database 'db'.
+  */
+
+  Column_group_stat(TABLE *stat, LEX_STRING *db, LEX_STRING *tab)
+    :Stat_table(stat, db, tab)
+  {
+    common_init_column_group_stat_table();
+  }
+
+
+  /**
+    @brief
+    Set table name fields for the statistical table column_group_stats
+  */
+
+  void set_full_table_name()
+  {
+    db_name_field->store(db_name->str, db_name->length, system_charset_info);
+    table_name_field->store(table_name->str, table_name->length,
+                            system_charset_info);
+  }
+
+
+  /**
+    @brief
+    Set the key fields for the statistical table column_group_stats
+
+    @param
+    group     The group of columns of 'table' to read/update statistics on
+
+    @details
+    The function stores the values of the fields db_name, table_name and
+    column_names in the record buffer for the statistical table
+    column_group_stats. These fields comprise the primary key for the table.
+    It also sets column_group to the passed parameter.
+  */
+
+  void set_key_fields(Column_group_statistics *group)
+  {
+    char buff[NAME_LEN * MAX_COLUMN_GROUP_COLUMNS];
+    String names(buff, sizeof(buff), system_charset_info);
+    names.length(0);
+    for (uint i= 0; i < group->columns; i++)
+    {
+      if (i)
+        names.append(',');
+      names.append(table_share->field[group->field_index[i]]->field_name);
+    }
+    set_full_table_name();
+    column_names_field->store(names.ptr(), names.length(),
+                              system_charset_info);
+    column_group= group;
+  }
+
+
+  /**
+    @brief
+    Set the key fields for column_group_stats by the names of the columns
+  */
+
+  void set_key_fields(String *names)
+  {
+    set_full_table_name();
+    column_names_field->store(names->ptr(), names->length(),
+                              system_charset_info);
+  }
+
+
+  /**
+    @brief
+    Get the names of the columns from the current record of stat_table
+  */
+
+  void get_column_names(String *names)
+  {
+    column_names_field->val_str(names);
+  }
+
+
+  /**
+    @brief
+    Update the column names in the current record of stat_table
+  */
+
+  bool update_column_names_key_part(String *names)
+  {
+    store_record_for_update();
+    column_names_field->store(names->ptr(), names->length(),
+                              system_charset_info);
+    bool rc= update_record();
+    store_record_for_lookup();
+    return rc;
+  }
+
+
+  /**
+    @brief
+    Find the columns of 'table' named in the current record of stat_table
+
+    @param
+    group     The group of columns to fill
+
+    @details
+    The function looks for the columns of 'table' whose names are listed
+    in the column 'column_names' of the current record and stores their
+    numbers in the group.
+
+    @retval
+    FALSE    the group is filled
+    @retval
+    TRUE     the record does not define a valid group of columns of 'table'
+  */
+
+  bool get_column_group(Column_group_statistics *group)
+  {
+    char buff[NAME_LEN * MAX_COLUMN_GROUP_COLUMNS];
+    String names(buff, sizeof(buff), system_charset_info);
+    column_names_field->val_str(&names);
+    const char *name= names.c_ptr_safe();
+    const char *end= name + names.length();
+
+    group->columns= 0;
+    while (name < end)
+    {
+      const char *name_end= strchr(name, ',');
+      if (!name_end)
+        name_end= end;
+      Field **field_ptr;
+      for (field_ptr= table_share->field; *field_ptr; field_ptr++)
+      {
+        const char *field_name= (*field_ptr)->field_name;
+        if (strlen(field_name) == (size_t) (name_end - name) &&
+            !my_strnncoll(system_charset_info,
+                          (const uchar *) field_name, name_end - name,
+                          (const uchar *) name, name_end - name))
+          break;
+      }
+      if (!*field_ptr || group->columns == MAX_COLUMN_GROUP_COLUMNS ||
+          (group->columns &&
+           group->field_index[group->columns-1] >= (*field_ptr)->field_index))
+        return TRUE;
+      group->field_index[group->columns++]= (*field_ptr)->field_index;
+      name= name_end + 1;
+    }
+    column_group= group;
+    return group->columns < 2;
+  }
+
+
+  /**
+    @brief
+    Store statistical data into statistical fields of column_group_stats
+
+    @details
+    This implementation of a purely virtual method sets the value of the
+    column 'avg_frequency' of the statistical table column_group_stats
+    according to the value of avg_frequency of the group 'column_group'.
+    If the value is equal to 0, the value of the column is set to NULL.
+  */
+
+  void store_stat_fields()
+  {
+    Field *stat_field= stat_table->field[COLUMN_GROUP_STAT_AVG_FREQUENCY];
+    double avg_frequency= column_group->get_avg_frequency();
+    if (avg_frequency == 0)
+      stat_field->set_null();
+    else
+    {
+      stat_field->set_notnull();
+      stat_field->store(avg_frequency);
+    }
+  }
+
+
+  /**
+    @brief
+    Read statistical data from statistical fields of column_group_stats
+
+    @details
+    This implementation of a purely virtual method reads the value of the
+    column 'avg_frequency' from the current record of column_group_stats
+    into the group 'column_group'. If the value of the column is NULL,
+    the avg_frequency of the group is set to 0.
+  */
+
+  void get_stat_values()
+  {
+    double avg_frequency= 0;
+    Field *stat_field= stat_table->field[COLUMN_GROUP_STAT_AVG_FREQUENCY];
+    if (!stat_field->is_null())
+      avg_frequency= stat_field->val_real();
+    column_group->set_avg_frequency(avg_frequency);
+  }
+
+};
+
+
 /*
   Histogram_builder is a helper class that is used to build histograms
   for columns
@@ -1281,6 +1629,7 @@ class Histogram_builder
   uint curr_bucket;        /* number of the current bucket to be built     */
   ulonglong count;         /* number of values retrieved                   */
   ulonglong count_distinct;    /* number of distinct values retrieved      */
+  ulonglong count_singletons;  /* number of values retrieved only once     */
 
 public: 
   Histogram_builder(Field *col, uint col_len, ha_rows rows)
@@ -1295,13 +1644,18 @@ public:
     curr_bucket= 0;
     count= 0;
     count_distinct= 0;    
+    count_singletons= 0;
   }
 
   ulonglong get_count_distinct() { return count_distinct; }
 
+  ulonglong get_count_singletons() { return count_singletons; }
+
   int next(void *elem, element_count elem_cnt)
   {
     count_distinct++;
+    if (elem_cnt == 1)
+      count_singletons++;
     count+= elem_cnt;
     if (curr_bucket == hist_width)
       return 0;
@@ -1331,6 +1685,21 @@ int histogram_build_walk(void *elem, element_count elem_cnt, void *arg)
   return hist_builder->next(elem, elem_cnt);
 }
 
+/*
+  Count the distinct values and the values met only once:
+  arg points to an array of two counters for them
+*/
+
+int count_distinct_singletons_walk(void *elem, element_count elem_cnt,
+                                   void *arg)
+{
+  ulonglong *counts= (ulonglong *) arg;
+  counts[0]++;
+  if (elem_cnt == 1)
+    counts[1]++;
+  return 0;
+}
+
 C_MODE_END
 
 
@@ -1418,14 +1787,29 @@ public:
     return count;
   }
 
+  /*
+    @brief
+    Calculate the number of elements accumulated in the container of 'tree'
+    and the number of the elements that have been added only once
+  */
+  ulonglong get_value(ulonglong *singletons)
+  {
+    ulonglong counts[2]= { 0, 0 };
+    tree->walk(table_field->table, count_distinct_singletons_walk,
+               (void*) counts);
+    *singletons= counts[1];
+    return counts[0];
+  }
+
   /*
     @brief
     Build the histogram for the elements accumulated in the container of 'tree'
   */
-  ulonglong get_value_with_histogram(ha_rows rows)
+  ulonglong get_value_with_histogram(ha_rows rows, ulonglong *singletons)
   {
     Histogram_builder hist_builder(table_field, tree_key_length, rows);
     tree->walk(table_field->table,  histogram_build_walk, (void *) &hist_builder);
+    *singletons= hist_builder.get_count_singletons();
     return hist_builder.get_count_distinct();
   }
 
@@ -1858,6 +2242,8 @@ int alloc_statistics_for_table(THD* thd, TABLE *table)
   table_stats->index_stats= index_stats;
   table_stats->idx_avg_frequency= idx_avg_frequency;
   table_stats->histograms= histogram;
+  table_stats->column_groups= 0;
+  table_stats->column_group_stats= NULL;
   
   memset(column_stats, 0, sizeof(Column_statistics) * (fields+1));
 
@@ -1893,6 +2279,141 @@ int alloc_statistics_for_table(THD* thd, TABLE *table)
 }
 
 
+/**
+  @brief
+  Allocate memory for the statistical data on column groups to be collected
+
+  @param
+  thd         Thread handler
+  @param
+  table       Table for which the memory for statistical data is allocated
+  @param
+  groups      The groups of columns specified in the PERSISTENT FOR clause
+              of the ANALYZE command or NULL
+
+  @details
+  The function allocates the memory for the statistics on the groups of
+  columns from the list 'groups' and on the groups of columns of 'table'
+  that have been already registered in the statistical table
+  column_group_stats, when all their columns are in table->read_set.
+  The names of the columns from 'groups' are supposed to be checked by
+  the caller. The memory is allocated in the statement's mem_root.
+
+  @retval
+  0      If the memory for all statistical data has been successfully allocated
+  @retval
+  1      Otherwise
+*/
+
+int alloc_column_groups_for_table(THD *thd, TABLE *table,
+                                  List<List<LEX_STRING> > *groups)
+{
+  TABLE_LIST tables;
+  Open_tables_backup open_tables_backup;
+  List<Column_group_statistics_collected> group_list;
+  Column_group_statistics_collected *group;
+
+  DBUG_ENTER("alloc_column_groups_for_table");
+
+  if (groups)
+  {
+    List<LEX_STRING> *column_names;
+    List_iterator_fast<List<LEX_STRING> > it(*groups);
+    while ((column_names= it++))
+    {
+      LEX_STRING *column_name;
+      List_iterator_fast<LEX_STRING> name_it(*column_names);
+      if (!(group= (Column_group_statistics_collected *)
+                   thd->alloc(sizeof(Column_group_statistics_collected))))
+        DBUG_RETURN(1);
+      group->columns= 0;
+      while ((column_name= name_it++))
+      {
+        Field **field_ptr;
+        for (field_ptr= table->field; *field_ptr; field_ptr++)
+        {
+          if (!my_strcasecmp(system_charset_info, (*field_ptr)->field_name,
+                             column_name->str))
+            break;
+        }
+        if (!*field_ptr || group->columns == MAX_COLUMN_GROUP_COLUMNS)
+          DBUG_RETURN(1);
+        /* Keep the numbers of the columns in ascending order */
+        uint i= group->columns++;
+        uint16 fldno= (*field_ptr)->field_index;
+        for ( ; i && group->field_index[i-1] > fldno; i--)
+          group->field_index[i]= group->field_index[i-1];
+        if (i && group->field_index[i-1] == fldno)
+          DBUG_RETURN(1);
+        group->field_index[i]= fldno;
+      }
+      if (group->columns < 2 || group_list.push_back(group))
+        DBUG_RETURN(1);
+    }
+  }
+
+  /* Add the groups registered in column_group_stats */
+  if (open_single_stat_table(thd, &tables,
+                             &stat_table_name[COLUMN_GROUP_STAT],
+                             &open_tables_backup, FALSE))
+    thd->clear_error();
+  else
+  {
+    Column_group_stat column_group_stat(tables.table, table);
+    column_group_stat.set_full_table_name();
+    group= NULL;
+    if (column_group_stat.start_prefix_scan(2))
+    {
+      do
+      {
+        if (!group &&
+            !(group= (Column_group_statistics_collected *)
+                     thd->alloc(sizeof(Column_group_statistics_collected))))
+          break;
+        if (column_group_stat.get_column_group(group))
+          continue;
+        uint i;
+        for (i= 0; i < group->columns; i++)
+        {
+          if (!bitmap_is_set(table->read_set, group->field_index[i]))
+            break;
+        }
+        if (i < group->columns)
+          continue;
+        Column_group_statistics_collected *other;
+        List_iterator_fast<Column_group_statistics_collected> it(group_list);
+        while ((other= it++))
+        {
+          if (other->columns == group->columns &&
+              !memcmp(other->field_index, group->field_index,
+                      sizeof(group->field_index[0]) * group->columns))
+            break;
+        }
+        if (other || group_list.push_back(group))
+          continue;
+        group= NULL;
+      } while (column_group_stat.next_in_prefix_scan());
+    }
+    column_group_stat.end_prefix_scan();
+    close_system_tables(thd, &open_tables_backup);
+  }
+
+  uint n= group_list.elements;
+  Column_group_statistics **column_group_stats= NULL;
+  if (n &&
+      !(column_group_stats= (Column_group_statistics **)
+                            thd->alloc(sizeof(Column_group_statistics *) * n)))
+    DBUG_RETURN(1);
+  List_iterator_fast<Column_group_statistics_collected> it(group_list);
+  for (uint i= 0; (group= it++); i++)
+    column_group_stats[i]= group;
+  table->collected_stats->column_groups= n;
+  table->collected_stats->column_group_stats= column_group_stats;
+
+  DBUG_RETURN(0);
+}
+
+
 /**
   @brief
   Check whether any persistent statistics for the processed command is needed
@@ -2193,6 +2714,7 @@ void Column_statistics_collected::init(THD *thd, Field *table_field)
 
   nulls= 0;
   column_total_length= 0;
+  sampled_values= 0;
   if (is_single_pk_col)
     count_distinct= NULL;
   if (table_field->flags & BLOB_FLAG)
@@ -2215,10 +2737,13 @@ void Column_statistics_collected::init(THD *thd, Field *table_field)
 
   @param
   rowno     The order number of the row
+  @param
+  sampled   TRUE <-> the row belongs to the sample of rows used to
+            count distinct values and to build the histogram
 */
 
 inline
-void Column_statistics_collected::add(ha_rows rowno)
+void Column_statistics_collected::add(ha_rows rowno, bool sampled)
 {
 
   if (column->is_null())
@@ -2230,12 +2755,50 @@ void Column_statistics_collected::add(ha_rows rowno)
       set_not_null(COLUMN_STAT_MIN_VALUE);
     if (max_value && column->update_max(max_value, rowno == nulls))
       set_not_null(COLUMN_STAT_MAX_VALUE);
-    if (count_distinct) 
+    if (count_distinct && sampled) 
+    {
       count_distinct->add();
+      sampled_values++;
+    }
   } 
 }
 
 
+/**
+  @brief
+  Estimate the number of distinct values in a column from a sample
+
+  @param
+  values        The number of not null values in the column
+  @param
+  sampled       The number of values in the sample
+  @param
+  distincts     The number of distinct values in the sample
+  @param
+  singletons    The number of values that occur only once in the sample
+
+  @details
+  The function uses the Duj1 estimator by Haas and Stokes:
+    D = n*d / (n - f1 + f1*n/N)
+  where N is the number of values, n is the number of sampled values,
+  d is the number of distinct values in the sample and f1 is the number
+  of values met in the sample only once. When all values are sampled the
+  estimate is d. The result is never less than d and never greater than N.
+*/
+
+static
+double estimate_distincts(ha_rows values, ha_rows sampled,
+                          ulonglong distincts, ulonglong singletons)
+{
+  double n= (double) sampled;
+  double f1= (double) singletons;
+  double est= n * distincts / (n - f1 + f1 * n / values);
+  set_if_bigger(est, (double) distincts);
+  set_if_smaller(est, (double) values);
+  return est;
+}
+
+
 /**
   @brief
   Get the results of aggregation when collecting the statistics on a column
@@ -2264,14 +2827,24 @@ void Column_statistics_collected::finish(ha_rows rows)
   if (count_distinct)
   {
     ulonglong distincts;
+    ulonglong singletons;
+    bool is_sample= sampled_values < rows - nulls;
     uint hist_size= count_distinct->get_hist_size();
-    if (hist_size == 0)
-      distincts= count_distinct->get_value();
+    if (hist_size)
+      distincts= count_distinct->get_value_with_histogram(sampled_values,
+                                                          &singletons);
+    else if (is_sample)
+      distincts= count_distinct->get_value(&singletons);
     else
-      distincts= count_distinct->get_value_with_histogram(rows - nulls);
+      distincts= count_distinct->get_value();
     if (distincts)
     {
-      val= (double) (rows - nulls) / distincts;
+      if (is_sample)
+        val= (double) (rows - nulls) /
+             estimate_distincts(rows - nulls, sampled_values,
+                                distincts, singletons);
+      else
+        val= (double) (rows - nulls) / distincts;
       set_avg_frequency(val); 
       set_not_null(COLUMN_STAT_AVG_FREQUENCY);
     }
@@ -2313,6 +2886,141 @@ void Column_statistics_collected::cleanup()
 }
 
 
+/*
+  Get the i-th group of columns whose statistics is collected for a table
+*/
+
+static inline
+Column_group_statistics_collected *collected_column_group(TABLE *table,
+                                                          uint i)
+{
+  return static_cast<Column_group_statistics_collected *>
+           (table->collected_stats->column_group_stats[i]);
+}
+
+
+/*
+  Compare the images of the values of the columns of a group that are
+  built by Column_group_statistics_collected::add()
+*/
+
+static
+int column_group_key_cmp(void* arg, uchar* key1, uchar* key2)
+{
+  return memcmp(key1, key2, *(uint *) arg);
+}
+
+
+/**
+  @brief
+  Initialize the aggregation fields to collect statistics on a column group
+
+  @param
+  thd            Thread handler
+  @param
+  table          The table the columns of the group belong to
+
+  @details
+  The distinct combinations of values of the columns are put in a Unique
+  container as the concatenations of the sort images of the values.
+  No statistics is collected for a group with a BLOB column.
+*/
+
+inline
+void Column_group_statistics_collected::init(THD *thd, TABLE *table)
+{
+  uint max_heap_table_size= thd->variables.max_heap_table_size;
+
+  tree= NULL;
+  tree_key_length= 0;
+  values= 0;
+  sampled_values= 0;
+  set_avg_frequency(0);
+
+  for (uint i= 0; i < columns; i++)
+  {
+    fields[i]= table->field[field_index[i]];
+    if (fields[i]->flags & BLOB_FLAG)
+      return;
+    tree_key_length+= fields[i]->sort_length();
+  }
+  if (!(key_buff= (uchar *) thd->alloc(tree_key_length)))
+    return;
+  tree= new Unique((qsort_cmp2) column_group_key_cmp,
+                   (void*) &tree_key_length,
+                   tree_key_length, max_heap_table_size, 1);
+}
+
+
+/**
+  @brief
+  Perform aggregation for a row when collecting statistics on a column group
+
+  @param
+  sampled   TRUE <-> the row belongs to the sample of rows used to
+            count distinct values
+*/
+
+inline
+void Column_group_statistics_collected::add(bool sampled)
+{
+  for (uint i= 0; i < columns; i++)
+  {
+    if (fields[i]->is_null())
+      return;
+  }
+  values++;
+  if (!tree || !sampled)
+    return;
+
+  uchar *to= key_buff;
+  for (uint i= 0; i < columns; i++)
+  {
+    uint length= fields[i]->sort_length();
+    fields[i]->sort_string(to, length);
+    to+= length;
+  }
+  tree->unique_add(key_buff);
+  sampled_values++;
+}
+
+
+/**
+  @brief
+  Get the results of aggregation when collecting statistics on a column group
+*/
+
+inline
+void Column_group_statistics_collected::finish()
+{
+  if (tree && sampled_values)
+  {
+    ulonglong counts[2]= { 0, 0 };
+    tree->walk(fields[0]->table, count_distinct_singletons_walk,
+               (void*) counts);
+    double distincts= (double) counts[0];
+    if (sampled_values < values)
+      distincts= estimate_distincts(values, sampled_values,
+                                    counts[0], counts[1]);
+    set_avg_frequency((double) values / distincts);
+  }
+  cleanup();
+}
+
+
+/**
+  @brief
+  Clean up auxiliary structures used for aggregation on a column group
+*/
+
+inline
+void Column_group_statistics_collected::cleanup()
+{
+  delete tree;
+  tree= NULL;
+}
+
+
 /**
   @brief
   Collect statistical data on an index
@@ -2450,12 +3158,35 @@ int collect_statistics_for_table(THD *thd, TABLE *table)
   Field *table_field;
   ha_rows rows= 0;
   handler *file=table->file;
+  double sample_fraction= thd->variables.analyze_sample_percentage / 100;
+  struct my_rnd_struct sample_rand;
+  uint column_groups= table->collected_stats->column_groups;
+  uint i;
 
   DBUG_ENTER("collect_statistics_for_table");
 
   table->collected_stats->cardinality_is_null= TRUE;
   table->collected_stats->cardinality= 0;
 
+  /*
+    With analyze_sample_percentage=0 the number of sampled rows is
+    limited by ANALYZE_SAMPLE_ROWS whatever the size of the table is
+  */
+  if (sample_fraction == 0)
+  {
+    file->info(HA_STATUS_VARIABLE | HA_STATUS_NO_LOCK);
+    sample_fraction= 1;
+    if (file->stats.records > ANALYZE_SAMPLE_ROWS)
+      sample_fraction= (double) ANALYZE_SAMPLE_ROWS / file->stats.records;
+  }
+
+  /*
+    The sample is drawn with a generator of its own, so that ANALYZE does
+    not change the sequence of RAND() of the session, and with fixed seeds,
+    so that the same data always give the same statistics
+  */
+  my_rnd_init(&sample_rand, ANALYZE_SAMPLE_SEED1, ANALYZE_SAMPLE_SEED2);
+
   for (field_ptr= table->field; *field_ptr; field_ptr++)
   {
     table_field= *field_ptr;   
@@ -2463,6 +3194,8 @@ int collect_statistics_for_table(THD *thd, TABLE *table)
       continue; 
     table_field->collected_stats->init(thd, table_field);
   }
+  for (i= 0; i < column_groups; i++)
+    collected_column_group(table, i)->init(thd, table);
 
   /* Perform a full table scan to collect statistics on 'table's columns */
   if (!(rc= file->ha_rnd_init(TRUE)))
@@ -2481,13 +3214,22 @@ int collect_statistics_for_table(THD *thd, TABLE *table)
         break;
       }
 
+      /*
+        All rows are used for the cardinality, the number of nulls and the
+        min/max values. Only the sampled rows are used to count distinct
+        values and to build histograms.
+      */
+      bool sampled= sample_fraction >= 1 ||
+                    my_rnd(&sample_rand) < sample_fraction;
       for (field_ptr= table->field; *field_ptr; field_ptr++)
       {
         table_field= *field_ptr;
         if (!bitmap_is_set(table->read_set, table_field->field_index))
           continue;  
-        table_field->collected_stats->add(rows);
+        table_field->collected_stats->add(rows, sampled);
       }
+      for (i= 0; i < column_groups; i++)
+        collected_column_group(table, i)->add(sampled);
       rows++;
     }
     file->ha_rnd_end();
@@ -2517,6 +3259,13 @@ int collect_statistics_for_table(THD *thd, TABLE *table)
     else
       table_field->collected_stats->cleanup();
   }
+  for (i= 0; i < column_groups; i++)
+  {
+    if (!rc)
+      collected_column_group(table, i)->finish();
+    else
+      collected_column_group(table, i)->cleanup();
+  }
 bitmap_clear_all(table->write_set);
 
   if (!rc)
@@ -2645,6 +3394,19 @@ int update_statistics_for_table(THD *thd, TABLE *table)
     }
   }
 
+  /* Update the statistical table column_group_stats */
+  stat_table= tables[COLUMN_GROUP_STAT].table;
+  Column_group_stat column_group_stat(stat_table, table);
+  for (i= 0; i < table->collected_stats->column_groups; i++)
+  {
+    restore_record(stat_table, s->default_values);
+    column_group_stat.set_key_fields(table->collected_stats->
+                                     column_group_stats[i]);
+    err= column_group_stat.update_stat();
+    if (err && !rc)
+      rc= 1;
+  }
+
   thd->restore_stmt_binlog_format(save_binlog_format);
 
   close_system_tables(thd, &open_tables_backup);
@@ -2777,6 +3539,59 @@ int read_statistics_for_table(THD *thd, TABLE *table, TABLE_LIST *stat_tables)
       }
     }
   }
+
+  /* Read statistics from the statistical table column_group_stats */
+  stat_table= stat_tables[COLUMN_GROUP_STAT].table;
+  Column_group_stat column_group_stat(stat_table, table);
+  List<Column_group_statistics> group_list;
+  Column_group_statistics *group= NULL;
+  column_group_stat.set_full_table_name();
+  if (column_group_stat.start_prefix_scan(2))
+  {
+    do
+    {
+      if (!group &&
+          !(group= (Column_group_statistics *)
+                   thd->alloc(sizeof(Column_group_statistics))))
+        break;
+      if (column_group_stat.get_column_group(group))
+        continue;
+      column_group_stat.get_stat_values();
+      if (group->get_avg_frequency() == 0 || group_list.push_back(group))
+        continue;
+      group= NULL;
+    } while (column_group_stat.next_in_prefix_scan());
+  }
+  column_group_stat.end_prefix_scan();
+
+  /* The statistics on column groups is kept in the memory of the share */
+  if (group_list.elements)
+  {
+    TABLE_STATISTICS_CB *stats_cb= &table_share->stats_cb;
+    uint n= group_list.elements;
+    mysql_mutex_lock(&table_share->LOCK_share);
+    Column_group_statistics **column_group_stats=
+      (Column_group_statistics **)
+        alloc_root(&stats_cb->mem_root,
+                   (sizeof(Column_group_statistics *) +
+                    sizeof(Column_group_statistics)) * n);
+    if (column_group_stats)
+    {
+      Column_group_statistics *group_stats=
+        (Column_group_statistics *) (column_group_stats + n);
+      List_iterator_fast<Column_group_statistics> it(group_list);
+      for (i= 0; (group= it++); i++)
+      {
+        group_stats[i]= *group;
+        column_group_stats[i]= group_stats + i;
+      }
+      read_stats->column_group_stats= column_group_stats;
+      read_stats->column_groups= n;
+    }
+    mysql_mutex_unlock(&table_share->LOCK_share);
+  }
+  else
+    read_stats->column_groups= 0;
       
   table->stats_is_read= TRUE;
 
@@ -3002,7 +3817,8 @@ int read_statistics_for_tables_if_needed(THD *thd, TABLE_LIST *tables)
 
   @details
   The function delete statistics on the table called 'tab' of the database
-  'db' from all statistical tables: table_stats, column_stats, index_stats.
+  'db' from all statistical tables: table_stats, column_stats, index_stats,
+  column_group_stats.
 
   @retval
   0         If all deletions are successful  
@@ -3043,6 +3859,17 @@ int delete_statistics_for_table(THD *thd, LEX_STRING *db, LEX_STRING *tab)
       rc= 1;
   }
 
+  /* Delete statistics on table from the statistical table column_group_stats */
+  stat_table= tables[COLUMN_GROUP_STAT].table;
+  Column_group_stat column_group_stat(stat_table, db, tab);
+  column_group_stat.set_full_table_name();
+  while (column_group_stat.find_next_stat_for_prefix(2))
+  {
+    err= column_group_stat.delete_stat();
+    if (err & !rc)
+      rc= 1;
+  }
+
   /* Delete statistics on table from the statistical table column_stats */
   stat_table= tables[COLUMN_STAT].table;
   Column_stat column_stat(stat_table, db, tab);
@@ -3073,6 +3900,132 @@ int delete_statistics_for_table(THD *thd, LEX_STRING *db, LEX_STRING *tab)
 }
 
 
+/**
+  @brief
+  Delete or rename a column in the groups of columns of the specified table
+
+  @param
+  thd         The thread handle
+  @param
+  tab         The table the column belongs to
+  @param
+  col         The column to be deleted or renamed
+  @param
+  new_name    The new column name or NULL if the column is deleted
+
+  @details
+  The function finds the records of the statistical table column_group_stats
+  for the groups of columns of the table 'tab' that contain the column 'col'.
+  If new_name is NULL the records are deleted, otherwise the name of the
+  column is replaced for 'new_name' in the list of the column names.
+
+  @retval
+  0         If all deletions/updates are successful
+  @retval
+  1         Otherwise
+*/
+
+static
+int update_column_groups_for_column(THD *thd, TABLE *tab, Field *col,
+                                    const char *new_name)
+{
+  int err;
+  enum_binlog_format save_binlog_format;
+  TABLE_LIST tables;
+  Open_tables_backup open_tables_backup;
+  List<String> groups;
+  String *names;
+  int rc= 0;
+
+  DBUG_ENTER("update_column_groups_for_column");
+
+  if (open_single_stat_table(thd, &tables,
+                             &stat_table_name[COLUMN_GROUP_STAT],
+                             &open_tables_backup, TRUE))
+  {
+    thd->clear_error();
+    DBUG_RETURN(rc);
+  }
+
+  save_binlog_format= thd->set_current_stmt_binlog_format_stmt();
+
+  /* Collect the names of the groups that contain the column */
+  Column_group_stat column_group_stat(tables.table, tab);
+  column_group_stat.set_full_table_name();
+  size_t col_length= strlen(col->field_name);
+  if (column_group_stat.start_prefix_scan(2))
+  {
+    do
+    {
+      if (!(names= new (thd->mem_root) String()))
+        break;
+      column_group_stat.get_column_names(names);
+      if (names->copy())
+        break;
+      const char *name= names->ptr();
+      const char *end= name + names->length();
+      while (name < end)
+      {
+        const char *name_end= (const char *) memchr(name, ',', end - name);
+        if (!name_end)
+          name_end= end;
+        if ((size_t) (name_end - name) == col_length &&
+            !my_strnncoll(system_charset_info,
+                          (const uchar *) name, col_length,
+                          (const uchar *) col->field_name, col_length))
+        {
+          groups.push_back(names);
+          break;
+        }
+        name= name_end + 1;
+      }
+    } while (column_group_stat.next_in_prefix_scan());
+  }
+  column_group_stat.end_prefix_scan();
+
+  List_iterator_fast<String> it(groups);
+  while ((names= it++))
+  {
+    column_group_stat.set_key_fields(names);
+    if (!column_group_stat.find_stat())
+      continue;
+    if (!new_name)
+      err= column_group_stat.delete_stat();
+    else
+    {
+      String new_names;
+      const char *name= names->ptr();
+      const char *end= name + names->length();
+      while (name < end)
+      {
+        const char *name_end= (const char *) memchr(name, ',', end - name);
+        if (!name_end)
+          name_end= end;
+        if (new_names.length())
+          new_names.append(',');
+        if ((size_t) (name_end - name) == col_length &&
+            !my_strnncoll(system_charset_info,
+                          (const uchar *) name, col_length,
+                          (const uchar *) col->field_name, col_length))
+          new_names.append(new_name);
+        else
+          new_names.append(name, name_end - name);
+        name= name_end + 1;
+      }
+      err= column_group_stat.update_column_names_key_part(&new_names);
+    }
+    if (err && !rc)
+      rc= 1;
+  }
+
+  thd->restore_stmt_binlog_format(save_binlog_format);
+
+  close_system_tables(thd, &open_tables_backup);
+
+  DBUG_RETURN(rc);
+}
+
+
 /**
   @brief
   Delete statistics on a column of the specified table
@@ -3086,7 +4039,9 @@ int delete_statistics_for_table(THD *thd, LEX_STRING *db, LEX_STRING *tab)
 
   @details
   The function delete statistics on the column 'col' belonging to the table 
-  'tab' from the statistical table column_stats. 
+  'tab' from the statistical table column_stats and the statistics on
+  the groups of columns containing 'col' from the statistical table
+  column_group_stats.
 
   @retval
   0         If the deletion is successful  
@@ -3132,6 +4087,9 @@ int delete_statistics_for_column(THD *thd, TABLE *tab, Field *col)
 
   close_system_tables(thd, &open_tables_backup);
 
+  if (update_column_groups_for_column(thd, tab, col, NULL))
+    rc= 1;
+
   DBUG_RETURN(rc);
 }
 
@@ -3235,7 +4193,7 @@ int delete_statistics_for_index(THD *thd, TABLE *tab, KEY *key_info,
   @details
   The function replaces the name of the table 'tab' from the database 'db' 
   for 'new_tab' in all all statistical tables: table_stats, column_stats,
-  index_stats.
+  index_stats, column_group_stats.
 
   @retval
   0         If all updates of the table name are successful  
@@ -3278,6 +4236,18 @@ int rename_table_in_stat_tables(THD *thd, LEX_STRING *db, LEX_STRING *tab,
     index_stat.set_full_table_name();
   }
 
+  /* Rename table in the statistical table column_group_stats */
+  stat_table= tables[COLUMN_GROUP_STAT].table;
+  Column_group_stat column_group_stat(stat_table, db, tab);
+  column_group_stat.set_full_table_name();
+  while (column_group_stat.find_next_stat_for_prefix(2))
+  {
+    err= column_group_stat.update_table_name_key_parts(new_db, new_tab);
+    if (err & !rc)
+      rc= 1;
+    column_group_stat.set_full_table_name();
+  }
+
   /* Rename table in the statistical table column_stats */
   stat_table= tables[COLUMN_STAT].table;
   Column_stat column_stat(stat_table, db, tab);
@@ -3324,7 +4294,8 @@ int rename_table_in_stat_tables(THD *thd, LEX_STRING *db, LEX_STRING *tab,
 
   @details
   The function replaces the name of the column 'col' belonging to the table 
-  'tab' for 'new_name' in the statistical table column_stats.
+  'tab' for 'new_name' in the statistical tables column_stats and
+  column_group_stats.
 
   @retval
   0         If all updates of the table name are successful  
@@ -3375,6 +4346,9 @@ int rename_column_in_stat_tables(THD *thd, TABLE *tab, Field *col,
 
   close_system_tables(thd, &open_tables_backup);
 
+  if (update_column_groups_for_column(thd, tab, col, new_name))
+    rc= 1;
+
   DBUG_RETURN(rc);
 }
 
@@ -3453,6 +4427,79 @@ double get_column_avg_frequency(Field * field)
 } 
 
 
+/**
+  @brief
+  Correct the selectivity of equalities over columns of a group of columns
+
+  @param
+  table       The table whose columns are compared with constants
+  @param
+  eq_fields   The bitmap of the columns of 'table' that are compared
+              with constants
+
+  @details
+  The selectivity of a conjunction of the equalities col_i=const_i over
+  the columns of a table is calculated as the product of the selectivities
+  field_i->cond_selectivity of the equalities, as if the columns were
+  independent. If the statistical data on a group of these columns has been
+  collected, the selectivity of the conjunction is rather estimated as the
+  average frequency of a combination of values of the group divided by the
+  number of rows in the table. The estimate cannot be greater than the
+  selectivity of any of the equalities and it is used only when it is
+  greater than the product.
+  The function looks for the groups whose columns all are in 'eq_fields',
+  the groups with more columns go first. The columns of the used groups
+  are removed from 'eq_fields'.
+
+  @retval
+  The factor the product of the selectivities is to be multiplied by
+*/
+
+double get_column_group_selectivity(TABLE *table, MY_BITMAP *eq_fields)
+{
+  double sel= 1.0;
+  double table_records= table->stat_records();
+  Table_statistics *read_stats= table->s->stats_cb.table_stats;
+
+  if (!table->stats_is_read || !read_stats || !read_stats->column_groups ||
+      table_records == 0)
+    return sel;
+
+  for (uint columns= MAX_COLUMN_GROUP_COLUMNS; columns >= 2; columns--)
+  {
+    for (uint k= 0; k < read_stats->column_groups; k++)
+    {
+      Column_group_statistics *group= read_stats->column_group_stats[k];
+      uint i;
+      if (group->columns != columns)
+        continue;
+      for (i= 0; i < columns; i++)
+      {
+        if (!bitmap_is_set(eq_fields, group->field_index[i]))
+          break;
+      }
+      if (i < columns)
+        continue;
+
+      double prod_sel= 1.0;
+      double min_sel= 1.0;
+      for (i= 0; i < columns; i++)
+      {
+        double fld_sel= table->field[group->field_index[i]]->cond_selectivity;
+        prod_sel*= fld_sel;
+        set_if_smaller(min_sel, fld_sel);
+        bitmap_clear_bit(eq_fields, group->field_index[i]);
+      }
+      double group_sel= group->get_avg_frequency() / table_records;
+      set_if_smaller(group_sel, min_sel);
+      if (group_sel > prod_sel && prod_sel > 0)
+        sel*= group_sel / prod_sel;
+    }
+  }
+  return sel;
+}
+
+
 /**
   @brief
   Estimate the number of rows in a column range using data from stat tables 
@@ -36,12 +36,13 @@ enum enum_stat_tables
   TABLE_STAT,
   COLUMN_STAT,
   INDEX_STAT,
+  COLUMN_GROUP_STAT
 };
 
 
 /* 
-  These enumeration types comprise the dictionary of three
-  statistical tables table_stat, column_stat and index_stat
+  These enumeration types comprise the dictionary of four statistical
+  tables table_stat, column_stat, index_stat and column_group_stat
   as they defined in ../scripts/mysql_system_tables.sql.
 
   It would be nice if the declarations of these types were
@@ -79,6 +80,20 @@ enum enum_index_stat_col
   INDEX_STAT_AVG_FREQUENCY
 };
 
+enum enum_column_group_stat_col
+{
+  COLUMN_GROUP_STAT_DB_NAME,
+  COLUMN_GROUP_STAT_TABLE_NAME,
+  COLUMN_GROUP_STAT_COLUMN_NAMES,
+  COLUMN_GROUP_STAT_AVG_FREQUENCY
+};
+
+/* Maximum number of columns in a column group */
+#define MAX_COLUMN_GROUP_COLUMNS 8
+
+/* Maximum length of the list of the column names of a column group */
+#define MAX_COLUMN_GROUP_NAMES_LENGTH 200
+
 inline
 Use_stat_tables_mode get_use_stat_tables_mode(THD *thd)
 { 
@@ -90,6 +105,8 @@ int collect_statistics_for_table(THD *thd, TABLE *table);
 int alloc_statistics_for_table_share(THD* thd, TABLE_SHARE *share,
                                      bool is_safe);
 int alloc_statistics_for_table(THD *thd, TABLE *table);
+int alloc_column_groups_for_table(THD *thd, TABLE *table,
+                                  List<List<LEX_STRING> > *groups);
 int update_statistics_for_table(THD *thd, TABLE *table);
 int delete_statistics_for_table(THD *thd, LEX_STRING *db, LEX_STRING *tab);
 int delete_statistics_for_column(THD *thd, TABLE *tab, Field *col);
@@ -103,6 +120,8 @@ void set_statistics_for_table(THD *thd, TABLE *table);
 
 double get_column_avg_frequency(Field * field);
 
+double get_column_group_selectivity(TABLE *table, MY_BITMAP *eq_fields);
+
 double get_column_range_cardinality(Field *field,
                                     key_range *min_endp,
                                     key_range *max_endp,
@@ -249,6 +268,7 @@ public:
 
 
 class Columns_statistics;
+class Column_group_statistics;
 class Index_statistics;
 
 static inline
@@ -277,6 +297,49 @@ public:
   ulong *idx_avg_frequency;   /* Array of records per key for index prefixes */
   ulong total_hist_size;            /* Total size of all histograms */
   uchar *histograms;                /* Sequence of histograms       */                    
+  uint column_groups;               /* Number of column groups      */
+  /* Array of statistical data for column groups */
+  Column_group_statistics **column_group_stats;
+};
+
+
+/*
+  Statistical data on a group of columns
+
+  The statistics on a group of columns shows how the values of the columns
+  are correlated. It is collected by ANALYZE for the groups of columns
+  specified in its PERSISTENT FOR COLUMNS clause, e.g.
+    ANALYZE TABLE t PERSISTENT FOR COLUMNS ((country, city)) INDEXES ()
+  and then is refreshed by any ANALYZE over all columns of the group.
+*/
+
+class Column_group_statistics
+{
+
+private:
+  static const uint Scale_factor_avg_frequency= 100000;
+
+  /*
+    The ratio N/D multiplied by the scale factor Scale_factor_avg_frequency,
+    where N is the number of rows that have no nulls in the columns of the
+    group and D is the number of distinct combinations of their values
+  */
+  ulong avg_frequency;
+
+public:
+  uint columns;         /* Number of columns in the group */
+  /* Numbers of the columns of the group in the table, in ascending order */
+  uint16 field_index[MAX_COLUMN_GROUP_COLUMNS];
+
+  double get_avg_frequency()
+  {
+    return (double) avg_frequency / Scale_factor_avg_frequency;
+  }
+
+  void set_avg_frequency(double val)
+  {
+    avg_frequency= (ulong) (val * Scale_factor_avg_frequency);
+  }
 };
 
 
@@ -0,0 +1,230 @@
+/*
+   Copyright (c) 2014, Monty Program Ab
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/**
+  @file
+
+  @brief
+  A pool of threads that run parts of a statement in parallel
+
+  @see run_pool_tasks()
+*/
+
+#include "my_global.h"
+#include "sql_priv.h"
+#include "sql_class.h"
+#include "sql_task_pool.h"
+#include "mysqld.h"
+
+
+static mysql_mutex_t LOCK_task_pool;
+/* Signaled when a task is queued, or when the pool is shut down */
+static mysql_cond_t COND_task_pool;
+/* Signaled when the last task of a batch ends, or when a thread ends */
+static mysql_cond_t COND_task_done;
+
+static Pool_task *task_queue, *task_queue_last;
+static uint task_pool_threads, task_pool_idle_threads, task_pool_queued;
+static bool task_pool_inited, task_pool_shutdown;
+
+
+void task_pool_init()
+{
+  mysql_mutex_init(key_LOCK_task_pool, &LOCK_task_pool, MY_MUTEX_INIT_FAST);
+  mysql_cond_init(key_COND_task_pool, &COND_task_pool, NULL);
+  mysql_cond_init(key_COND_task_done, &COND_task_done, NULL);
+  task_queue= task_queue_last= 0;
+  task_pool_threads= task_pool_idle_threads= task_pool_queued= 0;
+  task_pool_shutdown= FALSE;
+  task_pool_inited= TRUE;
+}
+
+
+/* Wait for the threads of the pool to end, and free the pool */
+
+void task_pool_end()
+{
+  if (!task_pool_inited)
+    return;
+  mysql_mutex_lock(&LOCK_task_pool);
+  task_pool_shutdown= TRUE;
+  mysql_cond_broadcast(&COND_task_pool);
+  while (task_pool_threads)
+    mysql_cond_wait(&COND_task_done, &LOCK_task_pool);
+  mysql_mutex_unlock(&LOCK_task_pool);
+  mysql_cond_destroy(&COND_task_done);
+  mysql_cond_destroy(&COND_task_pool);
+  mysql_mutex_destroy(&LOCK_task_pool);
+  task_pool_inited= FALSE;
+}
+
+
+static Pool_task *pop_task()
+{
+  Pool_task *task= task_queue;
+  if (!(task_queue= task->next))
+    task_queue_last= 0;
+  task->queued= FALSE;
+  task_pool_queued--;
+  return task;
+}
+
+
+static void remove_task(Pool_task *task)
+{
+  Pool_task **prev= &task_queue, *last= 0;
+  while (*prev != task)
+  {
+    last= *prev;
+    prev= &last->next;
+  }
+  *prev= task->next;
+  if (task_queue_last == task)
+    task_queue_last= last;
+  task->queued= FALSE;
+  task_pool_queued--;
+}
+
+
+/* Must be called with LOCK_task_pool held */
+
+static void finish_task(Pool_task *task)
+{
+  if (!--*task->pending)
+    mysql_cond_broadcast(&COND_task_done);
+}
+
+
+pthread_handler_t handle_task_pool_thread(void *arg)
+{
+  THD *thd;
+  struct timespec abstime;
+  int error;
+
+  my_thread_init();
+  thd= new THD;
+  thd->thread_stack= (char*) &thd;
+  thd->store_globals();
+  pthread_detach_this_thread();
+
+  mysql_mutex_lock(&LOCK_task_pool);
+  for (;;)
+  {
+    error= 0;
+    set_timespec(abstime, TASK_POOL_IDLE_TIMEOUT);
+    while (!task_queue && !task_pool_shutdown && error != ETIMEDOUT &&
+           error != ETIME)
+    {
+      task_pool_idle_threads++;
+      error= mysql_cond_timedwait(&COND_task_pool, &LOCK_task_pool,
+                                  &abstime);
+      task_pool_idle_threads--;
+    }
+    if (!task_queue)
+      break;
+    Pool_task *task= pop_task();
+    mysql_mutex_unlock(&LOCK_task_pool);
+    task->run(thd);
+    mysql_mutex_lock(&LOCK_task_pool);
+    finish_task(task);
+  }
+  task_pool_threads--;
+  mysql_cond_broadcast(&COND_task_done);
+  mysql_mutex_unlock(&LOCK_task_pool);
+
+  delete thd;
+  set_current_thd(0);
+  my_thread_end();
+  pthread_exit(0);
+  return 0;
+}
+
+
+/**
+  Run tasks in parallel and wait until all of them have ended
+
+  @param thd    the THD of the statement
+  @param tasks  the tasks
+  @param count  the number of tasks
+
+  @details
+  The first task is run by the calling thread, the other ones are queued
+  for the threads of the pool. When the first task is done, the calling
+  thread takes back the tasks that no thread of the pool has picked up
+  yet and runs them itself. So the statement never waits for a thread of
+  the pool to become free, and it is done even if the pool cannot start
+  any thread.
+*/
+
+void run_pool_tasks(THD *thd, Pool_task **tasks, uint count)
+{
+  uint pending= 0, started= 0;
+  DBUG_ENTER("run_pool_tasks");
+
+  if (count > 1)
+  {
+    mysql_mutex_lock(&LOCK_task_pool);
+    for (uint i= 1; i < count; i++)
+    {
+      Pool_task *task= tasks[i];
+      task->pending= &pending;
+      task->next= 0;
+      task->queued= TRUE;
+      if (task_queue_last)
+        task_queue_last->next= task;
+      else
+        task_queue= task;
+      task_queue_last= task;
+      task_pool_queued++;
+      pending++;
+    }
+    while (task_pool_idle_threads + started < task_pool_queued &&
+           task_pool_threads < TASK_POOL_MAX_THREADS &&
+           !task_pool_shutdown)
+    {
+      pthread_t th;
+      if (mysql_thread_create(key_thread_task_pool, &th, &connection_attrib,
+                              handle_task_pool_thread, 0))
+        break;
+      task_pool_threads++;
+      started++;
+    }
+    mysql_cond_broadcast(&COND_task_pool);
+    mysql_mutex_unlock(&LOCK_task_pool);
+  }
+
+  tasks[0]->run(thd);
+
+  if (count > 1)
+  {
+    mysql_mutex_lock(&LOCK_task_pool);
+    for (uint i= 1; i < count; i++)
+    {
+      Pool_task *task= tasks[i];
+      if (!task->queued)
+        continue;
+      remove_task(task);
+      mysql_mutex_unlock(&LOCK_task_pool);
+      task->run(thd);
+      mysql_mutex_lock(&LOCK_task_pool);
+      finish_task(task);
+    }
+    while (pending)
+      mysql_cond_wait(&COND_task_done, &LOCK_task_pool);
+    mysql_mutex_unlock(&LOCK_task_pool);
+  }
+  DBUG_VOID_RETURN;
+}
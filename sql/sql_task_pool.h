@@ -0,0 +1,76 @@
+#ifndef SQL_TASK_POOL_INCLUDED
+#define SQL_TASK_POOL_INCLUDED
+
+/*
+   Copyright (c) 2014, Monty Program Ab
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/**
+  @file
+
+  @brief
+  A pool of threads that run parts of a statement in parallel
+
+  The threads are started when there are more queued tasks than idle
+  threads, up to TASK_POOL_MAX_THREADS for the whole server, and are
+  reused by later statements. A thread that has had nothing to do for
+  TASK_POOL_IDLE_TIMEOUT seconds ends. Every thread of the pool has a
+  THD of its own, created once when the thread starts.
+*/
+
+/* Maximum number of threads of the pool */
+#define TASK_POOL_MAX_THREADS 64
+
+/* Seconds an idle thread of the pool waits for a task before it ends */
+#define TASK_POOL_IDLE_TIMEOUT 60
+
+class THD;
+
+
+/**
+  A part of a statement that can be run by a thread of the pool
+
+  @see run_pool_tasks()
+*/
+
+class Pool_task
+{
+public:
+  /* Next task in the queue of the pool */
+  Pool_task *next;
+  /* Number of unfinished tasks of the batch of the task */
+  uint *pending;
+  /* TRUE <=> the task is in the queue of the pool */
+  bool queued;
+
+  Pool_task() :next(0), pending(0), queued(FALSE) {}
+  virtual ~Pool_task() {}
+
+  /**
+    Do the work of the task
+
+    @param thd  the THD of the thread that runs the task: a THD of the
+                pool, or the THD of the statement if the task is run by
+                the thread that submitted it
+  */
+  virtual void run(THD *thd)= 0;
+};
+
+
+void task_pool_init();
+void task_pool_end();
+void run_pool_tasks(THD *thd, Pool_task **tasks, uint count);
+
+#endif /* SQL_TASK_POOL_INCLUDED */
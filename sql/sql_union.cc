@@ -104,6 +104,23 @@ bool select_union::send_eof()
 }
 
 
+int select_union_direct::send_data(List<Item> &items)
+{
+  if (unit->offset_limit_cnt)
+  {						// using limit offset,count
+    unit->offset_limit_cnt--;
+    return 0;
+  }
+  if (thd->killed == ABORT_QUERY)
+    return 0;
+  fill_record(thd, table, table->field, items, TRUE, FALSE);
+  if (thd->is_error())
+    return 1;
+  send_records++;
+  return result->send_data(unit->item_list);
+}
+
+
 bool select_union::flush()
 {
   int error;
@@ -283,7 +300,12 @@ bool st_select_lex_unit::prepare(THD *thd_arg, select_result *sel_result,
 
   if (is_union_select)
   {
-    if (!(tmp_result= union_result= new select_union))
+    union_direct= !union_needs_tmp_table();
+    if (union_direct)
+      union_result= new select_union_direct(sel_result);
+    else
+      union_result= new select_union;
+    if (!(tmp_result= union_result))
       goto err;
     if (describe)
       tmp_result= sel_result;
@@ -451,7 +473,8 @@ bool st_select_lex_unit::prepare(THD *thd_arg, select_result *sel_result,
       create_options= create_options | TMP_TABLE_FORCE_MYISAM;
 
     if (union_result->create_result_table(thd, &types, MY_TEST(union_distinct),
-                                          create_options, "", FALSE, TRUE))
+                                          create_options, "", FALSE,
+                                          !union_direct))
       goto err;
     if (fake_select_lex && !fake_select_lex->first_cond_optimization)
     {
@@ -650,6 +673,9 @@ bool st_select_lex_unit::exec()
   if (saved_error)
     DBUG_RETURN(saved_error);
 
+  if (union_direct)
+    DBUG_RETURN(exec_direct());
+
   if (uncacheable || !item || !item->assigned() || describe)
   {
     for (SELECT_LEX *sl= select_cursor; sl; sl= sl->next_select())
@@ -863,6 +889,104 @@ err:
 }
 
 
+/*
+  Check if the rows of the UNION must be collected in the temporary table
+  before they are sent to the result
+
+  DESCRIPTION
+    A UNION ALL without ORDER BY and LIMIT over the whole UNION that sends
+    its rows to the client can send the rows of each SELECT as they are
+    produced. The table is still needed to remove duplicates, to sort and
+    limit the rows, and for the units that are read as a table: subqueries,
+    derived tables and the SELECTs of INSERT, CREATE, cursors and
+    SELECT ... INTO.
+
+  RETURN
+    TRUE   the rows are written into the temporary table
+    FALSE  the rows are sent to the result directly, see exec_direct()
+*/
+
+bool st_select_lex_unit::union_needs_tmp_table()
+{
+  LEX *lex= thd->lex;
+  if (!optimizer_flag(thd, OPTIMIZER_SWITCH_UNION_ALL_STREAMING) ||
+      !is_union() || union_distinct || item || derived ||
+      this != &lex->unit || lex->sql_command != SQLCOM_SELECT ||
+      lex->result || (first_select()->options & OPTION_BUFFER_RESULT))
+    return TRUE;
+
+  /* ORDER BY, LIMIT and sql_select_limit apply to the whole UNION */
+  if (global_parameters->order_list.elements ||
+      global_parameters->explicit_limit || global_parameters->offset_limit)
+    return TRUE;
+  if (global_parameters->select_limit &&
+      global_parameters->select_limit->val_uint() != HA_POS_ERROR)
+    return TRUE;
+  return FALSE;
+}
+
+
+/*
+  Execute a UNION ALL that sends the rows of its SELECTs to the result
+  directly, see union_needs_tmp_table()
+*/
+
+bool st_select_lex_unit::exec_direct()
+{
+  SELECT_LEX *lex_select_save= thd->lex->current_select;
+  ha_rows examined_rows= 0;
+  DBUG_ENTER("st_select_lex_unit::exec_direct");
+
+  if (!describe &&
+      (result->prepare(item_list, this) ||
+       result->send_result_set_metadata(item_list, Protocol::SEND_NUM_ROWS |
+                                                   Protocol::SEND_EOF)))
+    DBUG_RETURN(TRUE);
+
+  for (SELECT_LEX *sl= first_select(); sl; sl= sl->next_select())
+  {
+    thd->lex->current_select= sl;
+    set_limit(sl);
+    if (describe)
+    {
+      offset_limit_cnt= 0;
+      select_limit_cnt= HA_POS_ERROR;
+    }
+    sl->join->select_options= 
+      (select_limit_cnt == HA_POS_ERROR || sl->braces) ?
+      sl->options & ~OPTION_FOUND_ROWS : sl->options | found_rows_for_union;
+    if (!(saved_error= sl->join->optimize()))
+    {
+      sl->join->exec();
+      saved_error= sl->join->error;
+    }
+    if (saved_error)
+      break;
+    examined_rows+= thd->get_examined_row_count();
+    thd->set_examined_row_count(0);
+    if (thd->killed == ABORT_QUERY)
+    {
+      /* Stop executing the SELECTs, the rows sent so far are the result */
+      push_warning_printf(thd, Sql_condition::WARN_LEVEL_WARN,
+                          ER_QUERY_EXCEEDED_ROWS_EXAMINED_LIMIT,
+                          ER(ER_QUERY_EXCEEDED_ROWS_EXAMINED_LIMIT),
+                          thd->accessed_rows_and_keys,
+                          thd->lex->limit_rows_examined->val_uint());
+      thd->reset_killed();
+      break;
+    }
+  }
+  thd->lex->current_select= lex_select_save;
+  if (saved_error || describe)
+    DBUG_RETURN(saved_error);
+
+  thd->limit_found_rows=
+    ((select_union_direct*) union_result)->send_records;
+  thd->inc_examined_row_count(examined_rows);
+  DBUG_RETURN(result->send_eof());
+}
+
+
 bool st_select_lex_unit::cleanup()
 {
   int error= 0;
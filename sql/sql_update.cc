@@ -277,6 +277,7 @@ int mysql_update(THD *thd,
   List<Item> all_fields;
   killed_state killed_status= NOT_KILLED;
   Update_plan query_plan(thd->mem_root);
+  Table_access_tracker *tracker= NULL;
   query_plan.index= MAX_KEY;
   query_plan.using_filesort= FALSE;
   DBUG_ENTER("mysql_update");
@@ -381,7 +382,7 @@ int mysql_update(THD *thd,
     {
       limit= 0;                                   // Impossible WHERE
       query_plan.set_impossible_where();
-      if (thd->lex->describe)
+      if (thd->lex->describe || thd->lex->analyze_stmt)
         goto exit_without_my_ok;
     }
   }
@@ -403,7 +404,7 @@ int mysql_update(THD *thd,
     free_underlaid_joins(thd, select_lex);
 
     query_plan.set_no_partitions();
-    if (thd->lex->describe)
+    if (thd->lex->describe || thd->lex->analyze_stmt)
       goto exit_without_my_ok;
 
     my_ok(thd);				// No matching records
@@ -419,7 +420,7 @@ int mysql_update(THD *thd,
       (select && select->check_quick(thd, safe_update, limit)))
   {
     query_plan.set_impossible_where();
-    if (thd->lex->describe)
+    if (thd->lex->describe || thd->lex->analyze_stmt)
       goto exit_without_my_ok;
 
     delete select;
@@ -518,6 +519,13 @@ int mysql_update(THD *thd,
     goto exit_without_my_ok;
   query_plan.save_explain_data(thd->lex->explain);
 
+  if (thd->lex->analyze_stmt)
+  {
+    tracker= &thd->lex->explain->get_upd_del_plan()->tracker;
+    table->file->tracker= &tracker->time_tracker;
+    tracker->on_scan_init();
+  }
+
   DBUG_EXECUTE_IF("show_explain_probe_update_exec_start", 
                   dbug_serve_apcs(thd, 1););
   
@@ -561,6 +569,13 @@ int mysql_update(THD *thd,
 	goto err;
       }
       thd->inc_examined_row_count(examined_rows);
+      /* The loop below reads the sorted rows again, don't count them */
+      if (tracker)
+      {
+        tracker->r_rows+= examined_rows;
+        tracker->r_rows_after_where+= found_rows;
+        tracker= NULL;
+      }
       /*
 	Filesort has already found and selected the rows we want to update,
 	so we don't need the where clause
@@ -618,11 +633,16 @@ int mysql_update(THD *thd,
                                 table->triggers ? VCOL_UPDATE_ALL :
                                                   VCOL_UPDATE_FOR_READ);
         thd->inc_examined_row_count(1);
+        if (tracker)
+          tracker->on_record_read();
 	if (!select || (error= select->skip_record(thd)) > 0)
 	{
           if (table->file->was_semi_consistent_read())
 	    continue;  /* repeat the read of the same row if it still exists */
 
+          if (tracker)
+            tracker->on_record_after_where();
+
 	  table->file->position(table->record[0]);
 	  if (my_b_write(&tempfile,table->file->ref,
 			 table->file->ref_length))
@@ -655,6 +675,8 @@ int mysql_update(THD *thd,
       if (thd->killed && !error)
 	error= 1;				// Aborted
       limit= tmp_limit;
+      /* The loop below reads the saved rows again, don't count them */
+      tracker= NULL;
       table->file->try_semi_consistent_read(0);
       end_read_record(&info);
      
@@ -731,11 +753,16 @@ int mysql_update(THD *thd,
                             table->triggers ? VCOL_UPDATE_ALL :
                                               VCOL_UPDATE_FOR_READ);
     thd->inc_examined_row_count(1);
+    if (tracker)
+      tracker->on_record_read();
     if (!select || select->skip_record(thd) > 0)
     {
       if (table->file->was_semi_consistent_read())
         continue;  /* repeat the read of the same row if it still exists */
 
+      if (tracker)
+        tracker->on_record_after_where();
+
       store_record(table,record[1]);
       if (fill_record_n_invoke_before_triggers(thd, table, fields, values, 0,
                                                TRG_EVENT_UPDATE))
@@ -993,7 +1020,13 @@ int mysql_update(THD *thd,
   id= thd->arg_of_last_insert_id_function ?
     thd->first_successful_insert_id_in_prev_stmt : 0;
 
-  if (error < 0)
+  if (error < 0 && thd->lex->analyze_stmt)
+  {
+    /* ANALYZE UPDATE sends the EXPLAIN output instead of the OK packet */
+    if (thd->lex->explain->send_explain(thd))
+      error= 1;
+  }
+  else if (error < 0)
   {
     char buff[MYSQL_ERRMSG_SIZE];
     my_snprintf(buff, sizeof(buff), ER(ER_UPDATE_INFO), (ulong) found,
@@ -1556,7 +1589,7 @@ bool mysql_multi_update(THD *thd,
     (*result)->abort_result_set();
   else
   {
-    if (thd->lex->describe)
+    if (thd->lex->describe || thd->lex->analyze_stmt)
       res= thd->lex->explain->send_explain(thd);
   }
   thd->abort_on_warning= 0;
@@ -2499,7 +2532,9 @@ bool multi_update::send_eof()
     thd->first_successful_insert_id_in_prev_stmt : 0;
   my_snprintf(buff, sizeof(buff), ER(ER_UPDATE_INFO),
               (ulong) found, (ulong) updated, (ulong) thd->cuted_fields);
-  ::my_ok(thd, (thd->client_capabilities & CLIENT_FOUND_ROWS) ? found : updated,
-          id, buff);
+  /* ANALYZE UPDATE sends the EXPLAIN output instead */
+  if (!thd->lex->analyze_stmt)
+    ::my_ok(thd, (thd->client_capabilities & CLIENT_FOUND_ROWS) ? found : updated,
+            id, buff);
   DBUG_RETURN(FALSE);
 }
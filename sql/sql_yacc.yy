@@ -1000,6 +1000,7 @@ bool my_yyoverflow(short **a, YYSTYPE **b, ulong *yystacksize);
 %token  AND_AND_SYM                   /* OPERATOR */
 %token  AND_SYM                       /* SQL-2003-R */
 %token  ANY_SYM                       /* SQL-2003-R */
+%token  APPROX_COUNT_DISTINCT_SYM
 %token  AS                            /* SQL-2003-R */
 %token  ASC                           /* SQL-2003-N */
 %token  ASCII_SYM                     /* MYSQL-FUNC */
@@ -1177,6 +1178,7 @@ bool my_yyoverflow(short **a, YYSTYPE **b, ulong *yystacksize);
 %token  FLUSH_SYM
 %token  FORCE_SYM
 %token  FOREIGN                       /* SQL-2003-R */
+%token  FORMAT_SYM
 %token  FOR_SYM                       /* SQL-2003-R */
 %token  FOUND_SYM                     /* SQL-2003-R */
 %token  FROM
@@ -1813,7 +1815,8 @@ bool my_yyoverflow(short **a, YYSTYPE **b, ulong *yystacksize);
         analyze_table_list analyze_table_elem_spec
         opt_persistent_stat_clause persistent_stat_spec
         persistent_column_stat_spec persistent_index_stat_spec
-        table_column_list table_index_list table_index_name
+        table_column_list table_column_elem table_column_group
+        table_index_list table_index_name
         check start checksum
         field_list field_list_item field_spec kill column_def key_def
         keycache_list keycache_list_or_parts assign_to_keycache
@@ -1846,6 +1849,7 @@ bool my_yyoverflow(short **a, YYSTYPE **b, ulong *yystacksize);
         subselect_end select_var_list select_var_list_init help 
         field_length opt_field_length
         opt_extended_describe shutdown
+        opt_format_json analyze_stmt_command analyzable_command
         prepare prepare_src execute deallocate
         statement sp_suid
         sp_c_chistics sp_a_chistics sp_chistic sp_c_chistic xa
@@ -1990,6 +1994,7 @@ verb_clause:
 statement:
           alter
         | analyze
+        | analyze_stmt_command
         | binlog_base64_event
         | call
         | change
@@ -8031,14 +8036,41 @@ persistent_index_stat_spec:
 table_column_list:
           /* empty */
           {}
-        | ident 
+        | table_column_elem
+        | table_column_list ',' table_column_elem
+        ;
+
+table_column_elem:
+          ident 
           {
             Lex->column_list->push_back((LEX_STRING*)
             sql_memdup(&$1, sizeof(LEX_STRING)));
           }
-        | table_column_list ',' ident
+        | '('
           {
-            Lex->column_list->push_back((LEX_STRING*)
+            LEX* lex= thd->lex;
+            List<LEX_STRING> *group= new List<LEX_STRING>;
+            if (group == NULL)
+              MYSQL_YYABORT;
+            if (lex->column_group_list == NULL &&
+                (lex->column_group_list= new List<List<LEX_STRING> >) == NULL)
+              MYSQL_YYABORT;
+            if (lex->column_group_list->push_front(group))
+              MYSQL_YYABORT;
+          }
+          table_column_group
+          ')'
+        ;
+
+table_column_group:
+          ident
+          {
+            Lex->column_group_list->head()->push_back((LEX_STRING*)
+            sql_memdup(&$1, sizeof(LEX_STRING)));
+          }
+        | table_column_group ',' ident
+          {
+            Lex->column_group_list->head()->push_back((LEX_STRING*)
             sql_memdup(&$3, sizeof(LEX_STRING)));
           }
         ;
@@ -9748,6 +9780,18 @@ function_call_conflict:
               MYSQL_YYABORT;
             Lex->safe_to_cache_query=0;
           }
+        | FORMAT_SYM '(' expr ',' expr ')'
+          {
+            $$= new (thd->mem_root) Item_func_format($3, $5);
+            if ($$ == NULL)
+              MYSQL_YYABORT;
+          }
+        | FORMAT_SYM '(' expr ',' expr ',' expr ')'
+          {
+            $$= new (thd->mem_root) Item_func_format($3, $5, $7);
+            if ($$ == NULL)
+              MYSQL_YYABORT;
+          }
         | IF '(' expr ',' expr ',' expr ')'
           {
             $$= new (thd->mem_root) Item_func_if($3,$5,$7);
@@ -10142,6 +10186,12 @@ sum_expr:
             if ($$ == NULL)
               MYSQL_YYABORT;
           }
+        | APPROX_COUNT_DISTINCT_SYM '(' in_sum_expr ')'
+          {
+            $$= new (thd->mem_root) Item_sum_approx_count_distinct($3);
+            if ($$ == NULL)
+              MYSQL_YYABORT;
+          }
         | BIT_AND  '(' in_sum_expr ')'
           {
             $$= new (thd->mem_root) Item_sum_and($3);
@@ -12752,6 +12802,13 @@ describe:
           }
         ;
 
+analyze_stmt_command:
+          ANALYZE_SYM opt_format_json analyzable_command
+          {
+            Lex->analyze_stmt= true;
+          }
+        ;
+
 explainable_command:
           select
         | insert
@@ -12760,17 +12817,37 @@ explainable_command:
         | delete
         ;
 
+analyzable_command:
+          select
+        | update
+        | delete
+        ;
+
 describe_command:
           DESC
         | DESCRIBE
         ;
 
 opt_extended_describe:
-          /* empty */ {}
+          opt_format_json {}
         | EXTENDED_SYM   { Lex->describe|= DESCRIBE_EXTENDED; }
         | PARTITIONS_SYM { Lex->describe|= DESCRIBE_PARTITIONS; }
         ;
 
+opt_format_json:
+          /* empty */ {}
+        | FORMAT_SYM EQ ident_or_text
+          {
+            if (!my_strcasecmp(system_charset_info, $3.str, "JSON"))
+              Lex->explain_json= true;
+            else if (my_strcasecmp(system_charset_info, $3.str, "TRADITIONAL"))
+            {
+              my_error(ER_UNKNOWN_EXPLAIN_FORMAT, MYF(0), $3.str);
+              MYSQL_YYABORT;
+            }
+          }
+        ;
+
 opt_describe_column:
           /* empty */ {}
         | text_string { Lex->wild= $1; }
@@ -14188,6 +14265,7 @@ keyword_sp:
         | EXTENT_SIZE_SYM          {}
         | FAULTS_SYM               {}
         | FAST_SYM                 {}
+        | FORMAT_SYM               {}
         | FOUND_SYM                {}
         | ENABLE_SYM               {}
         | FULL                     {}
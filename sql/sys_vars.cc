@@ -62,6 +62,8 @@
 #include "sql_repl.h"
 #include "opt_range.h"
 #include "rpl_parallel.h"
+#include "sql_parallel_scan.h"
+#include "sql_sort.h"                           // MAX_SORT_THREADS
 
 /*
   The rule for this file: everything should be 'static'. When a sys_var
@@ -367,6 +369,16 @@ static Sys_var_ulong Sys_back_log(
        READ_ONLY GLOBAL_VAR(back_log), CMD_LINE(REQUIRED_ARG),
        VALID_RANGE(1, 65535), DEFAULT(150), BLOCK_SIZE(1));
 
+static Sys_var_uint Sys_acceptor_threads(
+       "acceptor_threads", "Number of threads accepting TCP/IP "
+       "connections on the main port. Every thread listens on its own "
+       "socket, bound with SO_REUSEPORT, and the kernel distributes the "
+       "new connections between them. With 1 (the default) all "
+       "connections are accepted by the main thread. Only supported on "
+       "platforms with SO_REUSEPORT",
+       READ_ONLY GLOBAL_VAR(acceptor_threads), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(1, 256), DEFAULT(1), BLOCK_SIZE(1));
+
 static Sys_var_charptr Sys_basedir(
        "basedir", "Path to installation directory. All paths are "
        "usually resolved relative to this",
@@ -1944,6 +1956,15 @@ static Sys_var_ulong Sys_max_sort_length(
        SESSION_VAR(max_sort_length), CMD_LINE(REQUIRED_ARG),
        VALID_RANGE(4, 8192*1024L), DEFAULT(1024), BLOCK_SIZE(1));
 
+static Sys_var_ulong Sys_max_sort_threads(
+       "max_sort_threads",
+       "Maximum number of threads that sort the sort buffer of a filesort. "
+       "Each thread sorts its own part of the buffer, and the sorted parts "
+       "are merged pairwise by several threads as well. 1 disables "
+       "parallel sorting",
+       SESSION_VAR(max_sort_threads), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(1, MAX_SORT_THREADS), DEFAULT(1), BLOCK_SIZE(1));
+
 static Sys_var_ulong Sys_max_sp_recursion_depth(
        "max_sp_recursion_depth",
        "Maximum stored procedure recursion depth",
@@ -2183,6 +2204,15 @@ export const char *optimizer_switch_names[]=
   "table_elimination",
   "extended_keys",
   "exists_to_in",
+  "join_cache_grace",
+  "merge_join",
+  "skip_scan",
+  "batch_condition",
+  "hash_aggregate",
+  "join_cache_bloom_filter",
+  "reuse_join_order",
+  "condition_pushdown_for_derived",
+  "union_all_streaming",
   "default", NullS
 };
 /** propagates changes to @@engine_condition_pushdown */
@@ -2197,9 +2227,12 @@ static bool fix_optimizer_switch(sys_var *self, THD *thd,
 static Sys_var_flagset Sys_optimizer_switch(
        "optimizer_switch",
        "optimizer_switch=option=val[,option=val...], where option is one of {"
+        "batch_condition, "
+        "condition_pushdown_for_derived, "
         "derived_merge, "
         "derived_with_keys, "
         "firstmatch, "
+        "hash_aggregate, "
         "in_to_exists, "
         "engine_condition_pushdown, "
         "index_condition_pushdown, "
@@ -2209,10 +2242,13 @@ static Sys_var_flagset Sys_optimizer_switch(
         "index_merge_sort_union, "
         "index_merge_union, "
         "join_cache_bka, "
+        "join_cache_bloom_filter, "
+        "join_cache_grace, "
         "join_cache_hashed, "
         "join_cache_incremental, "
         "loosescan, "
         "materialization, "
+        "merge_join, "
         "mrr, "
         "mrr_cost_based, "
         "mrr_sort_keys, "
@@ -2220,10 +2256,13 @@ static Sys_var_flagset Sys_optimizer_switch(
         "outer_join_with_cache, "
         "partial_match_rowid_merge, "
         "partial_match_table_scan, "
+        "reuse_join_order, "
         "semijoin, "
         "semijoin_with_cache, "
+        "skip_scan, "
         "subquery_cache, "
         "table_elimination, "
+        "union_all_streaming, "
         "extended_keys, "
         "exists_to_in "
        "} and val is one of {on, off, default}",
@@ -2232,6 +2271,15 @@ static Sys_var_flagset Sys_optimizer_switch(
        NO_MUTEX_GUARD, NOT_IN_BINLOG, ON_CHECK(NULL),
        ON_UPDATE(fix_optimizer_switch));
 
+static Sys_var_ulong Sys_parallel_scan_workers(
+       "parallel_scan_workers",
+       "Maximum number of threads that read a table in parallel when "
+       "a single-table query computes aggregate functions without GROUP BY. "
+       "Each thread scans its own range of an index and the partial "
+       "results are merged at the end. 0 or 1 disables parallel scans",
+       SESSION_VAR(parallel_scan_workers), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, PARALLEL_SCAN_MAX_WORKERS), DEFAULT(0), BLOCK_SIZE(1));
+
 static Sys_var_charptr Sys_pid_file(
        "pid_file", "Pid file used by safe_mysqld",
        READ_ONLY GLOBAL_VAR(pidfile_name_ptr), CMD_LINE(REQUIRED_ARG),
@@ -2399,6 +2447,14 @@ static Sys_var_ulong Sys_range_alloc_block_size(
        VALID_RANGE(RANGE_ALLOC_BLOCK_SIZE, UINT_MAX),
        DEFAULT(RANGE_ALLOC_BLOCK_SIZE), BLOCK_SIZE(1024));
 
+static Sys_var_ulong Sys_range_index_dive_limit(
+       "range_index_dive_limit",
+       "The number of ranges of a range scan whose rows are estimated by "
+       "looking into the index. The rows of the further ranges are estimated "
+       "from a sample of them. 0 means no limit",
+       SESSION_VAR(range_index_dive_limit), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, UINT_MAX32), DEFAULT(0), BLOCK_SIZE(1));
+
 static Sys_var_ulong Sys_multi_range_count(
        "multi_range_count", "Ignored. Use mrr_buffer_size instead",
        SESSION_VAR(multi_range_count), CMD_LINE(REQUIRED_ARG),
@@ -3063,6 +3119,23 @@ static Sys_var_ulong Sys_thread_cache_size(
        GLOBAL_VAR(thread_cache_size), CMD_LINE(REQUIRED_ARG),
        VALID_RANGE(0, 16384), DEFAULT(0), BLOCK_SIZE(1));
 
+static bool fix_session_cache_size(sys_var *, THD *, enum_var_type)
+{
+  mysql_mutex_unlock(&LOCK_global_system_variables);
+  flush_session_cache(session_cache_size);
+  mysql_mutex_lock(&LOCK_global_system_variables);
+  return false;
+}
+
+static Sys_var_ulong Sys_session_cache_size(
+       "session_cache_size",
+       "How many sessions (THD objects) of closed connections we should "
+       "keep in a cache, to be reset and reused by new connections instead "
+       "of creating new ones",
+       GLOBAL_VAR(session_cache_size), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, 16384), DEFAULT(0), BLOCK_SIZE(1), NO_MUTEX_GUARD,
+       NOT_IN_BINLOG, ON_CHECK(0), ON_UPDATE(fix_session_cache_size));
+
 #ifdef HAVE_POOL_OF_THREADS
 static bool fix_tp_max_threads(sys_var *, THD *, enum_var_type)
 {
@@ -3132,6 +3205,15 @@ static Sys_var_uint Sys_threadpool_oversubscribe(
   GLOBAL_VAR(threadpool_oversubscribe), CMD_LINE(REQUIRED_ARG),
   VALID_RANGE(1, 1000), DEFAULT(3), BLOCK_SIZE(1)
 );
+static Sys_var_uint Sys_threadpool_prio_kickup_timer(
+  "thread_pool_prio_kickup_timer",
+  "Requests of connections inside a transaction or holding locks are "
+  "handled before other requests, unless one of these has been waiting "
+  "for more than this many milliseconds. 0 handles all requests in the "
+  "order they arrive.",
+  GLOBAL_VAR(threadpool_prio_kickup_timer), CMD_LINE(REQUIRED_ARG),
+  VALID_RANGE(0, UINT_MAX), DEFAULT(1000), BLOCK_SIZE(1)
+);
 static Sys_var_uint Sys_threadpool_size(
  "thread_pool_size",
  "Number of thread groups in the pool. "
@@ -4710,6 +4792,14 @@ static Sys_var_enum Sys_histogram_type(
        SESSION_VAR(histogram_type), CMD_LINE(REQUIRED_ARG),
        histogram_types, DEFAULT(0));
 
+static Sys_var_double Sys_analyze_sample_percentage(
+       "analyze_sample_percentage",
+       "Percentage of rows from the table ANALYZE TABLE will sample to "
+       "collect column statistics. Set to 0 to sample about 100000 rows "
+       "whatever the size of the table is.",
+       SESSION_VAR(analyze_sample_percentage), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, 100), DEFAULT(100));
+
 static Sys_var_mybool Sys_no_thread_alarm(
        "debug_no_thread_alarm",
        "Disable system thread alarm calls. Disabling it may be useful "
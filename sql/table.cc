@@ -4015,6 +4015,7 @@ void TABLE::init(THD *thd, TABLE_LIST *tl)
   status= STATUS_NO_RECORD;
   insert_values= 0;
   fulltext_searched= 0;
+  file->tracker= NULL;
   file->ft_handler= 0;
   reginfo.impossible_range= 0;
   created= TRUE;
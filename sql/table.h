@@ -332,6 +332,7 @@ public:
   size_t    addon_length;       /* Length of the buffer */
   struct st_sort_addon_field *addon_field;     /* Pointer to the fields info */
   void    (*unpack)(struct st_sort_addon_field *, uchar *, uchar *); /* To unpack back */
+  bool      using_packed_addons; /* Records start with their length */
   uchar     *record_pointers;    /* If sorted in memory */
   ha_rows   found_records;      /* How many records in sort */
 
@@ -345,6 +346,9 @@ public:
   uchar *get_record_buffer(uint idx)
   { return filesort_buffer.get_record_buffer(idx); }
 
+  uchar *get_packed_record_buffer(uint idx, uint length)
+  { return filesort_buffer.get_packed_record_buffer(idx, length); }
+
   uchar **get_sort_keys()
   { return filesort_buffer.get_sort_keys(); }
 
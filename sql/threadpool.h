@@ -23,6 +23,7 @@ extern uint threadpool_max_size;
 extern uint threadpool_stall_limit;  /* time interval in 10 ms units for stall checks*/
 extern uint threadpool_max_threads;  /* Maximum threads in pool */
 extern uint threadpool_oversubscribe;  /* Maximum active threads in group */
+extern uint threadpool_prio_kickup_timer; /* ms before a normal event is served first */
 
 
 
@@ -53,6 +54,13 @@ struct TP_STATISTICS
 {
   /* Current number of worker thread. */
   volatile int32 num_worker_threads;
+  /* Number of events taken from the queue of another group */
+  volatile int64 stolen_events;
+  /* Number of events dequeued from the high priority and normal queues */
+  volatile int64 high_prio_events;
+  volatile int64 low_prio_events;
+  /* Number of normal events served first because they waited too long */
+  volatile int64 prio_kickups;
 };
 
 extern TP_STATISTICS tp_stats;
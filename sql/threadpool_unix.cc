@@ -113,9 +113,16 @@ struct connection_t
 
   THD *thd;
   thread_group_t *thread_group;
+  /*
+    Group of the worker handling the current event. It differs from
+    thread_group if the event was stolen by a worker of another group.
+  */
+  thread_group_t *worker_group;
   connection_t *next_in_queue;
   connection_t **prev_in_queue;
   ulonglong abs_wait_timeout;
+  /* When the connection was put to a queue, in microseconds */
+  ulonglong enqueue_time;
   bool logged_in;
   bool bound_to_poll_descriptor;
   bool waiting;
@@ -133,6 +140,11 @@ struct thread_group_t
 {
   mysql_mutex_t mutex;
   connection_queue_t queue;
+  /*
+    Connections inside a transaction or holding locks, served before
+    those in queue (see queue_get())
+  */
+  connection_queue_t high_prio_queue;
   worker_list_t waiting_threads; 
   worker_thread_t *listener;
   pthread_attr_t *pthread_attr;
@@ -154,6 +166,12 @@ static thread_group_t *all_groups;
 static uint group_count;
 static int32 shutdown_group_count;
 
+/**
+  Number of groups with a non-empty queue. Idle workers look for events
+  to steal only if it is not 0.
+*/
+static int32 queued_group_count;
+
 /**
  Used for printing "pool blocked" message, see
  print_pool_blocked_message();
@@ -174,6 +192,7 @@ struct pool_timer_t
 static pool_timer_t pool_timer;
 
 static void queue_put(thread_group_t *thread_group, connection_t *connection);
+static void queue_push(thread_group_t *thread_group, connection_t *connection);
 static int  wake_thread(thread_group_t *thread_group);
 static void handle_event(connection_t *connection);
 static int  wake_or_create_thread(thread_group_t *thread_group);
@@ -411,21 +430,168 @@ static void* native_event_get_userdata(native_event *event)
 #endif
 
 
-/* Dequeue element from a workqueue */
+static inline bool queue_is_empty(thread_group_t *thread_group)
+{
+  return thread_group->queue.is_empty() &&
+         thread_group->high_prio_queue.is_empty();
+}
+
+
+/**
+  Check whether the next event of a connection should be served before
+  the events of other connections.
+
+  A connection inside a transaction, or holding metadata locks (e.g. with
+  LOCK TABLES), makes other connections wait for its locks. Serving it
+  first shortens the time the locks are held.
+*/
+
+static bool connection_is_high_prio(connection_t *c)
+{
+  THD *thd= c->thd;
+  return c->logged_in &&
+         (thd->in_active_multi_stmt_transaction() ||
+          thd->mdl_context.has_locks());
+}
+
+
+/**
+  Dequeue element from a workqueue
+
+  Events from the high priority queue are served first. To prevent
+  starvation, an event that has been waiting in the normal queue for
+  more than thread_pool_prio_kickup_timer milliseconds is served first
+  if it is older than the first high priority event. With a timer of 0
+  the events are served in the order they were queued.
+*/
 
 static connection_t *queue_get(thread_group_t *thread_group)
 {
   DBUG_ENTER("queue_get");
   thread_group->queue_event_count++;
-  connection_t *c= thread_group->queue.front();
-  if (c)
+  connection_t *c= thread_group->high_prio_queue.front();
+  connection_t *low= thread_group->queue.front();
+
+  if (low && 
+      (!c ||
+       (low->enqueue_time < c->enqueue_time &&
+        microsecond_interval_timer() - low->enqueue_time >=
+        1000ULL * threadpool_prio_kickup_timer)))
   {
+    if (c)
+      my_atomic_add64(&tp_stats.prio_kickups, 1);
+    c= low;
     thread_group->queue.remove(c);
+    my_atomic_add64(&tp_stats.low_prio_events, 1);
   }
+  else if (c)
+  {
+    thread_group->high_prio_queue.remove(c);
+    my_atomic_add64(&tp_stats.high_prio_events, 1);
+  }
+  if (c && queue_is_empty(thread_group))
+    my_atomic_add32(&queued_group_count, -1);
   DBUG_RETURN(c);  
 }
 
 
+/* Enqueue element to a workqueue */
+
+static void queue_push(thread_group_t *thread_group, connection_t *connection)
+{
+  if (queue_is_empty(thread_group))
+    my_atomic_add32(&queued_group_count, 1);
+  connection->enqueue_time= microsecond_interval_timer();
+  if (connection_is_high_prio(connection))
+    thread_group->high_prio_queue.push_back(connection);
+  else
+    thread_group->queue.push_back(connection);
+}
+
+
+/**
+  Take an event from the queue of another group.
+
+  Connections are bound to a group for their whole life, so a few busy
+  connections in one group can make its queue grow while workers of other
+  groups are idle. Such workers take events from the other queues before
+  they go to sleep. The groups are tried in a round robin order starting
+  after the worker's group, so that the idle workers of different groups
+  pick different victims. The mutexes of the victims are only tried, the
+  caller must not hold the mutex of its group.
+
+  @param thread_group - group of the current worker
+
+  @return a connection with a pending event, or NULL
+*/
+
+static connection_t *steal_event(thread_group_t *thread_group)
+{
+  DBUG_ENTER("steal_event");
+  uint count= group_count;
+  uint own= (uint) (thread_group - all_groups);
+
+  if (!my_atomic_load32(&queued_group_count))
+    DBUG_RETURN(NULL);
+
+  for (uint i= 1; i < count; i++)
+  {
+    thread_group_t *victim= &all_groups[(own + i) % count];
+    connection_t *connection= NULL;
+
+    /* Dirty read, the queue is checked again under the mutex */
+    if (queue_is_empty(victim) || victim->shutdown)
+      continue;
+    if (mysql_mutex_trylock(&victim->mutex) != 0)
+      continue;
+    if (!victim->shutdown)
+      connection= queue_get(victim);
+    mysql_mutex_unlock(&victim->mutex);
+    if (connection)
+    {
+      my_atomic_add64(&tp_stats.stolen_events, 1);
+      DBUG_RETURN(connection);
+    }
+  }
+  DBUG_RETURN(NULL);
+}
+
+
+/**
+  Wake an idle worker of another group to steal from the queue of
+  the given group.
+
+  Used when events are queued in a group, whose workers are all busy.
+  Only workers of groups with no active threads are woken, so that the
+  total number of active threads stays about the number of groups.
+  The caller must not hold the mutex of its group.
+*/
+
+static void wake_stealer(thread_group_t *thread_group)
+{
+  DBUG_ENTER("wake_stealer");
+  uint count= group_count;
+  uint own= (uint) (thread_group - all_groups);
+
+  for (uint i= 1; i < count; i++)
+  {
+    thread_group_t *group= &all_groups[(own + i) % count];
+
+    /* Dirty read, checked again under the mutex */
+    if (group->active_thread_count || group->waiting_threads.is_empty())
+      continue;
+    if (mysql_mutex_trylock(&group->mutex) != 0)
+      continue;
+    bool woken= !group->shutdown && !group->active_thread_count &&
+                !wake_thread(group);
+    mysql_mutex_unlock(&group->mutex);
+    if (woken)
+      break;
+  }
+  DBUG_VOID_RETURN;
+}
+
+
 /* 
   Handle wait timeout : 
   Find connections that have been idle for too long and kill them.
@@ -591,7 +757,7 @@ void check_stall(thread_group_t *thread_group)
     do wait and indicate that via thd_wait_begin/end callbacks, thread creation
     will be faster.
   */
-  if (!thread_group->queue.is_empty() && !thread_group->queue_event_count)
+  if (!queue_is_empty(thread_group) && !thread_group->queue_event_count)
   {
     thread_group->stalled= true;
     wake_or_create_thread(thread_group);
@@ -709,27 +875,33 @@ static connection_t * listener(worker_thread_t *current_thread,
      more workers.
     */
     
-    bool listener_picks_event= thread_group->queue.is_empty();
+    bool listener_picks_event= queue_is_empty(thread_group);
     
     /* 
-      If listener_picks_event is set, listener thread will handle first event, 
-      and put the rest into the queue. If listener_pick_event is not set, all 
-      events go to the queue.
+      All events go to the queues. If listener_picks_event is set, listener
+      thread will handle the first event of the queues, i.e. an event of
+      a high priority connection if there is one.
     */
-    for(int i=(listener_picks_event)?1:0; i < cnt ; i++)
+    for(int i=0; i < cnt ; i++)
     {
       connection_t *c= (connection_t *)native_event_get_userdata(&ev[i]);
-      thread_group->queue.push_back(c);
+      queue_push(thread_group, c);
     }
     
     if (listener_picks_event)
     {
       /* Handle the first event. */
-      retval= (connection_t *)native_event_get_userdata(&ev[0]);
+      retval= queue_get(thread_group);
       mysql_mutex_unlock(&thread_group->mutex);
       break;
     }
 
+    /*
+      If the workers are busy, the queued events wait for them. Let an idle
+      group take some of them instead.
+    */
+    bool steal= thread_group->active_thread_count > 0;
+
     if(thread_group->active_thread_count==0)
     {
       /* We added some work items to queue, now wake a worker. */
@@ -756,6 +928,9 @@ static connection_t * listener(worker_thread_t *current_thread,
       }
     }
     mysql_mutex_unlock(&thread_group->mutex);
+
+    if (steal)
+      wake_stealer(thread_group);
   }
 
   DBUG_RETURN(retval);
@@ -912,6 +1087,7 @@ int thread_group_init(thread_group_t *thread_group, pthread_attr_t* thread_attr)
   thread_group->shutdown_pipe[0]= -1;
   thread_group->shutdown_pipe[1]= -1;
   thread_group->queue.empty();
+  thread_group->high_prio_queue.empty();
   DBUG_RETURN(0);
 }
 
@@ -978,6 +1154,17 @@ static void thread_group_close(thread_group_t *thread_group)
   thread_group->shutdown= true; 
   thread_group->listener= NULL;
 
+  /*
+    Nothing is taken from the queues of a group that shuts down, so it
+    must not be counted as a group that has events to steal
+  */
+  if (!queue_is_empty(thread_group))
+  {
+    thread_group->queue.empty();
+    thread_group->high_prio_queue.empty();
+    my_atomic_add32(&queued_group_count, -1);
+  }
+
   if (pipe(thread_group->shutdown_pipe))
   {
     DBUG_VOID_RETURN;
@@ -1017,13 +1204,18 @@ static void queue_put(thread_group_t *thread_group, connection_t *connection)
   DBUG_ENTER("queue_put");
 
   mysql_mutex_lock(&thread_group->mutex);
-  thread_group->queue.push_back(connection);
+  queue_push(thread_group, connection);
 
+  /* As in listener(), let an idle group help if the workers are busy */
+  bool steal= thread_group->active_thread_count > 0;
   if (thread_group->active_thread_count == 0)
     wake_or_create_thread(thread_group);
 
   mysql_mutex_unlock(&thread_group->mutex);
 
+  if (steal)
+    wake_stealer(thread_group);
+
   DBUG_VOID_RETURN;
 }
 
@@ -1064,6 +1256,7 @@ connection_t *get_event(worker_thread_t *current_thread,
   DBUG_ENTER("get_event");
   connection_t *connection = NULL;
   int err=0;
+  bool steal_tried= false;
 
   mysql_mutex_lock(&thread_group->mutex);
   DBUG_ASSERT(thread_group->active_thread_count >= 0);
@@ -1113,6 +1306,22 @@ connection_t *get_event(worker_thread_t *current_thread,
       }
     }
 
+    /*
+      Before sleeping, help a group whose queue is not empty. The group
+      mutex is released meanwhile, so check own queue and listener again
+      if nothing was stolen.
+    */
+    if (!oversubscribed && !steal_tried)
+    {
+      steal_tried= true;
+      mysql_mutex_unlock(&thread_group->mutex);
+      connection= steal_event(thread_group);
+      mysql_mutex_lock(&thread_group->mutex);
+      if (connection)
+        break;
+      continue;
+    }
+
     /* And now, finally sleep */ 
     current_thread->woken = false; /* wake() sets this to true */
 
@@ -1147,6 +1356,7 @@ connection_t *get_event(worker_thread_t *current_thread,
 
     if (err)
       break;
+    steal_tried= false;
   }
 
   thread_group->stalled= false;
@@ -1169,10 +1379,9 @@ void wait_begin(thread_group_t *thread_group)
   thread_group->active_thread_count--;
   
   DBUG_ASSERT(thread_group->active_thread_count >=0);
-  DBUG_ASSERT(thread_group->connection_count > 0);
  
   if ((thread_group->active_thread_count == 0) && 
-     (thread_group->queue.is_empty() || !thread_group->listener))
+     (queue_is_empty(thread_group) || !thread_group->listener))
   {
     /* 
       Group might stall while this thread waits, thus wake 
@@ -1211,6 +1420,7 @@ connection_t *alloc_connection(THD *thd)
   if (connection)
   {
     connection->thd = thd;
+    connection->worker_group= NULL;
     connection->waiting= false;
     connection->logged_in= false;
     connection->bound_to_poll_descriptor= false;
@@ -1294,7 +1504,7 @@ void tp_wait_begin(THD *thd, int type)
   {
     DBUG_ASSERT(!connection->waiting);
     connection->waiting= true;
-    wait_begin(connection->thread_group);
+    wait_begin(connection->worker_group);
   }
   DBUG_VOID_RETURN;
 }
@@ -1314,7 +1524,7 @@ void tp_wait_end(THD *thd)
   {
     DBUG_ASSERT(connection->waiting);
     connection->waiting = false;
-    wait_end(connection->thread_group);
+    wait_end(connection->worker_group);
   }
   DBUG_VOID_RETURN;
 }
@@ -1493,6 +1703,7 @@ static void *worker_main(void *param)
     if (!connection)
       break;
     this_thread.event_count++;
+    connection->worker_group= thread_group;
     handle_event(connection);
   }
 
@@ -28,6 +28,17 @@
 
   The unique entries will be returned in sort order, to ensure that we do the
   deletes in disk order.
+
+  In the hash mode the elements are stored in an open addressing hash table
+  with linear probing, which grows up to 'max_in_memory_size'. When the
+  table is full, its elements are written to the file in
+  UNIQUE_HASH_PARTITIONS partitions selected by the high bits of their hash
+  values, and the table is cleared. At the end the partitions are read back
+  one by one, and every partition is deduplicated in the hash table. A
+  partition that does not fit either is split again by the next bits of the
+  hash values. walk() visits the elements of every partition in the order
+  of the hash table; get() sorts every partition and merges them as the
+  sorted runs of the tree.
 */
 
 #include "sql_priv.h"
@@ -74,12 +85,78 @@ int unique_intersect_write_to_ptrs(uchar* key, element_count count, Unique *uniq
 }
 
 
+/* The elements of a partition written to the file by a full hash table */
+
+struct Unique_hash_chunk
+{
+  my_off_t file_pos;
+  ulong count;
+  uint partition;
+};
+
+
+/* Number of slots of the hash table when the first element is added */
+#define UNIQUE_HASH_MIN_SLOTS 256
+
+/*
+  Bytes read from the file at once when the partitions of the hash table
+  are deduplicated
+*/
+#define UNIQUE_HASH_READ_BUFFER (64*1024)
+
+
+/*
+  Hash an element of the hash mode. Every 8 bytes are mixed into the state
+  by a multiplication, the result is finished with the finalizer of
+  MurmurHash3 so that both the low bits (the slot) and the high bits (the
+  partition) depend on all bytes.
+*/
+
+static inline ulonglong unique_hash_key(const uchar *key, uint length)
+{
+  ulonglong hash= length;
+  for (; length >= 8; key+= 8, length-= 8)
+    hash= (hash ^ uint8korr(key)) * 0x9E3779B97F4A7C15ULL;
+  for (; length; key++, length--)
+    hash= (hash ^ *key) * 0x100000001B3ULL;
+  hash^= hash >> 33;
+  hash*= 0xff51afd7ed558ccdULL;
+  hash^= hash >> 33;
+  hash*= 0xc4ceb9fe1a85ec53ULL;
+  hash^= hash >> 33;
+  return hash;
+}
+
+
+/* The partition of an element written by a full table at the given level */
+
+static inline uint unique_hash_partition(ulonglong hash, uint level)
+{
+  return (uint) (hash >> (64 - (level + 1) * UNIQUE_HASH_PARTITION_BITS)) &
+         (UNIQUE_HASH_PARTITIONS - 1);
+}
+
+
+/**
+  @param comp_func            the comparison of two elements
+  @param comp_func_fixed_arg  the first argument of comp_func
+  @param size_arg             the size of an element
+  @param max_in_memory_size_arg  the memory for the tree or the hash table
+  @param min_dupl_count_arg   >0 for intersections, see unique_add()
+  @param hash_mode_arg        TRUE <=> two elements are equal if and only
+                              if their bytes are equal; they are then kept
+                              in a hash table instead of the tree
+*/
+
 Unique::Unique(qsort_cmp2 comp_func, void * comp_func_fixed_arg,
 	       uint size_arg, ulonglong max_in_memory_size_arg,
-               uint min_dupl_count_arg)
+               uint min_dupl_count_arg, bool hash_mode_arg)
   :max_in_memory_size(max_in_memory_size_arg),
    record_pointers(NULL),
    size(size_arg),
+   hash_mode(hash_mode_arg && size_arg),
+   hash_slots(NULL), hash_used(NULL),
+   hash_capacity(0), hash_elements(0),
    elements(0)
 {
   min_dupl_count= min_dupl_count_arg;
@@ -100,6 +177,16 @@ Unique::Unique(qsort_cmp2 comp_func, void * comp_func_fixed_arg,
                          ALIGN_SIZE(sizeof(TREE_ELEMENT)+size));
   (void) open_cached_file(&file, mysql_tmpdir,TEMP_PREFIX, DISK_BUFFER_SIZE,
 		   MYF(MY_WME));
+
+  /* The counters of intersections are not supported by the hash table */
+  DBUG_ASSERT(!hash_mode || !min_dupl_count);
+  /* The largest power of 2 of slots with their bytes in the memory limit */
+  hash_max_capacity= UNIQUE_HASH_MIN_SLOTS;
+  while ((ulonglong) hash_max_capacity * 2 * (size + 1) <= max_in_memory_size &&
+         hash_max_capacity < (ULONG_MAX >> 2))
+    hash_max_capacity*= 2;
+  my_init_dynamic_array(&hash_chunks, sizeof(Unique_hash_chunk), 16, 16,
+                        MYF(MY_THREAD_SPECIFIC));
 }
 
 
@@ -363,6 +450,8 @@ Unique::~Unique()
   close_cached_file(&file);
   delete_tree(&tree);
   delete_dynamic(&file_ptrs);
+  hash_free();
+  delete_dynamic(&hash_chunks);
 }
 
 
@@ -395,6 +484,19 @@ void
 Unique::reset()
 {
   reset_tree(&tree);
+  if (hash_mode)
+  {
+    /*
+      A table grown for a big set is freed rather than cleared, so that
+      clearing it for many small sets (e.g. the groups of COUNT(DISTINCT))
+      does not cost its size every time.
+    */
+    if (hash_capacity > UNIQUE_HASH_MIN_SLOTS)
+      hash_free();
+    else
+      hash_clear();
+    reset_dynamic(&hash_chunks);
+  }
   /*
     If elements != 0, some trees were stored in the file (see how
     flush() works). Note, that we can not count on my_b_tell(&file) == 0
@@ -631,6 +733,21 @@ bool Unique::walk(TABLE *table, tree_walk_action action, void *walk_action_arg)
   int res= 0;
   uchar *merge_buffer;
 
+  if (hash_mode)
+  {
+    uchar *buff;
+    if (elements == 0)                     /* the whole table is in memory */
+      return hash_walk(action, walk_action_arg);
+    if (hash_spill(&hash_chunks, 0) ||
+        !(buff= (uchar *) my_malloc(UNIQUE_HASH_READ_BUFFER,
+                                    MYF(MY_THREAD_SPECIFIC))))
+      return 1;
+    res= hash_walk_partitions(&hash_chunks, 0, buff, UNIQUE_HASH_READ_BUFFER,
+                              action, walk_action_arg);
+    my_free(buff);
+    return res;
+  }
+
   if (elements == 0)                       /* the whole tree is in memory */
     return tree_walk(&tree, action, walk_action_arg, left_root_right);
 
@@ -753,7 +870,41 @@ bool Unique::get(TABLE *table)
   uchar *sort_buffer= NULL;
   table->sort.found_records= elements+tree.elements_in_tree;
 
-  if (my_b_tell(&file) == 0)
+  if (hash_mode)
+  {
+    table->sort.found_records= elements + hash_elements;
+    if (elements == 0)
+    {
+      /* Sort the table in place and copy it */
+      ulong count= hash_sort();
+      if ((record_pointers=table->sort.record_pointers= (uchar*)
+           my_malloc(size * count, MYF(MY_THREAD_SPECIFIC))))
+      {
+        memcpy(record_pointers, hash_slots, size * count);
+        hash_clear();
+        return 0;
+      }
+      hash_clear();
+      return 1;
+    }
+    /*
+      Write every partition as a sorted run and merge the runs. The
+      partitions have no common elements, so the runs are disjoint.
+    */
+    uchar *buff;
+    if (hash_spill(&hash_chunks, 0) ||
+        !(buff= (uchar *) my_malloc(UNIQUE_HASH_READ_BUFFER,
+                                    MYF(MY_THREAD_SPECIFIC))))
+      return 1;
+    rc= hash_walk_partitions(&hash_chunks, 0, buff, UNIQUE_HASH_READ_BUFFER,
+                             NULL, NULL);
+    my_free(buff);
+    hash_free();
+    if (rc)
+      return 1;
+    rc= 1;
+  }
+  else if (my_b_tell(&file) == 0)
   {
     /* Whole tree is in memory;  Don't use disk if you don't need to */
     if ((record_pointers=table->sort.record_pointers= (uchar*)
@@ -770,7 +921,7 @@ bool Unique::get(TABLE *table)
     }
   }
   /* Not enough memory; Save the result to file && free memory used by tree */
-  if (flush())
+  if (!hash_mode && flush())
     return 1;
   
   ulong buff_sz= (max_in_memory_size / full_size + 1) * full_size;
@@ -785,3 +936,315 @@ err:
   my_free(sort_buffer);  
   return rc;
 }
+
+
+/* Allocate an empty hash table */
+
+bool Unique::hash_alloc(ulong capacity)
+{
+  if (!(hash_slots= (uchar*) my_malloc((size_t) capacity * size,
+                                       MYF(MY_THREAD_SPECIFIC))) ||
+      !(hash_used= (uchar*) my_malloc(capacity,
+                                      MYF(MY_THREAD_SPECIFIC | MY_ZEROFILL))))
+  {
+    hash_free();
+    return 1;
+  }
+  hash_capacity= capacity;
+  hash_elements= 0;
+  return 0;
+}
+
+
+void Unique::hash_free()
+{
+  my_free(hash_slots);
+  my_free(hash_used);
+  hash_slots= hash_used= NULL;
+  hash_capacity= hash_elements= 0;
+}
+
+
+void Unique::hash_clear()
+{
+  if (hash_capacity)
+    bzero(hash_used, hash_capacity);
+  hash_elements= 0;
+}
+
+
+/* Put an element that is not in the table to a free slot */
+
+void Unique::hash_insert(const uchar *key, ulonglong hash)
+{
+  ulong mask= hash_capacity - 1;
+  ulong slot;
+  for (slot= (ulong) hash & mask; hash_used[slot]; slot= (slot + 1) & mask)
+  {}
+  memcpy(hash_slots + (size_t) slot * size, key, size);
+  hash_used[slot]= 1;
+  hash_elements++;
+}
+
+
+/**
+  Add an element to the hash table
+
+  The table is at most 3/4 full. When it has no more room, it is doubled
+  or, when it has reached the memory limit, written to the file.
+
+  @param key  the element
+
+  @retval 0  OK
+  @retval 1  out of memory or a write error
+*/
+
+bool Unique::hash_add(const uchar *key)
+{
+  ulonglong hash= unique_hash_key(key, size);
+  ulong mask, slot;
+
+  if (!hash_capacity &&
+      hash_alloc(MY_MIN(UNIQUE_HASH_MIN_SLOTS, hash_max_capacity)))
+    return 1;
+
+  mask= hash_capacity - 1;
+  for (slot= (ulong) hash & mask; hash_used[slot]; slot= (slot + 1) & mask)
+  {
+    if (!memcmp(hash_slots + (size_t) slot * size, key, size))
+      return 0;                                 /* A duplicate */
+  }
+
+  if (hash_elements >= hash_capacity / 4 * 3)
+  {
+    if (hash_capacity < hash_max_capacity)
+    {
+      uchar *old_slots= hash_slots, *old_used= hash_used;
+      ulong old_capacity= hash_capacity;
+      hash_slots= hash_used= NULL;
+      if (hash_alloc(old_capacity * 2))
+      {
+        hash_slots= old_slots;
+        hash_used= old_used;
+        hash_capacity= old_capacity;
+        hash_elements= old_capacity / 4 * 3;
+        return 1;
+      }
+      for (ulong i= 0; i < old_capacity; i++)
+      {
+        uchar *old_key= old_slots + (size_t) i * size;
+        if (old_used[i])
+          hash_insert(old_key, unique_hash_key(old_key, size));
+      }
+      my_free(old_slots);
+      my_free(old_used);
+    }
+    else if (hash_spill(&hash_chunks, 0))
+      return 1;
+  }
+  hash_insert(key, hash);
+  return 0;
+}
+
+
+/**
+  Write the elements of the hash table to the file and clear the table
+
+  The elements are written in partitions by the bits of their hash values
+  that follow the bits of the partitions of the previous levels.
+
+  @param chunks  the array the written partitions are added to
+  @param level   0 for the elements added by unique_add(), n+1 for the
+                 elements of a partition of level n
+*/
+
+bool Unique::hash_spill(DYNAMIC_ARRAY *chunks, uint level)
+{
+  /* All bits of the hash values have been used for partitions */
+  if ((level + 1) * UNIQUE_HASH_PARTITION_BITS > 64)
+    return 1;
+  if (!hash_elements)
+    return 0;
+  if (level == 0)
+    elements+= hash_elements;
+
+  /* Mark every used slot with its partition + 1 */
+  for (ulong i= 0; i < hash_capacity; i++)
+  {
+    if (hash_used[i])
+    {
+      ulonglong hash= unique_hash_key(hash_slots + (size_t) i * size, size);
+      hash_used[i]= (uchar) (unique_hash_partition(hash, level) + 1);
+    }
+  }
+
+  for (uint part= 0; part < UNIQUE_HASH_PARTITIONS; part++)
+  {
+    Unique_hash_chunk chunk;
+    chunk.file_pos= my_b_tell(&file);
+    chunk.count= 0;
+    chunk.partition= part;
+    for (ulong i= 0; i < hash_capacity; i++)
+    {
+      if (hash_used[i] != part + 1)
+        continue;
+      if (my_b_write(&file, hash_slots + (size_t) i * size, size))
+        return 1;
+      chunk.count++;
+    }
+    if (chunk.count && insert_dynamic(chunks, (uchar*) &chunk))
+      return 1;
+  }
+  hash_clear();
+  return 0;
+}
+
+
+/* Call the action for every element of the hash table */
+
+bool Unique::hash_walk(tree_walk_action action, void *walk_action_arg)
+{
+  for (ulong i= 0; i < hash_capacity; i++)
+  {
+    if (hash_used[i] &&
+        action(hash_slots + (size_t) i * size, 1, walk_action_arg))
+      return 1;
+  }
+  return 0;
+}
+
+
+/**
+  Move the elements of the hash table to its first slots and sort them
+
+  @note The table must be cleared before it is used again.
+
+  @return the number of elements
+*/
+
+ulong Unique::hash_sort()
+{
+  ulong count= 0;
+  for (ulong i= 0; i < hash_capacity; i++)
+  {
+    if (!hash_used[i])
+      continue;
+    if (i != count)
+      memcpy(hash_slots + (size_t) count * size,
+             hash_slots + (size_t) i * size, size);
+    count++;
+  }
+  my_qsort2(hash_slots, count, size, (qsort2_cmp) tree.compare,
+            tree.custom_arg);
+  return count;
+}
+
+
+/**
+  Deduplicate the partitions written to the file by the hash table
+
+  @param chunks        the written parts of the partitions of the level
+  @param level         the level of the partitions
+  @param buff          the buffer the elements are read to
+  @param buff_size     the size of buff
+  @param action        the function called for every unique element, NULL
+                       to write the elements of every partition as a sorted
+                       run to the file (see merge())
+  @param walk_action_arg  the argument of the action
+*/
+
+bool Unique::hash_walk_partitions(DYNAMIC_ARRAY *chunks, uint level,
+                                  uchar *buff, ulong buff_size,
+                                  tree_walk_action action,
+                                  void *walk_action_arg)
+{
+  DYNAMIC_ARRAY children;
+  ulong buff_elements= buff_size / size;
+  bool res= 1;
+
+  if (my_init_dynamic_array(&children, sizeof(Unique_hash_chunk), 16, 16,
+                            MYF(MY_THREAD_SPECIFIC)))
+    return 1;
+
+  for (uint part= 0; part < UNIQUE_HASH_PARTITIONS; part++)
+  {
+    bool spilled= FALSE;
+    reset_dynamic(&children);
+    if (flush_io_cache(&file))
+      goto end;
+
+    for (uint i= 0; i < chunks->elements; i++)
+    {
+      Unique_hash_chunk *chunk= dynamic_element(chunks, i, Unique_hash_chunk*);
+      my_off_t pos= chunk->file_pos;
+      ulong left= chunk->count;
+      if (chunk->partition != part)
+        continue;
+      while (left)
+      {
+        ulong count= MY_MIN(left, buff_elements);
+        if (mysql_file_pread(file.file, buff, (size_t) count * size, pos,
+                             MYF(MY_WME | MY_NABP)))
+          goto end;
+        pos+= (my_off_t) count * size;
+        left-= count;
+        for (uchar *key= buff; count--; key+= size)
+        {
+          ulonglong hash= unique_hash_key(key, size);
+          ulong mask= hash_capacity - 1, slot;
+          bool found= FALSE;
+          for (slot= (ulong) hash & mask; hash_used[slot];
+               slot= (slot + 1) & mask)
+          {
+            if (!memcmp(hash_slots + (size_t) slot * size, key, size))
+            {
+              found= TRUE;
+              break;
+            }
+          }
+          if (found)
+            continue;
+          if (hash_elements >= hash_capacity / 4 * 3)
+          {
+            /* The partition does not fit; split it further */
+            if (hash_spill(&children, level + 1))
+              goto end;
+            spilled= TRUE;
+          }
+          hash_insert(key, hash);
+        }
+      }
+    }
+
+    if (spilled)
+    {
+      if (hash_spill(&children, level + 1) ||
+          flush_io_cache(&file) ||
+          hash_walk_partitions(&children, level + 1, buff, buff_size,
+                               action, walk_action_arg))
+        goto end;
+      continue;
+    }
+
+    if (action)
+    {
+      if (hash_walk(action, walk_action_arg))
+        goto end;
+    }
+    else if (hash_elements)
+    {
+      BUFFPEK run;
+      run.file_pos= my_b_tell(&file);
+      run.count= hash_sort();
+      if (my_b_write(&file, hash_slots, (size_t) run.count * size) ||
+          insert_dynamic(&file_ptrs, (uchar*) &run))
+        goto end;
+    }
+    hash_clear();
+  }
+  res= 0;
+
+end:
+  delete_dynamic(&children);
+  return res;
+}
@@ -0,0 +1,96 @@
+/* Copyright (c) 2014, Monty Program Ab
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA */
+
+/*
+  Tests msd_radixsort_for_str_ptr() against qsort for different numbers
+  and lengths of strings.
+*/
+
+#include <my_global.h>
+#include <my_sys.h>
+#include <tap.h>
+#include <string.h>
+
+static const uint key_lengths[]= {1, 4, 8, 16, 32, 64, 255};
+static const uint key_counts[]= {10, 100, 1000, 20000, 100000};
+
+#define ARRAY_ELEMENTS(A) (sizeof(A) / sizeof((A)[0]))
+
+/*
+  Fill the strings with a few distinct values of each byte, after a
+  prefix that is common to all of them (as in padded sort keys).
+*/
+
+static void fill_keys(uchar *keys, uint count, uint length)
+{
+  uint prefix= length / 4, i, j;
+  for (i= 0; i < count; i++)
+  {
+    uchar *key= keys + (size_t) i * length;
+    memset(key, 'a', prefix);
+    for (j= prefix; j < length; j++)
+      key[j]= (uchar) (rand() % 7 * 37);
+  }
+}
+
+
+static void init_ptrs(uchar **ptrs, uchar *keys, uint count, uint length)
+{
+  uint i;
+  for (i= 0; i < count; i++)
+    ptrs[i]= keys + (size_t) i * length;
+}
+
+
+int main(int argc __attribute__((unused)), char *argv[])
+{
+  uint i, j;
+  MY_INIT(argv[0]);
+
+  plan(ARRAY_ELEMENTS(key_lengths) * ARRAY_ELEMENTS(key_counts));
+
+  for (i= 0; i < ARRAY_ELEMENTS(key_lengths); i++)
+  {
+    for (j= 0; j < ARRAY_ELEMENTS(key_counts); j++)
+    {
+      size_t length= key_lengths[i];
+      uint count= key_counts[j], k;
+      uchar *keys= (uchar*) malloc(count * length);
+      uchar **ptrs= (uchar**) malloc(count * sizeof(uchar*));
+      uchar **sorted= (uchar**) malloc(count * sizeof(uchar*));
+      my_bool same= TRUE;
+
+      fill_keys(keys, count, length);
+
+      init_ptrs(sorted, keys, count, length);
+      my_qsort2(sorted, count, sizeof(uchar*), get_ptr_compare(length),
+                &length);
+
+      init_ptrs(ptrs, keys, count, length);
+      msd_radixsort_for_str_ptr(ptrs, count, length);
+
+      for (k= 0; k < count && same; k++)
+        same= !memcmp(ptrs[k], sorted[k], length);
+      ok(same, "msd_radixsort_for_str_ptr: %u strings of %u bytes",
+         count, (uint) length);
+
+      free(sorted);
+      free(ptrs);
+      free(keys);
+    }
+  }
+  my_end(0);
+  return exit_status();
+}